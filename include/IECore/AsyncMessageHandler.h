@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2026, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef IECORE_ASYNCMESSAGEHANDLER_H
+#define IECORE_ASYNCMESSAGEHANDLER_H
+
+#include "IECore/Export.h"
+#include "IECore/FilteredMessageHandler.h"
+
+#include <memory>
+
+namespace IECore
+{
+
+class AsyncMessageHandler;
+IE_CORE_DECLAREPTR( AsyncMessageHandler );
+
+/// A FilteredMessageHandler which queues messages and forwards them to
+/// another handler from a dedicated background thread, so that threads
+/// outputting messages are not blocked by slow I/O. The queue is bounded,
+/// so if it fills up, messages are forwarded synchronously on the calling
+/// thread instead, rather than consuming unbounded memory or waiting for
+/// space (which could deadlock if the caller holds a lock needed by the
+/// wrapped handler, such as the Python GIL). Such messages may therefore
+/// be output ahead of messages that are still queued.
+///
+/// > Note : Exceptions thrown by the wrapped handler on the background
+/// > thread are reported to `std::cerr`, since there is no client to which
+/// > they could be propagated.
+/// \ingroup utilityGroup
+class IECORE_API AsyncMessageHandler : public FilteredMessageHandler
+{
+	public :
+
+		IE_CORE_DECLAREMEMBERPTR( AsyncMessageHandler );
+
+		/// Creates a handler which forwards messages to `handler`, queueing
+		/// at most `capacity` messages at once.
+		AsyncMessageHandler( MessageHandlerPtr handler, size_t capacity = 1024 );
+		/// Forwards all remaining messages before returning.
+		~AsyncMessageHandler() override;
+
+		void handle( Level level, const std::string &context, const std::string &message ) override;
+		/// Returns the maximum level of the wrapped handler, so that
+		/// messages it would discard are never queued.
+		Level maximumLevel() const override;
+
+		/// Blocks until all messages queued so far have been
+		/// forwarded to the wrapped handler.
+		void flush();
+
+	private :
+
+		class Implementation;
+		std::unique_ptr<Implementation> m_implementation;
+
+};
+
+}; // namespace IECore
+
+#endif // IECORE_ASYNCMESSAGEHANDLER_H
@@ -37,6 +37,7 @@
 
 #include "IECore/BoxTraits.h"
 #include "IECore/Export.h"
+#include "IECore/IndexedIO.h"
 
 IECORE_PUSH_DEFAULT_VISIBILITY
 #include "OpenEXR/OpenEXRConfig.h"
@@ -47,12 +48,23 @@ IECORE_PUSH_DEFAULT_VISIBILITY
 #endif
 IECORE_POP_DEFAULT_VISIBILITY
 
+#include "tbb/concurrent_vector.h"
+
+#include <cstdint>
+#include <limits>
 #include <vector>
 
 namespace IECore
 {
 
 /// Builds a KDTree of bounded volumes to permit fast intersection/overlap tests.
+///
+/// The tree is built in parallel, choosing each split using a binned
+/// surface area heuristic. Nodes store their bounds inline and reference
+/// their children and bounds using 32 bit indices, with the two children
+/// of each branch adjacent in memory. The tree keeps a copy of the bounds
+/// in the order of the leaves, along with the index of each bound in the
+/// original range. BoundIterator must be a random access iterator.
 /// \ingroup mathGroup
 template<class BoundIterator>
 class BoundedKDTree
@@ -65,6 +77,8 @@ class BoundedKDTree
 		class Node;
 		typedef std::vector<Node> NodeVector;
 		typedef typename NodeVector::size_type NodeIndex;
+		/// The index of a bound within the range passed to init().
+		typedef uint32_t BoundIndex;
 
 		/// Construncts an uninitialised tree - you must call init() before
 		/// using it.
@@ -83,12 +97,38 @@ class BoundedKDTree
 		/// making queries.
 		void init( BoundIterator first, BoundIterator last, int maxLeafSize=4 );
 
+		//! @name Serialisation
+		/// Trees for static geometry may be saved alongside it, and loaded
+		/// again rather than being rebuilt.
+		//@{
+		/// Saves the structure of the tree into the specified directory. The
+		/// bounds themselves are not saved.
+		void save( IndexedIO *directory ) const;
+		/// Loads a tree previously saved with save(). The iterator range must
+		/// refer to the same bounds as were used to build the saved tree, and
+		/// an Exception is thrown if it is not the same length, or if the saved
+		/// nodes or indices are out of range. The tree is unchanged if an
+		/// Exception is thrown.
+		/// \threading This can't be called while other threads are
+		/// making queries.
+		void load( const IndexedIO *directory, BoundIterator first, BoundIterator last );
+		//@}
+
 		/// Populates the passed vector of iterators with the bounds which intersect "b". Returns the number of bounds found.
 		/// \threading May be called by multiple concurrent threads provided they each use a different vector for the result.
 		/// \todo There should be a form where nearNeighbours is an output iterator, to allow any container to be filled.
 		template<typename S>
 		unsigned int intersectingBounds( const S &b, std::vector<BoundIterator> &bounds ) const;
 
+		/// Returns the number of bounds in the tree.
+		inline size_t numBounds() const;
+		/// Returns a bound stored in the tree, where `i` is in the range
+		/// specified by Node::firstBound() and Node::lastBound().
+		inline const Bound &bound( size_t i ) const;
+		/// Returns the index of a bound within the range passed to init(),
+		/// where `i` is as for bound().
+		inline BoundIndex boundIndex( size_t i ) const;
+
 		/// Returns the number of nodes in the tree.
 		inline NodeIndex numNodes() const;
 
@@ -98,31 +138,40 @@ class BoundedKDTree
 		/// Returns the index for the root node
 		NodeIndex rootIndex() const;
 
-		/// Retrieve the index of the "low" child node
-		static NodeIndex lowChildIndex( NodeIndex index );
+		/// Retrieve the index of the "low" child node. Only valid
+		/// if the node is a branch.
+		inline NodeIndex lowChildIndex( NodeIndex index ) const;
 
-		/// Retrieve the index of the "high" child node
-		static NodeIndex highChildIndex( NodeIndex index );
+		/// Retrieve the index of the "high" child node. Only valid
+		/// if the node is a branch.
+		inline NodeIndex highChildIndex( NodeIndex index ) const;
 
 	private:
 
-		typedef std::vector<BoundIterator> Permutation;
-		typedef typename Permutation::iterator PermutationIterator;
-		typedef typename Permutation::const_iterator PermutationConstIterator;
+		typedef typename VectorTraits<BaseType>::BaseType ScalarType;
 
-		class AxisSort;
+		struct BuildBound
+		{
+			Bound bound;
+			BaseType center;
+			BoundIndex index;
+		};
 
-		unsigned char majorAxis( PermutationConstIterator permFirst, PermutationConstIterator permLast );
-		void build( NodeIndex nodeIndex, PermutationIterator permFirst, PermutationIterator permLast );
-		void bound( NodeIndex nodeIndex );
+		// Nodes are appended concurrently during building.
+		typedef tbb::concurrent_vector<Node> BuildNodes;
 
-		template<typename S>
-		void intersectingBoundsWalk( NodeIndex nodeIndex, const S &p, std::vector<BoundIterator> &bounds ) const;
+		static ScalarType halfArea( const Bound &b );
+
+		void build( BuildNodes &nodes, NodeIndex nodeIndex, BuildBound *first, BuildBound *last, const BuildBound *begin, unsigned depth );
+		BuildBound *split( BuildBound *first, BuildBound *last, const Bound &centerBound, unsigned depth, unsigned char &cutAxis ) const;
+		// Throws if the nodes refer to children or bounds which don't exist.
+		static void validateNodes( const NodeVector &nodes, size_t numBounds );
 
-		Permutation m_perm;
+		std::vector<Bound> m_bounds;
+		std::vector<BoundIndex> m_indices;
 		NodeVector m_nodes;
 		int m_maxLeafSize;
-		BoundIterator m_lastBound;
+		BoundIterator m_firstBound;
 };
 
 template<class BoundIterator>
@@ -135,9 +184,14 @@ class BoundedKDTree<BoundIterator>::Node
 
 		inline bool isLeaf() const;
 
-		inline BoundIterator *permFirst() const;
+		/// Returns the first bound contained by this Node, for use with
+		/// BoundedKDTree::bound() and BoundedKDTree::boundIndex(). Only
+		/// valid if isLeaf() is true.
+		inline size_t firstBound() const;
 
-		inline BoundIterator *permLast() const;
+		/// Returns one past the last bound contained by this Node. Only
+		/// valid if isLeaf() is true.
+		inline size_t lastBound() const;
 
 		inline bool isBranch() const;
 
@@ -149,23 +203,20 @@ class BoundedKDTree<BoundIterator>::Node
 
 		friend class BoundedKDTree<BoundIterator>;
 
-		inline void makeLeaf( PermutationIterator permFirst, PermutationIterator permLast );
-		inline void makeBranch( unsigned char cutAxis );
+		inline void makeLeaf( uint32_t first, uint32_t last );
+		inline void makeBranch( unsigned char cutAxis, uint32_t lowChild );
 
-		inline Bound &bound();
+		Bound m_bound;
 
-		unsigned char m_cutAxisAndLeaf;
+		// For leaves, the index of the first bound. For branches, the
+		// index of the low child, with the high child following it.
+		uint32_t m_index;
+		// For leaves, the number of bounds shifted left by 2 bits, with
+		// the low bits set to `leafFlag`. For branches, the cut axis.
+		uint32_t m_sizeAndAxis;
 
-		Bound m_bound;
+		static const uint32_t leafFlag = 3;
 
-		struct
-		{
-			/// \todo Could this be 0 for branch nodes? This could allow us to remove m_cutAxisAndLeaf.
-			BoundIterator *first;
-			/// \todo Could we just store an offset instead of last? If we limit the maxLeafSize to 255
-			/// then this could be a single byte instead of 8 bytes.
-			BoundIterator *last;
-		} m_perm;
 };
 
 typedef BoundedKDTree<std::vector<Imath::Box2f>::const_iterator> Box2fTree;
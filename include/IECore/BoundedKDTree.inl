@@ -33,82 +33,86 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "IECore/BoxOps.h"
+#include "IECore/Exception.h"
 #include "IECore/VectorOps.h"
 #include "IECore/VectorTraits.h"
 
+#include "boost/format.hpp"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_invoke.h"
+#include "tbb/task_arena.h"
+
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 
 namespace IECore
 {
 
-template<class BoundIterator>
-class BoundedKDTree<BoundIterator>::AxisSort
+namespace Detail
 {
-	public :
-		AxisSort( unsigned int axis ) : m_axis( axis )
-		{
-		}
 
-		bool operator() ( BoundIterator i, BoundIterator j )
-		{
-			return VectorTraits< BaseType >::get( boxCenter(*i), m_axis)
-				< VectorTraits< BaseType >::get( boxCenter(*j), m_axis);
-		}
-
-	private :
-		const unsigned int m_axis;
-};
+// Number of bins used to evaluate the surface area heuristic.
+static const int boundedKDTreeNumBins = 16;
+// Depth below which splits revert to the median, bounding the depth of
+// the tree for pathological distributions of bounds.
+static const unsigned boundedKDTreeMaxSAHDepth = 64;
+// Size of the stack used by flattened traversals. This exceeds the
+// maximum depth of any tree.
+static const size_t boundedKDTreeMaxStackSize = 128;
 
+} // namespace Detail
 
 template<class BoundIterator>
-BoundedKDTree<BoundIterator>::Node::Node() : m_cutAxisAndLeaf(0)
+BoundedKDTree<BoundIterator>::Node::Node() : m_index( 0 ), m_sizeAndAxis( leafFlag )
 {
 	BoxTraits<Bound>::makeEmpty( m_bound );
-	m_perm.first = nullptr;
-	m_perm.last = nullptr;
 }
 
 template<class BoundIterator>
-void BoundedKDTree<BoundIterator>::Node::makeLeaf( PermutationIterator permFirst, PermutationIterator permLast )
+void BoundedKDTree<BoundIterator>::Node::makeLeaf( uint32_t first, uint32_t last )
 {
-	m_cutAxisAndLeaf = 255;
-	m_perm.first = &(*permFirst);
-	m_perm.last = &(*permLast);
+	m_index = first;
+	m_sizeAndAxis = ( ( last - first ) << 2 ) | leafFlag;
 }
 
 template<class BoundIterator>
-void BoundedKDTree<BoundIterator>::Node::makeBranch( unsigned char cutAxis )
+void BoundedKDTree<BoundIterator>::Node::makeBranch( unsigned char cutAxis, uint32_t lowChild )
 {
-	m_cutAxisAndLeaf = cutAxis;
+	m_index = lowChild;
+	m_sizeAndAxis = cutAxis;
 }
 
 template<class BoundIterator>
 bool BoundedKDTree<BoundIterator>::Node::isLeaf() const
 {
-	return m_cutAxisAndLeaf==255;
+	return ( m_sizeAndAxis & leafFlag ) == leafFlag;
 }
 
 template<class BoundIterator>
-BoundIterator *BoundedKDTree<BoundIterator>::Node::permFirst() const
+size_t BoundedKDTree<BoundIterator>::Node::firstBound() const
 {
 	assert( isLeaf() );
 
-	return m_perm.first;
+	return m_index;
 }
 
 template<class BoundIterator>
-BoundIterator *BoundedKDTree<BoundIterator>::Node::permLast() const
+size_t BoundedKDTree<BoundIterator>::Node::lastBound() const
 {
 	assert( isLeaf() );
 
-	return m_perm.last;
+	return m_index + ( m_sizeAndAxis >> 2 );
 }
 
 template<class BoundIterator>
 bool BoundedKDTree<BoundIterator>::Node::isBranch() const
 {
-	return m_cutAxisAndLeaf!=255;
+	return !isLeaf();
 }
 
 template<class BoundIterator>
@@ -116,119 +120,193 @@ unsigned char BoundedKDTree<BoundIterator>::Node::cutAxis() const
 {
 	assert( isBranch() );
 
-	return m_cutAxisAndLeaf;
+	return m_sizeAndAxis;
 }
 
 template<class BoundIterator>
-typename BoundedKDTree<BoundIterator>::Bound &BoundedKDTree<BoundIterator>::Node::bound()
+const typename BoundedKDTree<BoundIterator>::Bound &BoundedKDTree<BoundIterator>::Node::bound() const
 {
 	return m_bound;
 }
 
 template<class BoundIterator>
-const typename BoundedKDTree<BoundIterator>::Bound &BoundedKDTree<BoundIterator>::Node::bound() const
+typename BoundedKDTree<BoundIterator>::ScalarType BoundedKDTree<BoundIterator>::halfArea( const Bound &b )
 {
-	return m_bound;
+	if( BoxTraits<Bound>::isEmpty( b ) )
+	{
+		return 0;
+	}
+
+	const BaseType size = boxSize( b );
+	const unsigned dimensions = VectorTraits<BaseType>::dimensions();
+	if( dimensions == 2 )
+	{
+		// Perimeter is the 2d equivalent of surface area.
+		return VectorTraits<BaseType>::get( size, 0 ) + VectorTraits<BaseType>::get( size, 1 );
+	}
+
+	ScalarType result = 0;
+	for( unsigned i = 0; i < dimensions; ++i )
+	{
+		for( unsigned j = i + 1; j < dimensions; ++j )
+		{
+			result += VectorTraits<BaseType>::get( size, i ) * VectorTraits<BaseType>::get( size, j );
+		}
+	}
+	return result;
 }
 
 template<class BoundIterator>
-unsigned char BoundedKDTree<BoundIterator>::majorAxis( PermutationConstIterator permFirst, PermutationConstIterator permLast )
+typename BoundedKDTree<BoundIterator>::BuildBound *BoundedKDTree<BoundIterator>::split( BuildBound *first, BuildBound *last, const Bound &centerBound, unsigned depth, unsigned char &cutAxis ) const
 {
-	BaseType min, max;
-	vecSetAll( min, std::numeric_limits<typename BaseType::BaseType>::max() );
-	vecSetAll( max, std::numeric_limits<typename BaseType::BaseType>::lowest() );
+	const int numBins = Detail::boundedKDTreeNumBins;
+	const size_t size = last - first;
 
-	for( PermutationConstIterator it=permFirst; it!=permLast; it++ )
+	const BaseType extent = boxSize( centerBound );
+	cutAxis = 0;
+	for( unsigned char i = 1; i < VectorTraits<BaseType>::dimensions(); ++i )
 	{
-		BaseType center = boxCenter(**it);
-
-		for( unsigned char i=0; i<VectorTraits<BaseType>::dimensions(); i++ )
+		if( VectorTraits<BaseType>::get( extent, i ) > VectorTraits<BaseType>::get( extent, cutAxis ) )
 		{
-			if( VectorTraits<BaseType>::get(center, i) < VectorTraits<BaseType>::get(min, i) )
-			{
-				VectorTraits<BaseType>::set(min, i, VectorTraits<BaseType>::get(center, i) );
-			}
-			if( VectorTraits<BaseType>::get(center, i) > VectorTraits<BaseType>::get(min, i) )
-			{
-				VectorTraits<BaseType>::set(max, i, VectorTraits<BaseType>::get(center, i) );
-			}
+			cutAxis = i;
 		}
+	}
 
+	if( !( VectorTraits<BaseType>::get( extent, cutAxis ) > 0 ) )
+	{
+		// All centers coincide, so no split can separate them. Divide
+		// the bounds in two to keep the leaves within m_maxLeafSize.
+		return first + size / 2;
 	}
-	unsigned char major = 0;
-	BaseType size;
-	vecSub( max, min, size );
-	for( unsigned char i=1; i<VectorTraits<BaseType>::dimensions(); i++ )
+
+	// Bin the centers along the axis of greatest extent, and choose the
+	// split between bins with the lowest surface area heuristic cost.
+	// Binning the other axes too gives marginally better trees, but at
+	// three times the cost.
+
+	const ScalarType axisMin = VectorTraits<BaseType>::get( BoxTraits<Bound>::min( centerBound ), cutAxis );
+	const ScalarType scale = numBins / VectorTraits<BaseType>::get( extent, cutAxis );
+	const unsigned char axis = cutAxis;
+
+	if( depth >= Detail::boundedKDTreeMaxSAHDepth || !std::isfinite( scale ) )
 	{
-		if( VectorTraits<BaseType>::get(size, i) > VectorTraits<BaseType>::get(size, major) )
-		{
-			major = i;
-		}
+		BuildBound *mid = first + size / 2;
+		std::nth_element(
+			first, mid, last,
+			[axis]( const BuildBound &a, const BuildBound &b ) {
+				return VectorTraits<BaseType>::get( a.center, axis ) < VectorTraits<BaseType>::get( b.center, axis );
+			}
+		);
+		return mid;
 	}
-	return major;
-}
 
-template<class BoundIterator>
-void BoundedKDTree<BoundIterator>::bound( NodeIndex nodeIndex  )
-{
-	assert( nodeIndex < m_nodes.size() );
+	auto binIndex = [&]( const BuildBound &b ) {
+		return std::min( numBins - 1, (int)( ( VectorTraits<BaseType>::get( b.center, axis ) - axisMin ) * scale ) );
+	};
 
-	Node &node = m_nodes[nodeIndex];
+	std::array<Bound, numBins> binBounds;
+	std::array<size_t, numBins> binCounts;
+	for( int i = 0; i < numBins; ++i )
+	{
+		BoxTraits<Bound>::makeEmpty( binBounds[i] );
+		binCounts[i] = 0;
+	}
 
-	assert( BoxTraits<Bound>::isEmpty( node.bound() ) );
+	for( const BuildBound *it = first; it != last; ++it )
+	{
+		const int bin = binIndex( *it );
+		boxExtend( binBounds[bin], it->bound );
+		binCounts[bin]++;
+	}
+
+	// Sweep from the high end to accumulate the cost of the bins
+	// above each split, then from the low end to find the best.
+
+	std::array<ScalarType, numBins> highCosts;
+	Bound accumulatedBound;
+	BoxTraits<Bound>::makeEmpty( accumulatedBound );
+	size_t accumulatedCount = 0;
+	for( int i = numBins - 1; i > 0; --i )
+	{
+		boxExtend( accumulatedBound, binBounds[i] );
+		accumulatedCount += binCounts[i];
+		highCosts[i] = halfArea( accumulatedBound ) * accumulatedCount;
+	}
 
-	if( node.isLeaf() )
+	ScalarType bestCost = std::numeric_limits<ScalarType>::max();
+	int bestBin = -1;
+	BoxTraits<Bound>::makeEmpty( accumulatedBound );
+	accumulatedCount = 0;
+	for( int i = 1; i < numBins; ++i )
 	{
-		BoundIterator *permLast = node.permLast();
-		for( BoundIterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		boxExtend( accumulatedBound, binBounds[i-1] );
+		accumulatedCount += binCounts[i-1];
+		if( accumulatedCount == 0 || accumulatedCount == size )
 		{
-			boxExtend( node.bound(), **perm );
+			continue;
+		}
+		const ScalarType cost = halfArea( accumulatedBound ) * accumulatedCount + highCosts[i];
+		if( cost < bestCost )
+		{
+			bestCost = cost;
+			bestBin = i;
 		}
 	}
-	else
-	{
-		assert( node.isBranch() );
 
-		assert( lowChildIndex( nodeIndex ) < m_nodes.size() );
-		assert( highChildIndex( nodeIndex ) < m_nodes.size() );
+	// The lowest and highest centers fall in the first and last bins,
+	// so there is always at least one valid split.
+	assert( bestBin != -1 );
 
-		bound( lowChildIndex( nodeIndex ) );
-		bound( highChildIndex( nodeIndex ) );
-		boxExtend( node.bound(), m_nodes[lowChildIndex( nodeIndex )].bound() );
-		boxExtend( node.bound(), m_nodes[highChildIndex( nodeIndex )].bound() );
-	}
+	return std::partition(
+		first, last,
+		[&]( const BuildBound &b ) {
+			return binIndex( b ) < bestBin;
+		}
+	);
 }
 
-
 template<class BoundIterator>
-void BoundedKDTree<BoundIterator>::build( NodeIndex nodeIndex, PermutationIterator permFirst, PermutationIterator permLast )
+void BoundedKDTree<BoundIterator>::build( BuildNodes &nodes, NodeIndex nodeIndex, BuildBound *first, BuildBound *last, const BuildBound *begin, unsigned depth )
 {
-	// make room for the new node
-	if( nodeIndex>=m_nodes.size() )
+	Node &node = nodes[nodeIndex];
+
+	Bound centerBound;
+	BoxTraits<Bound>::makeEmpty( centerBound );
+	for( const BuildBound *it = first; it != last; ++it )
 	{
-		m_nodes.resize( nodeIndex+1 );
+		boxExtend( node.m_bound, it->bound );
+		boxExtend( centerBound, it->center );
 	}
 
-	assert( nodeIndex < m_nodes.size() );
-
-	Node &node = m_nodes[nodeIndex];
-
-	if( permLast - permFirst > m_maxLeafSize )
+	const size_t size = last - first;
+	if( size <= (size_t)m_maxLeafSize )
 	{
-		unsigned int cutAxis = majorAxis( permFirst, permLast );
-		PermutationIterator permMid = permFirst  + (permLast - permFirst)/2;
-		std::nth_element( permFirst, permMid, permLast, AxisSort( cutAxis ) );
+		node.makeLeaf( first - begin, last - begin );
+		return;
+	}
+
+	unsigned char cutAxis;
+	BuildBound *mid = split( first, last, centerBound, depth, cutAxis );
 
-		// insert node
-		node.makeBranch( cutAxis );
+	// Allocate the children together, so that siblings are adjacent.
+	const NodeIndex lowChild = nodes.grow_by( 2 ) - nodes.begin();
+	node.makeBranch( cutAxis, lowChild );
 
-		build( lowChildIndex( nodeIndex ), permFirst, permMid );
-		build( highChildIndex( nodeIndex ), permMid, permLast );
+	// The children write to disjoint ranges of bounds and nodes,
+	// so can be built concurrently.
+	if( size > 4096 )
+	{
+		tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+		tbb::parallel_invoke(
+			[&] { build( nodes, lowChild, first, mid, begin, depth + 1 ); },
+			[&] { build( nodes, lowChild + 1, mid, last, begin, depth + 1 ); },
+			taskGroupContext
+		);
 	}
 	else
 	{
-		// leaf node
-		node.makeLeaf( permFirst, permLast );
+		build( nodes, lowChild, first, mid, begin, depth + 1 );
+		build( nodes, lowChild + 1, mid, last, begin, depth + 1 );
 	}
 }
 
@@ -246,19 +324,187 @@ BoundedKDTree<BoundIterator>::BoundedKDTree( BoundIterator first, BoundIterator
 template<class BoundIterator>
 void BoundedKDTree<BoundIterator>::init( BoundIterator first, BoundIterator last, int maxLeafSize )
 {
+	const size_t numBounds = last - first;
+	if( numBounds >= ( 1u << 30 ) )
+	{
+		throw Exception( "BoundedKDTree : Too many bounds" );
+	}
+
+	m_maxLeafSize = std::max( maxLeafSize, 1 );
+	m_firstBound = first;
+
+	std::vector<BuildBound> buildBounds( numBounds );
+
+	tbb::this_task_arena::isolate(
+		[&] {
+
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			tbb::parallel_for(
+				tbb::blocked_range<size_t>( 0, numBounds, 1024 ),
+				[&]( const tbb::blocked_range<size_t> &r )
+				{
+					for( size_t i = r.begin(); i != r.end(); ++i )
+					{
+						BuildBound &b = buildBounds[i];
+						b.bound = *(first + i);
+						b.center = boxCenter( b.bound );
+						b.index = i;
+					}
+				},
+				taskGroupContext
+			);
+
+			BuildNodes nodes( rootIndex() + 1 );
+			build( nodes, rootIndex(), buildBounds.data(), buildBounds.data() + numBounds, buildBounds.data(), 0 );
+			m_nodes.assign( nodes.begin(), nodes.end() );
+
+		}
+	);
+
+	m_bounds.resize( numBounds );
+	m_indices.resize( numBounds );
+	for( size_t i = 0; i < numBounds; ++i )
+	{
+		m_bounds[i] = buildBounds[i].bound;
+		m_indices[i] = buildBounds[i].index;
+	}
+}
+
+template<class BoundIterator>
+void BoundedKDTree<BoundIterator>::save( IndexedIO *directory ) const
+{
+	directory->write( "maxLeafSize", m_maxLeafSize );
+	directory->write( "nodeSize", (unsigned int)sizeof( Node ) );
+	directory->write( "nodes", reinterpret_cast<const char *>( m_nodes.data() ), m_nodes.size() * sizeof( Node ) );
+	directory->write( "indices", m_indices.data(), m_indices.size() );
+}
+
+template<class BoundIterator>
+void BoundedKDTree<BoundIterator>::load( const IndexedIO *directory, BoundIterator first, BoundIterator last )
+{
+	unsigned int nodeSize = 0;
+	directory->read( "nodeSize", nodeSize );
+	if( nodeSize != sizeof( Node ) )
+	{
+		throw Exception( "BoundedKDTree : Saved tree has incompatible node type" );
+	}
+
+	const size_t numBounds = last - first;
+	const size_t numIndices = directory->entry( "indices" ).arrayLength();
+	if( numIndices != numBounds )
+	{
+		throw Exception( boost::str( boost::format( "BoundedKDTree : Saved tree has %d bounds but %d were provided" ) % numIndices % numBounds ) );
+	}
+
+	int maxLeafSize = 0;
+	directory->read( "maxLeafSize", maxLeafSize );
+
+	const size_t numNodeBytes = directory->entry( "nodes" ).arrayLength();
+	if( numNodeBytes % sizeof( Node ) )
+	{
+		throw Exception( "BoundedKDTree : Saved tree has invalid nodes" );
+	}
+
+	NodeVector nodes( numNodeBytes / sizeof( Node ) );
+	char *nodeData = reinterpret_cast<char *>( nodes.data() );
+	directory->read( "nodes", nodeData, numNodeBytes );
+
+	std::vector<BoundIndex> indices( numIndices );
+	BoundIndex *indexData = indices.data();
+	directory->read( "indices", indexData, numIndices );
+
+	// Validate everything before modifying the tree, so that queries
+	// can't index outside the arrays, and so that a failed load leaves
+	// the tree unchanged.
+
+	std::vector<bool> indexUsed( numBounds, false );
+	for( size_t i = 0; i < numBounds; ++i )
+	{
+		if( indices[i] >= numBounds || indexUsed[indices[i]] )
+		{
+			throw Exception( "BoundedKDTree : Saved tree has invalid indices" );
+		}
+		indexUsed[indices[i]] = true;
+	}
+
+	validateNodes( nodes, numBounds );
+	if( nodes.empty() )
+	{
+		// Queries start from the root node, so we need one even when there
+		// are no bounds, just as `init()` always creates one.
+		nodes.resize( 1 );
+	}
+
 	m_maxLeafSize = maxLeafSize;
-	m_lastBound = last;
+	m_firstBound = first;
+	m_nodes.swap( nodes );
+	m_indices.swap( indices );
+	m_bounds.resize( numBounds );
+	for( size_t i = 0; i < numBounds; ++i )
+	{
+		m_bounds[i] = *(first + m_indices[i]);
+	}
+}
+
+template<class BoundIterator>
+void BoundedKDTree<BoundIterator>::validateNodes( const NodeVector &nodes, size_t numBounds )
+{
+	if( nodes.empty() && numBounds )
+	{
+		throw Exception( "BoundedKDTree : Saved tree has no nodes" );
+	}
 
-	m_perm.resize( last - first );
-	unsigned int i=0;
-	for( BoundIterator it=first; it!=last; it++ )
+	// Children are always allocated after their parent, so we can
+	// propagate depths in a single pass, and requiring it rules out
+	// cycles. Requiring that each node has at most one parent and a
+	// depth within the traversal stack keeps queries bounded too.
+	std::vector<unsigned> depths( nodes.size(), 0 );
+	std::vector<bool> hasParent( nodes.size(), false );
+	for( NodeIndex i = 0; i < nodes.size(); ++i )
 	{
-		m_perm[i++] = it;
+		const Node &node = nodes[i];
+		if( node.isLeaf() )
+		{
+			// Summed as size_t so that corrupt values can't wrap around.
+			if( (size_t)node.m_index + ( node.m_sizeAndAxis >> 2 ) > numBounds )
+			{
+				throw Exception( boost::str( boost::format( "BoundedKDTree : Saved tree has invalid bounds for node %d" ) % i ) );
+			}
+			continue;
+		}
+
+		const NodeIndex lowChild = node.m_index;
+		if(
+			node.m_sizeAndAxis >= VectorTraits<BaseType>::dimensions() ||
+			lowChild <= i || lowChild + 1 >= nodes.size() ||
+			hasParent[lowChild] || hasParent[lowChild+1] ||
+			depths[i] + 1 >= Detail::boundedKDTreeMaxStackSize
+		)
+		{
+			throw Exception( boost::str( boost::format( "BoundedKDTree : Saved tree has invalid children for node %d" ) % i ) );
+		}
+
+		hasParent[lowChild] = hasParent[lowChild+1] = true;
+		depths[lowChild] = depths[lowChild+1] = depths[i] + 1;
 	}
+}
+
+template<class BoundIterator>
+size_t BoundedKDTree<BoundIterator>::numBounds() const
+{
+	return m_bounds.size();
+}
+
+template<class BoundIterator>
+const typename BoundedKDTree<BoundIterator>::Bound &BoundedKDTree<BoundIterator>::bound( size_t i ) const
+{
+	return m_bounds[i];
+}
 
-	/// \todo Can we reserve() enough space for m_nodes before doing this?
-	build( rootIndex(), m_perm.begin(), m_perm.end() );
-	bound( rootIndex() );
+template<class BoundIterator>
+typename BoundedKDTree<BoundIterator>::BoundIndex BoundedKDTree<BoundIterator>::boundIndex( size_t i ) const
+{
+	return m_indices[i];
 }
 
 template<class BoundIterator>
@@ -270,7 +516,6 @@ typename BoundedKDTree<BoundIterator>::NodeIndex BoundedKDTree<BoundIterator>::n
 template<class BoundIterator>
 const typename BoundedKDTree<BoundIterator>::Node& BoundedKDTree<BoundIterator>::node( NodeIndex idx ) const
 {
-	assert( idx >= 0 );
 	assert( idx < m_nodes.size() );
 
 	return m_nodes[idx];
@@ -279,19 +524,23 @@ const typename BoundedKDTree<BoundIterator>::Node& BoundedKDTree<BoundIterator>:
 template<class BoundIterator>
 typename BoundedKDTree<BoundIterator>::NodeIndex BoundedKDTree<BoundIterator>::rootIndex() const
 {
-	return 1;
+	return 0;
 }
 
 template<class BoundIterator>
-typename BoundedKDTree<BoundIterator>::NodeIndex BoundedKDTree<BoundIterator>::lowChildIndex( NodeIndex index )
+typename BoundedKDTree<BoundIterator>::NodeIndex BoundedKDTree<BoundIterator>::lowChildIndex( NodeIndex index ) const
 {
-	return index * 2;
+	assert( m_nodes[index].isBranch() );
+
+	return m_nodes[index].m_index;
 }
 
 template<class BoundIterator>
-typename BoundedKDTree<BoundIterator>::NodeIndex BoundedKDTree<BoundIterator>::highChildIndex( NodeIndex index )
+typename BoundedKDTree<BoundIterator>::NodeIndex BoundedKDTree<BoundIterator>::highChildIndex( NodeIndex index ) const
 {
-	return index * 2 + 1;
+	assert( m_nodes[index].isBranch() );
+
+	return m_nodes[index].m_index + 1;
 }
 
 template<class BoundIterator>
@@ -300,42 +549,49 @@ unsigned int BoundedKDTree<BoundIterator>::intersectingBounds( const S &b, std::
 {
 	bounds.clear();
 
-	intersectingBoundsWalk(rootIndex(), b, bounds );
+	if( m_nodes.empty() || !boxIntersects( m_nodes[rootIndex()].bound(), b ) )
+	{
+		return 0;
+	}
+
+	// Walk the tree using an explicit stack rather than recursion. Children
+	// are tested before being pushed, so that only intersecting nodes are
+	// visited.
 
-	return bounds.size();
-}
+	std::array<NodeIndex, Detail::boundedKDTreeMaxStackSize> stack;
+	size_t stackSize = 0;
+	stack[stackSize++] = rootIndex();
 
-template<class BoundIterator>
-template<typename S>
-void BoundedKDTree<BoundIterator>::intersectingBoundsWalk(  NodeIndex nodeIndex, const S &b, std::vector<BoundIterator> &bounds ) const
-{
-	const Node &node = m_nodes[nodeIndex];
-	if( node.isLeaf() )
+	while( stackSize )
 	{
-		BoundIterator *permLast = node.permLast();
-		for( BoundIterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		const Node &node = m_nodes[stack[--stackSize]];
+		if( node.isLeaf() )
 		{
-			const Bound &bb = **perm;
-
-			if ( boxIntersects( bb, b ) )
+			const size_t lastBound = node.lastBound();
+			for( size_t i = node.firstBound(); i != lastBound; ++i )
 			{
-				bounds.push_back( *perm );
+				if( boxIntersects( m_bounds[i], b ) )
+				{
+					bounds.push_back( m_firstBound + m_indices[i] );
+				}
 			}
 		}
-	}
-	else
-	{
-		NodeIndex firstChild = highChildIndex( nodeIndex );
-		if ( boxIntersects( m_nodes[firstChild].bound(), b) )
-		{
-			intersectingBoundsWalk( firstChild, b, bounds );
-		}
-		NodeIndex secondChild = lowChildIndex( nodeIndex );
-		if ( boxIntersects( m_nodes[secondChild].bound(), b) )
+		else
 		{
-			intersectingBoundsWalk( secondChild, b, bounds );
+			assert( stackSize + 2 <= stack.size() );
+			const NodeIndex lowChild = node.m_index;
+			if( boxIntersects( m_nodes[lowChild].bound(), b ) )
+			{
+				stack[stackSize++] = lowChild;
+			}
+			if( boxIntersects( m_nodes[lowChild+1].bound(), b ) )
+			{
+				stack[stackSize++] = lowChild + 1;
+			}
 		}
 	}
+
+	return bounds.size();
 }
 
 } // namespace IECore
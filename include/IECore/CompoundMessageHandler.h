@@ -65,6 +65,8 @@ class IECORE_API CompoundMessageHandler : public MessageHandler
 		std::set<MessageHandlerPtr> handlers;
 
 		void handle( Level level, const std::string &context, const std::string &message ) override;
+		/// Returns the greatest of the maximum levels of the child handlers.
+		Level maximumLevel() const override;
 
 };
 
@@ -56,9 +56,16 @@ class IECORE_API FileIndexedIO : public StreamIndexedIO
 
 		/// Open or create an file at the given root location
 		/// options CompoundData and contain the following:
-		/// 	"compressor" : String [ 'blosclz' | 'lz4' | 'lz4hc' | 'snappy' | 'zlib']
+		/// 	"compressor" : String [ 'blosclz' | 'lz4' | 'lz4hc' | 'snappy' | 'zlib' | 'zstd' ]
 		///		"compressionLevel" : Int [ 0 = no compression, 9 = max compression ]
 		///		"maxCompressedBlockSize" : UInt [ size of compression block ]
+		///		"compressionPolicies" : CompoundData [ per-category overrides of the above, keyed by
+		///			'float' | 'integer' | 'string' | 'internedString'. Each is a CompoundData containing
+		///			any of "compressor", "compressionLevel", "shuffle" : String [ 'none' | 'byte' | 'bit' ]
+		///			and "typeSize" : Int [ 0 = size of the data elements ] ]
+		///		"indexCacheSize" : UInt64 [ when reading, the approximate number of bytes of index to keep in memory.
+		///			Directories stored in subindexes are paged in on demand, and evicted when not in use if
+		///			this is exceeded. 0 = unlimited ]
 		FileIndexedIO(const std::string &path, const IndexedIO::EntryIDList &root, IndexedIO::OpenMode mode, const CompoundData *options = nullptr);
 
 		~FileIndexedIO() override;
@@ -42,6 +42,7 @@
 #include <iostream>
 #include <iomanip>
 #include <array>
+#include <vector>
 
 namespace IECore
 {
@@ -134,6 +135,26 @@ IECORE_API void copy(const IndexedIO *src, IndexedIO *dst );
 /// This function is used for performance monitoring
 IECORE_API FileStats<size_t> parallelReadAll( const IndexedIO *src );
 
+/// The results of writing and reading a file using a particular set of
+/// IndexedIO options.
+struct CompressionBenchmark
+{
+	/// Size of the written file in bytes.
+	size_t fileSize;
+	/// Wall clock time in seconds to copy `src` into the file.
+	double writeTime;
+	/// Wall clock time in seconds to read the file with `parallelReadAll()`.
+	double readTime;
+};
+
+/// Copies 'src' to 'fileName' once for each of the `candidates` options
+/// (as passed to `IndexedIO::create()`), measuring the resulting file size
+/// and the time taken to write it and read it back. This is useful for
+/// choosing compression settings ( see StreamIndexedIO's "compressionPolicies"
+/// option ) for a representative sample file. The file is left containing the
+/// result of the last candidate.
+IECORE_API std::vector<CompressionBenchmark> benchmarkCompression( const IndexedIO *src, const std::string &fileName, const std::vector<ConstCompoundDataPtr> &candidates );
+
 template<typename T>
 inline std::ostream &operator <<( std::ostream &s, const FileStats<T> &stats)
 {
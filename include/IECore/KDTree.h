@@ -35,6 +35,7 @@
 #ifndef IE_CORE_KDTREE_H
 #define IE_CORE_KDTREE_H
 
+#include "IECore/Canceller.h"
 #include "IECore/Export.h"
 #include "IECore/VectorTraits.h"
 
@@ -47,6 +48,8 @@ IECORE_PUSH_DEFAULT_VISIBILITY
 #endif
 IECORE_POP_DEFAULT_VISIBILITY
 
+#include <cstdint>
+#include <limits>
 #include <set>
 #include <vector>
 
@@ -56,6 +59,11 @@ namespace IECore
 /// The KDTree class provides accelerated searching of pointsets. It is
 /// templated so that it can operate on a wide variety of datatypes, and uses
 /// the VectorTraits.h and VectorOps.h functionality to assist in this.
+///
+/// The tree keeps its own copy of the points, stored contiguously in the order
+/// of the leaves, along with the index of each point in the original range. This
+/// keeps the points visited by a query close together in memory, and allows the
+/// tree to be built in parallel. PointIterator must be a random access iterator.
 /// \ingroup mathGroup
 template<class PointIterator>
 class KDTree
@@ -68,6 +76,10 @@ class KDTree
 		class Node;
 		typedef std::vector<Node> NodeVector;
 		typedef typename NodeVector::size_type NodeIndex;
+		/// The index of a point within the range passed to init().
+		typedef uint32_t PointIndex;
+		/// Returned by the batch queries to signify that no point was found.
+		static constexpr PointIndex invalidPointIndex = std::numeric_limits<PointIndex>::max();
 
 		/// Constructs an unititialised tree - you must call init()
 		/// before using it.
@@ -82,6 +94,7 @@ class KDTree
 		/// Builds the tree for the specified points - the iterator range
 		/// must remain valid and unchanged as long as the tree is in use.
 		/// This method can be called again to rebuild the tree at any time.
+		/// Large trees are built in parallel.
 		/// \threading This can't be called while other threads are
 		/// making queries.
 		void init( PointIterator first, PointIterator last, int maxLeafSize=4  );
@@ -114,6 +127,40 @@ class KDTree
 		template<typename Box, typename OutputIterator>
 		void enclosedPoints( const Box &bound, OutputIterator it ) const;
 
+		/// \name Batch queries
+		/// These perform the equivalent single point query for every point in
+		/// the range [first, last), in parallel, and are considerably faster than
+		/// making the queries one at a time. Results are returned as indices into
+		/// the range of points passed to init(), which are more compact than
+		/// iterators and more convenient for transferring attributes.
+		/// \threading May be called by multiple concurrent threads provided they are
+		/// each using different vectors for the results.
+		////////////////////////////////////////////////////////////////////////
+		//@{
+		/// Fills `neighbours` with the index of the nearest neighbour to each query point.
+		template<typename QueryIterator>
+		void batchNearestNeighbour( QueryIterator first, QueryIterator last, std::vector<PointIndex> &neighbours, const Canceller *canceller = nullptr ) const;
+		/// Finds the neighbours closer than `r` to each query point. The neighbours of
+		/// query point `i` are stored in `neighbours`, in the range `[offsets[i], offsets[i+1])`.
+		template<typename QueryIterator>
+		void batchNearestNeighbours( QueryIterator first, QueryIterator last, BaseType r, std::vector<PointIndex> &neighbours, std::vector<size_t> &offsets, const Canceller *canceller = nullptr ) const;
+		/// Fills `neighbours` with the `numNeighbours` closest neighbours to each query point,
+		/// sorted with the closest first. The neighbours of query point `i` are stored at
+		/// `neighbours[i * numNeighbours]` onwards. If the tree contains fewer points than
+		/// `numNeighbours`, the remaining elements are filled with `invalidPointIndex`.
+		template<typename QueryIterator>
+		void batchNearestNNeighbours( QueryIterator first, QueryIterator last, unsigned int numNeighbours, std::vector<PointIndex> &neighbours, const Canceller *canceller = nullptr ) const;
+		//@}
+
+		/// Returns the number of points in the tree.
+		inline size_t numPoints() const;
+		/// Returns an iterator to a point stored in the tree, where `i` is in the
+		/// range specified by Node::firstPoint() and Node::lastPoint().
+		inline PointIterator point( size_t i ) const;
+		/// Returns the index of a point within the range passed to init(), where
+		/// `i` is as for point().
+		inline PointIndex pointIndex( size_t i ) const;
+
 		/// Returns the number of nodes in the tree.
 		inline NodeIndex numNodes() const;
 		/// Returns the specified Node of the tree. See rootIndex(), lowChildIndex() and highChildIndex() for
@@ -131,27 +178,41 @@ class KDTree
 
 	private :
 
-		typedef std::vector<PointIterator> Permutation;
-		typedef typename Permutation::iterator PermutationIterator;
-		typedef typename Permutation::const_iterator PermutationConstIterator;
+		struct BuildPoint
+		{
+			Point point;
+			PointIndex index;
+		};
 
-		class AxisSort;
+		// Pair of distance squared and index into m_points,
+		// used as the heap for nearestNNeighboursWalk().
+		typedef std::pair<BaseType, size_t> HeapEntry;
+		typedef std::vector<HeapEntry> Heap;
 
-		unsigned char majorAxis( PermutationConstIterator permFirst, PermutationConstIterator permLast );
-		void build( NodeIndex nodeIndex, PermutationIterator permFirst, PermutationIterator permLast );
+		unsigned char majorAxis( const BuildPoint *first, const BuildPoint *last ) const;
+		void build( NodeIndex nodeIndex, BuildPoint *first, BuildPoint *last, const BuildPoint *begin );
 
-		void nearestNeighbourWalk( NodeIndex nodeIndex, const Point &p, PointIterator &closestPoint, BaseType &distSquared ) const;
+		void nearestNeighbourWalk( NodeIndex nodeIndex, const Point &p, size_t &closestPoint, BaseType &distSquared ) const;
 
-		void nearestNeighboursWalk( NodeIndex nodeIndex, const Point &p, BaseType r2, std::vector<PointIterator> &nearNeighbours ) const;
+		template<typename F>
+		void nearestNeighboursWalk( NodeIndex nodeIndex, const Point &p, BaseType r2, F &&f ) const;
 
 		template<typename Box, typename OutputIterator>
 		void enclosedPointsWalk( NodeIndex nodeIndex, const Box &bound, OutputIterator it ) const;
 
-		void nearestNNeighboursWalk( NodeIndex nodeIndex, const Point &p, unsigned int numNeighbours, std::vector<Neighbour> &nearNeighbours, BaseType &maxDistSquared ) const;
+		void nearestNNeighboursWalk( NodeIndex nodeIndex, const Point &p, unsigned int numNeighbours, Heap &heap, BaseType &maxDistSquared ) const;
+		void nearestNNeighbours( const Point &p, unsigned int numNeighbours, Heap &heap ) const;
+
+		template<typename F>
+		static void parallelForBlocks( size_t size, size_t grainSize, const Canceller *canceller, F &&f );
 
-		Permutation m_perm;
+		// Points in leaf order.
+		std::vector<Point> m_points;
+		// Index of each point in m_points within the range passed to init().
+		std::vector<PointIndex> m_indices;
 		NodeVector m_nodes;
 		int m_maxLeafSize;
+		PointIterator m_firstPoint;
 		PointIterator m_lastPoint;
 
 };
@@ -164,12 +225,12 @@ class KDTree<PointIterator>::Node
 
 		/// Returns true if this is a leaf node of the tree.
 		inline bool isLeaf() const;
-		/// Returns a pointer to an iterator referencing the first
-		/// child of this Node. Only valid if isLeaf() is true.
-		inline PointIterator *permFirst() const;
-		/// Returns a pointer to an iterator referencing the last
-		/// child of this Node. Only valid if isLeaf() is true.
-		inline PointIterator *permLast() const;
+		/// Returns the first point contained by this Node, for use
+		/// with KDTree::point(). Only valid if isLeaf() is true.
+		inline size_t firstPoint() const;
+		/// Returns one past the last point contained by this Node, for
+		/// use with KDTree::point(). Only valid if isLeaf() is true.
+		inline size_t lastPoint() const;
 		/// Returns true if this is a branch node of the tree;
 		inline bool isBranch() const;
 		/// Returns the axis in which this node cuts the space. Only
@@ -183,18 +244,16 @@ class KDTree<PointIterator>::Node
 
 		friend class KDTree<PointIterator>;
 
-		inline void makeLeaf( PermutationIterator permFirst, PermutationIterator permLast );
+		inline void makeLeaf( PointIndex first, PointIndex last );
 		inline void makeBranch( unsigned char cutAxis, BaseType cutValue );
 
 		unsigned char m_cutAxisAndLeaf;
 		union {
 			BaseType m_cutValue;
 			struct {
-				PointIterator *first;
-				/// \todo Could we just store an offset instead of last? If we limit the maxLeafSize to 255
-				/// then this could be a single byte instead of 8 bytes.
-				PointIterator *last;
-			} m_perm;
+				PointIndex first;
+				PointIndex last;
+			} m_points;
 		};
 
 };
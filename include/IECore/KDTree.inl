@@ -33,9 +33,17 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "IECore/BoxOps.h"
+#include "IECore/Exception.h"
 #include "IECore/VectorOps.h"
 
+#include "tbb/blocked_range.h"
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_invoke.h"
+#include "tbb/task_arena.h"
+
 #include <algorithm>
+#include <numeric>
 
 namespace IECore
 {
@@ -47,15 +55,15 @@ inline bool KDTree<PointIterator>::Node::isLeaf() const
 }
 
 template<class PointIterator>
-inline PointIterator *KDTree<PointIterator>::Node::permFirst() const
+inline size_t KDTree<PointIterator>::Node::firstPoint() const
 {
-	return m_perm.first;
+	return m_points.first;
 }
 
 template<class PointIterator>
-inline PointIterator *KDTree<PointIterator>::Node::permLast() const
+inline size_t KDTree<PointIterator>::Node::lastPoint() const
 {
-	return m_perm.last;
+	return m_points.last;
 }
 
 template<class PointIterator>
@@ -77,11 +85,11 @@ inline typename KDTree<PointIterator>::BaseType KDTree<PointIterator>::Node::cut
 }
 
 template<class PointIterator>
-inline void KDTree<PointIterator>::Node::makeLeaf( PermutationIterator permFirst, PermutationIterator permLast )
+inline void KDTree<PointIterator>::Node::makeLeaf( PointIndex first, PointIndex last )
 {
 	m_cutAxisAndLeaf = 255;
-	m_perm.first = &(*permFirst);
-	m_perm.last = &(*permLast);
+	m_points.first = first;
+	m_points.last = last;
 }
 
 template<class PointIterator>
@@ -91,23 +99,6 @@ inline void KDTree<PointIterator>::Node::makeBranch( unsigned char cutAxis, Base
 	m_cutValue = cutValue;
 }
 
-template<class PointIterator>
-class KDTree<PointIterator>::AxisSort
-{
-	public :
-		AxisSort( unsigned int axis ) : m_axis( axis )
-		{
-		}
-
-		bool operator() ( PointIterator i, PointIterator j )
-		{
-			return (*i)[m_axis] < (*j)[m_axis];
-		}
-
-	private :
-		const unsigned int m_axis;
-};
-
 // initialisation
 
 template<class PointIterator>
@@ -124,38 +115,81 @@ KDTree<PointIterator>::KDTree( PointIterator first, PointIterator last, int maxL
 template<class PointIterator>
 void KDTree<PointIterator>::init( PointIterator first, PointIterator last, int maxLeafSize  )
 {
-	m_maxLeafSize = maxLeafSize;
+	const size_t numPoints = last - first;
+	if( numPoints >= invalidPointIndex )
+	{
+		throw Exception( "KDTree : Too many points" );
+	}
+
+	m_maxLeafSize = std::max( maxLeafSize, 1 );
+	m_firstPoint = first;
 	m_lastPoint = last;
-	m_perm.resize( last - first );
-	unsigned int i=0;
-	for( PointIterator it=first; it!=last; it++ )
+
+	std::vector<BuildPoint> buildPoints( numPoints );
+	parallelForBlocks(
+		numPoints, 1024, nullptr,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
+			{
+				buildPoints[i].point = *(first + i);
+				buildPoints[i].index = i;
+			}
+		}
+	);
+
+	// Each branch gives the larger half of its points to its high child,
+	// so the deepest node is the one with the highest index, found by
+	// following high children from the root.
+
+	NodeIndex maxNodeIndex = rootIndex();
+	for( size_t n = numPoints; n > (size_t)m_maxLeafSize; n -= n / 2 )
 	{
-		m_perm[i++] = it;
+		maxNodeIndex = highChildIndex( maxNodeIndex );
 	}
+	m_nodes.clear();
+	m_nodes.resize( maxNodeIndex + 1 );
 
-	/// \todo Can we reserve() enough space for m_nodes before doing this?
-	build( rootIndex(), m_perm.begin(), m_perm.end() );
+	tbb::this_task_arena::isolate(
+		[&] {
+			build( rootIndex(), buildPoints.data(), buildPoints.data() + numPoints, buildPoints.data() );
+		}
+	);
+
+	m_points.resize( numPoints );
+	m_indices.resize( numPoints );
+	parallelForBlocks(
+		numPoints, 1024, nullptr,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
+			{
+				m_points[i] = buildPoints[i].point;
+				m_indices[i] = buildPoints[i].index;
+			}
+		}
+	);
 }
 
 template<class PointIterator>
-unsigned char KDTree<PointIterator>::majorAxis( PermutationConstIterator permFirst, PermutationConstIterator permLast )
+unsigned char KDTree<PointIterator>::majorAxis( const BuildPoint *first, const BuildPoint *last ) const
 {
 	Point min, max;
 	for( unsigned char i=0; i<VectorTraits<Point>::dimensions(); i++ ) {
 		min[i] = std::numeric_limits<BaseType>::max();
 		max[i] = std::numeric_limits<BaseType>::lowest();
 	}
-	for( PermutationConstIterator it=permFirst; it!=permLast; it++ )
+	for( const BuildPoint *it=first; it!=last; it++ )
 	{
 		for( unsigned char i=0; i<VectorTraits<Point>::dimensions(); i++ )
 		{
-			if( (**it)[i] < min[i] )
+			if( it->point[i] < min[i] )
 			{
-				min[i] = (**it)[i];
+				min[i] = it->point[i];
 			}
-			if( (**it)[i] > max[i] )
+			if( it->point[i] > max[i] )
 			{
-				max[i] = (**it)[i];
+				max[i] = it->point[i];
 			}
 		}
 	}
@@ -172,50 +206,76 @@ unsigned char KDTree<PointIterator>::majorAxis( PermutationConstIterator permFir
 }
 
 template<class PointIterator>
-void KDTree<PointIterator>::build( NodeIndex nodeIndex, PermutationIterator permFirst, PermutationIterator permLast )
+void KDTree<PointIterator>::build( NodeIndex nodeIndex, BuildPoint *first, BuildPoint *last, const BuildPoint *begin )
 {
-	// make room for the new node
-	if( nodeIndex>=m_nodes.size() )
+	const size_t size = last - first;
+	if( size > (size_t)m_maxLeafSize )
 	{
-		m_nodes.resize( nodeIndex+1 );
-	}
+		const unsigned char cutAxis = majorAxis( first, last );
+		BuildPoint *mid = first + size / 2;
+		std::nth_element(
+			first, mid, last,
+			[cutAxis]( const BuildPoint &a, const BuildPoint &b ) {
+				return a.point[cutAxis] < b.point[cutAxis];
+			}
+		);
+		m_nodes[nodeIndex].makeBranch( cutAxis, mid->point[cutAxis] );
 
-	if( permLast - permFirst > m_maxLeafSize )
-	{
-		unsigned int cutAxis = majorAxis( permFirst, permLast );
-		PermutationIterator permMid = permFirst  + (permLast - permFirst)/2;
-		std::nth_element( permFirst, permMid, permLast, AxisSort( cutAxis ) );
-		BaseType cutValue = (**permMid)[cutAxis];
-		// insert node
-		m_nodes[nodeIndex].makeBranch( cutAxis, cutValue );
-
-		build( lowChildIndex( nodeIndex ), permFirst, permMid );
-		build( highChildIndex( nodeIndex ), permMid, permLast );
+		// The children write to disjoint ranges of points and nodes,
+		// so can be built concurrently.
+		if( size > 10000 )
+		{
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			tbb::parallel_invoke(
+				[&] { build( lowChildIndex( nodeIndex ), first, mid, begin ); },
+				[&] { build( highChildIndex( nodeIndex ), mid, last, begin ); },
+				taskGroupContext
+			);
+		}
+		else
+		{
+			build( lowChildIndex( nodeIndex ), first, mid, begin );
+			build( highChildIndex( nodeIndex ), mid, last, begin );
+		}
 	}
 	else
 	{
 		// leaf node
-		m_nodes[nodeIndex].makeLeaf( permFirst, permLast );
+		m_nodes[nodeIndex].makeLeaf( first - begin, last - begin );
 	}
 }
 
+template<class PointIterator>
+template<typename F>
+void KDTree<PointIterator>::parallelForBlocks( size_t size, size_t grainSize, const Canceller *canceller, F &&f )
+{
+	tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, size, grainSize ),
+		[&]( const tbb::blocked_range<size_t> &r )
+		{
+			Canceller::check( canceller );
+			f( r.begin(), r.end() );
+		},
+		taskGroupContext
+	);
+}
+
 // nearest neighbour searching
 
 template<class PointIterator>
 PointIterator KDTree<PointIterator>::nearestNeighbour( const Point &p ) const
 {
 	BaseType maxDistSquared = std::numeric_limits<BaseType>::max();
-	PointIterator closestPoint = m_lastPoint;
-	nearestNeighbourWalk( rootIndex(), p, closestPoint, maxDistSquared );
-	return closestPoint;
+	return nearestNeighbour( p, maxDistSquared );
 }
 
 template<class PointIterator>
 PointIterator KDTree<PointIterator>::nearestNeighbour( const Point &p, BaseType &distSquared ) const
 {
-	PointIterator closestPoint = m_lastPoint;
+	size_t closestPoint = m_points.size();
 	nearestNeighbourWalk( rootIndex(), p, closestPoint, distSquared );
-	return closestPoint;
+	return closestPoint < m_points.size() ? point( closestPoint ) : m_lastPoint;
 }
 
 template<class PointIterator>
@@ -223,7 +283,7 @@ unsigned int KDTree<PointIterator>::nearestNeighbours( const Point &p, BaseType
 {
 	nearNeighbours.clear();
 
-	nearestNeighboursWalk(rootIndex(), p, r*r, nearNeighbours );
+	nearestNeighboursWalk( rootIndex(), p, r*r, [&]( size_t i ) { nearNeighbours.push_back( point( i ) ); } );
 
 	return nearNeighbours.size();
 }
@@ -240,32 +300,147 @@ unsigned int KDTree<PointIterator>::nearestNNeighbours( const Point &p, unsigned
 {
 	nearNeighbours.clear();
 
+	Heap heap;
+	nearestNNeighbours( p, numNeighbours, heap );
+
+	nearNeighbours.reserve( heap.size() );
+	for( const auto &h : heap )
+	{
+		nearNeighbours.push_back( Neighbour( point( h.second ), h.first ) );
+	}
+
+	return nearNeighbours.size();
+}
+
+template<class PointIterator>
+void KDTree<PointIterator>::nearestNNeighbours( const Point &p, unsigned int numNeighbours, Heap &heap ) const
+{
+	heap.clear();
 	if( numNeighbours )
 	{
 		BaseType maxDistSquared = std::numeric_limits<BaseType>::max();
-		nearestNNeighboursWalk( rootIndex(), p, numNeighbours, nearNeighbours, maxDistSquared );
-		std::sort_heap( nearNeighbours.begin(), nearNeighbours.end() );
+		nearestNNeighboursWalk( rootIndex(), p, numNeighbours, heap, maxDistSquared );
+		std::sort_heap( heap.begin(), heap.end() );
 	}
+}
 
-	return nearNeighbours.size();
+// batch queries
+
+template<class PointIterator>
+template<typename QueryIterator>
+void KDTree<PointIterator>::batchNearestNeighbour( QueryIterator first, QueryIterator last, std::vector<PointIndex> &neighbours, const Canceller *canceller ) const
+{
+	const size_t numQueries = last - first;
+	neighbours.resize( numQueries );
+
+	parallelForBlocks(
+		numQueries, 256, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
+			{
+				BaseType distSquared = std::numeric_limits<BaseType>::max();
+				size_t closestPoint = m_points.size();
+				nearestNeighbourWalk( rootIndex(), *(first + i), closestPoint, distSquared );
+				neighbours[i] = closestPoint < m_points.size() ? m_indices[closestPoint] : invalidPointIndex;
+			}
+		}
+	);
+}
+
+template<class PointIterator>
+template<typename QueryIterator>
+void KDTree<PointIterator>::batchNearestNeighbours( QueryIterator first, QueryIterator last, BaseType r, std::vector<PointIndex> &neighbours, std::vector<size_t> &offsets, const Canceller *canceller ) const
+{
+	const size_t numQueries = last - first;
+	offsets.assign( numQueries + 1, 0 );
+
+	// Query in fixed size chunks, so that each chunk can collect its
+	// results without synchronisation, and then concatenate the results
+	// once we know where each chunk belongs.
+
+	const size_t chunkSize = 1024;
+	const size_t numChunks = ( numQueries + chunkSize - 1 ) / chunkSize;
+	std::vector<std::vector<PointIndex>> chunkNeighbours( numChunks );
+
+	const BaseType r2 = r * r;
+	parallelForBlocks(
+		numChunks, 1, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t c = begin; c != end; ++c )
+			{
+				std::vector<PointIndex> &result = chunkNeighbours[c];
+				for( size_t i = c * chunkSize, e = std::min( i + chunkSize, numQueries ); i != e; ++i )
+				{
+					const size_t size = result.size();
+					nearestNeighboursWalk( rootIndex(), *(first + i), r2, [&]( size_t j ) { result.push_back( m_indices[j] ); } );
+					offsets[i+1] = result.size() - size;
+				}
+			}
+		}
+	);
+
+	std::partial_sum( offsets.begin(), offsets.end(), offsets.begin() );
+	neighbours.resize( offsets.back() );
+
+	parallelForBlocks(
+		numChunks, 1, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t c = begin; c != end; ++c )
+			{
+				std::copy( chunkNeighbours[c].begin(), chunkNeighbours[c].end(), neighbours.begin() + offsets[c * chunkSize] );
+			}
+		}
+	);
 }
 
 template<class PointIterator>
-void KDTree<PointIterator>::nearestNeighbourWalk( NodeIndex nodeIndex, const Point &p, PointIterator &closestPoint, BaseType &distSquared ) const
+template<typename QueryIterator>
+void KDTree<PointIterator>::batchNearestNNeighbours( QueryIterator first, QueryIterator last, unsigned int numNeighbours, std::vector<PointIndex> &neighbours, const Canceller *canceller ) const
+{
+	const size_t numQueries = last - first;
+	neighbours.resize( numQueries * numNeighbours );
+
+	// Scratch space for the heap, reused for every query made
+	// by a thread.
+	tbb::enumerable_thread_specific<Heap> heaps;
+
+	parallelForBlocks(
+		numQueries, 256, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			Heap &heap = heaps.local();
+			for( size_t i = begin; i != end; ++i )
+			{
+				nearestNNeighbours( *(first + i), numNeighbours, heap );
+				PointIndex *result = neighbours.data() + i * numNeighbours;
+				for( size_t j = 0; j < numNeighbours; ++j )
+				{
+					result[j] = j < heap.size() ? m_indices[heap[j].second] : invalidPointIndex;
+				}
+			}
+		}
+	);
+}
+
+// tree walking
+
+template<class PointIterator>
+void KDTree<PointIterator>::nearestNeighbourWalk( NodeIndex nodeIndex, const Point &p, size_t &closestPoint, BaseType &distSquared ) const
 {
 	const Node &node = m_nodes[nodeIndex];
 	if( node.isLeaf() )
 	{
-		PointIterator *permLast = node.permLast();
-		for( PointIterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		for( size_t i = node.firstPoint(), e = node.lastPoint(); i != e; ++i )
 		{
-			const Point &pp = **perm;
-			BaseType dist2 = vecDistance2( p, pp );
+			BaseType dist2 = vecDistance2( p, m_points[i] );
 
 			if( dist2 < distSquared )
 			{
 				distSquared = dist2;
-				closestPoint = *perm;
+				closestPoint = i;
 			}
 		}
 	}
@@ -294,20 +469,19 @@ void KDTree<PointIterator>::nearestNeighbourWalk( NodeIndex nodeIndex, const Poi
 }
 
 template<class PointIterator>
-void KDTree<PointIterator>::nearestNeighboursWalk( NodeIndex nodeIndex, const Point &p, BaseType r2, std::vector<PointIterator> &nearNeighbours ) const
+template<typename F>
+void KDTree<PointIterator>::nearestNeighboursWalk( NodeIndex nodeIndex, const Point &p, BaseType r2, F &&f ) const
 {
 	const Node &node = m_nodes[nodeIndex];
 	if( node.isLeaf() )
 	{
-		PointIterator *permLast = node.permLast();
-		for( PointIterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		for( size_t i = node.firstPoint(), e = node.lastPoint(); i != e; ++i )
 		{
-			const Point &pp = **perm;
-			BaseType dist2 = vecDistance2( p, pp );
+			BaseType dist2 = vecDistance2( p, m_points[i] );
 
 			if (dist2 < r2 )
 			{
-				nearNeighbours.push_back( *perm );
+				f( i );
 			}
 		}
 	}
@@ -327,49 +501,42 @@ void KDTree<PointIterator>::nearestNeighboursWalk( NodeIndex nodeIndex, const Po
 			secondChild = highChildIndex( nodeIndex );
 		}
 
-		nearestNeighboursWalk( firstChild, p, r2, nearNeighbours );
+		nearestNeighboursWalk( firstChild, p, r2, f );
 		if( d*d < r2 )
 		{
-			nearestNeighboursWalk( secondChild, p, r2, nearNeighbours );
+			nearestNeighboursWalk( secondChild, p, r2, f );
 		}
 	}
 }
 
 template<class PointIterator>
-void KDTree<PointIterator>::nearestNNeighboursWalk( NodeIndex nodeIndex, const Point &p, unsigned int numNeighbours, std::vector<Neighbour> &nearNeighbours, BaseType &maxDistSquared ) const
+void KDTree<PointIterator>::nearestNNeighboursWalk( NodeIndex nodeIndex, const Point &p, unsigned int numNeighbours, Heap &heap, BaseType &maxDistSquared ) const
 {
 	const Node &node = m_nodes[nodeIndex];
 	if( node.isLeaf() )
 	{
-		PointIterator *permLast = node.permLast();
-		for( PointIterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		for( size_t i = node.firstPoint(), e = node.lastPoint(); i != e; ++i )
 		{
-			const Point &pp = **perm;
-			BaseType dist2 = vecDistance2( p, pp );
+			BaseType dist2 = vecDistance2( p, m_points[i] );
 
-			if( dist2 < maxDistSquared || nearNeighbours.size() < numNeighbours )
+			if( dist2 < maxDistSquared || heap.size() < numNeighbours )
 			{
-				Neighbour n( *perm, dist2 );
-				assert( nearNeighbours.size() <= numNeighbours );
+				assert( heap.size() <= numNeighbours );
 
-				if( nearNeighbours.size() == numNeighbours )
+				if( heap.size() == numNeighbours )
 				{
-					std::pop_heap( nearNeighbours.begin(), nearNeighbours.end() );
-					*(nearNeighbours.rbegin()) = n;
+					std::pop_heap( heap.begin(), heap.end() );
+					heap.back() = HeapEntry( dist2, i );
 				}
 				else
 				{
-					nearNeighbours.push_back( n );
+					heap.push_back( HeapEntry( dist2, i ) );
 				}
 
-				std::push_heap( nearNeighbours.begin(), nearNeighbours.end() );
-
-				assert( nearNeighbours.size() > 0 );
+				std::push_heap( heap.begin(), heap.end() );
 
 				// first element is furthest point away
-				typename std::vector<Neighbour>::const_iterator it = nearNeighbours.begin();
-				assert( it->distSquared >= nearNeighbours.rbegin()->distSquared );
-				maxDistSquared = it->distSquared;
+				maxDistSquared = heap.front().first;
 			}
 		}
 	}
@@ -389,10 +556,10 @@ void KDTree<PointIterator>::nearestNNeighboursWalk( NodeIndex nodeIndex, const P
 			secondChild = highChildIndex( nodeIndex );
 		}
 
-		nearestNNeighboursWalk( firstChild, p, numNeighbours, nearNeighbours, maxDistSquared );
-		if( d*d < maxDistSquared || nearNeighbours.size()<numNeighbours )
+		nearestNNeighboursWalk( firstChild, p, numNeighbours, heap, maxDistSquared );
+		if( d*d < maxDistSquared || heap.size()<numNeighbours )
 		{
-			nearestNNeighboursWalk( secondChild, p, numNeighbours, nearNeighbours, maxDistSquared );
+			nearestNNeighboursWalk( secondChild, p, numNeighbours, heap, maxDistSquared );
 		}
 	}
 }
@@ -405,13 +572,11 @@ void KDTree<PointIterator>::enclosedPointsWalk( NodeIndex nodeIndex, const Box &
 
 	if( node.isLeaf() )
 	{
-		PointIterator *permLast = node.permLast();
-		for( PointIterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		for( size_t i = node.firstPoint(), e = node.lastPoint(); i != e; ++i )
 		{
-			const Point &pp = **perm;
-			if( boxIntersects( bound, pp ) )
+			if( boxIntersects( bound, m_points[i] ) )
 			{
-				*it++ = *perm;
+				*it++ = point( i );
 			}
 		}
 	}
@@ -428,6 +593,24 @@ void KDTree<PointIterator>::enclosedPointsWalk( NodeIndex nodeIndex, const Box &
 	}
 }
 
+template<class PointIterator>
+inline size_t KDTree<PointIterator>::numPoints() const
+{
+	return m_points.size();
+}
+
+template<class PointIterator>
+inline PointIterator KDTree<PointIterator>::point( size_t i ) const
+{
+	return m_firstPoint + m_indices[i];
+}
+
+template<class PointIterator>
+inline typename KDTree<PointIterator>::PointIndex KDTree<PointIterator>::pointIndex( size_t i ) const
+{
+	return m_indices[i];
+}
+
 template<class PointIterator>
 inline typename KDTree<PointIterator>::NodeIndex KDTree<PointIterator>::numNodes() const
 {
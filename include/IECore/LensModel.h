@@ -47,6 +47,7 @@
 #include "boost/format.hpp"
 
 #include <map>
+#include <vector>
 
 namespace IECore
 {
@@ -73,8 +74,18 @@ IE_CORE_FORWARDDECLARE( LensModel );
 /// * Call validate() to validate the parameters and set up any internal state as necessary.
 /// * Call distort(), undistort() or bounds() as desired to query distorted UV values.
 ///
+/// When the same distortion is to be applied to many images, stMap() may be used to
+/// bake it into a dense lookup table, which is cached and shared between all models
+/// with identical parameter values. Baking calls distort() and undistort() concurrently
+/// from multiple threads, so derived classes must not modify any state in them.
+///
 class IECORE_API LensModel : public Parameterised
 {
+
+	private :
+
+		struct STMapCacheAccess;
+
 	public:
 
 		enum
@@ -115,6 +126,76 @@ class IECORE_API LensModel : public Parameterised
 		virtual Imath::V2d undistort( Imath::V2d p ) = 0;
 		//@}
 
+		//! @name ST-maps
+		/// Methods for baking the distortion into a lookup table, so that it can
+		/// be applied to many images without evaluating the model again.
+		//////////////////////////////////////////////////////////////
+		//@{
+		/// A dense table of distorted or undistorted UV positions, sampled at
+		/// the pixel corners of an image of a particular resolution.
+		class IECORE_API STMap : public RefCounted
+		{
+
+			public :
+
+				IE_CORE_DECLAREMEMBERPTR( STMap );
+
+				~STMap() override;
+
+				/// Distort or Undistort.
+				int mode() const;
+				/// The number of pixels the map was baked for. Samples are
+				/// taken at each pixel corner, so there are `resolution + 1`
+				/// samples along each axis.
+				const Imath::V2i &resolution() const;
+
+				/// Returns the sample at the pixel corner `( x, y )`, where
+				/// `( 0, 0 )` is the bottom left corner and `resolution()` is
+				/// the top right. These are exactly the values at
+				/// `uv = V2d( x, y ) / resolution()`, to within float precision.
+				Imath::V2d sample( int x, int y ) const;
+				/// Returns the bilinearly interpolated position for a point in
+				/// UV space. Points outside the 0-1 range are clamped to the edge
+				/// of the map, so the LensModel itself should be used for those.
+				Imath::V2d lookup( const Imath::V2d &uv ) const;
+
+				size_t memoryUsage() const;
+
+			private :
+
+				friend struct LensModel::STMapCacheAccess;
+
+				STMap( LensModel *lensModel, int mode, const Imath::V2i &resolution );
+
+				int m_mode;
+				Imath::V2i m_resolution;
+				// Offsets from the UV position of each sample, which keeps
+				// the precision of the model while storing floats.
+				std::vector<Imath::V2f> m_offsets;
+
+		};
+
+		/// Returns an STMap for the current parameter values. Maps are stored in
+		/// a process-wide cache keyed on the type of the model, its parameter values,
+		/// and the mode and resolution, so repeated calls with identical lens models
+		/// return the same map without evaluating the model again. Calls validate()
+		/// before looking up the map.
+		STMap::ConstPtr stMap( int mode, const Imath::V2i &resolution );
+		/// Returns the largest distance, in pixels, between `stMap->lookup()` and
+		/// this model, as measured at the centre of every pixel. This may be used
+		/// to choose a resolution which is accurate enough for a particular purpose.
+		/// The model is evaluated at every pixel, so this is as expensive as
+		/// building the map in the first place.
+		double stMapError( const STMap *stMap );
+
+		/// Limits the memory used by the process-wide cache of STMaps. The
+		/// initial limit is specified in megabytes by the
+		/// IECORE_LENSMODEL_STMAP_CACHE_MEMORY environment variable, and
+		/// defaults to 500.
+		static void setSTMapCacheMemoryLimit( size_t bytes );
+		static size_t getSTMapCacheMemoryLimit();
+		//@}
+
 		//! @name Lens Model Registry
 		/// A set of methods to query the available lens models and create them.
 		//////////////////////////////////////////////////////////////
@@ -69,6 +69,9 @@ class IECORE_API LevelFilteredMessageHandler : public FilteredMessageHandler
 		~LevelFilteredMessageHandler() override;
 
 		void handle( Level level, const std::string &context, const std::string &message ) override;
+		/// Returns the lesser of getLevel() and the maximum level of the
+		/// wrapped handler.
+		Level maximumLevel() const override;
 
 		MessageHandler::Level getLevel() const;
 		void setLevel( MessageHandler::Level level );
@@ -82,6 +82,12 @@ class IECORE_API MessageHandler : public RefCounted
 		static void output( Level level, const std::string &context, const std::string &message );
 		/// Output a message to the current handler.
 		static void output( Level level, const std::string &context, const boost::format &message );
+		/// Returns true if a message at the specified level may be output
+		/// by the current handler, and false if it would definitely be
+		/// discarded. This is cheap, and may be used to avoid the cost of
+		/// formatting messages which would be discarded anyway. See also the
+		/// IECORE_MSG macro.
+		static bool enabled( Level level );
 		//@}
 
 		//! @name Default handler
@@ -146,6 +152,12 @@ class IECORE_API MessageHandler : public RefCounted
 		/// should use MessageHandler::output() rather than call this directly.
 		virtual void handle( Level level, const std::string &context, const std::string &message ) = 0;
 
+		/// Returns the most verbose level which this handler might output. Messages
+		/// above this level are discarded by MessageHandler::output() without being passed
+		/// to handle(). The default implementation returns Invalid so that all messages are
+		/// passed through, and should be overridden by subclasses which filter messages by level.
+		virtual Level maximumLevel() const;
+
 };
 
 /// typedef for brevity.
@@ -158,4 +170,18 @@ IECORE_API void msg( MessageHandler::Level level, const std::string &context, co
 
 }; // namespace IECore
 
+/// Calls IECore::msg(), but only evaluates the message argument if the current handler
+/// might output it. This makes suppressed messages almost free, because the formatting
+/// is skipped entirely :
+///
+/// IECORE_MSG( Msg::Debug, "MyClass::myMethod", boost::format( "Processing %d items" ) % n );
+#define IECORE_MSG( LEVEL, CONTEXT, MESSAGE ) \
+	do \
+	{ \
+		if( IECore::MessageHandler::enabled( LEVEL ) ) \
+		{ \
+			IECore::msg( LEVEL, CONTEXT, MESSAGE ); \
+		} \
+	} while( false )
+
 #endif // IECORE_MESSAGEHANDLER_H
@@ -163,8 +163,10 @@ class IECORE_API Object : public RunTimeTyped
 		/// Throws an Exception if typeName is not a valid type.
 		static ObjectPtr create( const std::string &typeName );
 		/// Loads an object previously saved with the given name in the current directory
-		/// of ioInterface.
-		static ObjectPtr load( ConstIndexedIOPtr ioInterface, const IndexedIO::EntryID &name, const IECore::Canceller *canceller = nullptr );
+		/// of ioInterface. If parallel is true, the members of compound objects are loaded
+		/// concurrently, which can give significant speedups for objects with many large
+		/// members. Objects which were shared when saved remain shared in either case.
+		static ObjectPtr load( ConstIndexedIOPtr ioInterface, const IndexedIO::EntryID &name, const IECore::Canceller *canceller = nullptr, bool parallel = false );
 		//@}
 
 		typedef std::function<ObjectPtr ()> CreatorFn;
@@ -253,7 +255,8 @@ class IECORE_API Object : public RunTimeTyped
 		class IECORE_API LoadContext : public RefCounted
 		{
 			public :
-				LoadContext( ConstIndexedIOPtr ioInterface, const IECore::Canceller *canceller = nullptr );
+				/// If parallel is true, calls to parallelFor() will be executed concurrently.
+				LoadContext( ConstIndexedIOPtr ioInterface, const IECore::Canceller *canceller = nullptr, bool parallel = false );
 				/// Returns an interface to the container created by SaveContext::container().
 				/// @param typeName The typename of your class.
 				/// @param ioVersion On entry this should contain the current file format version
@@ -273,6 +276,15 @@ class IECORE_API Object : public RunTimeTyped
 				/// A canceller that will be triggered if this load should be cancelled
 				inline const Canceller *canceller();
 
+				/// Returns true if parallel loading was requested.
+				bool parallel() const;
+				/// Calls `f( i )` for each `i` in `[0, size)`, checking for cancellation
+				/// between calls. If parallel() is true, the calls are made concurrently
+				/// from multiple threads. This should be used by classes with many member
+				/// objects, so that the members can be read and decompressed in parallel.
+				/// It is safe to call load() from within `f`.
+				void parallelFor( size_t size, const std::function<void ( size_t )> &f );
+
 			private :
 				struct LoadedObjects;
 				LoadContext( ConstIndexedIOPtr ioInterface, std::shared_ptr<LoadedObjects> loadedObjects, const IECore::Canceller *canceller = nullptr );
@@ -51,7 +51,13 @@ class IECOREGL_API MeshPrimitive : public Primitive
 
 		IE_CORE_DECLARERUNTIMETYPEDEXTENSION( IECoreGL::MeshPrimitive, MeshPrimitiveTypeId, Primitive );
 
+		/// Constructs a mesh to be drawn with glDrawArrays(), using FaceVarying
+		/// primitive variables with one value per triangle vertex.
 		MeshPrimitive( unsigned numTriangles );
+		/// Constructs a mesh to be drawn with glDrawElements(), using Vertex
+		/// primitive variables indexed by `vertexIds`, with three ids per triangle.
+		/// Suitable for use with IECoreScene::MeshAlgo::triangulateIndexed().
+		MeshPrimitive( IECore::ConstIntVectorDataPtr vertexIds );
 		~MeshPrimitive() override;
 
 		Imath::Box3f bound() const override;
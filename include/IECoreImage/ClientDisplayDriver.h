@@ -46,9 +46,21 @@ namespace IECoreImage
 
 
 /// Connects to a DisplayDriverServer and forwards the image to the server using socket messages.
-/// This client class works synchronously.
+/// Buckets are queued by imageData() and sent from a background thread, so imageData() only blocks
+/// if the connection falls behind, and may be called concurrently from multiple threads. Errors
+/// encountered while sending are reported by the next call to imageData() or imageClose().
 /// It forwards all parameters to the server and also includes one called "clientPID" to help grouping AOVs from the same render.
 /// You must set the parameter 'remoteDisplayType' with a registered display driver to be instantiated in the server side.
+/// The optional StringData parameter 'displayCompression' may be used to compress buckets before sending them :
+///
+/// - "none" : Sends uncompressed 32 bit floats (the default).
+/// - "lossless" : Compresses 32 bit floats using lz4.
+/// - "half" : Converts to 16 bit floats before compressing using lz4.
+///
+/// Compression is only used if the server supports it, and otherwise the data is sent uncompressed.
+/// The optional BoolData parameter 'displaySharedMemory' may be used when the server is running on
+/// the same host, in which case buckets are passed via a shared memory ring buffer rather than
+/// through the socket. If the server can't open the shared memory, the socket is used instead.
 /// \ingroup renderingGroup
 class IECOREIMAGE_API ClientDisplayDriver : public DisplayDriver
 {
@@ -57,7 +69,8 @@ class IECOREIMAGE_API ClientDisplayDriver : public DisplayDriver
 		IE_CORE_DECLARERUNTIMETYPEDEXTENSION( ClientDisplayDriver, ClientDisplayDriverTypeId, DisplayDriver );
 
 		// Constructor.
-		// Expects two StringData parameters: displayHost and displayPort.
+		// Expects two StringData parameters: displayHost and displayPort, and
+		// optionally displayCompression and displaySharedMemory.
 		ClientDisplayDriver( const Imath::Box2i &displayWindow, const Imath::Box2i &dataWindow, const std::vector<std::string> &channelNames, IECore::ConstCompoundDataPtr parameters );
 
 		~ClientDisplayDriver() override;
@@ -68,6 +81,15 @@ class IECOREIMAGE_API ClientDisplayDriver : public DisplayDriver
 		// Get the port number or service name
 		std::string port() const;
 
+		// Returns true if shared memory was requested via displaySharedMemory
+		// and the server was able to open it.
+		bool sharedMemory() const;
+
+		// Returns the number of buckets passed to the server via shared memory
+		// so far. Buckets which don't fit in the ring buffer are sent through
+		// the socket instead.
+		size_t numSharedMemoryBuckets() const;
+
 		bool scanLineOrderOnly() const override;
 
 		bool acceptsRepeatedData() const override;
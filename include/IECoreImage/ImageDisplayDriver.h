@@ -43,11 +43,16 @@
 #include "IECoreImage/ImagePrimitive.h"
 #include "IECoreImage/TypeIds.h"
 
+#include <atomic>
+#include <mutex>
+
 namespace IECoreImage
 {
 
 /// Display driver that creates an ImagePrimitive object held
-/// in memory.
+/// in memory. The channels are allocated up front, and buckets
+/// are written directly into them, so imageData() may be called
+/// concurrently from many threads without locking.
 /// \ingroup renderingGroup
 class IECOREIMAGE_API ImageDisplayDriver : public DisplayDriver
 {
@@ -62,19 +67,28 @@ class IECOREIMAGE_API ImageDisplayDriver : public DisplayDriver
 
 		bool scanLineOrderOnly() const override;
 		bool acceptsRepeatedData() const override;
+		/// \threading May be called concurrently from multiple threads.
 		void imageData( const Imath::Box2i &box, const float *data, size_t dataSize ) override;
 		void imageClose() override;
 
 		/// Access to the image being created. This should always be valid for reading, even
-		/// before imageClose() has been called.
+		/// before imageClose() has been called. Buckets are written directly into this image
+		/// as they are received, so it must not be copied while data is still arriving - use
+		/// snapshot() instead.
 		ConstImagePrimitivePtr image() const;
+		/// Returns a copy of the image as it is now, which is unaffected by subsequent calls
+		/// to imageData(). The same copy is returned until more data is received, so polling
+		/// for updates is cheap. If called concurrently with imageData(), the copy may contain
+		/// partially received buckets.
+		ConstImagePrimitivePtr snapshot() const;
 
 		//! @name Image pool
 		/// It can be useful to store the images created by ImageDisplayDrivers for
 		/// later retrieval. Images can be stored by passing a StringData
 		/// "handle" parameter to the constructor or to the
 		/// DisplayDriver::create() method. The resulting image will then be
-		/// stored and can be retrieved using the methods below.
+		/// stored and can be retrieved using the methods below. Images retrieved
+		/// before imageClose() is called are snapshots of the data received so far.
 		///////////////////////////////////////////////////////////////////////
 		//@{
 		/// Returns the image stored with the specified handle, or 0 if no
@@ -89,7 +103,23 @@ class IECOREIMAGE_API ImageDisplayDriver : public DisplayDriver
 
 		static const DisplayDriverDescription<ImageDisplayDriver> g_description;
 
+		// Replaces our entry in the image pool with a final snapshot.
+		void storeFinalImage();
+
 		ImagePrimitivePtr m_image;
+		// Pointers to the channel data of `m_image`, in the order of `channelNames()`.
+		// We write through these rather than calling `writable()` for each bucket, so that
+		// buckets may be received concurrently, and never trigger a copy of the channel.
+		std::vector<float *> m_channelData;
+		// Incremented for every bucket received.
+		std::atomic<uint64_t> m_generation;
+
+		mutable std::mutex m_snapshotMutex;
+		mutable ConstImagePrimitivePtr m_snapshot;
+		mutable uint64_t m_snapshotGeneration;
+
+		// Handle for the image pool, or empty if not stored.
+		std::string m_handle;
 
 };
 
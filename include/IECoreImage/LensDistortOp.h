@@ -42,6 +42,7 @@
 #include "IECore/LensModel.h"
 #include "IECore/ObjectParameter.h"
 #include "IECore/RunTimeTyped.h"
+#include "IECore/SimpleTypedParameter.h"
 #include "IECore/VectorTypedData.h"
 
 namespace IECoreImage
@@ -66,6 +67,7 @@ class IECOREIMAGE_API LensDistortOp : public WarpOp
 
 		void begin( const IECore::CompoundObject * operands ) override;
 		Imath::Box2i warpedDataWindow( const Imath::Box2i &dataWindow ) const override;
+		IECore::ConstV2fVectorDataPtr computeWarpField( const Imath::Box2i &warpedDataWindow ) const override;
 		Imath::V2f warp( const Imath::V2f &p ) const override;
 		void end() override;
 
@@ -77,12 +79,21 @@ class IECOREIMAGE_API LensDistortOp : public WarpOp
 			kDistort = 1
 		};
 
+		// Returns the image space position for a pixel in the space
+		// of the lens model, where the origin is at the bottom left.
+		// The ST-map is used where it covers the pixel, and the lens
+		// model is evaluated directly elsewhere.
+		Imath::V2f distortedPosition( int x, int y, const IECore::LensModel::STMap *stMap = nullptr ) const;
+
 		int m_mode;
 		IECore::LensModelPtr m_lensModel;
 		IECore::ObjectParameterPtr m_lensParameter;
 		IECore::IntParameterPtr m_modeParameter;
+		IECore::BoolParameterPtr m_cacheSTMapParameter;
 		Imath::Box2i m_distortedDataWindow;
-		IECore::FloatVectorDataPtr m_cachePtr;
+		Imath::Box2i m_distortionSpaceWindow;
+		Imath::V2d m_displaySize;
+		Imath::V2d m_displayOrigin;
 };
 
 IE_CORE_DECLAREPTR( LensDistortOp );
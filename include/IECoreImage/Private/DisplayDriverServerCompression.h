@@ -0,0 +1,76 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2026, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef IECOREIMAGE_DISPLAYDRIVERSERVERCOMPRESSION
+#define IECOREIMAGE_DISPLAYDRIVERSERVERCOMPRESSION
+
+#include "IECore/Export.h"
+
+IECORE_PUSH_DEFAULT_VISIBILITY
+#include "OpenEXR/OpenEXRConfig.h"
+#if OPENEXR_VERSION_MAJOR < 3
+#include "OpenEXR/ImathBox.h"
+#else
+#include "Imath/ImathBox.h"
+#endif
+IECORE_POP_DEFAULT_VISIBILITY
+
+#include <vector>
+
+namespace IECoreImage
+{
+
+namespace DisplayDriverServerCompression
+{
+
+/* Payload of an imageDataCompressed message :
+* [0-15] - box containing the data ( Imath::Box2i )
+* [16] - format of the samples ( Float or Half )
+* [17-] - samples, compressed by Blosc using the lz4 codec.
+*/
+enum Format { Float = 0, Half = 1 };
+
+// Fills `buffer` with the payload for the interleaved samples of a bucket.
+void compress( const Imath::Box2i &box, const float *data, size_t dataSize, Format format, std::vector<char> &buffer );
+
+// Decompresses a payload containing `numChannels` interleaved channels into
+// `data`, returning the box containing it. Throws if the payload is invalid,
+// including if its size doesn't match the size of the box.
+Imath::Box2i decompress( const char *buffer, size_t bufferSize, size_t numChannels, std::vector<float> &data );
+
+} // namespace DisplayDriverServerCompression
+
+} // namespace IECoreImage
+
+#endif // IECOREIMAGE_DISPLAYDRIVERSERVERCOMPRESSION
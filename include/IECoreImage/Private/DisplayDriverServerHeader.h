@@ -44,16 +44,33 @@ namespace IECoreImage
 * 7 bytes long:
 * [0] - magic number ( 0x82 )
 * [1] - protocol version ( 1 )
-* [2] - message type ( imageOpen, imageData, imageClose )
+* [2] - message type ( imageOpen, imageData, imageDataCompressed, imageDataShared, imageClose )
 * [3-6] - length of following data block.
+*
+* Optional features are negotiated during imageOpen, so that clients and servers
+* which predate them continue to work together. A client requests them by adding
+* parameters to the imageOpen parameters :
+*
+* - `compressionParameter` : BoolData requesting imageDataCompressed messages,
+*   whose payload is described in DisplayDriverServerCompression.h.
+* - `sharedMemoryParameter` : StringData naming a shared memory segment, to be
+*   used by imageDataShared messages as described in DisplayDriverServerSharedMemory.h.
+*
+* If any feature was requested, a server which supports them replies to the
+* acceptsRepeatedData query with 3 bytes rather than 1. The second byte is 1 if
+* compression is supported, and the third is 1 if the shared memory segment was
+* opened successfully. Older servers reply with a single byte, and the client must
+* then fall back to sending imageData messages.
 */
 class DisplayDriverServerHeader
 {
 	public:
 
-		enum MessageType { imageOpen = 1, imageData = 2, imageClose = 3, exception = 4 };
+		enum MessageType { imageOpen = 1, imageData = 2, imageClose = 3, exception = 4, imageDataCompressed = 5, imageDataShared = 6 };
 
 		static const unsigned char headerLength = 7;
+		static const char *compressionParameter;
+		static const char *sharedMemoryParameter;
 		static const unsigned char magicNumber = 0x82;
 		static const unsigned char currentProtocolVersion = 2;
 
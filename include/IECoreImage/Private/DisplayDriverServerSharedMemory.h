@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2026, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef IECOREIMAGE_DISPLAYDRIVERSERVERSHAREDMEMORY
+#define IECOREIMAGE_DISPLAYDRIVERSERVERSHAREDMEMORY
+
+#include "IECore/Export.h"
+
+IECORE_PUSH_DEFAULT_VISIBILITY
+#include "OpenEXR/OpenEXRConfig.h"
+#if OPENEXR_VERSION_MAJOR < 3
+#include "OpenEXR/ImathBox.h"
+#else
+#include "Imath/ImathBox.h"
+#endif
+IECORE_POP_DEFAULT_VISIBILITY
+
+#include <atomic>
+#include <cstdint>
+
+namespace IECoreImage
+{
+
+namespace DisplayDriverServerSharedMemory
+{
+
+/* Layout of the shared memory segment created by a client on the same host
+* as the server. The segment starts with a SegmentHeader, followed at
+* `dataOffset` by a ring buffer of `capacity` bytes. The client copies each
+* bucket into the ring, and sends an imageDataShared message whose payload is
+* a Notification. The server passes the pixels to the display driver in place,
+* and then sets `consumed` to the end of the bucket, allowing the client to
+* reuse the space.
+*
+* Positions in the ring are byte counts since the start of the image, which
+* increase monotonically. The data for a position is at `position % capacity`,
+* and buckets never wrap around the end of the ring. Notifications are sent in
+* order of position, so the server always consumes the ring in order.
+*/
+
+struct SegmentHeader
+{
+	uint64_t magic;
+	uint64_t capacity;
+	// Written by the server once it has finished with a bucket.
+	std::atomic<uint64_t> consumed;
+	// Set by the server when it will no longer consume buckets, so
+	// that a client waiting for space can fail rather than hang.
+	std::atomic<uint32_t> closed;
+};
+
+static_assert( std::atomic<uint64_t>::is_always_lock_free, "Shared memory requires lock free atomics" );
+static_assert( std::atomic<uint32_t>::is_always_lock_free, "Shared memory requires lock free atomics" );
+
+const uint64_t magicNumber = 0x494543446973704dull;
+const size_t dataOffset = 64;
+static_assert( sizeof( SegmentHeader ) <= dataOffset, "SegmentHeader too large" );
+
+struct Notification
+{
+	Imath::Box2i box;
+	uint64_t position;
+	uint64_t numBytes;
+};
+
+} // namespace DisplayDriverServerSharedMemory
+
+} // namespace IECoreImage
+
+#endif // IECOREIMAGE_DISPLAYDRIVERSERVERSHAREDMEMORY
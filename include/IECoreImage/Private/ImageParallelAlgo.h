@@ -0,0 +1,221 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2026, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef IECOREIMAGE_IMAGEPARALLELALGO_H
+#define IECOREIMAGE_IMAGEPARALLELALGO_H
+
+#include "IECore/Export.h"
+
+IECORE_PUSH_DEFAULT_VISIBILITY
+#include "OpenEXR/OpenEXRConfig.h"
+#if OPENEXR_VERSION_MAJOR < 3
+#include "OpenEXR/ImathBox.h"
+#else
+#include "Imath/ImathBox.h"
+#endif
+IECORE_POP_DEFAULT_VISIBILITY
+
+#include "tbb/blocked_range.h"
+#include "tbb/blocked_range2d.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_reduce.h"
+#include "tbb/task_arena.h"
+
+#include <algorithm>
+
+namespace IECoreImage
+{
+
+/// Utilities for processing the channels of an ImagePrimitive in parallel.
+/// Channels are stored row by row covering the data window, so the pixel
+/// at `( x, y )` has index `( y - window.min.y ) * width + x - window.min.x`.
+namespace ImageParallelAlgo
+{
+
+/// Calls `f( yBegin, yEnd )` in parallel for bands of rows covering the
+/// window, where `yEnd` is exclusive. The pixels for a band are contiguous
+/// in the channel data.
+template<typename F>
+void parallelForRows( const Imath::Box2i &window, F &&f )
+{
+	if( window.isEmpty() )
+	{
+		return;
+	}
+
+	// Give each task at least a few thousand pixels.
+	const int width = window.size().x + 1;
+	const int grainSize = std::max( 1, 4096 / width );
+
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			tbb::parallel_for(
+				tbb::blocked_range<int>( window.min.y, window.max.y + 1, grainSize ),
+				[&]( const tbb::blocked_range<int> &rows )
+				{
+					f( rows.begin(), rows.end() );
+				},
+				taskGroupContext
+			);
+		}
+	);
+}
+
+/// Calls `f( tile )` in parallel for tiles covering the window, where
+/// `tile` is an inclusive box no larger than `tileSize` in either
+/// dimension.
+template<typename F>
+void parallelForTiles( const Imath::Box2i &window, F &&f, int tileSize = 64 )
+{
+	if( window.isEmpty() )
+	{
+		return;
+	}
+
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			tbb::parallel_for(
+				tbb::blocked_range2d<int>( window.min.y, window.max.y + 1, tileSize, window.min.x, window.max.x + 1, tileSize ),
+				[&]( const tbb::blocked_range2d<int> &range )
+				{
+					f(
+						Imath::Box2i(
+							Imath::V2i( range.cols().begin(), range.rows().begin() ),
+							Imath::V2i( range.cols().end() - 1, range.rows().end() - 1 )
+						)
+					);
+				},
+				taskGroupContext
+			);
+		}
+	);
+}
+
+/// Reduces over tiles covering the window in parallel, returning
+/// `reduce( f( tile1, identity ), f( tile2, identity ) ... )`. The
+/// order of reduction is unspecified.
+template<typename T, typename F, typename R>
+T parallelReduceTiles( const Imath::Box2i &window, const T &identity, F &&f, R &&reduce, int tileSize = 64 )
+{
+	if( window.isEmpty() )
+	{
+		return identity;
+	}
+
+	return tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			return tbb::parallel_reduce(
+				tbb::blocked_range2d<int>( window.min.y, window.max.y + 1, tileSize, window.min.x, window.max.x + 1, tileSize ),
+				identity,
+				[&]( const tbb::blocked_range2d<int> &range, const T &value )
+				{
+					return f(
+						Imath::Box2i(
+							Imath::V2i( range.cols().begin(), range.rows().begin() ),
+							Imath::V2i( range.cols().end() - 1, range.rows().end() - 1 )
+						),
+						value
+					);
+				},
+				reduce,
+				taskGroupContext
+			);
+		}
+	);
+}
+
+/// Replaces the `width * height` values in `data` with their summed area
+/// table, so that each value becomes the sum of all values above and to the
+/// left of it, inclusive. The result is identical to that of the obvious
+/// serial algorithm, as each value is accumulated in the same order.
+template<typename T>
+void summedAreaTable( T *data, int width, int height )
+{
+	if( width <= 0 || height <= 0 )
+	{
+		return;
+	}
+
+	// Prefix sum each row in parallel.
+	parallelForRows(
+		Imath::Box2i( Imath::V2i( 0 ), Imath::V2i( width - 1, height - 1 ) ),
+		[&]( int yBegin, int yEnd )
+		{
+			for( int y = yBegin; y < yEnd; ++y )
+			{
+				T *row = data + (size_t)y * width;
+				T sum = 0;
+				for( int x = 0; x < width; ++x )
+				{
+					sum += row[x];
+					row[x] = sum;
+				}
+			}
+		}
+	);
+
+	// Then accumulate down the columns, in parallel over strips
+	// of columns. The inner loop is over contiguous values, so
+	// vectorises well.
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			tbb::parallel_for(
+				tbb::blocked_range<int>( 0, width, 256 ),
+				[&]( const tbb::blocked_range<int> &columns )
+				{
+					for( int y = 1; y < height; ++y )
+					{
+						const T *above = data + (size_t)( y - 1 ) * width;
+						T *row = data + (size_t)y * width;
+						for( int x = columns.begin(); x < columns.end(); ++x )
+						{
+							row[x] += above[x];
+						}
+					}
+				},
+				taskGroupContext
+			);
+		}
+	);
+}
+
+} // namespace ImageParallelAlgo
+
+} // namespace IECoreImage
+
+#endif // IECOREIMAGE_IMAGEPARALLELALGO_H
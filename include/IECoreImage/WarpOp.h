@@ -40,6 +40,8 @@
 
 #include "IECore/ModifyOp.h"
 #include "IECore/NumericParameter.h"
+#include "IECore/ObjectParameter.h"
+#include "IECore/VectorTypedData.h"
 
 namespace IECoreImage
 {
@@ -49,6 +51,12 @@ namespace IECoreImage
 /// The display window does not change in this process, but the data window may change.
 /// The mapping is determined by the derived classes. The base class is responsible for resizing the
 /// data window and applying filter on the colors based on the floating point positions returned by warp method.
+///
+/// The input position for every output pixel is computed once per operation, in parallel, to form a
+/// "warp field" (also known as an ST-map). All channels are then resampled from this field in a single
+/// parallel pass. Because the field depends only on the warp and the data window, it may be retrieved
+/// with lastWarpField() and passed to the "warpField" parameter of subsequent operations to avoid
+/// recomputing it.
 /// \ingroup imageProcessingGroup
 class IECOREIMAGE_API WarpOp : public IECore::ModifyOp
 {
@@ -63,11 +71,18 @@ class IECOREIMAGE_API WarpOp : public IECore::ModifyOp
 		IECore::IntParameter *filterParameter();
 		const IECore::IntParameter *filterParameter() const;
 
+		IECore::ObjectParameter *warpFieldParameter();
+		const IECore::ObjectParameter *warpFieldParameter() const;
+
+		/// Returns the warp field used by the most recent operation, or
+		/// null if the Op has not been run.
+		IECore::ConstV2fVectorDataPtr lastWarpField() const;
+
 		IE_CORE_DECLARERUNTIMETYPEDEXTENSION( WarpOp, WarpOpTypeId, IECore::ModifyOp );
 
 	protected :
 
-		/// Implemented to call begin(), warpedDataWindow(), warp() and end(). Derived classes should implement those functions rather than
+		/// Implemented to call begin(), warpedDataWindow(), computeWarpField() and end(). Derived classes should implement those functions rather than
 		/// this function.
 		void modify( IECore::Object *object, const IECore::CompoundObject *operands ) override;
 
@@ -78,10 +93,16 @@ class IECOREIMAGE_API WarpOp : public IECore::ModifyOp
 		/// This function is called after begin() method. The input Box2i corresponds to the input image data window.
 		/// The default implementation returns the same data window as the original image.
 		virtual Imath::Box2i warpedDataWindow( const Imath::Box2i &dataWindow ) const;
+		/// Called after warpedDataWindow(), unless a field was supplied via the "warpField" parameter.
+		/// Must return the input position for every pixel of the warped data window, in scanline
+		/// order. The default implementation calls warp() for each pixel, in parallel. Derived classes
+		/// may reimplement it to compute or retrieve the field more efficiently.
+		virtual IECore::ConstV2fVectorDataPtr computeWarpField( const Imath::Box2i &warpedDataWindow ) const;
 		/// Called once per element (pixel for ImagePrimitives).
 		/// Must be implemented by subclasses to determine where the color will come from.
 		/// The returned coordinate is on pixel space of the input image and the given V2f coordinates are on the
 		/// output image pixel space.
+		/// \threading This is called concurrently from multiple threads.
 		virtual Imath::V2f warp( const Imath::V2f &p ) const = 0;
 		/// Called once per operation, after all calls to transform() have been made. This is
 		/// an opportunity to perform any cleanup necessary.
@@ -91,8 +112,8 @@ class IECOREIMAGE_API WarpOp : public IECore::ModifyOp
 
 		IECore::IntParameterPtr m_filterParameter;
 		IECore::IntParameterPtr m_boundModeParameter;
-		struct Warp;
-		friend struct Warp;
+		IECore::ObjectParameterPtr m_warpFieldParameter;
+		IECore::ConstV2fVectorDataPtr m_lastWarpField;
 };
 
 IE_CORE_DECLAREPTR( WarpOp );
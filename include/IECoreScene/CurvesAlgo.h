@@ -67,6 +67,12 @@ IECORESCENE_API std::vector<CurvesPrimitivePtr> segment( const CurvesPrimitive *
 /// Update the number of replicated end points based on the basis.
 IECORESCENE_API CurvesPrimitivePtr updateEndpointMultiplicity( const CurvesPrimitive *curves, const IECore::CubicBasisf& cubicBasis, const IECore::Canceller *canceller = nullptr  );
 
+/// Converts cubic curves to linear curves, using `verticesPerSegment` vertices to approximate each
+/// segment of the input. Vertex, Varying and FaceVarying primitive variables of type Float, Int, V3f
+/// and Color3f are evaluated at the new vertices, and other interpolated primitive variables are
+/// omitted with a warning. Linear curves are returned unchanged.
+IECORESCENE_API CurvesPrimitivePtr linearise( const CurvesPrimitive *curves, float verticesPerSegment, const IECore::Canceller *canceller = nullptr );
+
 } // namespace CurveAlgo
 
 } // namespace IECoreScene
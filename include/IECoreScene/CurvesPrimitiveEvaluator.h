@@ -39,7 +39,9 @@
 #include "IECoreScene/PrimitiveEvaluator.h"
 
 #include "IECore/BoundedKDTree.h"
+#include "IECore/Canceller.h"
 
+#include <atomic>
 #include <mutex>
 
 namespace IECoreScene
@@ -147,6 +149,38 @@ class IECORESCENE_API CurvesPrimitiveEvaluator : public PrimitiveEvaluator
 		/// Returns the length of the given curve from vStart to vEnd.
 		/// Returns 0.0f if inappropriate parameters are given.
 		float curveLength( unsigned curveIndex, float vStart=0.0f, float vEnd=1.0f ) const;
+		/// Returns the v parameter at which the length of the curve measured from
+		/// v=0 reaches `length`. Lengths outside the range [ 0, curveLength( curveIndex ) ]
+		/// are clamped. Uses a table of arc lengths which is built for all curves on first use.
+		float vAtLength( unsigned curveIndex, float length ) const;
+		//@}
+
+		//! @name Batch queries
+		/// These perform the equivalent single query for many curves or points at once,
+		/// in parallel, writing the results into separate arrays indexed in the same way
+		/// as the inputs. They are considerably faster than making the queries one at a
+		/// time with a Result. Invalid curve indices or v values throw an
+		/// InvalidArgumentException rather than returning false.
+		/// \threading May be called by multiple concurrent threads provided they are
+		/// each using different vectors for the results.
+		////////////////////////////////////////////////////////////////////////////////////////
+		//@{
+		/// Fills `positions` with the position at `v[i]` on curve `curveIndices[i]`, and
+		/// `tangents` with the equivalent of `Result::vTangent()` if it is non-null.
+		void pointsAtV( const std::vector<int> &curveIndices, const std::vector<float> &v, std::vector<Imath::V3f> &positions, std::vector<Imath::V3f> *tangents = nullptr, const IECore::Canceller *canceller = nullptr ) const;
+		/// Returns a VectorTypedData containing the value of `primVar` at each
+		/// `( curveIndices[i], v[i] )` pair. Supports the same types as the
+		/// `Result::*PrimVar()` methods, with the exception of strings.
+		IECore::DataPtr primVarAtV( const PrimitiveVariable &primVar, const std::vector<int> &curveIndices, const std::vector<float> &v, const IECore::Canceller *canceller = nullptr ) const;
+		/// Fills `curveIndices` and `v` with the closest point on the curves to each
+		/// of `points`. Returns false if there are no curves.
+		bool closestPoints( const std::vector<Imath::V3f> &points, std::vector<int> &curveIndices, std::vector<float> &v, const IECore::Canceller *canceller = nullptr ) const;
+		/// As for `vAtLength()`, converting `lengths[i]` on curve `curveIndices[i]`.
+		void vAtLengths( const std::vector<int> &curveIndices, const std::vector<float> &lengths, std::vector<float> &v, const IECore::Canceller *canceller = nullptr ) const;
+		/// Fills `curveIndices` and `v` with `samplesPerCurve` samples on every curve,
+		/// spaced at equal lengths along the curve, with the first at v=0 and the last
+		/// at v=1. The results may be passed directly to `pointsAtV()` or `primVarAtV()`.
+		void uniformLengthSamples( unsigned samplesPerCurve, std::vector<int> &curveIndices, std::vector<float> &v, const IECore::Canceller *canceller = nullptr ) const;
 		//@}
 
 		//! @name Topology access
@@ -178,6 +212,9 @@ class IECORESCENE_API CurvesPrimitiveEvaluator : public PrimitiveEvaluator
 
 		float integrateCurve( unsigned curveIndex, float vStart, float vEnd, int samples, Result& typedResult ) const;
 
+		template<typename F>
+		void parallelForQueries( const std::vector<int> &curveIndices, const std::vector<float> &v, const IECore::Canceller *canceller, F &&f ) const;
+
 		CurvesPrimitivePtr m_curvesPrimitive;
 		const std::vector<int> &m_verticesPerCurve;
 		std::vector<int> m_vertexDataOffsets; // one value per curve
@@ -185,7 +222,7 @@ class IECORESCENE_API CurvesPrimitiveEvaluator : public PrimitiveEvaluator
 		PrimitiveVariable m_p;
 
 		void buildTree();
-		bool m_haveTree;
+		std::atomic_bool m_haveTree;
 		typedef std::mutex TreeMutex;
 		TreeMutex m_treeMutex;
 		IECore::Box3fTree m_tree;
@@ -195,6 +232,17 @@ class IECORESCENE_API CurvesPrimitiveEvaluator : public PrimitiveEvaluator
 
 		void closestPointWalk( IECore::Box3fTree::NodeIndex nodeIndex, const Imath::V3f &p, unsigned &curveIndex, float &v, float &closestDistSquared ) const;
 
+		// Cumulative lengths sampled at uniform intervals in v, for use by vAtLength().
+		// The samples for curve `i` are in the range
+		// `[ m_arcLengthOffsets[i], m_arcLengthOffsets[i+1] )`.
+		void buildArcLengths();
+		unsigned arcLengthSamples( unsigned curveIndex ) const;
+		float vAtLengthInternal( unsigned curveIndex, float length ) const;
+		std::atomic_bool m_haveArcLengths;
+		std::mutex m_arcLengthMutex;
+		std::vector<int> m_arcLengthOffsets;
+		std::vector<float> m_arcLengths;
+
 };
 
 IE_CORE_DECLAREPTR( CurvesPrimitiveEvaluator );
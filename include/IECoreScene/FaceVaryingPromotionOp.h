@@ -75,10 +75,6 @@ class IECORESCENE_API FaceVaryingPromotionOp : public MeshPrimitiveOp
 
 		void modifyTypedPrimitive( MeshPrimitive *mesh, const IECore::CompoundObject *operands ) override;
 
-	private :
-
-		struct Promoter;
-
 };
 
 IE_CORE_DECLAREPTR( FaceVaryingPromotionOp );
@@ -41,6 +41,9 @@
 #include "IECoreScene/PointsPrimitive.h"
 #include "IECoreScene/PrimitiveVariable.h"
 
+#include <functional>
+#include <limits>
+#include <memory>
 #include <utility>
 
 namespace IECoreScene
@@ -80,6 +83,34 @@ IECORESCENE_API std::pair<PrimitiveVariable, PrimitiveVariable> calculateDistort
 
 IECORESCENE_API void resamplePrimitiveVariable( const MeshPrimitive *mesh, PrimitiveVariable& primitiveVariable, PrimitiveVariable::Interpolation interpolation, const IECore::Canceller *canceller = nullptr );
 
+/// Resamples primitive variables between interpolations, in the same way as resamplePrimitiveVariable().
+/// Using a class allows the tables mapping between interpolations to be computed once from the mesh
+/// topology, and then shared when resampling many primitive variables. Tables are computed on demand,
+/// and it is safe to call resample() concurrently from multiple threads.
+class IECORESCENE_API PrimitiveVariableResampler
+{
+public:
+
+	PrimitiveVariableResampler( ConstMeshPrimitivePtr mesh );
+	~PrimitiveVariableResampler();
+
+	// Equivalent to resamplePrimitiveVariable( mesh, primitiveVariable, interpolation, canceller )
+	void resample( PrimitiveVariable &primitiveVariable, PrimitiveVariable::Interpolation interpolation, const IECore::Canceller *canceller = nullptr ) const;
+
+	// Resamples several primitive variables to the same interpolation, processing them in parallel
+	void resample( std::vector<PrimitiveVariable> &primitiveVariables, PrimitiveVariable::Interpolation interpolation, const IECore::Canceller *canceller = nullptr ) const;
+
+private:
+
+	// Holds the original mesh
+	ConstMeshPrimitivePtr m_mesh;
+
+	// Mapping tables, computed lazily
+	struct Tables;
+	std::unique_ptr<Tables> m_tables;
+
+};
+
 /// create a new MeshPrimitive deleting faces from the input MeshPrimitive based on the facesToDelete uniform (int|float|bool) PrimitiveVariable
 /// When invert is set then zeros in facesToDelete indicate which faces should be deleted
 IECORESCENE_API MeshPrimitivePtr deleteFaces( const MeshPrimitive *meshPrimitive, const PrimitiveVariable &facesToDelete, bool invert = false, const IECore::Canceller *canceller = nullptr );
@@ -96,6 +127,49 @@ IECORESCENE_API void reorderVertices( MeshPrimitive *mesh, int id0, int id1, int
 /// vertex spacing, provided the UVs are well layed out.
 IECORESCENE_API PointsPrimitivePtr distributePoints( const MeshPrimitive *mesh, float density = 100.0, const Imath::V2f &offset = Imath::V2f( 0 ), const std::string &densityMask = "density", const std::string &uvSet = "uv", const std::string &position = "P", const IECore::Canceller *canceller = nullptr );
 
+/// Distributes points in the same way as distributePoints(). Using a class allows the preparation of
+/// the mesh ( triangulation, face areas, and a cumulative distribution of face area used to divide the
+/// work into balanced tasks ) to be done once and reused for many distributions, for instance on every
+/// frame of an animation. Points may also be streamed to a function in fixed size chunks rather than
+/// accumulated in a single PointsPrimitive. Points are always generated in the same order, so results
+/// are independent of the number of threads. It is safe to call distribute() concurrently from multiple
+/// threads.
+class IECORESCENE_API PointDistributor
+{
+public:
+
+	PointDistributor( const MeshPrimitive *mesh, const std::string &densityMask = "density", const std::string &uvSet = "uv", const std::string &position = "P", const IECore::Canceller *canceller = nullptr );
+	~PointDistributor();
+
+	// Called with consecutive chunks of points, in order. Calls are made serially,
+	// but not necessarily from the thread that called distribute().
+	using ChunkFunction = std::function<void ( const std::vector<Imath::V3f> &positions )>;
+
+	// Equivalent to distributePoints( mesh, density, offset, densityMask, uvSet, position, canceller ),
+	// with the following additions :
+	//
+	// - `maxPointsPerFace` caps the density on each triangle of the triangulated mesh, so that the
+	//   expected number of points on it is at most `maxPointsPerFace`. This guards against runaway point
+	//   counts on faces with tiny UVs or extreme density values. It is not a hard limit : because points
+	//   come from a fixed distribution in UV space, the actual count on a triangle may be slightly higher.
+	// - `positions` may be used to provide new Vertex positions with which to replace "P" on the mesh.
+	//   The points are still distributed using the UVs and areas computed in the constructor, so remain
+	//   stuck to the same place on the surface as it deforms.
+	PointsPrimitivePtr distribute( float density = 100.0, const Imath::V2f &offset = Imath::V2f( 0 ), float maxPointsPerFace = std::numeric_limits<float>::infinity(), const std::vector<Imath::V3f> *positions = nullptr, const IECore::Canceller *canceller = nullptr ) const;
+
+	// As above, but rather than returning the points, passes them to `chunkFunction` in chunks of
+	// `chunkSize` points, with only the last chunk being smaller. Memory usage is bounded regardless
+	// of the total number of points.
+	void distribute( const ChunkFunction &chunkFunction, size_t chunkSize, float density = 100.0, const Imath::V2f &offset = Imath::V2f( 0 ), float maxPointsPerFace = std::numeric_limits<float>::infinity(), const std::vector<Imath::V3f> *positions = nullptr, const IECore::Canceller *canceller = nullptr ) const;
+
+private:
+
+	// The triangulated mesh and associated tables
+	struct Tables;
+	std::unique_ptr<Tables> m_tables;
+
+};
+
 
 /// Split the input mesh in to N meshes based on the N unique values contained in a segment primitive variable.
 /// Using a class allows for the initialization work to be done once, and shared when actually splitting
@@ -130,6 +204,18 @@ public:
 	// calling mesh(), but slower than calling bound() if you already have the split mesh.
 	Imath::Box3f bound( int segmentId, const IECore::Canceller *canceller = nullptr ) const;
 
+	// Return the number of faces in one of the result meshes
+	inline int numFaces( int segmentId ) const;
+
+	// Return the result meshes for several segments at once. Equivalent to calling mesh() for each id, but
+	// the outputs are built in parallel, and each primitive variable is dispatched once for all outputs
+	// rather than once per output.
+	std::vector<MeshPrimitivePtr> meshes( const std::vector<int> &segmentIds, const IECore::Canceller *canceller = nullptr ) const;
+
+	// Return the bounds of all the result meshes, computed in parallel. Yields identical results to calling
+	// bound( i ) for i in range( numMeshes() ), but is considerably faster when there are many segments.
+	std::vector<Imath::Box3f> bounds( const IECore::Canceller *canceller = nullptr ) const;
+
 	// Used by the python binding, but otherwise shouldn't be necessary
 	const PrimitiveVariable &segmentPrimitiveVariable() const
 	{
@@ -138,6 +224,13 @@ public:
 
 private:
 
+	// Returns the range of m_faceRemap holding the faces for a segment, throwing if the id is invalid
+	inline void faceRange( int segmentId, int &startIndex, int &endIndex ) const;
+
+	// Builds the topology for one output mesh, filling vertRemapBackwards with the original vertex
+	// corresponding to each output vertex, and returning the number of face vertices
+	MeshPrimitivePtr meshTopology( int segmentId, std::vector<int> &vertRemapBackwards, int &totalFaceVerts, const IECore::Canceller *canceller ) const;
+
 	// Holds the original mesh
 	ConstMeshPrimitivePtr m_mesh;
 
@@ -168,6 +261,43 @@ IECORESCENE_API MeshPrimitivePtr merge( const std::vector<const MeshPrimitive *>
 /// Generate a new triangulated MeshPrimitive
 IECORESCENE_API MeshPrimitivePtr triangulate( const MeshPrimitive *mesh, const IECore::Canceller *canceller = nullptr );
 
+/// Generates a triangulated MeshPrimitive suitable for indexed drawing on the GPU.
+/// All Uniform, Varying and FaceVarying primitive variables are converted to Vertex
+/// interpolation, welding together the face-vertices which share both a vertex and
+/// the same value for every primitive variable. The vertex ids may then be used
+/// directly as a triangle index buffer, and each primitive variable as a vertex
+/// stream, without the expansion caused by promoting everything to FaceVarying.
+/// Constant primitive variables are passed through unchanged. Vertices which are
+/// not used by any face are removed, as are corners and creases.
+IECORESCENE_API MeshPrimitivePtr triangulateIndexed( const MeshPrimitive *mesh, const IECore::Canceller *canceller = nullptr );
+
+/// Vertex data interleaved into a single buffer of floats, for upload to the GPU
+/// as an alternative to using a separate buffer per primitive variable.
+struct IECORESCENE_API InterleavedVertexData
+{
+
+	struct Attribute
+	{
+		std::string name;
+		/// Offset to the first component, in floats from the start of each vertex.
+		size_t offset;
+		size_t numComponents;
+	};
+
+	std::vector<Attribute> attributes;
+	/// The number of floats per vertex.
+	size_t stride = 0;
+	IECore::FloatVectorDataPtr data;
+
+};
+
+/// Interleaves the Vertex primitive variables of a mesh, typically one returned by
+/// `triangulateIndexed()`. If `names` is empty then all Vertex primitive variables
+/// with float-based data are interleaved in name order, otherwise exactly those named
+/// are interleaved, in the order given. Throws if a named primitive variable does not
+/// exist, is not Vertex interpolated, or does not have float-based data.
+IECORESCENE_API InterleavedVertexData interleaveVertexData( const MeshPrimitive *mesh, const std::vector<std::string> &names = {}, const IECore::Canceller *canceller = nullptr );
+
 /// Generate a list of connected vertices per vertex
 /// The first vector contains a flat list of all the indices of the connected neighbor vertices.
 ///	The second one holds an offset index for every vertex. Note that the offset indices vector skips the first offset index (since it's 0)
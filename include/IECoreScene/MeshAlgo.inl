@@ -48,15 +48,31 @@ int MeshSplitter::numMeshes() const
 	return m_meshIndices.size();
 }
 
-template< typename T >
-typename std::vector<T>::const_reference IECoreScene::MeshAlgo::MeshSplitter::value( int segmentId ) const
+int MeshSplitter::numFaces( int segmentId ) const
+{
+	int startIndex, endIndex;
+	faceRange( segmentId, startIndex, endIndex );
+	return endIndex - startIndex;
+}
+
+void MeshSplitter::faceRange( int segmentId, int &startIndex, int &endIndex ) const
 {
-	if( segmentId < 0 || segmentId > (int)m_meshIndices.size() )
+	if( segmentId < 0 || segmentId >= (int)m_meshIndices.size() )
 	{
-		throw IECore::Exception( "Invalid mesh id " + std::to_string( segmentId ) );
+		throw IECore::Exception( "Invalid segment id " + std::to_string( segmentId ) );
 	}
 
-	int firstFace = m_meshIndices[ segmentId ];
+	// Based on our index, and the index of the next mesh in m_meshIndices, we know how many faces there are
+	startIndex = m_meshIndices[ segmentId ];
+	endIndex = ( segmentId + 1 < (int)m_meshIndices.size() ) ? m_meshIndices[ segmentId + 1 ] : m_faceRemap.size();
+}
+
+template< typename T >
+typename std::vector<T>::const_reference IECoreScene::MeshAlgo::MeshSplitter::value( int segmentId ) const
+{
+	int firstFace, endFace;
+	faceRange( segmentId, firstFace, endFace );
+
 	int originalFaceIndex = m_faceRemap[ firstFace ];
 	return PrimitiveVariable::IndexedView<T>( m_segmentPrimitiveVariable )[ originalFaceIndex ];
 }
@@ -38,19 +38,9 @@
 #include "IECoreScene/Export.h"
 #include "IECoreScene/TypeIds.h"
 
-#include "IECore/Export.h"
 #include "IECore/Reader.h"
 
-IECORE_PUSH_DEFAULT_VISIBILITY
-#include "OpenEXR/OpenEXRConfig.h"
-#if OPENEXR_VERSION_MAJOR < 3
-#include "OpenEXR/ImathVec.h"
-#else
-#include "Imath/ImathVec.h"
-#endif
-IECORE_POP_DEFAULT_VISIBILITY
-
-#include <vector>
+#include <functional>
 
 namespace IECoreScene
 {
@@ -59,6 +49,10 @@ IE_CORE_FORWARDDECLARE(MeshPrimitive);
 
 /// The OBJReader class defines a class for reading OBJ mesh data.
 /// This is a subset of the full setup of objects encodable in OBJ.
+///
+/// The file is memory mapped and split into chunks which are parsed
+/// in parallel, with vertex and face indices being merged in a
+/// second pass.
 /// \ingroup ioGroup
 class IECORESCENE_API OBJReader : public IECore::Reader
 {
@@ -70,6 +64,20 @@ class IECORESCENE_API OBJReader : public IECore::Reader
 
 		static bool canRead( const std::string &filename );
 
+		/// Function called by `readGroups()` for each mesh it produces.
+		using GroupFunction = std::function<void ( const std::string &groupName, MeshPrimitivePtr mesh )>;
+
+		/// Reads the file as a stream of meshes, one for each contiguous run
+		/// of faces following a `g` statement. The group name is the full text
+		/// following the statement, or "default" if none is given. Each mesh
+		/// contains only the vertices referenced by its faces, and is passed to
+		/// `groupFunction` on the calling thread as soon as its group ends. The
+		/// file is parsed in batches, so memory usage is bounded by the vertex
+		/// data and the largest group rather than by the size of the file. Groups
+		/// which refer to vertices defined later in the file are held back until
+		/// those vertices have been read.
+		void readGroups( const GroupFunction &groupFunction );
+
 	protected:
 
 		IECore::ObjectPtr doOperation( const IECore::CompoundObject * operands) override;
@@ -78,27 +86,6 @@ class IECORESCENE_API OBJReader : public IECore::Reader
 
 		static const ReaderDescription<OBJReader> m_readerDescription;
 
-		// top-level parse method
-		void parseOBJ();
-
-		// statement-level parse methods
-		void parseVertex(const char *, const char *);
-		void parseTextureCoordinate(const char *, const char *);
-		void parseNormal(const char *, const char *);
-
-		// elements
-		void parseFace(const char *, const char *);
-
-		// grouping
-		void parseGroup(const char *, const char *);
-
-		// pointers to mesh data
-		std::vector<int> *m_vpf, *m_vids;
-		std::vector<Imath::V3f> *m_vertices, *m_normals;
-		std::vector<float> *m_sTextureCoordinates, *m_tTextureCoordinates;
-
-		// local data for assembling mesh
-		std::vector<Imath::V3f> m_introducedNormals, m_introducedTextureCoordinates;
 };
 
 IE_CORE_DECLAREPTR(OBJReader);
@@ -139,6 +139,32 @@ class IECORESCENE_API SceneCache : public SampledSceneInterface
 		/// tells you if this scene cache is read only or writable:
 		bool readOnly() const;
 
+		/// Enables delta encoding for FloatVectorData and V3fVectorData primitive
+		/// variables written by subsequent calls to `writeObject()`. When enabled,
+		/// values which change between samples are stored relative to the previous
+		/// sample, which compresses much better for slowly deforming geometry. A full
+		/// sample is stored every `keyframeInterval` samples, to bound the cost of
+		/// reading a single sample. Child locations created subsequently inherit the
+		/// setting. An interval of 0 disables delta encoding, which is the default.
+		/// Decoding is transparent when reading, but files written with delta encoding
+		/// can't be read by earlier versions of Cortex.
+		void setObjectDeltaKeyframeInterval( unsigned keyframeInterval );
+		unsigned getObjectDeltaKeyframeInterval() const;
+
+		/// Enables lossy quantization of primitive variables written by subsequent
+		/// calls to `writeObject()`, for caches where reduced precision is acceptable.
+		/// V3fVectorData with Point or Vector interpretation and V2fVectorData with
+		/// UV interpretation are stored as 8 or 16 bit fixed point values relative to
+		/// their bounds, and V3fVectorData with Normal interpretation is stored using
+		/// octahedral encoding. The precision is chosen per primitive variable such
+		/// that each component is reconstructed to within `tolerance`, and data which
+		/// can't be represented to that accuracy in 16 bits is stored unmodified.
+		/// Quantized primitive variables are not delta encoded. Child locations created
+		/// subsequently inherit the setting. A tolerance of 0 disables quantization,
+		/// which is the default.
+		void setObjectQuantizationTolerance( float tolerance );
+		float getObjectQuantizationTolerance() const;
+
 		// The attribute names used to mark animated topology and primitive variables
 		// when SceneCache objects are Primitives.
 		static const Name &animatedObjectTopologyAttribute;
@@ -38,8 +38,21 @@
 #include "IECoreScene/PrimitiveVariable.h"
 #include "IECoreScene/CurvesPrimitive.h"
 
+#include "IECore/Canceller.h"
+#include "IECore/DataAlgo.h"
+#include "IECore/TypeTraits.h"
 #include "IECore/VectorTypedData.h"
 
+#include "boost/format.hpp"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <type_traits>
 #include <unordered_map>
 
 namespace IECoreScene
@@ -152,271 +165,415 @@ class IndexedPrimitiveVariableBuilder
 		std::unordered_map<int, int> m_indexMapping;
 };
 
-// Base type for all Functors which delete primivars
-template<typename U>
-class DeleteFlagged
-{
-	public:
-		DeleteFlagged( const PrimitiveVariable::IndexedView<U> &deleteFlagView, bool invert )
-			: m_deleteFlagView ( deleteFlagView ), m_dataIndices( nullptr ), m_invert( invert )
-		{
-		}
-
-		bool shouldKeepPrimitive( size_t i ) const
-		{
-			return ( m_invert && m_deleteFlagView[i] ) || ( !m_invert && !m_deleteFlagView[i] );
-		}
-
-		void setIndices( const IECore::TypedData<std::vector<int> > *dataIndices )
-		{
-			m_dataIndices = dataIndices ? &dataIndices->readable() : nullptr;
-		}
-
-	private:
-		const PrimitiveVariable::IndexedView<U> &m_deleteFlagView;
-
-	protected:
-		const std::vector<int> *m_dataIndices;
-		bool m_invert;
-};
+//////////////////////////////////////////////////////////////////////////
+// Parallel compaction. Used to implement the various `delete*()` algorithms,
+// by building lists of the source elements to be kept for each interpolation,
+// and then gathering all primitive variables from those lists concurrently.
+//////////////////////////////////////////////////////////////////////////
 
-/// Filter a primitive variable based on optionally indexed flag array
-/// Lifetime of flags, flagIndices & dataIndices should be longer than this functor.
-template<typename U>
-class DeleteFlaggedUniformFunctor : public DeleteFlagged<U>
+/// Calls `f( begin, end )` for blocks of the range [0, size), in parallel unless
+/// `parallel` is false, checking the canceller for each block.
+template<typename F>
+void parallelForBlocks( size_t size, const IECore::Canceller *canceller, F &&f, bool parallel = true )
 {
-	public:
+	if( !parallel )
+	{
+		IECore::Canceller::check( canceller );
+		f( 0, size );
+		return;
+	}
 
-		DeleteFlaggedUniformFunctor( const PrimitiveVariable::IndexedView<U> &deleteFlagView, bool invert ) : DeleteFlagged<U>( deleteFlagView, invert )
+	tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, size ),
+		[&]( const tbb::blocked_range<size_t> &r )
 		{
-		}
-
-		template<typename T, template<typename> class V>
-		IndexedData operator()( const V<std::vector<T> > *data )
+			IECore::Canceller::check( canceller );
+			f( r.begin(), r.end() );
+		},
+		taskGroupContext
+	);
+}
+
+/// Fills `offsets` with the exclusive prefix sum of `count( i )` for
+/// `i` in [0, size), returning the total.
+template<typename F>
+size_t exclusiveScan( size_t size, F &&count, std::vector<int> &offsets, const IECore::Canceller *canceller )
+{
+	offsets.resize( size );
+	return tbb::parallel_scan(
+		tbb::blocked_range<size_t>( 0, size ), size_t( 0 ),
+		[&]( const tbb::blocked_range<size_t> &r, size_t sum, bool isFinalScan )
 		{
-
-			const std::vector<T> &inputs = data->readable();
-			IECoreScene::PrimitiveVariable::IndexedView<T> dataView( inputs, this->m_dataIndices );
-
-			IndexedPrimitiveVariableBuilder<T, V> builder( inputs.size(), this->m_dataIndices ? this->m_dataIndices->size() : 0, data );
-
-			for( size_t i = 0; i < dataView.size(); ++i )
+			IECore::Canceller::check( canceller );
+			for( size_t i = r.begin(); i != r.end(); ++i )
 			{
-				if( this->shouldKeepPrimitive( i ) )
+				if( isFinalScan )
 				{
-					builder.addIndexedValue( dataView, i );
+					offsets[i] = sum;
 				}
+				sum += count( i );
 			}
+			return sum;
+		},
+		[]( size_t a, size_t b ) { return a + b; }
+	);
+}
+
+/// Returns the indices in [0, size) for which `keep( i )` is true, in order.
+template<typename F>
+std::vector<int> keptElements( size_t size, F &&keep, const IECore::Canceller *canceller )
+{
+	std::vector<int> offsets;
+	const size_t numKept = exclusiveScan( size, [&]( size_t i ) -> size_t { return keep( i ) ? 1 : 0; }, offsets, canceller );
 
-			return builder.indexedData();
-		}
-
-		IndexedData operator()( const IECore::Data *data )
+	std::vector<int> result( numKept );
+	parallelForBlocks(
+		size, canceller,
+		[&]( size_t begin, size_t end )
 		{
-			throw IECore::Exception(
-				boost::str( boost::format( "Unexpected Data: %1%" ) % ( data ? data->typeName() : std::string( "nullptr" ) ) )
-			);
+			for( size_t i = begin; i != end; ++i )
+			{
+				if( keep( i ) )
+				{
+					result[offsets[i]] = i;
+				}
+			}
 		}
+	);
 
-};
+	return result;
+}
 
-template<typename U>
-class DeleteFlaggedFaceVaryingFunctor : public DeleteFlagged<U>
+/// Given the kept primitives, returns the indices of the elements belonging to
+/// them, where each primitive `i` owns `count( i )` consecutive elements. Used to
+/// find the FaceVarying elements for kept faces, or the vertices for kept curves.
+template<typename F>
+std::vector<int> keptPrimitiveElements( const std::vector<int> &keptPrimitives, size_t numPrimitives, F &&count, const IECore::Canceller *canceller )
 {
-	public:
+	std::vector<int> sourceOffsets;
+	exclusiveScan( numPrimitives, count, sourceOffsets, canceller );
 
-		DeleteFlaggedFaceVaryingFunctor( const PrimitiveVariable::IndexedView<U> &deleteFlagView, IECore::ConstIntVectorDataPtr verticesPerPrimitive, bool invert )
-			: DeleteFlagged<U>( deleteFlagView, invert ), m_verticesPerPrimitive( verticesPerPrimitive )
-		{
-		}
+	std::vector<int> offsets;
+	const size_t numKept = exclusiveScan( keptPrimitives.size(), [&]( size_t i ) { return count( keptPrimitives[i] ); }, offsets, canceller );
 
-		template<typename T, template<typename> class V>
-		IndexedData operator()( const V<std::vector<T> > *data )
+	std::vector<int> result( numKept );
+	parallelForBlocks(
+		keptPrimitives.size(), canceller,
+		[&]( size_t begin, size_t end )
 		{
-			const std::vector<T> &inputs = data->readable();
-			const std::vector<int> &verticesPerPrimitive = m_verticesPerPrimitive->readable();
-
-			IECoreScene::PrimitiveVariable::IndexedView<T> dataView( inputs, this->m_dataIndices );
-			IndexedPrimitiveVariableBuilder<T, V> builder( inputs.size(), this->m_dataIndices ? this->m_dataIndices->size() : 0, data );
-
-			size_t offset = 0;
-			for( size_t c = 0; c < verticesPerPrimitive.size(); ++c )
+			for( size_t i = begin; i != end; ++i )
 			{
-				int numVerts = verticesPerPrimitive[c];
-				if( this->shouldKeepPrimitive( c ) )
+				const int primitive = keptPrimitives[i];
+				const int sourceOffset = sourceOffsets[primitive];
+				int *out = result.data() + offsets[i];
+				for( int j = 0, e = count( primitive ); j < e; ++j )
 				{
-					for( int v = 0; v < numVerts; ++v )
-					{
-						builder.addIndexedValue( dataView, offset + v );
-					}
+					out[j] = sourceOffset + j;
 				}
-				offset += numVerts;
 			}
-
-			return builder.indexedData();
 		}
+	);
+
+	return result;
+}
 
-		IndexedData operator()( const IECore::Data *data )
+/// Returns the indices of the vertices referenced by the kept face vertices, in order,
+/// and fills `remapping` with the new index for each original vertex, or -1 if it
+/// isn't used.
+inline std::vector<int> keptVertices( const std::vector<int> &keptFaceVertices, const std::vector<int> &vertexIds, size_t numVertices, std::vector<int> &remapping, const IECore::Canceller *canceller )
+{
+	// Value initialisation zeroes the flags.
+	std::vector<std::atomic<char>> used( numVertices );
+	parallelForBlocks(
+		keptFaceVertices.size(), canceller,
+		[&]( size_t begin, size_t end )
 		{
-			throw IECore::Exception(
-				boost::str( boost::format( "Unexpected Data: %1%" ) % ( data ? data->typeName() : std::string( "nullptr" ) ) )
-			);
+			for( size_t i = begin; i != end; ++i )
+			{
+				used[vertexIds[keptFaceVertices[i]]].store( 1, std::memory_order_relaxed );
+			}
 		}
+	);
 
-	private:
+	std::vector<int> result = keptElements( numVertices, [&]( size_t i ) { return used[i].load( std::memory_order_relaxed ); }, canceller );
 
-		IECore::ConstIntVectorDataPtr m_verticesPerPrimitive;
+	remapping.clear();
+	remapping.resize( numVertices, -1 );
+	parallelForBlocks(
+		result.size(), canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
+			{
+				remapping[result[i]] = i;
+			}
+		}
+	);
 
-};
+	return result;
+}
 
-template<typename U>
-class DeleteFlaggedVaryingFunctor : public DeleteFlagged<U>
+/// Returns a new primitive variable containing only the elements listed in `elements`.
+/// Indexed primitive variables remain indexed, with the data being compacted to remove
+/// unused values, ordered by first use.
+inline PrimitiveVariable compactPrimitiveVariable( const PrimitiveVariable &primitiveVariable, const std::vector<int> &elements, const IECore::Canceller *canceller )
 {
-	public:
-
-		DeleteFlaggedVaryingFunctor( const PrimitiveVariable::IndexedView<U> &deleteFlagView, const CurvesPrimitive *curvesPrimitive, bool invert )
-			: DeleteFlagged<U>( deleteFlagView, invert ), m_curvesPrimitive( curvesPrimitive )
+	return IECore::dispatch(
+		primitiveVariable.data.get(),
+		[&]( const auto *data ) -> PrimitiveVariable
 		{
-		}
+			using DataType = typename std::remove_const_t<std::remove_pointer_t<decltype( data )>>;
+			if constexpr( !IECore::TypeTraits::IsVectorTypedData<DataType>::value )
+			{
+				throw IECore::Exception(
+					boost::str( boost::format( "Unexpected Data: %1%" ) % data->typeName() )
+				);
+			}
+			else
+			{
+				using ValueType = typename DataType::ValueType::value_type;
+				// The packed storage of `std::vector<bool>` means it can't be written concurrently.
+				const bool parallel = !std::is_same_v<ValueType, bool>;
 
-		template<typename T, template<typename> class V>
-		IndexedData operator()( const V<std::vector<T> > *data )
-		{
-			const std::vector<T> &inputs = data->readable();
-			IECoreScene::PrimitiveVariable::IndexedView<T> dataView( inputs, this->m_dataIndices );
-			IndexedPrimitiveVariableBuilder<T, V> builder( inputs.size(), this->m_dataIndices ? this->m_dataIndices->size() : 0, data );
+				const auto &in = data->readable();
+				typename DataType::Ptr outData = new DataType;
+				if constexpr( IECore::TypeTraits::IsGeometricTypedData<DataType>::value )
+				{
+					outData->setInterpretation( data->getInterpretation() );
+				}
+				auto &out = outData->writable();
 
-			size_t offset = 0;
-			for( size_t c = 0; c < m_curvesPrimitive->numCurves(); ++c )
-			{
-				int numVarying = m_curvesPrimitive->numSegments( c ) + 1;
+				if( !primitiveVariable.indices )
+				{
+					out.resize( elements.size() );
+					parallelForBlocks(
+						elements.size(), canceller,
+						[&]( size_t begin, size_t end )
+						{
+							for( size_t i = begin; i != end; ++i )
+							{
+								out[i] = in[elements[i]];
+							}
+						},
+						parallel
+					);
+					return PrimitiveVariable( primitiveVariable.interpolation, outData );
+				}
 
-				if( this->shouldKeepPrimitive( c ) )
+				const std::vector<int> &indices = primitiveVariable.indices->readable();
+				if( elements.empty() )
 				{
-					for( int v = 0; v < numVarying; ++v )
+					return PrimitiveVariable( primitiveVariable.interpolation, outData );
+				}
+
+				IECore::IntVectorDataPtr outIndicesData = new IECore::IntVectorData;
+				std::vector<int> &outIndices = outIndicesData->writable();
+				outIndices.resize( elements.size() );
+
+				// Find the first output element referencing each value.
+
+				std::vector<std::atomic<int>> firstUse( in.size() );
+				parallelForBlocks(
+					in.size(), canceller,
+					[&]( size_t begin, size_t end )
 					{
-						builder.addIndexedValue( dataView, offset + v );
+						for( size_t i = begin; i != end; ++i )
+						{
+							firstUse[i].store( std::numeric_limits<int>::max(), std::memory_order_relaxed );
+						}
 					}
-				}
-				offset += numVarying;
-			}
+				);
 
-			return builder.indexedData();
-		}
+				parallelForBlocks(
+					elements.size(), canceller,
+					[&]( size_t begin, size_t end )
+					{
+						for( size_t i = begin; i != end; ++i )
+						{
+							std::atomic<int> &f = firstUse[indices[elements[i]]];
+							int current = f.load( std::memory_order_relaxed );
+							while( (int)i < current && !f.compare_exchange_weak( current, i, std::memory_order_relaxed ) )
+							{
+							}
+						}
+					}
+				);
 
-		IndexedData operator()( const IECore::Data *data )
-		{
-			throw IECore::Exception(
-				boost::str( boost::format( "Unexpected Data: %1%" ) % ( data ? data->typeName() : std::string( "nullptr" ) ) )
-			);
-		}
+				// Number the values in order of first use, and copy them
+				// to the output. We temporarily use `outIndices` to hold
+				// the new index for each first use.
 
-	private:
+				auto isFirstUse = [&]( size_t i ) -> size_t {
+					return firstUse[indices[elements[i]]].load( std::memory_order_relaxed ) == (int)i ? 1 : 0;
+				};
 
-		const CurvesPrimitive *m_curvesPrimitive;
-};
+				out.resize( exclusiveScan( elements.size(), isFirstUse, outIndices, canceller ) );
 
+				std::vector<int> remapping( in.size() );
+				parallelForBlocks(
+					elements.size(), canceller,
+					[&]( size_t begin, size_t end )
+					{
+						for( size_t i = begin; i != end; ++i )
+						{
+							if( isFirstUse( i ) )
+							{
+								const int index = indices[elements[i]];
+								remapping[index] = outIndices[i];
+								out[outIndices[i]] = in[index];
+							}
+						}
+					},
+					parallel
+				);
+
+				parallelForBlocks(
+					elements.size(), canceller,
+					[&]( size_t begin, size_t end )
+					{
+						for( size_t i = begin; i != end; ++i )
+						{
+							outIndices[i] = remapping[indices[elements[i]]];
+						}
+					}
+				);
 
-template<typename U>
-class DeleteFlaggedVertexFunctor : public DeleteFlagged<U>
+				return PrimitiveVariable( primitiveVariable.interpolation, outData, outIndicesData );
+			}
+		}
+	);
+}
+
+/// Compacts several primitive variables concurrently, using `elementsForInterpolation()`
+/// to choose the kept elements for each one. Returns a null pointer to indicate that
+/// the primitive variable should be copied as is.
+template<typename F>
+void compactPrimitiveVariables( const PrimitiveVariableMap &in, PrimitiveVariableMap &out, F &&elementsForInterpolation, const IECore::Canceller *canceller )
 {
-	public:
+	std::vector<PrimitiveVariableMap::const_iterator> inputs;
+	for( auto it = in.begin(); it != in.end(); ++it )
+	{
+		inputs.push_back( it );
+	}
 
-		DeleteFlaggedVertexFunctor(
-			size_t maxVertexId,
-			IECore::ConstIntVectorDataPtr vertexIdsData,
-			IECore::ConstIntVectorDataPtr verticesPerFaceData,
-			const PrimitiveVariable::IndexedView<U> &deleteFlagView,
-			bool invert
-		) :  DeleteFlagged<U>( deleteFlagView, invert), m_verticesPerFaceData( verticesPerFaceData ), m_vertexIdsData( vertexIdsData )
+	std::vector<PrimitiveVariable> results( inputs.size() );
+	tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, inputs.size(), 1 ),
+		[&]( const tbb::blocked_range<size_t> &r )
 		{
-			const std::vector<int> *vertexIds = nullptr;
-			if( m_vertexIdsData )
+			for( size_t i = r.begin(); i != r.end(); ++i )
 			{
-				vertexIds = &m_vertexIdsData->readable();
+				const PrimitiveVariable &primitiveVariable = inputs[i]->second;
+				const std::vector<int> *elements = elementsForInterpolation( primitiveVariable.interpolation );
+				results[i] = elements ? compactPrimitiveVariable( primitiveVariable, *elements, canceller ) : primitiveVariable;
 			}
-			const std::vector<int> &verticesPerFace = m_verticesPerFaceData->readable();
+		},
+		taskGroupContext
+	);
 
-			m_usedVerticesData = new IECore::BoolVectorData();
-			std::vector<bool> &usedVertices = m_usedVerticesData->writable();
+	for( size_t i = 0; i < inputs.size(); ++i )
+	{
+		out[inputs[i]->first] = results[i];
+	}
+}
 
-			usedVertices.resize( maxVertexId, false );
+//////////////////////////////////////////////////////////////////////////
+// Parallel resampling. Used to implement `resamplePrimitiveVariable()` for
+// the various primitive types, using mapping tables computed from the
+// topology.
+//////////////////////////////////////////////////////////////////////////
 
-			size_t index = 0;
-			size_t offset = 0;
-			for( size_t f = 0; f < verticesPerFace.size(); ++f )
+/// Fills `out` with `in[indices[i]]` for each index.
+template<typename T>
+void gatherElements( const std::vector<int> &indices, const std::vector<T> &in, std::vector<T> &out, const IECore::Canceller *canceller )
+{
+	out.resize( indices.size() );
+	parallelForBlocks(
+		indices.size(), canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
 			{
-				int numVerts = verticesPerFace[f];
-
-				if( this->shouldKeepPrimitive( f ) )
-				{
-					for( int v = 0; v < numVerts; ++v )
-					{
-						index = vertexIds ? (*vertexIds)[offset + v] : offset + v;
-						usedVertices[index] = true;
-					}
-				}
-				offset += numVerts;
+				out[i] = in[indices[i]];
 			}
-
-			m_remappingData = new IECore::IntVectorData();
-			std::vector<int> &remapping = m_remappingData->writable();
-
-			// again this array is too large but large enough
-			remapping.resize( maxVertexId, -1 );
-
-			size_t newIndex = 0;
-			for( size_t i = 0; i < usedVertices.size(); ++i )
+		},
+		// The packed storage of `std::vector<bool>` means it can't be written concurrently.
+		!std::is_same_v<T, bool>
+	);
+}
+
+/// Fills `out` with the average of `in[source( j )]` for `j` in the range
+/// `[offsets[i], offsets[i+1])`, or with zero if the range is empty.
+template<typename T, typename F>
+void averageElements( const std::vector<int> &offsets, F &&source, const std::vector<T> &in, std::vector<T> &out, const IECore::Canceller *canceller )
+{
+	const size_t size = offsets.empty() ? 0 : offsets.size() - 1;
+	out.resize( size );
+	parallelForBlocks(
+		size, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
 			{
-				if( usedVertices[i] )
+				const int first = offsets[i];
+				const int last = offsets[i+1];
+				if( first == last )
 				{
-					remapping[i] = newIndex;
-					newIndex++;
+					out[i] = T( 0 );
+					continue;
 				}
-			}
-		}
-
-		template<typename T, template<typename> class V>
-		IndexedData operator()(const V<std::vector<T> > *data )
-		{
-			const std::vector<bool> &usedVertices = m_usedVerticesData->readable();
-			const std::vector<T> &vertices = data->readable();
-
-			IndexedPrimitiveVariableBuilder<T, V> builder( vertices.size(), this->m_dataIndices ? this->m_dataIndices->size() : 0, data );
-			IECoreScene::PrimitiveVariable::IndexedView<T> dataView( vertices, this->m_dataIndices );
 
-			for( size_t v = 0; v < dataView.size(); ++v )
-			{
-				if( usedVertices[v] )
+				// initialize with the first value to avoid
+				// ambiguity during default construction
+				T total = in[source( first )];
+				for( int j = first + 1; j < last; ++j )
 				{
-					builder.addIndexedValue(dataView, v);
+					total += in[source( j )];
 				}
+				out[i] = total / ( last - first );
 			}
-
-			return builder.indexedData();
-		}
-
-		IndexedData operator()( const IECore::Data *data )
-		{
-			throw IECore::Exception(
-				boost::str( boost::format( "Unexpected Data: %1%" ) % ( data ? data->typeName() : std::string( "nullptr" ) ) )
-			);
 		}
-
-		IECore::ConstIntVectorDataPtr getRemapping() const
+	);
+}
+
+/// Returns the offsets of the first element of each primitive, where primitive `i`
+/// has `count( i )` elements. The total is appended, so that the offsets may be used
+/// with `averageElements()`.
+template<typename F>
+std::vector<int> primitiveOffsets( size_t numPrimitives, F &&count, const IECore::Canceller *canceller )
+{
+	std::vector<int> offsets;
+	const size_t total = exclusiveScan( numPrimitives, count, offsets, canceller );
+	offsets.push_back( total );
+	return offsets;
+}
+
+/// Returns the index of the owning primitive for each element, given the
+/// offsets returned by `primitiveOffsets()`.
+inline std::vector<int> primitiveIndices( const std::vector<int> &offsets, const IECore::Canceller *canceller )
+{
+	std::vector<int> result( offsets.empty() ? 0 : offsets.back() );
+	parallelForBlocks(
+		offsets.empty() ? 0 : offsets.size() - 1, canceller,
+		[&]( size_t begin, size_t end )
 		{
-			return m_remappingData;
+			for( size_t i = begin; i != end; ++i )
+			{
+				std::fill( result.begin() + offsets[i], result.begin() + offsets[i+1], i );
+			}
 		}
+	);
+	return result;
+}
 
-	private:
-		IECore::ConstIntVectorDataPtr m_verticesPerFaceData;
-		IECore::ConstIntVectorDataPtr m_vertexIdsData;
-
-		IECore::BoolVectorDataPtr m_usedVerticesData;
-
-		// map from old vertex index to new
-		IECore::IntVectorDataPtr m_remappingData;
-};
+/// Returns true if the element should be kept, given the value of a deletion flag.
+template<typename U>
+inline bool keepFlagged( const U &flag, bool invert )
+{
+	return invert ? (bool)flag : !(bool)flag;
+}
 
 } // PrimitiveVariableAlgos
 
@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2026, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "IECore/AsyncMessageHandler.h"
+
+#include "tbb/concurrent_queue.h"
+
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <thread>
+
+using namespace IECore;
+
+//////////////////////////////////////////////////////////////////////////
+// Implementation
+//////////////////////////////////////////////////////////////////////////
+
+class AsyncMessageHandler::Implementation
+{
+
+	public :
+
+		Implementation( MessageHandler *handler, size_t capacity )
+			:	m_handler( handler )
+		{
+			m_queue.set_capacity( std::max<size_t>( capacity, 1 ) );
+			m_thread = std::thread( [this] { run(); } );
+		}
+
+		~Implementation()
+		{
+			m_queue.push( Message{ Message::Stop } );
+			m_thread.join();
+		}
+
+		void push( Level level, const std::string &context, const std::string &message )
+		{
+			// We must never block waiting for space in the queue, because the
+			// calling thread may hold a lock (most notably the Python GIL) that
+			// the background thread needs in order to make progress. So when the
+			// queue is full, we output the message synchronously instead. This is
+			// safe because the wrapped handler must be threadsafe anyway.
+			if( !m_queue.try_push( Message{ Message::Output, level, context, message } ) )
+			{
+				m_handler->handle( level, context, message );
+			}
+		}
+
+		void flush()
+		{
+			std::promise<void> promise;
+			std::future<void> future = promise.get_future();
+			m_queue.push( Message{ Message::Flush, Error, std::string(), std::string(), &promise } );
+			future.wait();
+		}
+
+	private :
+
+		struct Message
+		{
+			enum Type
+			{
+				Output,
+				Flush,
+				Stop
+			};
+
+			Type type;
+			Level level = Error;
+			std::string context;
+			std::string message;
+			std::promise<void> *flushed = nullptr;
+		};
+
+		void run()
+		{
+			Message message;
+			while( true )
+			{
+				m_queue.pop( message );
+				switch( message.type )
+				{
+					case Message::Output :
+						try
+						{
+							m_handler->handle( message.level, message.context, message.message );
+						}
+						catch( const std::exception &e )
+						{
+							std::cerr << "AsyncMessageHandler : " << e.what() << std::endl;
+						}
+						catch( ... )
+						{
+							std::cerr << "AsyncMessageHandler : Unknown exception" << std::endl;
+						}
+						break;
+					case Message::Flush :
+						message.flushed->set_value();
+						break;
+					case Message::Stop :
+						return;
+				}
+			}
+		}
+
+		// Not owned. The handler is kept alive by `FilteredMessageHandler::m_handler`,
+		// which is destroyed after the Implementation.
+		MessageHandler *m_handler;
+		tbb::concurrent_bounded_queue<Message> m_queue;
+		std::thread m_thread;
+
+};
+
+//////////////////////////////////////////////////////////////////////////
+// AsyncMessageHandler
+//////////////////////////////////////////////////////////////////////////
+
+AsyncMessageHandler::AsyncMessageHandler( MessageHandlerPtr handler, size_t capacity )
+	:	FilteredMessageHandler( handler ), m_implementation( new Implementation( handler.get(), capacity ) )
+{
+}
+
+AsyncMessageHandler::~AsyncMessageHandler()
+{
+}
+
+void AsyncMessageHandler::handle( Level level, const std::string &context, const std::string &message )
+{
+	m_implementation->push( level, context, message );
+}
+
+MessageHandler::Level AsyncMessageHandler::maximumLevel() const
+{
+	return m_handler->maximumLevel();
+}
+
+void AsyncMessageHandler::flush()
+{
+	m_implementation->flush();
+}
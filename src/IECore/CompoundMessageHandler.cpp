@@ -34,6 +34,8 @@
 
 #include "IECore/CompoundMessageHandler.h"
 
+#include <algorithm>
+
 
 using namespace std;
 using namespace IECore;
@@ -55,3 +57,13 @@ void CompoundMessageHandler::handle( Level level, const std::string &context, co
 		(*it)->handle( level, context, message );
 	}
 }
+
+MessageHandler::Level CompoundMessageHandler::maximumLevel() const
+{
+	Level result = Error;
+	for( const auto &handler : handlers )
+	{
+		result = std::max( result, handler->maximumLevel() );
+	}
+	return result;
+}
@@ -103,11 +103,18 @@ void CompoundObject::load( LoadContextPtr context )
 
 	IndexedIO::EntryIDList memberNames;
 	container->entryIds( memberNames );
-	IndexedIO::EntryIDList::const_iterator it;
 
-	for( it=memberNames.begin(); it!=memberNames.end(); it++ )
+	std::vector<ObjectPtr> members( memberNames.size() );
+	context->parallelFor(
+		memberNames.size(),
+		[&]( size_t i ) {
+			members[i] = context->load<Object>( container.get(), memberNames[i] );
+		}
+	);
+
+	for( size_t i = 0; i < memberNames.size(); ++i )
 	{
-		m_members[*it] = context->load<Object>( container.get(), *it );
+		m_members[memberNames[i]] = members[i];
 	}
 }
 
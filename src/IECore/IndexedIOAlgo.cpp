@@ -34,6 +34,10 @@
 
 #include "IECore/IndexedIOAlgo.h"
 
+#include "IECore/Timer.h"
+
+#include "boost/filesystem/operations.hpp"
+
 #include "tbb/task.h"
 
 #include <atomic>
@@ -308,5 +312,37 @@ FileStats<size_t> parallelReadAll( const IndexedIO *src )
 	return fileStats;
 }
 
+std::vector<CompressionBenchmark> benchmarkCompression( const IndexedIO *src, const std::string &fileName, const std::vector<ConstCompoundDataPtr> &candidates )
+{
+	std::vector<CompressionBenchmark> result;
+	result.reserve( candidates.size() );
+
+	for( const auto &options : candidates )
+	{
+		CompressionBenchmark benchmark;
+
+		Timer timer( true, Timer::WallClock );
+		{
+			IndexedIOPtr dst = IndexedIO::create( fileName, IndexedIO::rootPath, IndexedIO::Write, options.get() );
+			copy( src, dst.get() );
+			// Destroying `dst` flushes the index, which is part of the cost of writing.
+		}
+		benchmark.writeTime = timer.stop();
+
+		benchmark.fileSize = boost::filesystem::file_size( fileName );
+
+		timer.start();
+		{
+			ConstIndexedIOPtr written = IndexedIO::create( fileName, IndexedIO::rootPath, IndexedIO::Read, options.get() );
+			parallelReadAll( written.get() );
+		}
+		benchmark.readTime = timer.stop();
+
+		result.push_back( benchmark );
+	}
+
+	return result;
+}
+
 } // IndexedIOAlgo
 } // IECore
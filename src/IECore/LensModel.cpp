@@ -34,10 +34,22 @@
 
 #include "IECore/LensModel.h"
 
+#include "IECore/LRUCache.h"
+#include "IECore/MurmurHash.h"
 #include "IECore/Object.h"
 #include "IECore/RunTimeTyped.h"
 
+#include "boost/lexical_cast.hpp"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_reduce.h"
+#include "tbb/task_arena.h"
+
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
@@ -45,6 +57,164 @@ using namespace IECore;
 
 IE_CORE_DEFINERUNTIMETYPED( LensModel );
 
+//////////////////////////////////////////////////////////////////////////
+// STMap cache
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+// Conceptually the key for the cache is just a hash of the
+// type, parameter values, mode and resolution, but the getter
+// also needs the lens model itself, so we use the GetterKey
+// feature of the LRUCache to pass it through.
+struct STMapGetterKey
+{
+
+	STMapGetterKey( LensModel *lensModel, int mode, const Imath::V2i &resolution )
+		:	lensModel( lensModel ), mode( mode ), resolution( resolution )
+	{
+		hash.append( (int)lensModel->typeId() );
+		lensModel->parameters()->getValue()->hash( hash );
+		hash.append( mode );
+		hash.append( resolution );
+	}
+
+	operator const MurmurHash & () const
+	{
+		return hash;
+	}
+
+	LensModel *lensModel;
+	const int mode;
+	const Imath::V2i resolution;
+	MurmurHash hash;
+
+};
+
+using STMapCache = LRUCache<MurmurHash, LensModel::STMap::ConstPtr, LRUCachePolicy::Parallel, STMapGetterKey>;
+
+size_t defaultSTMapCacheMemoryLimit()
+{
+	const char *m = getenv( "IECORE_LENSMODEL_STMAP_CACHE_MEMORY" );
+	const size_t megabytes = m ? boost::lexical_cast<size_t>( m ) : 500;
+	return megabytes * 1024 * 1024;
+}
+
+} // namespace
+
+struct LensModel::STMapCacheAccess
+{
+
+	static STMapCache &cache()
+	{
+		static STMapCache g_cache( getter, defaultSTMapCacheMemoryLimit() );
+		return g_cache;
+	}
+
+	static STMap::ConstPtr getter( const STMapGetterKey &key, size_t &cost )
+	{
+		STMap::ConstPtr result = new STMap( key.lensModel, key.mode, key.resolution );
+		cost = result->memoryUsage();
+		return result;
+	}
+
+};
+
+//////////////////////////////////////////////////////////////////////////
+// STMap
+//////////////////////////////////////////////////////////////////////////
+
+LensModel::STMap::STMap( LensModel *lensModel, int mode, const Imath::V2i &resolution )
+	:	m_mode( mode ), m_resolution( resolution )
+{
+	const int width = resolution.x + 1;
+	const int height = resolution.y + 1;
+	m_offsets.resize( (size_t)width * height );
+
+	auto evaluate = [lensModel, mode]( const Imath::V2d &uv ) {
+		return mode == Distort ? lensModel->distort( uv ) : lensModel->undistort( uv );
+	};
+
+	tbb::this_task_arena::isolate(
+		[&] {
+
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+
+			// Bake the samples at the pixel corners.
+
+			tbb::parallel_for(
+				tbb::blocked_range<int>( 0, height ),
+				[&]( const tbb::blocked_range<int> &range )
+				{
+					for( int y = range.begin(); y != range.end(); ++y )
+					{
+						Imath::V2f *offsets = m_offsets.data() + (size_t)y * width;
+						for( int x = 0; x < width; ++x )
+						{
+							const Imath::V2d uv = Imath::V2d( x, y ) / Imath::V2d( m_resolution );
+							offsets[x] = Imath::V2f( evaluate( uv ) - uv );
+						}
+					}
+				},
+				taskGroupContext
+			);
+
+		}
+	);
+}
+
+LensModel::STMap::~STMap()
+{
+}
+
+int LensModel::STMap::mode() const
+{
+	return m_mode;
+}
+
+const Imath::V2i &LensModel::STMap::resolution() const
+{
+	return m_resolution;
+}
+
+Imath::V2d LensModel::STMap::sample( int x, int y ) const
+{
+	assert( x >= 0 && x <= m_resolution.x );
+	assert( y >= 0 && y <= m_resolution.y );
+	const Imath::V2d uv = Imath::V2d( x, y ) / Imath::V2d( m_resolution );
+	return uv + Imath::V2d( m_offsets[ (size_t)y * ( m_resolution.x + 1 ) + x ] );
+}
+
+Imath::V2d LensModel::STMap::lookup( const Imath::V2d &uv ) const
+{
+	const Imath::V2d p(
+		std::clamp( uv.x * m_resolution.x, 0.0, (double)m_resolution.x ),
+		std::clamp( uv.y * m_resolution.y, 0.0, (double)m_resolution.y )
+	);
+
+	const int x = std::min( (int)p.x, m_resolution.x - 1 );
+	const int y = std::min( (int)p.y, m_resolution.y - 1 );
+	const double tx = p.x - x;
+	const double ty = p.y - y;
+
+	const size_t stride = m_resolution.x + 1;
+	const Imath::V2f *o = m_offsets.data() + y * stride + x;
+	const Imath::V2d bottom = Imath::V2d( o[0] ) * ( 1.0 - tx ) + Imath::V2d( o[1] ) * tx;
+	const Imath::V2d top = Imath::V2d( o[stride] ) * ( 1.0 - tx ) + Imath::V2d( o[stride + 1] ) * tx;
+
+	return p / Imath::V2d( m_resolution ) + bottom * ( 1.0 - ty ) + top * ty;
+}
+
+size_t LensModel::STMap::memoryUsage() const
+{
+	return sizeof( *this ) + m_offsets.capacity() * sizeof( Imath::V2f );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// LensModel
+//////////////////////////////////////////////////////////////////////////
+
 LensModel::LensModel()
 	: Parameterised( this->staticTypeName() )
 {
@@ -138,6 +308,82 @@ Imath::Box2i LensModel::bounds( int mode, const Imath::Box2i &input, int width,
 	return out;
 }
 
+LensModel::STMap::ConstPtr LensModel::stMap( int mode, const Imath::V2i &resolution )
+{
+	if( mode != Distort && mode != Undistort )
+	{
+		throw InvalidArgumentException( boost::str( boost::format( "LensModel::stMap : Invalid mode %d" ) % mode ) );
+	}
+
+	if( resolution.x < 1 || resolution.y < 1 )
+	{
+		throw InvalidArgumentException(
+			boost::str( boost::format( "LensModel::stMap : Invalid resolution %dx%d" ) % resolution.x % resolution.y )
+		);
+	}
+
+	// The cache key is computed from the parameter values, so we must validate
+	// them now, to guarantee that the map isn't built from stale internal state.
+	validate();
+	return STMapCacheAccess::cache().get( STMapGetterKey( this, mode, resolution ) );
+}
+
+double LensModel::stMapError( const STMap *stMap )
+{
+	validate();
+
+	const int mode = stMap->mode();
+	const Imath::V2i &resolution = stMap->resolution();
+	auto evaluate = [this, mode]( const Imath::V2d &uv ) {
+		return mode == Distort ? distort( uv ) : undistort( uv );
+	};
+
+	// Measure the interpolation error at the pixel centres, where
+	// it is likely to be greatest.
+
+	double result = 0;
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			result = tbb::parallel_reduce(
+				tbb::blocked_range<int>( 0, resolution.y ),
+				0.0,
+				[&]( const tbb::blocked_range<int> &range, double maxError )
+				{
+					for( int y = range.begin(); y != range.end(); ++y )
+					{
+						for( int x = 0; x < resolution.x; ++x )
+						{
+							const Imath::V2d uv = ( Imath::V2d( x, y ) + Imath::V2d( 0.5 ) ) / Imath::V2d( resolution );
+							const Imath::V2d error = ( stMap->lookup( uv ) - evaluate( uv ) ) * Imath::V2d( resolution );
+							const double length = error.length();
+							if( std::isfinite( length ) )
+							{
+								maxError = std::max( maxError, length );
+							}
+						}
+					}
+					return maxError;
+				},
+				[]( double a, double b ) { return std::max( a, b ); },
+				taskGroupContext
+			);
+		}
+	);
+
+	return result;
+}
+
+void LensModel::setSTMapCacheMemoryLimit( size_t bytes )
+{
+	STMapCacheAccess::cache().setMaxCost( bytes );
+}
+
+size_t LensModel::getSTMapCacheMemoryLimit()
+{
+	return STMapCacheAccess::cache().getMaxCost();
+}
+
 LensModelPtr LensModel::create( const std::string &name )
 {
 	// Check to see whether the requested lens model is registered and if not, throw an exception.
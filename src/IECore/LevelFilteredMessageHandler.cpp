@@ -34,6 +34,8 @@
 
 #include "IECore/LevelFilteredMessageHandler.h"
 
+#include <algorithm>
+
 using namespace std;
 using namespace IECore;
 
@@ -62,6 +64,11 @@ void LevelFilteredMessageHandler::handle( Level level, const std::string &contex
 	m_handler->handle( level, context, message );
 }
 
+MessageHandler::Level LevelFilteredMessageHandler::maximumLevel() const
+{
+	return std::min( m_level, m_handler->maximumLevel() );
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////
 // accessors
@@ -40,8 +40,6 @@
 
 #include "boost/algorithm/string/case_conv.hpp"
 
-#include "tbb/enumerable_thread_specific.h"
-
 #include <iostream>
 
 using namespace std;
@@ -53,13 +51,32 @@ using namespace IECore;
 
 void MessageHandler::output( Level level, const std::string &context, const std::string &message )
 {
-	currentHandler()->handle( level, context, message );
+	MessageHandler *handler = currentHandler();
+	if( level > handler->maximumLevel() )
+	{
+		return;
+	}
+	handler->handle( level, context, message );
 }
 
 void MessageHandler::output( Level level, const std::string &context, const boost::format &message )
 {
-	string m = message.str();
-	output( level, context, m );
+	MessageHandler *handler = currentHandler();
+	if( level > handler->maximumLevel() )
+	{
+		return;
+	}
+	handler->handle( level, context, message.str() );
+}
+
+bool MessageHandler::enabled( Level level )
+{
+	return level <= currentHandler()->maximumLevel();
+}
+
+MessageHandler::Level MessageHandler::maximumLevel() const
+{
+	return Invalid;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -86,17 +103,28 @@ MessageHandler *MessageHandler::getDefaultHandler()
 // Scope class and current handler
 ///////////////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+
 typedef std::stack<MessageHandler *> HandlerStack;
-typedef tbb::enumerable_thread_specific<HandlerStack> ThreadSpecificHandlerStack;
 
-ThreadSpecificHandlerStack g_threadHandlers;
+// A plain `thread_local` is significantly cheaper to access than
+// `tbb::enumerable_thread_specific`, which matters because we
+// query the current handler for every message, including those
+// which are then discarded.
+HandlerStack &threadHandlers()
+{
+	static thread_local HandlerStack g_threadHandlers;
+	return g_threadHandlers;
+}
+
+} // namespace
 
 MessageHandler::Scope::Scope( MessageHandler *handler )
 {
 	if ( handler )
 	{
-		HandlerStack &stack = g_threadHandlers.local();
-		stack.push( handler );
+		threadHandlers().push( handler );
 	}
 
 	m_handler = handler;
@@ -106,15 +134,14 @@ MessageHandler::Scope::~Scope()
 {
 	if ( m_handler )
 	{
-		HandlerStack &stack = g_threadHandlers.local();
-		stack.pop();
+		threadHandlers().pop();
 	}
 }
 
 MessageHandler *MessageHandler::currentHandler()
 {
-	HandlerStack &stack = g_threadHandlers.local();
-	if( !stack.size() )
+	const HandlerStack &stack = threadHandlers();
+	if( stack.empty() )
 	{
 		return getDefaultHandler();
 	}
@@ -37,9 +37,18 @@
 #include "IECore/MurmurHash.h"
 
 #include "boost/format.hpp"
+#include "boost/functional/hash.hpp"
 #include "boost/tokenizer.hpp"
 
+#include "tbb/blocked_range.h"
+#include "tbb/concurrent_hash_map.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 
 using namespace IECore;
@@ -98,11 +107,143 @@ TypeInformation *typeInformation()
 
 } // namespace
 
+//////////////////////////////////////////////////////////////////////////////////////////
+// pointer map
+//////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+// Open addressing hash table mapping from pointers to values, using linear probing.
+// This is used to track the objects visited by the copy, save and memory contexts,
+// and is considerably faster than std::map because all entries are stored in a
+// single allocation rather than one node per object.
+template<typename Value>
+class PointerMap
+{
+
+	public :
+
+		PointerMap()
+			:	m_size( 0 ), m_shift( 64 )
+		{
+		}
+
+		// Returns the value for `key`, or nullptr if it
+		// hasn't been inserted.
+		const Value *find( const void *key ) const
+		{
+			if( m_entries.empty() )
+			{
+				return nullptr;
+			}
+
+			for( size_t i = bucket( key ); ; i = ( i + 1 ) & mask() )
+			{
+				const Entry &e = m_entries[i];
+				if( e.key == key )
+				{
+					return &e.value;
+				}
+				else if( !e.key )
+				{
+					return nullptr;
+				}
+			}
+		}
+
+		// Inserts `key` if it is not already present. Returns the
+		// value for `key`, and true if it was inserted. The returned
+		// pointer is invalidated by subsequent insertions.
+		std::pair<Value *, bool> insert( const void *key )
+		{
+			// Keep the load factor below 0.5, so probe sequences stay short.
+			if( ( m_size + 1 ) * 2 > m_entries.size() )
+			{
+				grow();
+			}
+
+			for( size_t i = bucket( key ); ; i = ( i + 1 ) & mask() )
+			{
+				Entry &e = m_entries[i];
+				if( e.key == key )
+				{
+					return std::make_pair( &e.value, false );
+				}
+				else if( !e.key )
+				{
+					e.key = key;
+					m_size++;
+					return std::make_pair( &e.value, true );
+				}
+			}
+		}
+
+		size_t size() const
+		{
+			return m_size;
+		}
+
+	private :
+
+		struct Entry
+		{
+			const void *key = nullptr;
+			Value value = Value();
+		};
+
+		size_t mask() const
+		{
+			return m_entries.size() - 1;
+		}
+
+		// Fibonacci hashing. This spreads the bits of the address across
+		// the top of the hash, so the low bits (which are always zero due
+		// to alignment) don't cause collisions.
+		size_t bucket( const void *key ) const
+		{
+			return ( (uint64_t)reinterpret_cast<uintptr_t>( key ) * 11400714819323198485ull ) >> m_shift;
+		}
+
+		void grow()
+		{
+			std::vector<Entry> entries( std::max<size_t>( 64, m_entries.size() * 2 ) );
+			entries.swap( m_entries );
+			m_shift = 64;
+			for( size_t n = m_entries.size(); n > 1; n >>= 1 )
+			{
+				m_shift--;
+			}
+
+			for( auto &e : entries )
+			{
+				if( !e.key )
+				{
+					continue;
+				}
+				size_t i = bucket( e.key );
+				while( m_entries[i].key )
+				{
+					i = ( i + 1 ) & mask();
+				}
+				m_entries[i].key = e.key;
+				m_entries[i].value = std::move( e.value );
+			}
+		}
+
+		std::vector<Entry> m_entries;
+		size_t m_size;
+		int m_shift;
+
+};
+
+} // namespace
+
 //////////////////////////////////////////////////////////////////////////////////////////
 // copy context stuff
 //////////////////////////////////////////////////////////////////////////////////////////
 
-struct Object::CopyContext::CopiedObjects : public std::map<const Object *, Object *>
+struct Object::CopyContext::CopiedObjects : public PointerMap<Object *>
 {
 };
 
@@ -124,14 +265,13 @@ ObjectPtr Object::CopyContext::copyInternal( const Object *toCopy )
 		{
 			m_copies.reset( new CopiedObjects );
 		}
-		CopiedObjects::const_iterator it = m_copies->find( toCopy );
-		if( it!=m_copies->end() )
+		if( Object * const *existingCopy = m_copies->find( toCopy ) )
 		{
-			return it->second;
+			return *existingCopy;
 		}
 		ObjectPtr copy = create( toCopy->typeId() );
 		copy->copyFrom( toCopy, this );
-		m_copies->insert( std::pair<const Object *, Object *>( toCopy, copy.get() ) );
+		*(m_copies->insert( toCopy ).first) = copy.get();
 		return copy;
 	}
 	else
@@ -148,8 +288,27 @@ ObjectPtr Object::CopyContext::copyInternal( const Object *toCopy )
 // save context stuff
 //////////////////////////////////////////////////////////////////////////////////////////
 
-struct Object::SaveContext::SavedObjects : public std::map<const Object *, IndexedIO::EntryIDList >
+// Maps from each object saved so far to the location of its path in `paths`.
+// The paths are stored contiguously so that we don't need to make an
+// allocation per object.
+struct Object::SaveContext::SavedObjects
 {
+
+	SavedObjects()
+		:	rootSaved( false )
+	{
+	}
+
+	struct Path
+	{
+		size_t offset = 0;
+		size_t size = 0;
+	};
+
+	PointerMap<Path> objects;
+	IndexedIO::EntryIDList paths;
+	bool rootSaved;
+
 };
 
 Object::SaveContext::SaveContext( IndexedIOPtr ioInterface )
@@ -183,16 +342,17 @@ void Object::SaveContext::save( const Object *toSave, IndexedIO *container, cons
 		throw Exception( "Error trying to save NULL pointer object!" );
 	}
 
-	SavedObjects::const_iterator it = m_savedObjects->find( toSave );
-	if( it!=m_savedObjects->end() )
+	const SavedObjects::Path *savedPath = m_savedObjects->objects.find( toSave );
+	if( savedPath )
 	{
-		container->write( name, &(it->second[0]), it->second.size() );
+		container->write( name, &(m_savedObjects->paths[savedPath->offset]), savedPath->size );
 	}
 	else
 	{
-		bool rootObject = ( m_savedObjects->size() == 0 );
+		bool rootObject = !m_savedObjects->rootSaved;
 		if ( rootObject )
 		{
+			m_savedObjects->rootSaved = true;
 			if ( container->hasEntry( name ) )
 			{
 				container->remove( name );
@@ -200,9 +360,19 @@ void Object::SaveContext::save( const Object *toSave, IndexedIO *container, cons
 		}
 		IndexedIOPtr nameIO = container->createSubdirectory( name );
 
-		IndexedIO::EntryIDList pathParts;
-		nameIO->path( pathParts );
-		(*m_savedObjects)[toSave] = pathParts;
+		if( toSave->refCount() > 1 )
+		{
+			// Object may occur multiple times in the data structure being
+			// saved - record its path so subsequent occurrences can be saved
+			// as references. Objects which can only occur once don't need
+			// this bookkeeping.
+			IndexedIO::EntryIDList pathParts;
+			nameIO->path( pathParts );
+			SavedObjects::Path &path = *(m_savedObjects->objects.insert( toSave ).first);
+			path.offset = m_savedObjects->paths.size();
+			path.size = pathParts.size();
+			m_savedObjects->paths.insert( m_savedObjects->paths.end(), pathParts.begin(), pathParts.end() );
+		}
 
 		nameIO->write( g_typeEntry, toSave->typeName() );
 
@@ -224,12 +394,51 @@ void Object::SaveContext::save( const Object *toSave, IndexedIO *container, cons
 // load context stuff
 //////////////////////////////////////////////////////////////////////////////////////////
 
-struct Object::LoadContext::LoadedObjects : public std::map<IndexedIO::EntryIDList, ObjectPtr>
+namespace
+{
+
+// InternedStrings are unique, so we can hash and compare paths using
+// the string addresses alone.
+struct PathHashCompare
 {
+
+	static size_t hash( const IndexedIO::EntryIDList &path )
+	{
+		size_t result = 0;
+		for( const auto &p : path )
+		{
+			boost::hash_combine( result, p.c_str() );
+		}
+		return result;
+	}
+
+	static bool equal( const IndexedIO::EntryIDList &a, const IndexedIO::EntryIDList &b )
+	{
+		return a == b;
+	}
+
+};
+
+} // namespace
+
+// Maps from the path of each object to the loaded object, so that we can
+// preserve instancing. Entries are locked for writing while the object is
+// being loaded, so when loading in parallel, any other thread encountering
+// the same object waits for it rather than loading a duplicate.
+struct Object::LoadContext::LoadedObjects : public tbb::concurrent_hash_map<IndexedIO::EntryIDList, ObjectPtr, PathHashCompare>
+{
+
+	LoadedObjects( bool parallel )
+		:	parallel( parallel )
+	{
+	}
+
+	const bool parallel;
+
 };
 
-Object::LoadContext::LoadContext( ConstIndexedIOPtr ioInterface, const Canceller *canceller )
-	:	m_ioInterface( ioInterface ), m_loadedObjects( new LoadedObjects ), m_canceller( canceller )
+Object::LoadContext::LoadContext( ConstIndexedIOPtr ioInterface, const Canceller *canceller, bool parallel )
+	:	m_ioInterface( ioInterface ), m_loadedObjects( new LoadedObjects( parallel ) ), m_canceller( canceller )
 {
 }
 
@@ -260,6 +469,41 @@ const IndexedIO *Object::LoadContext::rawContainer()
 	return m_ioInterface.get();
 }
 
+bool Object::LoadContext::parallel() const
+{
+	return m_loadedObjects->parallel;
+}
+
+void Object::LoadContext::parallelFor( size_t size, const std::function<void ( size_t )> &f )
+{
+	if( !m_loadedObjects->parallel || size < 2 )
+	{
+		for( size_t i = 0; i < size; ++i )
+		{
+			Canceller::check( m_canceller );
+			f( i );
+		}
+		return;
+	}
+
+	tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::parallel_for(
+				tbb::blocked_range<size_t>( 0, size, 1 ),
+				[&]( const tbb::blocked_range<size_t> &range ) {
+					for( size_t i = range.begin(); i != range.end(); ++i )
+					{
+						Canceller::check( m_canceller );
+						f( i );
+					}
+				},
+				taskGroupContext
+			);
+		}
+	);
+}
+
 ObjectPtr Object::LoadContext::loadObjectOrReference( const IndexedIO *container, const IndexedIO::EntryID &name )
 {
 	IndexedIO::Entry e = container->entry( name );
@@ -287,15 +531,15 @@ ObjectPtr Object::LoadContext::loadObjectOrReference( const IndexedIO *container
 				pathParts.push_back( *t );
 			}
 		}
-		std::pair<LoadedObjects::iterator, bool> ret = m_loadedObjects->insert( std::pair<IndexedIO::EntryIDList, ObjectPtr>( pathParts, nullptr ) );
-		if ( ret.second )
+		LoadedObjects::accessor a;
+		if( m_loadedObjects->insert( a, pathParts ) )
 		{
 			// jump to the path..
 			ConstIndexedIOPtr ioObject = m_ioInterface->directory( pathParts );
 			// add the loaded object to the map.
-			ret.first->second = loadObject( ioObject.get() );
+			a->second = loadObject( ioObject.get() );
 		}
-		return ret.first->second;
+		return a->second;
 	}
 	else
 	{
@@ -304,13 +548,13 @@ ObjectPtr Object::LoadContext::loadObjectOrReference( const IndexedIO *container
 		IndexedIO::EntryIDList pathParts;
 		ioObject->path( pathParts );
 
-		std::pair<LoadedObjects::iterator, bool> ret = m_loadedObjects->insert( std::pair<IndexedIO::EntryIDList, ObjectPtr>( pathParts, nullptr ) );
-		if ( ret.second )
+		LoadedObjects::accessor a;
+		if( m_loadedObjects->insert( a, pathParts ) )
 		{
 			// add the loaded object to the map.
-			ret.first->second = loadObject( ioObject.get() );
+			a->second = loadObject( ioObject.get() );
 		}
-		return ret.first->second;
+		return a->second;
 	}
 }
 
@@ -332,7 +576,7 @@ ObjectPtr Object::LoadContext::loadObject( const IndexedIO *container )
 // memory accumulator stuff
 //////////////////////////////////////////////////////////////////////////////////////////
 
-struct IECore::Object::MemoryAccumulator::Accumulated : public std::set<const void *>
+struct IECore::Object::MemoryAccumulator::Accumulated : public PointerMap<bool>
 {
 };
 
@@ -379,10 +623,9 @@ void Object::MemoryAccumulator::accumulate( const void *ptr, size_t bytes )
 	{
 		m_accumulated.reset( new Accumulated );
 	}
-	if( m_accumulated->find( ptr )==m_accumulated->end() )
+	if( m_accumulated->insert( ptr ).second )
 	{
 		m_total += bytes;
-		m_accumulated->insert( ptr );
 	}
 }
 
@@ -561,9 +804,9 @@ ObjectPtr Object::create( const std::string &typeName )
 	return it->second();
 }
 
-ObjectPtr Object::load( ConstIndexedIOPtr ioInterface, const IndexedIO::EntryID &name, const Canceller *canceller )
+ObjectPtr Object::load( ConstIndexedIOPtr ioInterface, const IndexedIO::EntryID &name, const Canceller *canceller, bool parallel )
 {
-	LoadContextPtr context( new LoadContext( ioInterface, canceller ) );
+	LoadContextPtr context( new LoadContext( ioInterface, canceller, parallel ) );
 	ObjectPtr result = context->load<Object>( ioInterface.get(), name );
 	return result;
 }
@@ -121,11 +121,18 @@ void ObjectVector::load( LoadContextPtr context )
 
 	IndexedIO::EntryIDList l;
 	ioMembers->entryIds(l);
-	for( IndexedIO::EntryIDList::const_iterator it=l.begin(); it!=l.end(); it++ )
+	std::vector<MemberContainer::size_type> indices( l.size() );
+	for( size_t j = 0; j < l.size(); ++j )
 	{
-		MemberContainer::size_type i = boost::lexical_cast<MemberContainer::size_type>( (*it).value() );
-		m_members[i] = context->load<Object>( ioMembers.get(), *it );
+		indices[j] = boost::lexical_cast<MemberContainer::size_type>( l[j].value() );
 	}
+
+	context->parallelFor(
+		l.size(),
+		[&]( size_t j ) {
+			m_members[indices[j]] = context->load<Object>( ioMembers.get(), l[j] );
+		}
+	);
 }
 
 bool ObjectVector::isEqualTo( const Object *other ) const
@@ -45,7 +45,9 @@
 
 #include "blosc.h"
 
-#include "tbb/spin_rw_mutex.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
 
 #include "boost/format.hpp"
 #include "boost/iostreams/device/file.hpp"
@@ -56,12 +58,15 @@
 #include "boost/tokenizer.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <iostream>
 #include <list>
 #include <map>
+#include <mutex>
 #include <optional>
 #include <set>
+#include <unordered_map>
 
 #include <fcntl.h>
 #ifndef _MSC_VER
@@ -222,19 +227,22 @@ class StreamIndexedIO::StringCache
 {
 	public:
 
-		StringCache() : m_prevId(0), m_ioBuffer(nullptr), m_ioBufferLen(0)
+		StringCache() : m_prevId(0), m_numUnmappedStrings(0), m_ioBuffer(nullptr), m_ioBufferLen(0)
 		{
 			m_idToStringMap.reserve(100);
 		}
 
 		template < typename F >
-		StringCache( F &f ) : m_prevId(0), m_ioBuffer(nullptr), m_ioBufferLen(0)
+		StringCache( F &f ) : m_prevId(0), m_numUnmappedStrings(0), m_ioBuffer(nullptr), m_ioBufferLen(0)
 		{
 			uint64_t sz;
 			readLittleEndian(f,sz);
 
 			m_idToStringMap.reserve(sz + 100);
 
+			// We only build the id-to-string map here, as it is all that is
+			// needed for reading. The string-to-id map is built on demand
+			// by `stringToIdMap()` if we are going to write.
 			for (uint64_t i = 0; i < sz; ++i)
 			{
 				const char *s = read(f);
@@ -244,23 +252,30 @@ class StreamIndexedIO::StringCache
 
 				m_prevId = std::max( id, m_prevId );
 
-				m_stringToIdMap[s] = id;
 				if ( id >= m_idToStringMap.size() )
 				{
 					m_idToStringMap.resize(id+1, (const char *)"");
 				}
 				m_idToStringMap[id] = s;
+
+				if( !*s )
+				{
+					m_emptyStringId = id;
+				}
 			}
+			m_numUnmappedStrings = sz;
 		}
 
 		template < typename F >
 		void write( F &f ) const
 		{
-			uint64_t sz = m_stringToIdMap.size();
+			const StringToIdMap &stringToIdMap = this->stringToIdMap();
+
+			uint64_t sz = stringToIdMap.size();
 			writeLittleEndian( f,sz );
 
-			for (StringToIdMap::const_iterator it = m_stringToIdMap.begin();
-				it != m_stringToIdMap.end(); ++it)
+			for (StringToIdMap::const_iterator it = stringToIdMap.begin();
+				it != stringToIdMap.end(); ++it)
 			{
 				write(f, it->first);
 
@@ -270,8 +285,9 @@ class StreamIndexedIO::StringCache
 
 		uint64_t find( const IndexedIO::EntryID &s ) const
 		{
-			StringToIdMap::const_iterator it = m_stringToIdMap.find( s );
-			if ( it == m_stringToIdMap.end() )
+			const StringToIdMap &stringToIdMap = this->stringToIdMap();
+			StringToIdMap::const_iterator it = stringToIdMap.find( s );
+			if ( it == stringToIdMap.end() )
 			{
 				throw IOException( (boost::format ( "StringCache: could not find string %s!" ) % s.value() ).str() );
 			}
@@ -280,6 +296,7 @@ class StreamIndexedIO::StringCache
 
 		uint64_t find( const IndexedIO::EntryID &s, bool errIfNotFound = true )
 		{
+			stringToIdMap();
 			StringToIdMap::const_iterator it = m_stringToIdMap.find( s );
 
 			if ( it == m_stringToIdMap.end() )
@@ -322,11 +339,37 @@ class StreamIndexedIO::StringCache
 
 		uint64_t size() const
 		{
-			return m_stringToIdMap.size();
+			return m_stringToIdMap.size() + m_numUnmappedStrings;
 		}
 
 	protected:
 
+		typedef std::map< IndexedIO::EntryID, uint64_t > StringToIdMap;
+		typedef std::vector< IndexedIO::EntryID > IdToStringMap;
+
+		/// Returns the string-to-id map, building it from the id-to-string
+		/// map if necessary. This is only called when writing, so doesn't
+		/// need to be thread-safe.
+		const StringToIdMap &stringToIdMap() const
+		{
+			if( m_numUnmappedStrings )
+			{
+				for( uint64_t id = 0; id < m_idToStringMap.size(); ++id )
+				{
+					const IndexedIO::EntryID &s = m_idToStringMap[id];
+					// Unused ids are filled with empty strings, which we must
+					// not confuse with a genuine empty string.
+					if( s.string().empty() && m_emptyStringId != id )
+					{
+						continue;
+					}
+					m_stringToIdMap[s] = id;
+				}
+				m_numUnmappedStrings = 0;
+			}
+			return m_stringToIdMap;
+		}
+
 		template < typename F >
 		void write( F &f, const std::string &s ) const
 		{
@@ -359,11 +402,12 @@ class StreamIndexedIO::StringCache
 
 		uint64_t m_prevId;
 
-		typedef std::map< IndexedIO::EntryID, uint64_t > StringToIdMap;
-		typedef std::vector< IndexedIO::EntryID > IdToStringMap;
-
-		StringToIdMap m_stringToIdMap;
+		mutable StringToIdMap m_stringToIdMap;
 		IdToStringMap m_idToStringMap;
+		/// Number of strings loaded into `m_idToStringMap` but not yet
+		/// added to `m_stringToIdMap`.
+		mutable uint64_t m_numUnmappedStrings;
+		std::optional<uint64_t> m_emptyStringId;
 
 		mutable char *m_ioBuffer;
 		mutable size_t m_ioBufferLen;
@@ -372,10 +416,7 @@ class StreamIndexedIO::StringCache
 namespace
 {
 
-const char* indexCompressor = "lz4";
-const int indexCompressionLevel = 9;
-
-const static std::map<std::string, int> nameCodeMapping = {{"blosclz", 0}, {"lz4", 1}, {"lz4hc", 2}, {"snappy", 3}, {"zlib", 4}};
+const static std::map<std::string, int> nameCodeMapping = {{"blosclz", 0}, {"lz4", 1}, {"lz4hc", 2}, {"snappy", 3}, {"zlib", 4}, {"zstd", 5}};
 
 //! map blosc compressor name to a int which we can serialise into
 //! the indexedIO header. We don't use the blosc header defined values incase they change.
@@ -402,8 +443,93 @@ std::string getCompressor( int code )
 	return "unknown";
 }
 
+/// The blosc settings used to compress a block of data. Blosc embeds
+/// everything needed for decompression in the block header, so these
+/// only affect writing, and can be chosen independently for each block.
+struct CompressionPolicy
+{
+	std::string compressor;
+	int level;
+	/// One of BLOSC_NOSHUFFLE, BLOSC_SHUFFLE or BLOSC_BITSHUFFLE.
+	int shuffle;
+	/// The element size used by the shuffle filter.
+	size_t typeSize;
+};
+
+const CompressionPolicy g_indexCompressionPolicy = { "lz4", 9, BLOSC_SHUFFLE, 4 };
+
+/// Data is grouped into categories which each have their own
+/// CompressionPolicy, as the best filter and codec for an array of
+/// floats is rarely the best for an array of indices or strings.
+enum DataCategory
+{
+	FloatCategory = 0,
+	IntegerCategory,
+	StringCategory,
+	InternedStringCategory,
+	NumDataCategories
+};
+
+const char *g_dataCategoryNames[NumDataCategories] = { "float", "integer", "string", "internedString" };
+
+DataCategory dataCategory( IndexedIO::DataType dataType )
+{
+	switch( dataType )
+	{
+		case IndexedIO::Float :
+		case IndexedIO::FloatArray :
+		case IndexedIO::Double :
+		case IndexedIO::DoubleArray :
+		case IndexedIO::Half :
+		case IndexedIO::HalfArray :
+			return FloatCategory;
+		case IndexedIO::String :
+		case IndexedIO::StringArray :
+			return StringCategory;
+		case IndexedIO::InternedStringArray :
+			return InternedStringCategory;
+		default :
+			return IntegerCategory;
+	}
+}
+
+/// Returns the size of the elements stored for `dataType`, for use as
+/// the blosc typesize.
+size_t elementSize( IndexedIO::DataType dataType )
+{
+	switch( dataType )
+	{
+		case IndexedIO::Double :
+		case IndexedIO::DoubleArray :
+		case IndexedIO::Long :
+		case IndexedIO::LongArray :
+		case IndexedIO::Int64 :
+		case IndexedIO::Int64Array :
+		case IndexedIO::UInt64 :
+		case IndexedIO::UInt64Array :
+		case IndexedIO::InternedStringArray :
+			return 8;
+		case IndexedIO::Half :
+		case IndexedIO::HalfArray :
+		case IndexedIO::Short :
+		case IndexedIO::ShortArray :
+		case IndexedIO::UShort :
+		case IndexedIO::UShortArray :
+			return 2;
+		case IndexedIO::String :
+		case IndexedIO::StringArray :
+		case IndexedIO::Char :
+		case IndexedIO::CharArray :
+		case IndexedIO::UChar :
+		case IndexedIO::UCharArray :
+			return 1;
+		default :
+			return 4;
+	}
+}
+
 /// compress 'size' bytes at 'data' into 'outputBuffer'
-/// compressionLevel, compressor & threadCount are passed directly to blosc ( see blosc.h )
+/// the policy & threadCount are passed directly to blosc ( see blosc.h )
 /// if  'size' is greater than the max buffer blosc can handle we split into a number of independently compressed blocks.
 /// returns the number of compression blocks
 /// 'outputBuffer' contains the compressed block data and is resized in this function.
@@ -412,8 +538,7 @@ size_t compress(
 	const char *data,
 	size_t size,
 	std::vector<char> &outputBuffer,
-	int compressionLevel,
-	const std::string &compressor,
+	const CompressionPolicy &policy,
 	int threadCount,
 	std::optional<size_t> maxBlockSize = std::optional<size_t>(),
 	size_t minCompressedBlockSize = 1024U
@@ -450,14 +575,14 @@ size_t compress(
 		}
 
 		int compressedSize = blosc_compress_ctx(
-			compressionLevel,
-			true,
-			4,
+			policy.level,
+			policy.shuffle,
+			policy.typeSize,
 			currentBlockUncompressedSize,
 			currentBlockCompressed,
 			writePtr,
 			compressedBufferMaxSize,
-			compressor.c_str(),
+			policy.compressor.c_str(),
 			0,
 			threadCount
 		);
@@ -528,6 +653,67 @@ size_t decompress( const char *data, size_t size, std::vector<char> &outputBuffe
 	return blockSizes.size();
 }
 
+/// Buffers larger than this are hashed in parallel chunks by `hashData()`.
+const size_t g_hashChunkSize = 1024 * 1024;
+
+/// Returns a hash of 'size' bytes at 'data'. Large buffers are split into
+/// chunks which are hashed in parallel, and the chunk hashes are then combined
+/// in order. The result is only used for in-memory deduplication and is never
+/// stored in the file, so it doesn't need to match a sequential hash.
+MurmurHash hashData( const char *data, size_t size )
+{
+	MurmurHash result;
+	if( size <= g_hashChunkSize )
+	{
+		result.append( data, size );
+		return result;
+	}
+
+	const size_t numChunks = ( size + g_hashChunkSize - 1 ) / g_hashChunkSize;
+	std::vector<MurmurHash> chunkHashes( numChunks );
+
+	// Isolate so that we don't steal unrelated tasks while our
+	// caller may be holding locks.
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			tbb::parallel_for(
+				tbb::blocked_range<size_t>( 0, numChunks ),
+				[&]( const tbb::blocked_range<size_t> &range )
+				{
+					for( size_t i = range.begin(); i != range.end(); ++i )
+					{
+						const size_t offset = i * g_hashChunkSize;
+						chunkHashes[i].append( data + offset, std::min( g_hashChunkSize, size - offset ) );
+					}
+				},
+				taskGroupContext
+			);
+		}
+	);
+
+	for( const auto &h : chunkHashes )
+	{
+		result.append( h );
+	}
+	result.append( (uint64_t)size );
+
+	return result;
+}
+
+/// Key used to identify previously written data blocks.
+typedef std::pair<MurmurHash, uint64_t> HashAndSize;
+
+struct HashAndSizeHasher
+{
+	size_t operator()( const HashAndSize &key ) const
+	{
+		// MurmurHash is already well distributed, so there's no
+		// need to mix the bits any further.
+		return key.first.h1() ^ key.second;
+	}
+};
+
 } // namespace
 
 
@@ -732,21 +918,76 @@ class DataNode : public NodeBase
 };
 
 
-/// A compressed subindex node
+class DirectoryNode;
+
+/// A compressed subindex node. The directory stored in the subindex is
+/// paged in on demand by `Index::pageIn()`, and may be evicted again by
+/// the Index when it is not pinned.
 class SubIndexNode : public NodeBase
 {
 	public :
-		SubIndexNode(IndexedIO::EntryID name, uint64_t offset) : NodeBase(NodeBase::SubIndex, name), m_offset(offset) {}
+		SubIndexNode(IndexedIO::EntryID name, uint64_t offset) : NodeBase(NodeBase::SubIndex, name), m_pins(0), m_offset(offset), m_directory(nullptr) {}
 
 		inline uint64_t offset()
 		{
 			return m_offset;
 		}
 
+		/// Returns the paged in directory, or null if it is not currently loaded.
+		inline DirectoryNode *directory() const
+		{
+			return m_directory.load( std::memory_order_acquire );
+		}
+
+		inline void setDirectory( DirectoryNode *directory )
+		{
+			m_directory.store( directory, std::memory_order_release );
+		}
+
+		/// Prevents the directory from being evicted until `unpin()` is called.
+		/// Returns false if the directory is currently being evicted.
+		inline bool pin()
+		{
+			int32_t pins = m_pins.load();
+			do
+			{
+				if( pins < 0 )
+				{
+					return false;
+				}
+			} while( !m_pins.compare_exchange_weak( pins, pins + 1 ) );
+			return true;
+		}
+
+		inline void unpin()
+		{
+			m_pins--;
+		}
+
+		/// Returns true if there are no pins, in which case all calls to `pin()`
+		/// will fail until `endEviction()` is called.
+		inline bool beginEviction()
+		{
+			int32_t pins = 0;
+			return m_pins.compare_exchange_strong( pins, -1 );
+		}
+
+		inline void endEviction()
+		{
+			m_directory.store( nullptr );
+			m_pins.store( 0 );
+		}
+
 	protected :
+
+		/// Positioned to fit in the padding after the NodeBase members.
+		std::atomic<int32_t> m_pins;
+
 		/// The offset in the file to this node's subindex block if m_subindex is not NoSubIndex.
 		const uint64_t m_offset;
 
+		std::atomic<DirectoryNode *> m_directory;
+
 };
 
 /// A directory node within an index
@@ -760,6 +1001,9 @@ class DirectoryNode : public NodeBase
 			NoSubIndex = 0,
 			SavedSubIndex,
 			LoadedSubIndex,
+			/// The directory was paged in from the subindex of a SubIndexNode,
+			/// which remains in the parent's children.
+			PagedSubIndex,
 		};
 
 		typedef std::vector< NodeBase* > ChildMap;
@@ -768,7 +1012,6 @@ class DirectoryNode : public NodeBase
 		DirectoryNode(IndexedIO::EntryID name, std::optional<uint32_t> numChildren = std::optional<uint32_t>()) : NodeBase( NodeBase::Directory, name ),
 			m_subindex( NoSubIndex ),
 			m_sortedChildren( false ),
-			m_subindexChildren( false ),
 			m_offset( 0 ),
 			m_parent( nullptr )
 		{
@@ -779,8 +1022,8 @@ class DirectoryNode : public NodeBase
 
 		}
 
-		// constructor used when building a directory based on an existing SubIndexNode (because we want to load the contents soon).
-		DirectoryNode( SubIndexNode *subindex, DirectoryNode *parent ) : NodeBase(NodeBase::Directory, subindex->name()), m_subindex(SavedSubIndex), m_sortedChildren(false), m_subindexChildren(false), m_offset(subindex->offset()), m_parent(parent) {}
+		// constructor used when paging in the directory stored by an existing SubIndexNode.
+		DirectoryNode( SubIndexNode *subindex, DirectoryNode *parent ) : NodeBase(NodeBase::Directory, subindex->name()), m_subindex(PagedSubIndex), m_sortedChildren(false), m_offset(subindex->offset()), m_parent(parent) {}
 
 		// returns what's the state of this directory, whether it's contents are in a subindex and whether they have been loaded or not.
 		inline SubIndexMode subindex()
@@ -788,11 +1031,6 @@ class DirectoryNode : public NodeBase
 			return static_cast<SubIndexMode>(m_subindex);
 		}
 
-		inline bool subindexChildren() const
-		{
-			return m_subindexChildren;
-		}
-
 		inline uint64_t offset() const
 		{
 			return m_offset;
@@ -804,14 +1042,15 @@ class DirectoryNode : public NodeBase
 		}
 
 		/// Returns the current list of child Nodes.
-		// This function is not thread-safe and Index::lockDirectory must be used in read-only access
+		// Children read from a file are sorted and never modified, so may be accessed concurrently
+		// without locking. Otherwise this function is not thread-safe.
 		// \todo we may want to restrict more the access to the internal children and add the manipulation methods in the class instead.
 		inline ChildMap &children()
 		{
 			return m_children;
 		}
 
-		// This function is not thread-safe and Index::lockDirectory must be used in read-only access
+		// This function is not thread-safe unless the children have already been sorted
 		inline void sortChildren()
 		{
 			if ( !m_sortedChildren )
@@ -821,7 +1060,7 @@ class DirectoryNode : public NodeBase
 			}
 		}
 
-		// This function is not thread-safe and Index::lockDirectory must be used in read-only access
+		// This function is not thread-safe unless the children have already been sorted
 		inline ChildMap::iterator findChild( IndexedIO::EntryID name )
 		{
 			sortChildren();
@@ -852,7 +1091,6 @@ class DirectoryNode : public NodeBase
 
 		char m_subindex;	// using char instead of enum to compact members in one word
 		bool m_sortedChildren; // same as above
-		bool m_subindexChildren;	// true if one or more children are subindex. Helps avoiding the mutex...
 
 		/// The offset in the file to this node's subindex block if m_subindex is not NoSubIndex.
 		uint64_t m_offset;
@@ -883,8 +1121,17 @@ class StreamIndexedIO::Node
 			size_t numCompressedBlocks;
 		};
 
-		/// Construct a new Node in the given index with the given numeric id
-		Node(StreamIndexedIO::Index* index, DirectoryNode *dirNode);
+		/// Construct a new Node in the given index with the given numeric id.
+		/// `page` is the innermost paged in SubIndexNode containing `dirNode`,
+		/// which must have been pinned on behalf of the Node.
+		Node(StreamIndexedIO::Index* index, DirectoryNode *dirNode, SubIndexNode *page = nullptr);
+		~Node();
+
+		Node( const Node &other ) = delete;
+		Node &operator = ( const Node &other ) = delete;
+
+		/// Moves to another directory, taking ownership of the pin on `page`.
+		void setDirectory( DirectoryNode *dirNode, SubIndexNode *page );
 
 		void childNames( IndexedIO::EntryIDList &names ) const;
 		void childNames( IndexedIO::EntryIDList &names, IndexedIO::EntryType ) const;
@@ -893,8 +1140,10 @@ class StreamIndexedIO::Node
 
 		bool hasChild( const IndexedIO::EntryID &name ) const;
 
-		// Returns the named child directory node or NULL if not existent. Loads the subindex for the child nodes (if applicable).
-		DirectoryNode* directoryChild( const IndexedIO::EntryID &name ) const;
+		// Returns the named child directory node or NULL if not existent. Pages in the subindex for the child nodes (if applicable).
+		// If the child is found, `page` is set to the innermost paged in SubIndexNode containing it, and is pinned on behalf
+		// of the caller, who must either pass it to a Node or unpin it.
+		DirectoryNode* directoryChild( const IndexedIO::EntryID &name, SubIndexNode *&page ) const;
 
 		/// returns information about the Data node
 		bool dataChildInfo( const IndexedIO::EntryID &name, Info &info ) const;
@@ -914,6 +1163,10 @@ class StreamIndexedIO::Node
 
 		StreamIndexedIO::IndexPtr m_idx;
 		DirectoryNode *m_node;
+		/// Pinned to prevent `m_node` being evicted from the index. Null
+		/// if `m_node` isn't in a paged subindex, or if the Index doesn't
+		/// evict pages.
+		SubIndexNode *m_page;
 };
 
 //! Small scoped class to read from a given data block in a file,
@@ -1040,6 +1293,9 @@ class StreamIndexedIO::Index : public RefCounted
 		/// \param prefixSize If true than it will prepend to the block, the size of it
 		uint64_t writeUniqueData( const char *data, size_t size, bool prefixSize = false );
 
+		/// Saves the data to file without checking for duplicates, returning its offset.
+		uint64_t writeData( const char *data, size_t size, bool prefixSize = false );
+
 		struct WriteInfo
 		{
 			WriteInfo() : offset( 0 ), size( 0 ), numCompressedBlocks( 0 )
@@ -1055,7 +1311,10 @@ class StreamIndexedIO::Index : public RefCounted
 			size_t numCompressedBlocks;
 		};
 
-		WriteInfo writeUniqueDataCompressed( const char *data, size_t size, bool prefixSize = false );
+		/// Compresses and saves the data to file, using the compression policy for `dataType`.
+		/// Duplicates are detected by hashing the uncompressed data, so that we don't pay the
+		/// cost of compressing them again.
+		WriteInfo writeUniqueDataCompressed( const char *data, size_t size, IndexedIO::DataType dataType, bool prefixSize = false );
 
 		/// flushes the children of the given directory node to a subindex in the file
 		void commitNodeToSubIndex( DirectoryNode *n );
@@ -1063,11 +1322,20 @@ class StreamIndexedIO::Index : public RefCounted
 		/// read the subindex that contains the children of the given node
 		void readNodeFromSubIndex( DirectoryNode *n );
 
-		typedef tbb::spin_rw_mutex Mutex;
-		typedef Mutex::scoped_lock MutexLock;
-		/// Returns an appropriate mutex scoped lock to access the given Directory node.
-		/// It selects on mutex from the pool, reducing the changes of blocking other threads that are accessing different locations.
-		void lockDirectory( MutexLock &lock, const DirectoryNode *n, bool writeAccess = false ) const;
+		/// Returns the directory stored in the subindex of `subIndex`, loading it from the
+		/// file if necessary. `parent` is the directory containing `subIndex`, and `parentPage`
+		/// is the innermost paged SubIndexNode containing `parent`. If `evictsPages()` is true,
+		/// `subIndex` is pinned on behalf of the caller.
+		DirectoryNode *pageIn( SubIndexNode *subIndex, DirectoryNode *parent, SubIndexNode *parentPage );
+
+		/// Returns true if paged subindexes are evicted to keep within the
+		/// "indexCacheSize" budget, in which case they must be pinned while in use.
+		bool evictsPages() const { return m_indexCacheSize; }
+
+		/// Returns the innermost paged SubIndexNode containing `n`, pinned on behalf of
+		/// the caller. Returns null if there is no such node or if `evictsPages()` is false.
+		/// The caller must already have a pin which prevents `n` from being evicted.
+		SubIndexNode *pinPage( DirectoryNode *n );
 
 		int decompressionThreadCount() const { return m_decompressionThreadCount; }
 
@@ -1085,11 +1353,6 @@ class StreamIndexedIO::Index : public RefCounted
 
 	protected:
 
-		static const int MAX_MUTEXES = 11;
-
-		/// defines a pool of mutexes for thread-safe access to the Node hierarchy
-		mutable Mutex m_mutexes[ MAX_MUTEXES ];
-
 		DirectoryNode *m_root;
 
 		/// we keep all the removed nodes alive until the Index destruction
@@ -1106,9 +1369,14 @@ class StreamIndexedIO::Index : public RefCounted
 		typedef std::vector< NodeBase* > IndexToNodeMap;
 		IndexToNodeMap m_indexToNodeMap;
 
-		typedef std::map< std::pair<MurmurHash,unsigned int>, uint64_t > HashToDataMap;
+		typedef std::unordered_map< HashAndSize, uint64_t, HashAndSizeHasher > HashToDataMap;
 		HashToDataMap m_hashToDataMap;
 
+		/// Maps from the hash of uncompressed data to the result of
+		/// writing it with `writeUniqueDataCompressed()`.
+		typedef std::unordered_map< HashAndSize, WriteInfo, HashAndSizeHasher > HashToWriteInfoMap;
+		HashToWriteInfoMap m_hashToWriteInfoMap;
+
 		StringCache m_stringCache;
 
 		StreamIndexedIO::StreamFilePtr m_stream;
@@ -1126,6 +1394,37 @@ class StreamIndexedIO::Index : public RefCounted
 		int m_decompressionThreadCount;
 		std::optional<size_t> m_maxCompressedBlockSize;
 		std::string m_compressor;
+		/// Indexed by DataCategory.
+		CompressionPolicy m_compressionPolicies[NumDataCategories];
+
+		/// Maximum total size in bytes of the paged subindexes, or 0 for
+		/// no limit, in which case pages are never evicted.
+		size_t m_indexCacheSize;
+
+		/// A subindex that has been paged in. Pages are evicted in the
+		/// order they were loaded.
+		struct Page
+		{
+			SubIndexNode *subIndex;
+			/// Pinned by this page, so that parents are always evicted after
+			/// their children.
+			SubIndexNode *parentPage;
+			/// Size of the uncompressed subindex, used as an estimate of memory usage.
+			size_t size;
+		};
+
+		std::mutex m_pagesMutex;
+		std::list<Page> m_pages;
+		size_t m_pagesSize;
+
+		/// Evicts unpinned pages until we're within `m_indexCacheSize`.
+		/// Must be called with `m_pagesMutex` locked.
+		void evictPages();
+
+		/// Reads the children of `n` from the subindex at `n->offset()`, returning
+		/// the size of the uncompressed subindex. Must be called with the stream
+		/// mutex locked.
+		size_t readSubIndex( DirectoryNode *n );
 
 		struct FreePage
 		{
@@ -1219,6 +1518,10 @@ void NodeBase::destroy( NodeBase *n )
 		case NodeBase::SubIndex :
 			{
 				SubIndexNode *dn = static_cast< SubIndexNode *>(n);
+				if( DirectoryNode *directory = dn->directory() )
+				{
+					destroy( directory );
+				}
 				delete dn;
 				break;
 			}
@@ -1256,10 +1559,6 @@ void DirectoryNode::registerChild( NodeBase* c )
 		}
 		childNode->m_parent = this;
 	}
-	else if ( c->nodeType() == NodeBase::SubIndex )
-	{
-		m_subindexChildren = true;
-	}
 	m_children.push_back( c );
 	m_sortedChildren = false;
 }
@@ -1302,23 +1601,36 @@ void DirectoryNode::recoveredSubIndex()
 //
 ///////////////////////////////////////////////
 
-StreamIndexedIO::Node::Node(Index* index, DirectoryNode *dirNode) : m_idx(index), m_node(dirNode)
+StreamIndexedIO::Node::Node(Index* index, DirectoryNode *dirNode, SubIndexNode *page) : m_idx(index), m_node(dirNode), m_page(page)
 {
 }
 
+StreamIndexedIO::Node::~Node()
+{
+	if( m_page )
+	{
+		m_page->unpin();
+	}
+}
+
+void StreamIndexedIO::Node::setDirectory( DirectoryNode *dirNode, SubIndexNode *page )
+{
+	if( m_page )
+	{
+		m_page->unpin();
+	}
+	m_node = dirNode;
+	m_page = page;
+}
+
 bool StreamIndexedIO::Node::hasChild( const IndexedIO::EntryID &name ) const
 {
-	Index::MutexLock lock;
-	m_idx->lockDirectory( lock, m_node );
 	DirectoryNode::ChildMap::const_iterator cit = m_node->findChild( name );
 	return cit != m_node->children().end();
 }
 
-DirectoryNode* StreamIndexedIO::Node::directoryChild( const IndexedIO::EntryID &name ) const
+DirectoryNode* StreamIndexedIO::Node::directoryChild( const IndexedIO::EntryID &name, SubIndexNode *&page ) const
 {
-	Index::MutexLock lock;
-	m_idx->lockDirectory( lock, m_node );
-
 	DirectoryNode::ChildMap::iterator it = m_node->findChild( name );
 	if ( it != m_node->children().end() )
 	{
@@ -1328,45 +1640,25 @@ DirectoryNode* StreamIndexedIO::Node::directoryChild( const IndexedIO::EntryID &
 
 			if ( dir->subindex() == DirectoryNode::SavedSubIndex )
 			{
-				if ( m_node->subindexChildren() )
-				{
-					lock.release();		/// we will not change the children dictionary, so we release the lock!
-				}
-
 				// this can occur when the user flushed a directory and right after tries to access it.
 				m_idx->readNodeFromSubIndex( dir );
 			}
+
+			// The child lives in the same page as we do, so can't be
+			// evicted while we have it pinned.
+			if( m_page )
+			{
+				m_page->pin();
+			}
+			page = m_page;
 			return dir;
 		}
 		else if ( (*it)->nodeType() == NodeBase::SubIndex )
 		{
 			SubIndexNode *subIndex = static_cast< SubIndexNode *>( (*it) );
-
-			// build a Directory that knows it's flushed to a subindex.
-			DirectoryNode *newDir = new DirectoryNode( subIndex, m_node );
-
-			lock.release();		/// we release the lock while loading data..
-
-			m_idx->readNodeFromSubIndex( newDir );
-
-			// now that we loaded the whole thing, lock our Index for writing
-			m_idx->lockDirectory( lock, m_node, true );
-
-			// there's a chance that someone else already replaced the pointer...
-			if ( (*it)->nodeType() == NodeBase::Directory )
-			{
-				lock.release();		/// we release the lock because we won't change the children anyways..
-				NodeBase::destroy( newDir );
-				return static_cast< DirectoryNode *>(*it);
-			}
-
-			// replace SubIndex by Directory node.
-			(*it) = newDir;
-
-			// and now we are ok to delete the SubIndexNode..
-			delete subIndex;
-
-			return newDir;
+			DirectoryNode *dir = m_idx->pageIn( subIndex, m_node, m_page );
+			page = m_idx->evictsPages() ? subIndex : nullptr;
+			return dir;
 		}
 	}
 	return nullptr;
@@ -1374,9 +1666,6 @@ DirectoryNode* StreamIndexedIO::Node::directoryChild( const IndexedIO::EntryID &
 
 bool StreamIndexedIO::Node::dataChildInfo( const IndexedIO::EntryID &name, Info &info ) const
 {
-	Index::MutexLock lock;
-	m_idx->lockDirectory( lock, m_node );
-
 	DirectoryNode::ChildMap::const_iterator cit = m_node->findChild( name );
 	if ( cit != m_node->children().end() )
 	{
@@ -1494,9 +1783,6 @@ void StreamIndexedIO::Node::childNames( IndexedIO::EntryIDList &names ) const
 	names.clear();
 	names.reserve( m_node->children().size() );
 
-	Index::MutexLock lock;
-	m_idx->lockDirectory( lock, m_node );
-
 	for ( DirectoryNode::ChildMap::const_iterator cit = m_node->children().begin(); cit != m_node->children().end(); cit++ )
 	{
 		names.push_back( (*cit)->name() );
@@ -1510,9 +1796,6 @@ void StreamIndexedIO::Node::childNames( IndexedIO::EntryIDList &names, IndexedIO
 
 	bool typeIsDirectory = ( type == IndexedIO::Directory );
 
-	Index::MutexLock lock;
-	m_idx->lockDirectory( lock, m_node );
-
 	for ( DirectoryNode::ChildMap::const_iterator cit = m_node->children().begin(); cit != m_node->children().end(); cit++ )
 	{
 		NodeBase *cc = *cit;
@@ -1563,7 +1846,8 @@ StreamIndexedIO::Index::Index( StreamIndexedIO::StreamFilePtr stream, const Comp
 	m_next( 0 ),
 	m_stream( stream ), m_compressionLevel( 0 ),
 	m_compressionThreadCount(1),
-	m_decompressionThreadCount(1), m_compressor( "lz4" )
+	m_decompressionThreadCount(1), m_compressor( "lz4" ),
+	m_indexCacheSize( 0 ), m_pagesSize( 0 )
 
 {
 	m_stringCache.add(IndexedIO::rootName);
@@ -1604,6 +1888,16 @@ StreamIndexedIO::Index::Index( StreamIndexedIO::StreamFilePtr stream, const Comp
 		{
 			m_maxCompressedBlockSize = maxCompressedBlockSize->readable();
 		}
+
+		// Pages can only be evicted when reading, because otherwise the
+		// nodes they contain may be referenced by edits to the index.
+		if ( const UInt64Data* indexCacheSize = options->member<UInt64Data>("indexCacheSize", false) )
+		{
+			if( !( m_stream->openMode() & ( IndexedIO::Write | IndexedIO::Append ) ) )
+			{
+				m_indexCacheSize = indexCacheSize->readable();
+			}
+		}
 	}
 
 	// validate our parameters
@@ -1611,11 +1905,66 @@ StreamIndexedIO::Index::Index( StreamIndexedIO::StreamFilePtr stream, const Comp
 	m_compressionThreadCount = std::min( std::max( 1, m_compressionThreadCount ), 32 );
 	m_decompressionThreadCount = std::min( std::max( 1, m_decompressionThreadCount ), 32 );
 
-	if ( getCompressionCode( m_compressor ) == -1)
+	if ( getCompressionCode( m_compressor ) == -1 || blosc_compname_to_compcode( m_compressor.c_str() ) == -1 )
 	{
 		m_compressor = "lz4";
 	}
 
+	// Each category of data starts with the global settings, which may then be
+	// overridden by a CompoundData for the category in "compressionPolicies".
+
+	const CompoundData *policies = options ? options->member<CompoundData>( "compressionPolicies", false ) : nullptr;
+	for( int i = 0; i < NumDataCategories; ++i )
+	{
+		CompressionPolicy &policy = m_compressionPolicies[i];
+		policy = { m_compressor, m_compressionLevel, BLOSC_SHUFFLE, 4 };
+
+		const CompoundData *policyData = policies ? policies->member<CompoundData>( g_dataCategoryNames[i], false ) : nullptr;
+		if( !policyData )
+		{
+			continue;
+		}
+
+		if( const StringData *compressor = policyData->member<StringData>( "compressor", false ) )
+		{
+			if( getCompressionCode( compressor->readable() ) != -1 && blosc_compname_to_compcode( compressor->readable().c_str() ) != -1 )
+			{
+				policy.compressor = compressor->readable();
+			}
+		}
+
+		if( const IntData *compressionLevel = policyData->member<IntData>( "compressionLevel", false ) )
+		{
+			policy.level = std::clamp( compressionLevel->readable(), 0, 9 );
+		}
+
+		if( const StringData *shuffle = policyData->member<StringData>( "shuffle", false ) )
+		{
+			if( shuffle->readable() == "none" )
+			{
+				policy.shuffle = BLOSC_NOSHUFFLE;
+			}
+			else if( shuffle->readable() == "byte" )
+			{
+				policy.shuffle = BLOSC_SHUFFLE;
+			}
+			else if( shuffle->readable() == "bit" )
+			{
+				policy.shuffle = BLOSC_BITSHUFFLE;
+			}
+			else
+			{
+				throw InvalidArgumentException( boost::str( boost::format( "StreamIndexedIO : Invalid shuffle \"%s\" for \"%s\" compression policy" ) % shuffle->readable() % g_dataCategoryNames[i] ) );
+			}
+		}
+
+		if( const IntData *typeSize = policyData->member<IntData>( "typeSize", false ) )
+		{
+			// Zero is used to request the natural element size of the data being written.
+			policy.typeSize = std::clamp( typeSize->readable(), 0, BLOSC_MAX_TYPESIZE );
+		}
+	}
+
 }
 
 StreamIndexedIO::Index::~Index()
@@ -2288,7 +2637,7 @@ uint64_t StreamIndexedIO::Index::write()
 	sink.get(indexData, indexDataSize);
 
 	std::vector<char> compressedIndex;
-	compress( indexData, indexDataSize, compressedIndex, indexCompressionLevel, indexCompressor, 1, BLOSC_MAX_BUFFERSIZE, 0);
+	compress( indexData, indexDataSize, compressedIndex, g_indexCompressionPolicy, 1, BLOSC_MAX_BUFFERSIZE, 0 );
 
 	f.write( &compressedIndex[0], compressedIndex.size() );
 
@@ -2502,12 +2851,32 @@ uint64_t StreamIndexedIO::Index::writeUniqueData( const char *data, size_t size,
 {
 	m_hasChanged = true;
 
-	/// Find next writable location
-	uint64_t loc;
-
 	// compute hash for the data
-	MurmurHash hash;
-	hash.append( data, size );
+	const MurmurHash hash = hashData( data, size );
+
+	if ( size >= UINT32_MAX )
+	{
+		throw IOException( "StreamIndexedIO: Data size too long!" );
+	}
+
+	const uint64_t totalSize = prefixSize ? size + sizeof( uint32_t ) : size;
+
+	// see if it's already stored by another node..
+	HashToDataMap::const_iterator it = m_hashToDataMap.find( HashAndSize( hash, totalSize ) );
+	if ( it != m_hashToDataMap.end() )
+	{
+		// we already saved this data, so we dont save any additional data
+		return it->second;
+	}
+
+	const uint64_t loc = writeData( data, size, prefixSize );
+	m_hashToDataMap[HashAndSize( hash, totalSize )] = loc;
+	return loc;
+}
+
+uint64_t StreamIndexedIO::Index::writeData( const char *data, size_t size, bool prefixSize )
+{
+	m_hasChanged = true;
 
 	if ( size >= UINT32_MAX )
 	{
@@ -2521,17 +2890,8 @@ uint64_t StreamIndexedIO::Index::writeUniqueData( const char *data, size_t size,
 		totalSize += sizeof( clampedSize );
 	}
 
-	// see if it's already stored by another node..
-	std::pair< HashToDataMap::iterator,bool > ret = m_hashToDataMap.insert( HashToDataMap::value_type( std::pair< MurmurHash,uint64_t>(hash,totalSize), 0 ) );
-	if ( !ret.second )
-	{
-		// we already saved this data, so we dont save any additional data
-		return ret.first->second;
-	}
-
-	/// New data, find next writable location.
-	loc = allocate( totalSize );
-	ret.first->second = loc;
+	/// Find next writable location
+	uint64_t loc = allocate( totalSize );
 
 	/// Seek 'write' pointer to writable location
 	m_stream->seekp( loc, std::ios::beg );
@@ -2547,33 +2907,62 @@ uint64_t StreamIndexedIO::Index::writeUniqueData( const char *data, size_t size,
 	return loc;
 }
 
-StreamIndexedIO::Index::WriteInfo StreamIndexedIO::Index::writeUniqueDataCompressed( const char *data, size_t size, bool prefixSize )
+StreamIndexedIO::Index::WriteInfo StreamIndexedIO::Index::writeUniqueDataCompressed( const char *data, size_t size, IndexedIO::DataType dataType, bool prefixSize )
 {
+	CompressionPolicy policy = m_compressionPolicies[dataCategory( dataType )];
+	if( !policy.typeSize )
+	{
+		policy.typeSize = elementSize( dataType );
+	}
+
+	// See if we've already written this data with the same policy, in
+	// which case we can avoid compressing it again. Compression is
+	// deterministic for a given policy, so the previous result is still
+	// valid. Identical bytes written with different policies are stored
+	// separately, so that each is compressed as its policy requests.
+
+	MurmurHash hash = hashData( data, size );
+	hash.append( policy.compressor );
+	hash.append( policy.level );
+	hash.append( policy.shuffle );
+	hash.append( (uint64_t)policy.typeSize );
+
+	const HashAndSize key( hash, prefixSize ? size + sizeof( uint32_t ) : size );
+	HashToWriteInfoMap::const_iterator it = m_hashToWriteInfoMap.find( key );
+	if( it != m_hashToWriteInfoMap.end() )
+	{
+		m_hasChanged = true;
+		return it->second;
+	}
+
 	WriteInfo writeInfo;
 
 	std::vector<char> compressedBuffer;
 	size_t numBlocks = 0;
 
-	if ( m_compressionLevel )
+	if ( policy.level )
 	{
-		numBlocks = compress( data, size, compressedBuffer, m_compressionLevel, m_compressor, m_compressionThreadCount, m_maxCompressedBlockSize );
+		numBlocks = compress( data, size, compressedBuffer, policy, m_compressionThreadCount, m_maxCompressedBlockSize );
 	}
 
 	//! if compression fails or produces a buffer larger than the original
 	//! write the original source data uncompressed
+	//! Since compression is lossless, distinct source data can't produce identical
+	//! output, so there's no need to hash the compressed data again.
 	if( numBlocks && !compressedBuffer.empty() && ( compressedBuffer.size() < size ) )
 	{
-		writeInfo.offset = writeUniqueData( compressedBuffer.data(), compressedBuffer.size(), prefixSize );
+		writeInfo.offset = writeData( compressedBuffer.data(), compressedBuffer.size(), prefixSize );
 		writeInfo.size = compressedBuffer.size();
 		writeInfo.numCompressedBlocks = numBlocks;
 	}
 	else
 	{
-		writeInfo.offset = writeUniqueData( data, size, prefixSize );
+		writeInfo.offset = writeData( data, size, prefixSize );
 		writeInfo.size = size;
 		writeInfo.numCompressedBlocks = 0;
 	}
 
+	m_hashToWriteInfoMap[key] = writeInfo;
 
 	return writeInfo;
 }
@@ -2629,7 +3018,7 @@ void StreamIndexedIO::Index::commitNodeToSubIndex( DirectoryNode *n )
 		sink.get(indexData, indexDataSize);
 
 		std::vector<char> compressedIndex;
-		compress( indexData, indexDataSize, compressedIndex, indexCompressionLevel, indexCompressor, 1, BLOSC_MAX_BUFFERSIZE, 0);
+		compress( indexData, indexDataSize, compressedIndex, g_indexCompressionPolicy, 1, BLOSC_MAX_BUFFERSIZE, 0 );
 
 		uint32_t subindexSize = compressedIndex.size();
 
@@ -2649,6 +3038,14 @@ void StreamIndexedIO::Index::readNodeFromSubIndex( DirectoryNode *n )
 		return;
 	}
 
+	readSubIndex( n );
+
+	/// mark the node as loaded from subindex
+	n->recoveredSubIndex();
+}
+
+size_t StreamIndexedIO::Index::readSubIndex( DirectoryNode *n )
+{
 	m_stream->seekg( n->offset(), std::ios::beg );
 
 	uint32_t subindexSize = 0;
@@ -2657,12 +3054,14 @@ void StreamIndexedIO::Index::readNodeFromSubIndex( DirectoryNode *n )
 	char *data = m_stream->ioBuffer(subindexSize);
 	m_stream->read( data, subindexSize );
 
+	size_t uncompressedSize = subindexSize;
 	io::filtering_istream indexInStream;
 
 	if (m_version >= 7)
 	{
 		std::vector<char> decompressedIndex;
 		decompress( data, subindexSize, decompressedIndex, 1 );
+		uncompressedSize = decompressedIndex.size();
 
 		MemoryStreamSource source( &decompressedIndex[0], decompressedIndex.size(), false );
 		indexInStream.push( source );
@@ -2700,22 +3099,134 @@ void StreamIndexedIO::Index::readNodeFromSubIndex( DirectoryNode *n )
 	/// make sure the children is sorted to avoid non-thread safe sorting happening later...
 	n->sortChildren();
 
-	/// mark the node as loaded from subindex
-	n->recoveredSubIndex();
+	return uncompressedSize;
 }
 
-void StreamIndexedIO::Index::lockDirectory( MutexLock &lock, const DirectoryNode *n, bool writeAccess ) const
+DirectoryNode *StreamIndexedIO::Index::pageIn( SubIndexNode *subIndex, DirectoryNode *parent, SubIndexNode *parentPage )
 {
-	if ( n->subindexChildren() )
+	// Fast path for pages which are already loaded. Pages are only modified while
+	// loading, so once we have a pin no locking is needed to read them.
+
+	if( !m_indexCacheSize )
 	{
-		// choose one of the mutexes from the pool (in a deterministic way)
-		size_t v = (size_t)n / sizeof(DirectoryNode*);
-		unsigned int m = ( (v + 1) / 3 ) % MAX_MUTEXES;
+		if( DirectoryNode *directory = subIndex->directory() )
+		{
+			return directory;
+		}
+	}
+	else if( subIndex->pin() )
+	{
+		if( DirectoryNode *directory = subIndex->directory() )
+		{
+			return directory;
+		}
+		subIndex->unpin();
+	}
+
+	// Slow path. Eviction only happens while `m_pagesMutex` is held, so
+	// the page can't be part way through being evicted.
 
-		lock.acquire( m_mutexes[ m ], writeAccess );
+	std::lock_guard<std::mutex> pagesLock( m_pagesMutex );
+	if( m_indexCacheSize )
+	{
+		subIndex->pin();
+	}
+
+	DirectoryNode *directory = subIndex->directory();
+	if( directory )
+	{
+		// Loaded by another thread while we waited for the lock.
+		return directory;
+	}
+
+	directory = new DirectoryNode( subIndex, parent );
+	size_t size = 0;
+	try
+	{
+		StreamFile::MutexLock streamLock( m_stream->mutex() );
+		size = readSubIndex( directory );
+	}
+	catch( ... )
+	{
+		NodeBase::destroy( directory );
+		if( m_indexCacheSize )
+		{
+			subIndex->unpin();
+		}
+		throw;
+	}
+
+	subIndex->setDirectory( directory );
+
+	if( m_indexCacheSize )
+	{
+		if( parentPage )
+		{
+			parentPage->pin();
+		}
+		m_pages.push_back( { subIndex, parentPage, size } );
+		m_pagesSize += size;
+		evictPages();
+	}
+
+	return directory;
+}
+
+void StreamIndexedIO::Index::evictPages()
+{
+	// Evicting a page unpins its parent, which may then be evicted on a
+	// subsequent pass.
+	bool evicted = true;
+	while( evicted && m_pagesSize > m_indexCacheSize )
+	{
+		evicted = false;
+		for( auto it = m_pages.begin(); it != m_pages.end() && m_pagesSize > m_indexCacheSize; )
+		{
+			if( !it->subIndex->beginEviction() )
+			{
+				++it;
+				continue;
+			}
+
+			// Any paged subindexes within the directory would have pinned
+			// it, so we are free to destroy it.
+			NodeBase::destroy( it->subIndex->directory() );
+			it->subIndex->endEviction();
+			if( it->parentPage )
+			{
+				it->parentPage->unpin();
+			}
+
+			m_pagesSize -= it->size;
+			it = m_pages.erase( it );
+			evicted = true;
+		}
 	}
 }
 
+SubIndexNode *StreamIndexedIO::Index::pinPage( DirectoryNode *n )
+{
+	if( !m_indexCacheSize )
+	{
+		return nullptr;
+	}
+
+	for( ; n && n->parent(); n = n->parent() )
+	{
+		if( n->subindex() != DirectoryNode::PagedSubIndex )
+		{
+			continue;
+		}
+		DirectoryNode::ChildMap::iterator it = n->parent()->findChild( n->name() );
+		assert( it != n->parent()->children().end() && (*it)->nodeType() == NodeBase::SubIndex );
+		SubIndexNode *page = static_cast<SubIndexNode *>( *it );
+		page->pin();
+		return page;
+	}
+
+	return nullptr;
+}
+
 ///////////////////////////////////////////////
 //
 // StreamIndexedIO::Index (end)
@@ -2893,7 +3404,6 @@ void StreamIndexedIO::open( StreamFilePtr file, const IndexedIO::EntryIDList &ro
 StreamIndexedIO::~StreamIndexedIO()
 {
 	delete m_node;
-	// \todo Consider a mechanism for deallocating sub-indexes
 }
 
 void StreamIndexedIO::setRoot( const IndexedIO::EntryIDList &root )
@@ -2901,12 +3411,13 @@ void StreamIndexedIO::setRoot( const IndexedIO::EntryIDList &root )
 	IndexedIO::EntryIDList::const_iterator t = root.begin();
 	for ( ; t != root.end(); t++ )
 	{
-		DirectoryNode* childNode = m_node->directoryChild( *t );
+		SubIndexNode *page = nullptr;
+		DirectoryNode* childNode = m_node->directoryChild( *t, page );
 		if ( !childNode )
 		{
 			break;
 		}
-		m_node->m_node = childNode;
+		m_node->setDirectory( childNode, page );
 	}
 	bool found = ( t == root.end() );
 
@@ -2933,7 +3444,7 @@ void StreamIndexedIO::setRoot( const IndexedIO::EntryIDList &root )
 				{
 					throw IOException( "StreamIndexedIO: Cannot create entry '" + (*t).value() + "'" );
 				}
-				m_node->m_node = childNode;
+				m_node->setDirectory( childNode, nullptr );
 			}
 		}
 	}
@@ -2990,7 +3501,8 @@ bool StreamIndexedIO::hasEntry( const IndexedIO::EntryID &name ) const
 IndexedIOPtr StreamIndexedIO::subdirectory( const IndexedIO::EntryID &name, IndexedIO::MissingBehaviour missingBehaviour )
 {
 	assert( m_node );
-	DirectoryNode *childNode = m_node->directoryChild( name );
+	SubIndexNode *page = nullptr;
+	DirectoryNode *childNode = m_node->directoryChild( name, page );
 	if ( !childNode )
 	{
 		if ( missingBehaviour == IndexedIO::CreateIfMissing )
@@ -3011,7 +3523,7 @@ IndexedIOPtr StreamIndexedIO::subdirectory( const IndexedIO::EntryID &name, Inde
 			throw IOException( "StreamIndexedIO: Could not find child '" + name.value() + "'" );
 		}
 	}
-	StreamIndexedIO::Node *newNode = new StreamIndexedIO::Node( m_node->m_idx.get(), childNode );
+	StreamIndexedIO::Node *newNode = new StreamIndexedIO::Node( m_node->m_idx.get(), childNode, page );
 	return duplicate(*newNode);
 }
 
@@ -3019,7 +3531,8 @@ ConstIndexedIOPtr StreamIndexedIO::subdirectory( const IndexedIO::EntryID &name,
 {
 	readable(name);
 	assert( m_node );
-	DirectoryNode *childNode = m_node->directoryChild( name );
+	SubIndexNode *page = nullptr;
+	DirectoryNode *childNode = m_node->directoryChild( name, page );
 	if ( !childNode )
 	{
 		if ( missingBehaviour == IndexedIO::NullIfMissing )
@@ -3032,7 +3545,7 @@ ConstIndexedIOPtr StreamIndexedIO::subdirectory( const IndexedIO::EntryID &name,
 		}
 		throw IOException( "StreamIndexedIO: Could not find child '" + name.value() + "'" );
 	}
-	StreamIndexedIO::Node *newNode = new StreamIndexedIO::Node( m_node->m_idx.get(), childNode );
+	StreamIndexedIO::Node *newNode = new StreamIndexedIO::Node( m_node->m_idx.get(), childNode, page );
 	return duplicate(*newNode);
 }
 
@@ -3094,9 +3607,6 @@ IndexedIO::Entry StreamIndexedIO::entry(const IndexedIO::EntryID &name) const
 	assert( m_node );
 	readable(name);
 
-	Index::MutexLock lock;
-	m_node->m_idx->lockDirectory( lock, m_node->m_node );
-
 	DirectoryNode::ChildMap::iterator it = m_node->m_node->findChild( name );
 	if ( it == m_node->m_node->children().end() )
 	{
@@ -3136,7 +3646,7 @@ IndexedIOPtr StreamIndexedIO::parentDirectory()
 	{
 		return nullptr;
 	}
-	StreamIndexedIO::Node *newNode = new StreamIndexedIO::Node( m_node->m_idx.get(), parentNode );
+	StreamIndexedIO::Node *newNode = new StreamIndexedIO::Node( m_node->m_idx.get(), parentNode, m_node->m_idx->pinPage( parentNode ) );
 	return duplicate(*newNode);
 }
 
@@ -3148,7 +3658,7 @@ ConstIndexedIOPtr StreamIndexedIO::parentDirectory() const
 	{
 		return nullptr;
 	}
-	StreamIndexedIO::Node *newNode = new StreamIndexedIO::Node( m_node->m_idx.get(), parentNode );
+	StreamIndexedIO::Node *newNode = new StreamIndexedIO::Node( m_node->m_idx.get(), parentNode, m_node->m_idx->pinPage( parentNode ) );
 	return duplicate(*newNode);
 }
 
@@ -3161,7 +3671,8 @@ IndexedIOPtr StreamIndexedIO::directory( const IndexedIO::EntryIDList &path, Ind
 	{
 		const IndexedIO::EntryID &name = *pIt;
 
-		DirectoryNode* childNode = newNode->directoryChild( name );
+		SubIndexNode *page = nullptr;
+		DirectoryNode* childNode = newNode->directoryChild( name, page );
 		if ( !childNode )
 		{
 			if ( missingBehaviour == IndexedIO::CreateIfMissing )
@@ -3182,7 +3693,7 @@ IndexedIOPtr StreamIndexedIO::directory( const IndexedIO::EntryIDList &path, Ind
 				throw IOException( "StreamIndexedIO: Could not find child '" + name.value() + "'" );
 			}
 		}
-		newNode->m_node = childNode;
+		newNode->setDirectory( childNode, page );
 	}
 	return duplicate(*newNode.release());
 }
@@ -3221,7 +3732,7 @@ void StreamIndexedIO::write(const IndexedIO::EntryID &name, const InternedString
 
 	IndexedIO::DataFlattenTraits<uint64_t*>::flatten(constIds, arrayLength, data);
 
-	Index::WriteInfo info = index->writeUniqueDataCompressed( data, size );
+	Index::WriteInfo info = index->writeUniqueDataCompressed( data, size, dataType );
 	m_node->addDataChild( name, dataType, arrayLength, info.offset, info.size, size, info.numCompressedBlocks );
 
 	delete [] ids;
@@ -3282,7 +3793,7 @@ void StreamIndexedIO::write(const IndexedIO::EntryID &name, const T *x, size_t a
 	assert(data);
 	IndexedIO::DataFlattenTraits<T*>::flatten(x, arrayLength, data);
 
-	Index::WriteInfo info = m_node->m_idx->writeUniqueDataCompressed( data, size );
+	Index::WriteInfo info = m_node->m_idx->writeUniqueDataCompressed( data, size, dataType );
 	m_node->addDataChild( name, dataType, arrayLength, info.offset, info.size, size, info.numCompressedBlocks );
 }
 
@@ -3295,7 +3806,7 @@ void StreamIndexedIO::rawWrite(const IndexedIO::EntryID &name, const T *x, size_
 	size_t size = IndexedIO::DataSizeTraits<T*>::size(x, arrayLength);
 	IndexedIO::DataType dataType = IndexedIO::DataTypeTraits<T*>::type();
 
-	Index::WriteInfo info = m_node->m_idx->writeUniqueDataCompressed( (char *) x, size );
+	Index::WriteInfo info = m_node->m_idx->writeUniqueDataCompressed( (char *) x, size, dataType );
 	m_node->addDataChild( name, dataType, arrayLength, info.offset, info.size, size, info.numCompressedBlocks );
 }
 
@@ -3312,7 +3823,7 @@ void StreamIndexedIO::write(const IndexedIO::EntryID &name, const T &x)
 	assert(data);
 	IndexedIO::DataFlattenTraits<T>::flatten(x, data);
 
-	Index::WriteInfo info = m_node->m_idx->writeUniqueDataCompressed( data, size );
+	Index::WriteInfo info = m_node->m_idx->writeUniqueDataCompressed( data, size, dataType );
 	m_node->addDataChild( name, dataType, 0, info.offset, info.size, size, info.numCompressedBlocks );
 }
 
@@ -3325,7 +3836,7 @@ void StreamIndexedIO::rawWrite(const IndexedIO::EntryID &name, const T &x)
 	size_t size = IndexedIO::DataSizeTraits<T>::size(x);
 	IndexedIO::DataType dataType = IndexedIO::DataTypeTraits<T>::type();
 
-	Index::WriteInfo info = m_node->m_idx->writeUniqueDataCompressed( (char *) &x, size );
+	Index::WriteInfo info = m_node->m_idx->writeUniqueDataCompressed( (char *) &x, size, dataType );
 	m_node->addDataChild( name, dataType, 0, info.offset, info.size, size, info.numCompressedBlocks );
 }
 
@@ -34,6 +34,8 @@
 
 #include "IECoreGL/MeshPrimitive.h"
 
+#include "IECoreGL/Buffer.h"
+#include "IECoreGL/CachedConverter.h"
 #include "IECoreGL/GL.h"
 #include "IECoreGL/State.h"
 
@@ -69,6 +71,10 @@ class MeshPrimitive::MemberData : public IECore::RefCounted
 		unsigned numTriangles;
 		Imath::Box3f bound;
 
+		// Only used for indexed meshes.
+		IECore::ConstUIntVectorDataPtr vertIds;
+		mutable ConstBufferPtr vertIdsBuffer;
+
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -82,6 +88,15 @@ MeshPrimitive::MeshPrimitive( unsigned numTriangles )
 {
 }
 
+MeshPrimitive::MeshPrimitive( IECore::ConstIntVectorDataPtr vertexIds )
+	:	m_memberData( new MemberData( vertexIds->readable().size() / 3 ) )
+{
+	const std::vector<int> &ids = vertexIds->readable();
+	IECore::UIntVectorDataPtr vertIds = new IECore::UIntVectorData;
+	vertIds->writable().assign( ids.begin(), ids.end() );
+	m_memberData->vertIds = vertIds;
+}
+
 MeshPrimitive::~MeshPrimitive()
 {
 }
@@ -103,7 +118,8 @@ void MeshPrimitive::addPrimitiveVariable( const std::string &name, const IECoreS
 		}
 	}
 
-	if ( primVar.interpolation==IECoreScene::PrimitiveVariable::FaceVarying )
+	const IECoreScene::PrimitiveVariable::Interpolation vertexInterpolation = m_memberData->vertIds ? IECoreScene::PrimitiveVariable::Vertex : IECoreScene::PrimitiveVariable::FaceVarying;
+	if ( primVar.interpolation==vertexInterpolation )
 	{
 		addVertexAttribute( name, primVar.expandedData() );
 	}
@@ -111,6 +127,10 @@ void MeshPrimitive::addPrimitiveVariable( const std::string &name, const IECoreS
 	{
 		addUniformAttribute( name, primVar.expandedData() );
 	}
+	else if ( m_memberData->vertIds )
+	{
+		throw IECore::Exception( "IECoreGL::MeshPrimitive : Invalid interpolation for \"" + name + "\". Must be Vertex or Constant." );
+	}
 	else if ( primVar.interpolation==IECoreScene::PrimitiveVariable::Vertex || primVar.interpolation==IECoreScene::PrimitiveVariable::Varying )
 	{
 		throw( "IECoreGL::MeshPrimitive : Invalid interpolation for \"" + name + "\". Must be FaceVarying or Constant." );
@@ -119,6 +139,21 @@ void MeshPrimitive::addPrimitiveVariable( const std::string &name, const IECoreS
 
 void MeshPrimitive::renderInstances( size_t numInstances ) const
 {
+	if( m_memberData->vertIds )
+	{
+		if( !m_memberData->vertIdsBuffer )
+		{
+			// we don't build the actual buffer until now, because in the constructor we're not guaranteed
+			// a valid GL context.
+			CachedConverterPtr cachedConverter = CachedConverter::defaultCachedConverter();
+			m_memberData->vertIdsBuffer = IECore::runTimeCast<const Buffer>( cachedConverter->convert( m_memberData->vertIds.get() ) );
+		}
+
+		Buffer::ScopedBinding indexBinding( *(m_memberData->vertIdsBuffer), GL_ELEMENT_ARRAY_BUFFER );
+		glDrawElementsInstancedARB( GL_TRIANGLES, m_memberData->vertIds->readable().size(), GL_UNSIGNED_INT, nullptr, numInstances );
+		return;
+	}
+
 	glDrawArraysInstancedARB( GL_TRIANGLES, 0, m_memberData->numTriangles * 3, numInstances );
 }
 
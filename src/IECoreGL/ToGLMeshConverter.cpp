@@ -36,7 +36,6 @@
 
 #include "IECoreGL/MeshPrimitive.h"
 
-#include "IECoreScene/FaceVaryingPromotionOp.h"
 #include "IECoreScene/MeshAlgo.h"
 #include "IECoreScene/MeshNormalsOp.h"
 #include "IECoreScene/MeshPrimitive.h"
@@ -88,14 +87,11 @@ IECore::RunTimeTypedPtr ToGLMeshConverter::doConversion( IECore::ConstObjectPtr
 		normalOp->operate();
 	}
 
-	mesh = IECoreScene::MeshAlgo::triangulate( mesh.get() );
+	// Weld the triangulated face-vertices into indexed vertices, rather than
+	// promoting everything to FaceVarying, to minimise the data uploaded.
+	mesh = IECoreScene::MeshAlgo::triangulateIndexed( mesh.get() );
 
-	IECoreScene::FaceVaryingPromotionOpPtr faceVaryingOp = new IECoreScene::FaceVaryingPromotionOp;
-	faceVaryingOp->inputParameter()->setValue( mesh );
-	faceVaryingOp->copyParameter()->setTypedValue( false );
-	faceVaryingOp->operate();
-
-	MeshPrimitivePtr glMesh = new MeshPrimitive( mesh->numFaces() );
+	MeshPrimitivePtr glMesh = new MeshPrimitive( mesh->vertexIds() );
 
 	for ( IECoreScene::PrimitiveVariableMap::iterator pIt = mesh->variables.begin(); pIt != mesh->variables.end(); ++pIt )
 	{
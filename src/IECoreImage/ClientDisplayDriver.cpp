@@ -44,13 +44,28 @@
 // doesn't fail on macOS as intrusive_ptr needs to be defined via RefCounted.h
 #include "boost/asio.hpp"
 
+#include "IECoreImage/Private/DisplayDriverServerCompression.h"
 #include "IECoreImage/Private/DisplayDriverServerHeader.h"
+#include "IECoreImage/Private/DisplayDriverServerSharedMemory.h"
 
 #include "IECore/MemoryIndexedIO.h"
 #include "IECore/SimpleTypedData.h"
 
 #include "boost/array.hpp"
 #include "boost/bind/bind.hpp"
+#include "boost/format.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "boost/interprocess/shared_memory_object.hpp"
+
+#include "tbb/concurrent_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 using boost::asio::ip::tcp;
@@ -64,13 +79,50 @@ class ClientDisplayDriver::PrivateData : public RefCounted
 {
 	public :
 		PrivateData() :
-		m_service(), m_host(""), m_port(""), m_scanLineOrderOnly(false), m_acceptsRepeatedData(false), m_socket( m_service )
+		m_service(), m_host(""), m_port(""), m_scanLineOrderOnly(false), m_acceptsRepeatedData(false), m_compressed( false ),
+		m_format( DisplayDriverServerCompression::Float ), m_socket( m_service ), m_sharedMemoryPosition( 0 ), m_numSharedMemoryBuckets( 0 ), m_failed( false )
 		{
+			m_queue.set_capacity( 64 );
 		}
 
 		~PrivateData() override
 		{
+			stopSending();
 			m_socket.close();
+			removeSharedMemoryName();
+		}
+
+		// A message waiting to be sent by the send thread. A
+		// Message with an empty payload stops the thread.
+		struct Message
+		{
+			DisplayDriverServerHeader::MessageType type;
+			std::vector<char> payload;
+		};
+
+		void startSending()
+		{
+			m_sendThread = std::thread( [this] { sendMessages(); } );
+		}
+
+		// Waits for all queued messages to be sent, and rethrows
+		// any error encountered while sending them.
+		void stopSending()
+		{
+			if( m_sendThread.joinable() )
+			{
+				m_queue.push( Message{ DisplayDriverServerHeader::imageData, std::vector<char>() } );
+				m_sendThread.join();
+			}
+		}
+
+		void throwIfFailed()
+		{
+			if( m_failed )
+			{
+				std::lock_guard<std::mutex> lock( m_errorMutex );
+				throw Exception( "Error sending data to remote display driver server : " + m_error );
+			}
 		}
 
 		boost::asio::io_service m_service;
@@ -78,7 +130,168 @@ class ClientDisplayDriver::PrivateData : public RefCounted
 		std::string m_port;
 		bool m_scanLineOrderOnly;
 		bool m_acceptsRepeatedData;
+		bool m_compressed;
+		DisplayDriverServerCompression::Format m_format;
 		boost::asio::ip::tcp::socket m_socket;
+
+		// Buckets are queued by `imageData()`, and sent by a separate
+		// thread, so that rendering can continue while data is in transit.
+		// The queue is bounded so that a slow connection applies back
+		// pressure rather than consuming unlimited memory.
+		tbb::concurrent_bounded_queue<Message> m_queue;
+
+		// When the server is on the same host, buckets are copied into a ring
+		// buffer in shared memory, and only a small Notification is sent over
+		// the socket. See DisplayDriverServerSharedMemory.h for details.
+
+		void createSharedMemory( size_t capacity )
+		{
+			static std::atomic<unsigned> g_count( 0 );
+#ifndef _MSC_VER
+			const int pid = getpid();
+#else
+			const int pid = _getpid();
+#endif
+			m_sharedMemoryName = boost::str( boost::format( "IECoreImage.ClientDisplayDriver.%d.%d" ) % pid % g_count++ );
+
+			boost::interprocess::shared_memory_object segment( boost::interprocess::create_only, m_sharedMemoryName.c_str(), boost::interprocess::read_write );
+			segment.truncate( DisplayDriverServerSharedMemory::dataOffset + capacity );
+			m_sharedMemory.reset( new boost::interprocess::mapped_region( segment, boost::interprocess::read_write ) );
+
+			DisplayDriverServerSharedMemory::SegmentHeader *header = new( m_sharedMemory->get_address() ) DisplayDriverServerSharedMemory::SegmentHeader;
+			header->magic = DisplayDriverServerSharedMemory::magicNumber;
+			header->capacity = capacity;
+			header->consumed = 0;
+			header->closed = 0;
+		}
+
+		// The mapping remains valid after the name is removed, so we
+		// remove it as soon as the server has had a chance to open it,
+		// to avoid leaking segments if either process crashes.
+		void removeSharedMemoryName()
+		{
+			if( !m_sharedMemoryName.empty() )
+			{
+				boost::interprocess::shared_memory_object::remove( m_sharedMemoryName.c_str() );
+				m_sharedMemoryName.clear();
+			}
+		}
+
+		DisplayDriverServerSharedMemory::SegmentHeader *sharedMemoryHeader()
+		{
+			return static_cast<DisplayDriverServerSharedMemory::SegmentHeader *>( m_sharedMemory->get_address() );
+		}
+
+		// Copies a bucket into the ring, waiting for the server to consume
+		// earlier buckets if necessary. Returns false if the bucket can't
+		// fit in the ring at all.
+		bool writeSharedMemory( const Box2i &box, const float *data, size_t dataSize )
+		{
+			DisplayDriverServerSharedMemory::SegmentHeader *header = sharedMemoryHeader();
+			const uint64_t capacity = header->capacity;
+			const uint64_t numBytes = dataSize * sizeof( float );
+			if( numBytes > capacity )
+			{
+				return false;
+			}
+
+			// Buckets must be written to the ring in the same order as their
+			// notifications are queued, so we serialise concurrent callers.
+			std::lock_guard<std::mutex> lock( m_sharedMemoryMutex );
+
+			uint64_t position = m_sharedMemoryPosition;
+			if( position % capacity + numBytes > capacity )
+			{
+				// Skip to the start of the ring rather than wrap.
+				position += capacity - position % capacity;
+			}
+
+			while( true )
+			{
+				uint64_t consumed = header->consumed.load( std::memory_order_acquire );
+				if( consumed == m_sharedMemoryPosition )
+				{
+					// Everything has been consumed, including any space
+					// we skipped above, which the server never sees.
+					consumed = position;
+				}
+				if( position + numBytes - consumed <= capacity )
+				{
+					break;
+				}
+
+				throwIfFailed();
+				if( header->closed.load( std::memory_order_acquire ) )
+				{
+					throw Exception( "Remote display driver server closed shared memory connection" );
+				}
+				std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+			}
+
+			char *ring = static_cast<char *>( m_sharedMemory->get_address() ) + DisplayDriverServerSharedMemory::dataOffset;
+			memcpy( ring + position % capacity, data, numBytes );
+			m_sharedMemoryPosition = position + numBytes;
+			m_numSharedMemoryBuckets++;
+
+			const DisplayDriverServerSharedMemory::Notification notification = { box, position, numBytes };
+			Message message;
+			message.type = DisplayDriverServerHeader::imageDataShared;
+			message.payload.resize( sizeof( notification ) );
+			memcpy( message.payload.data(), &notification, sizeof( notification ) );
+			m_queue.push( std::move( message ) );
+
+			return true;
+		}
+
+		std::string m_sharedMemoryName;
+		std::unique_ptr<boost::interprocess::mapped_region> m_sharedMemory;
+		std::mutex m_sharedMemoryMutex;
+		uint64_t m_sharedMemoryPosition;
+		std::atomic<size_t> m_numSharedMemoryBuckets;
+
+	private :
+
+		void sendMessages()
+		{
+			Message message;
+			while( true )
+			{
+				m_queue.pop( message );
+				if( message.payload.empty() )
+				{
+					return;
+				}
+
+				if( m_failed )
+				{
+					// Keep draining the queue so that `imageData()`
+					// doesn't block, and report the error from there.
+					continue;
+				}
+
+				try
+				{
+					DisplayDriverServerHeader header( message.type, message.payload.size() );
+					boost::array<boost::asio::const_buffer, 2> buffers = { {
+						boost::asio::buffer( header.buffer(), header.headerLength ),
+						boost::asio::buffer( message.payload )
+					} };
+					boost::asio::write( m_socket, buffers );
+				}
+				catch( const std::exception &e )
+				{
+					std::lock_guard<std::mutex> lock( m_errorMutex );
+					m_error = e.what();
+					m_failed = true;
+				}
+			}
+		}
+
+		std::thread m_sendThread;
+		std::atomic<bool> m_failed;
+		std::mutex m_errorMutex;
+		std::string m_error;
+
 };
 
 IE_CORE_DEFINERUNTIMETYPED( ClientDisplayDriver );
@@ -96,6 +309,32 @@ ClientDisplayDriver::ClientDisplayDriver( const Imath::Box2i &displayWindow, con
 	m_data->m_host = displayHostData->readable();
 	m_data->m_port = displayPortData->readable();
 
+	bool requestCompression = false;
+	if( const StringData *compressionData = parameters->member<StringData>( "displayCompression" ) )
+	{
+		const std::string &compression = compressionData->readable();
+		if( compression == "lossless" )
+		{
+			m_data->m_format = DisplayDriverServerCompression::Float;
+			requestCompression = true;
+		}
+		else if( compression == "half" )
+		{
+			m_data->m_format = DisplayDriverServerCompression::Half;
+			requestCompression = true;
+		}
+		else if( compression != "none" )
+		{
+			throw InvalidArgumentException( "Unknown displayCompression \"" + compression + "\"" );
+		}
+	}
+
+	bool requestSharedMemory = false;
+	if( const BoolData *sharedMemoryData = parameters->member<BoolData>( "displaySharedMemory" ) )
+	{
+		requestSharedMemory = sharedMemoryData->readable();
+	}
+
 	tcp::resolver resolver(m_data->m_service);
 	tcp::resolver::query query(m_data->m_host, m_data->m_port);
 
@@ -127,6 +366,30 @@ ClientDisplayDriver::ClientDisplayDriver( const Imath::Box2i &displayWindow, con
 #else
 	tmpParameters->writable()[ "clientPID" ] = new IntData( _getpid() );
 #endif
+	if( requestCompression )
+	{
+		tmpParameters->writable()[ DisplayDriverServerHeader::compressionParameter ] = new BoolData( true );
+	}
+	if( requestSharedMemory )
+	{
+		// Size the ring to hold the whole image where possible, so that the
+		// server never holds up rendering, within reasonable limits.
+		const size_t imageBytes = ( (size_t)dataWindow.size().x + 1 ) * ( (size_t)dataWindow.size().y + 1 ) * channelNames.size() * sizeof( float );
+		const size_t capacity = ( std::clamp<size_t>( imageBytes, 1024 * 1024, 256 * 1024 * 1024 ) + 63 ) & ~size_t( 63 );
+		try
+		{
+			m_data->createSharedMemory( capacity );
+			tmpParameters->writable()[ DisplayDriverServerHeader::sharedMemoryParameter ] = new StringData( m_data->m_sharedMemoryName );
+		}
+		catch( const boost::interprocess::interprocess_exception & )
+		{
+			// Shared memory is only an optimisation, so we fall back to
+			// sending data over the socket.
+			m_data->m_sharedMemory.reset();
+			m_data->removeSharedMemoryName();
+			requestSharedMemory = false;
+		}
+	}
 
 	// build the data block
 	io = new MemoryIndexedIO( ConstCharVectorDataPtr(), IndexedIO::rootPath, IndexedIO::Exclusive | IndexedIO::Write );
@@ -148,11 +411,24 @@ ClientDisplayDriver::ClientDisplayDriver( const Imath::Box2i &displayWindow, con
 	}
 	m_data->m_socket.receive( boost::asio::buffer( &m_data->m_scanLineOrderOnly, sizeof(m_data->m_scanLineOrderOnly) ) );
 
-	if ( receiveHeader( DisplayDriverServerHeader::imageOpen ) != sizeof(m_data->m_acceptsRepeatedData) )
+	// Servers which support optional features append their status to the
+	// acceptsRepeatedData reply, but only when we have requested one.
+	const size_t replySize = receiveHeader( DisplayDriverServerHeader::imageOpen );
+	if ( replySize != 1 && !( replySize == 3 && ( requestCompression || requestSharedMemory ) ) )
 	{
 		throw Exception( "Invalid returned acceptsRepeatedData from display driver server!" );
 	}
-	m_data->m_socket.receive( boost::asio::buffer( &m_data->m_acceptsRepeatedData, sizeof(m_data->m_acceptsRepeatedData) ) );
+	unsigned char reply[3] = { 0, 0, 0 };
+	boost::asio::read( m_data->m_socket, boost::asio::buffer( reply, replySize ) );
+	m_data->m_acceptsRepeatedData = reply[0];
+	m_data->m_compressed = requestCompression && reply[1];
+	if( !reply[2] )
+	{
+		m_data->m_sharedMemory.reset();
+	}
+	m_data->removeSharedMemoryName();
+
+	m_data->startSending();
 }
 
 ClientDisplayDriver::~ClientDisplayDriver()
@@ -169,6 +445,16 @@ std::string ClientDisplayDriver::port() const
 	return m_data->m_port;
 }
 
+bool ClientDisplayDriver::sharedMemory() const
+{
+	return (bool)m_data->m_sharedMemory;
+}
+
+size_t ClientDisplayDriver::numSharedMemoryBuckets() const
+{
+	return m_data->m_numSharedMemoryBuckets;
+}
+
 bool ClientDisplayDriver::scanLineOrderOnly() const
 {
 	return m_data->m_scanLineOrderOnly;
@@ -211,17 +497,35 @@ size_t ClientDisplayDriver::receiveHeader( int msg )
 
 void ClientDisplayDriver::imageData( const Box2i &box, const float *data, size_t dataSize )
 {
-	sendHeader( DisplayDriverServerHeader::imageData, sizeof( box ) + dataSize * sizeof( float ) );
+	m_data->throwIfFailed();
 
-	boost::array<boost::asio::const_buffer, 2> buffers = { {
-		boost::asio::buffer( &box, sizeof( box ) ),
-		boost::asio::buffer( data, dataSize * sizeof( float ) )
-	} };
-	boost::asio::write( m_data->m_socket, buffers );
+	if( m_data->m_sharedMemory && m_data->writeSharedMemory( box, data, dataSize ) )
+	{
+		return;
+	}
+
+	PrivateData::Message message;
+	if( m_data->m_compressed )
+	{
+		message.type = DisplayDriverServerHeader::imageDataCompressed;
+		DisplayDriverServerCompression::compress( box, data, dataSize, m_data->m_format, message.payload );
+	}
+	else
+	{
+		message.type = DisplayDriverServerHeader::imageData;
+		message.payload.resize( sizeof( box ) + dataSize * sizeof( float ) );
+		memcpy( message.payload.data(), &box, sizeof( box ) );
+		memcpy( message.payload.data() + sizeof( box ), data, dataSize * sizeof( float ) );
+	}
+
+	m_data->m_queue.push( std::move( message ) );
 }
 
 void ClientDisplayDriver::imageClose()
 {
+	m_data->stopSending();
+	m_data->throwIfFailed();
+
 	sendHeader( DisplayDriverServerHeader::imageClose, 0 );
 	receiveHeader( DisplayDriverServerHeader::imageClose );
 	m_data->m_socket.close();
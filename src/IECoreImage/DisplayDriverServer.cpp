@@ -43,7 +43,9 @@
 // doesn't fail on macOS as intrusive_ptr needs to be defined via RefCounted.h
 #include "boost/asio.hpp"
 
+#include "IECoreImage/Private/DisplayDriverServerCompression.h"
 #include "IECoreImage/Private/DisplayDriverServerHeader.h"
+#include "IECoreImage/Private/DisplayDriverServerSharedMemory.h"
 
 #include "IECore/Exception.h"
 #include "IECore/MemoryIndexedIO.h"
@@ -51,7 +53,12 @@
 #include "IECore/SimpleTypedData.h"
 
 #include "boost/bind/bind.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "boost/interprocess/shared_memory_object.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
 #include <thread>
 
 #include <fcntl.h>
@@ -105,7 +112,8 @@ class DisplayDriverServer::Session : public RefCounted
 
 		void handleReadHeader( const boost::system::error_code& error );
 		void handleReadOpenParameters( const boost::system::error_code& error );
-		void handleReadDataParameters( const boost::system::error_code& error );
+		void handleReadDataParameters( const boost::system::error_code& error, DisplayDriverServerHeader::MessageType messageType );
+		bool openSharedMemory( const std::string &name );
 		void sendResult( DisplayDriverServerHeader::MessageType msg, size_t dataSize );
 		void sendException( const char *message );
 
@@ -114,6 +122,8 @@ class DisplayDriverServer::Session : public RefCounted
 		DisplayDriverPtr m_displayDriver;
 		DisplayDriverServerHeader m_header;
 		CharVectorDataPtr m_buffer;
+		std::vector<float> m_decompressedBuffer;
+		std::unique_ptr<boost::interprocess::mapped_region> m_sharedMemory;
 };
 
 class DisplayDriverServer::PrivateData : public RefCounted
@@ -124,12 +134,11 @@ class DisplayDriverServer::PrivateData : public RefCounted
 		boost::asio::ip::tcp::endpoint m_endpoint;
 		boost::asio::io_service m_service;
 		boost::asio::ip::tcp::acceptor m_acceptor;
-		std::thread m_thread;
+		std::vector<std::thread> m_threads;
 
 		PrivateData( DisplayDriverServer::Port portNumber ) :
 			m_service(),
-			m_acceptor( m_service ),
-			m_thread()
+			m_acceptor( m_service )
 		{
 			if( g_portRange.first != std::numeric_limits<DisplayDriverServer::Port>::min() || g_portRange.second != std::numeric_limits<DisplayDriverServer::Port>::max() )
 			{
@@ -170,7 +179,10 @@ class DisplayDriverServer::PrivateData : public RefCounted
 		{
 			m_acceptor.cancel();
 			m_acceptor.close();
-			m_thread.join();
+			for( auto &thread : m_threads )
+			{
+				thread.join();
+			}
 		}
 
 		void openPort( DisplayDriverServer::Port portNumber )
@@ -200,8 +212,15 @@ DisplayDriverServer::DisplayDriverServer( DisplayDriverServer::Port portNumber )
 			boost::bind( &DisplayDriverServer::handleAccept, this, newSession,
 			boost::asio::placeholders::error));
 	fixSocketFlags( m_data->m_acceptor.native_handle() );
-	std::thread newThread( boost::bind(&DisplayDriverServer::serverThread, this) );
-	m_data->m_thread.swap( newThread );
+
+	// Each session only ever has one operation in flight, so its handlers
+	// are never run concurrently. But with a pool of threads, separate
+	// sessions may receive and process data in parallel.
+	const unsigned numThreads = std::clamp( std::thread::hardware_concurrency(), 1u, 8u );
+	for( unsigned i = 0; i < numThreads; ++i )
+	{
+		m_data->m_threads.emplace_back( boost::bind( &DisplayDriverServer::serverThread, this ) );
+	}
 }
 
 DisplayDriverServer::~DisplayDriverServer()
@@ -298,6 +317,12 @@ DisplayDriverServer::Session::Session( boost::asio::io_service& io_service ) :
 
 DisplayDriverServer::Session::~Session()
 {
+	if( m_sharedMemory )
+	{
+		// Let a client waiting for space in the ring know that
+		// it isn't coming.
+		static_cast<DisplayDriverServerSharedMemory::SegmentHeader *>( m_sharedMemory->get_address() )->closed.store( 1, std::memory_order_release );
+	}
 	m_socket.close();
 }
 
@@ -351,10 +376,12 @@ void DisplayDriverServer::Session::handleReadHeader( const boost::system::error_
 		break;
 
 	case DisplayDriverServerHeader::imageData:
+	case DisplayDriverServerHeader::imageDataCompressed:
+	case DisplayDriverServerHeader::imageDataShared:
 		boost::asio::async_read( m_socket,
 				boost::asio::buffer( &data[0], bytesAhead ),
 				boost::bind(&DisplayDriverServer::Session::handleReadDataParameters, SessionPtr(this),
-				boost::asio::placeholders::error));
+				boost::asio::placeholders::error, m_header.messageType() ));
 		break;
 
 	case DisplayDriverServerHeader::imageClose:
@@ -410,6 +437,9 @@ void DisplayDriverServer::Session::handleReadOpenParameters( const boost::system
 	CompoundDataPtr parameters;
 	bool scanLineOrder = false;
 	bool acceptsRepeatedData = false;
+	bool compressionRequested = false;
+	bool sharedMemoryRequested = false;
+	bool sharedMemoryOpened = false;
 
 	// handle imageOpen parameters.
 	try
@@ -420,6 +450,20 @@ void DisplayDriverServer::Session::handleReadOpenParameters( const boost::system
 		channelNames = boost::static_pointer_cast<StringVectorData>( Object::load( io, "channelNames" ) );
 		parameters = boost::static_pointer_cast<CompoundData>( Object::load( io, "parameters" ) );
 
+		// The compression request is for us rather than the display driver.
+		if( const BoolData *compression = parameters->member<BoolData>( DisplayDriverServerHeader::compressionParameter ) )
+		{
+			compressionRequested = compression->readable();
+			parameters->writable().erase( DisplayDriverServerHeader::compressionParameter );
+		}
+
+		if( const StringData *sharedMemory = parameters->member<StringData>( DisplayDriverServerHeader::sharedMemoryParameter ) )
+		{
+			sharedMemoryRequested = true;
+			sharedMemoryOpened = openSharedMemory( sharedMemory->readable() );
+			parameters->writable().erase( DisplayDriverServerHeader::sharedMemoryParameter );
+		}
+
 		const StringData *displayType = parameters->member<StringData>( "remoteDisplayType", true /* throw if missing */ );
 
 		// create a displayDriver using the factory function.
@@ -442,8 +486,13 @@ void DisplayDriverServer::Session::handleReadOpenParameters( const boost::system
 		sendResult( DisplayDriverServerHeader::imageOpen, sizeof(scanLineOrder) );
 		m_socket.send( boost::asio::buffer( &scanLineOrder, sizeof(scanLineOrder) ) );
 
-		sendResult( DisplayDriverServerHeader::imageOpen, sizeof(acceptsRepeatedData) );
-		m_socket.send( boost::asio::buffer( &acceptsRepeatedData, sizeof(acceptsRepeatedData) ) );
+		// Clients requesting optional features expect additional bytes saying
+		// whether or not we support them. Older clients don't, so we only send
+		// them on request.
+		const unsigned char reply[3] = { acceptsRepeatedData, 1, sharedMemoryOpened };
+		const size_t replySize = compressionRequested || sharedMemoryRequested ? 3 : 1;
+		sendResult( DisplayDriverServerHeader::imageOpen, replySize );
+		boost::asio::write( m_socket, boost::asio::buffer( reply, replySize ) );
 
 		// prepare for getting imageData packages
 		boost::asio::async_read( m_socket,
@@ -462,7 +511,7 @@ void DisplayDriverServer::Session::handleReadOpenParameters( const boost::system
 
 }
 
-void DisplayDriverServer::Session::handleReadDataParameters( const boost::system::error_code& error )
+void DisplayDriverServer::Session::handleReadDataParameters( const boost::system::error_code& error, DisplayDriverServerHeader::MessageType messageType )
 {
 	if (error)
 	{
@@ -485,13 +534,60 @@ void DisplayDriverServer::Session::handleReadDataParameters( const boost::system
 		/// We used to send the data via MemoryIndexedIO which would take care of this
 		/// for us, but the overhead of this significantly affected interactive render
 		/// speeds.
-		const Imath::Box2i box = *reinterpret_cast<const Imath::Box2i *>( &m_buffer->readable()[0] );
-		const float *data = reinterpret_cast<const float *>( &m_buffer->readable()[0] + sizeof( box ) );
-		const size_t dataSize = ( m_buffer->readable().size() - sizeof( box ) ) / sizeof( float );
+		Imath::Box2i box;
+		const float *data;
+		size_t dataSize;
+		DisplayDriverServerSharedMemory::SegmentHeader *sharedMemoryHeader = nullptr;
+		uint64_t sharedMemoryEnd = 0;
+		if( messageType == DisplayDriverServerHeader::imageDataShared )
+		{
+			if( !m_sharedMemory || m_buffer->readable().size() != sizeof( DisplayDriverServerSharedMemory::Notification ) )
+			{
+				throw IECore::Exception( "Invalid shared memory notification" );
+			}
+			DisplayDriverServerSharedMemory::Notification notification;
+			memcpy( &notification, m_buffer->readable().data(), sizeof( notification ) );
+
+			// The segment is shared with another process, so we validate
+			// everything rather than trust it.
+			sharedMemoryHeader = static_cast<DisplayDriverServerSharedMemory::SegmentHeader *>( m_sharedMemory->get_address() );
+			const uint64_t capacity = m_sharedMemory->get_size() - DisplayDriverServerSharedMemory::dataOffset;
+			const uint64_t offset = notification.position % capacity;
+			if( notification.numBytes > capacity - offset || notification.numBytes % sizeof( float ) )
+			{
+				throw IECore::Exception( "Invalid shared memory notification" );
+			}
+
+			box = notification.box;
+			data = reinterpret_cast<const float *>( static_cast<const char *>( m_sharedMemory->get_address() ) + DisplayDriverServerSharedMemory::dataOffset + offset );
+			dataSize = notification.numBytes / sizeof( float );
+			sharedMemoryEnd = notification.position + notification.numBytes;
+		}
+		else if( messageType == DisplayDriverServerHeader::imageDataCompressed )
+		{
+			box = DisplayDriverServerCompression::decompress(
+				m_buffer->readable().data(), m_buffer->readable().size(),
+				m_displayDriver->channelNames().size(), m_decompressedBuffer
+			);
+			data = m_decompressedBuffer.data();
+			dataSize = m_decompressedBuffer.size();
+		}
+		else
+		{
+			box = *reinterpret_cast<const Imath::Box2i *>( &m_buffer->readable()[0] );
+			data = reinterpret_cast<const float *>( &m_buffer->readable()[0] + sizeof( box ) );
+			dataSize = ( m_buffer->readable().size() - sizeof( box ) ) / sizeof( float );
+		}
 
 		// call imageData passing the data
 		m_displayDriver->imageData( box, data, dataSize );
 
+		if( sharedMemoryHeader )
+		{
+			// Allow the client to reuse the space.
+			sharedMemoryHeader->consumed.store( sharedMemoryEnd, std::memory_order_release );
+		}
+
 		// prepare for getting more imageData packages or a imageClose.
 		boost::asio::async_read( m_socket,
 			boost::asio::buffer( m_header.buffer(), m_header.headerLength),
@@ -509,6 +605,37 @@ void DisplayDriverServer::Session::handleReadDataParameters( const boost::system
 	}
 }
 
+bool DisplayDriverServer::Session::openSharedMemory( const std::string &name )
+{
+	try
+	{
+		boost::interprocess::shared_memory_object segment( boost::interprocess::open_only, name.c_str(), boost::interprocess::read_write );
+		std::unique_ptr<boost::interprocess::mapped_region> region( new boost::interprocess::mapped_region( segment, boost::interprocess::read_write ) );
+		if( region->get_size() <= DisplayDriverServerSharedMemory::dataOffset )
+		{
+			return false;
+		}
+
+		const auto *header = static_cast<const DisplayDriverServerSharedMemory::SegmentHeader *>( region->get_address() );
+		if(
+			header->magic != DisplayDriverServerSharedMemory::magicNumber ||
+			header->capacity != region->get_size() - DisplayDriverServerSharedMemory::dataOffset
+		)
+		{
+			return false;
+		}
+
+		m_sharedMemory = std::move( region );
+		return true;
+	}
+	catch( const boost::interprocess::interprocess_exception & )
+	{
+		// Most likely the client is on another host, in which case
+		// it will fall back to sending data over the socket.
+		return false;
+	}
+}
+
 void DisplayDriverServer::Session::sendResult( DisplayDriverServerHeader::MessageType msg, size_t dataSize )
 {
 	DisplayDriverServerHeader header( msg, dataSize );
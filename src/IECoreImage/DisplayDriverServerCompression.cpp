@@ -0,0 +1,170 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2026, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "IECoreImage/Private/DisplayDriverServerCompression.h"
+
+#include "IECore/Exception.h"
+#include "IECore/HalfTypeTraits.h"
+
+#include "blosc.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+using namespace IECore;
+using namespace IECoreImage;
+
+namespace
+{
+
+const size_t g_payloadHeaderSize = sizeof( Imath::Box2i ) + 1;
+
+size_t sampleSize( DisplayDriverServerCompression::Format format )
+{
+	return format == DisplayDriverServerCompression::Half ? sizeof( half ) : sizeof( float );
+}
+
+} // namespace
+
+void DisplayDriverServerCompression::compress( const Imath::Box2i &box, const float *data, size_t dataSize, Format format, std::vector<char> &buffer )
+{
+	const void *samples = data;
+	std::vector<half> halfData;
+	if( format == Half )
+	{
+		halfData.assign( data, data + dataSize );
+		samples = halfData.data();
+	}
+
+	const size_t numBytes = dataSize * sampleSize( format );
+	if( numBytes > BLOSC_MAX_BUFFERSIZE )
+	{
+		throw Exception( "DisplayDriverServerCompression : Too much data to compress." );
+	}
+
+	buffer.resize( g_payloadHeaderSize + numBytes + BLOSC_MAX_OVERHEAD );
+	memcpy( buffer.data(), &box, sizeof( box ) );
+	buffer[sizeof( box )] = format;
+
+	// Interactive renders care more about latency than compression ratio,
+	// so we use the fastest settings, relying on the shuffle filter to
+	// group the exponent bytes of the samples together.
+	const int compressedSize = blosc_compress_ctx(
+		1, BLOSC_SHUFFLE, sampleSize( format ), numBytes, samples,
+		buffer.data() + g_payloadHeaderSize, numBytes + BLOSC_MAX_OVERHEAD,
+		"lz4", 0, 1
+	);
+
+	if( compressedSize <= 0 )
+	{
+		throw Exception( "DisplayDriverServerCompression : Failed to compress data." );
+	}
+
+	buffer.resize( g_payloadHeaderSize + compressedSize );
+}
+
+Imath::Box2i DisplayDriverServerCompression::decompress( const char *buffer, size_t bufferSize, size_t numChannels, std::vector<float> &data )
+{
+	if( bufferSize < g_payloadHeaderSize + BLOSC_MIN_HEADER_LENGTH )
+	{
+		throw Exception( "DisplayDriverServerCompression : Compressed data is too short." );
+	}
+
+	Imath::Box2i box;
+	memcpy( &box, buffer, sizeof( box ) );
+
+	const Format format = (Format)buffer[sizeof( box )];
+	if( format != Float && format != Half )
+	{
+		throw Exception( "DisplayDriverServerCompression : Unknown sample format." );
+	}
+
+	// The payload comes from another process, so we check that the sizes
+	// declared in the Blosc header match both the payload and the box before
+	// allocating anything.
+
+	if( box.isEmpty() || numChannels == 0 )
+	{
+		throw Exception( "DisplayDriverServerCompression : Invalid box." );
+	}
+
+	const uint64_t width = (int64_t)box.max.x - box.min.x + 1;
+	const uint64_t height = (int64_t)box.max.y - box.min.y + 1;
+	const uint64_t maxPixels = BLOSC_MAX_BUFFERSIZE / ( numChannels * sampleSize( format ) );
+	if( width > maxPixels || height > maxPixels / width )
+	{
+		throw Exception( "DisplayDriverServerCompression : Box is too large." );
+	}
+	const size_t expectedBytes = width * height * numChannels * sampleSize( format );
+
+	const char *compressed = buffer + g_payloadHeaderSize;
+	size_t numBytes = 0, compressedBytes = 0, blockSize = 0;
+	blosc_cbuffer_sizes( compressed, &numBytes, &compressedBytes, &blockSize );
+	size_t typeSize = 0;
+	int flags = 0;
+	blosc_cbuffer_metainfo( compressed, &typeSize, &flags );
+	if( compressedBytes != bufferSize - g_payloadHeaderSize || typeSize != sampleSize( format ) )
+	{
+		throw Exception( "DisplayDriverServerCompression : Compressed data is corrupt." );
+	}
+
+	if( numBytes != expectedBytes )
+	{
+		throw Exception( "DisplayDriverServerCompression : Compressed data does not match box." );
+	}
+
+	const size_t numSamples = numBytes / sampleSize( format );
+	data.resize( numSamples );
+
+	std::vector<half> halfData;
+	void *samples = data.data();
+	if( format == Half )
+	{
+		halfData.resize( numSamples );
+		samples = halfData.data();
+	}
+
+	if( blosc_decompress_ctx( compressed, samples, numBytes, 1 ) != (int)numBytes )
+	{
+		throw Exception( "DisplayDriverServerCompression : Compressed data is corrupt." );
+	}
+
+	if( format == Half )
+	{
+		std::copy( halfData.begin(), halfData.end(), data.begin() );
+	}
+
+	return box;
+}
@@ -47,6 +47,9 @@ enum byteOrder {
 	orderDataSize4
 };
 
+const char *DisplayDriverServerHeader::compressionParameter = "displayDriverServer:compression";
+const char *DisplayDriverServerHeader::sharedMemoryParameter = "displayDriverServer:sharedMemory";
+
 DisplayDriverServerHeader::DisplayDriverServerHeader()
 {
 	memset( &m_header[0], 0, sizeof(m_header) );
@@ -72,7 +75,9 @@ bool DisplayDriverServerHeader::valid()
 		( m_header[orderMessageType] != imageOpen &&
 			m_header[orderMessageType] != imageData &&
 			m_header[orderMessageType] != imageClose &&
-			m_header[orderMessageType] != exception ) )
+			m_header[orderMessageType] != exception &&
+			m_header[orderMessageType] != imageDataCompressed &&
+			m_header[orderMessageType] != imageDataShared ) )
 	{
 		return false;
 	}
@@ -35,14 +35,17 @@
 #include "IECoreImage/HdrMergeOp.h"
 
 #include "IECoreImage/ImagePrimitive.h"
+#include "IECoreImage/Private/ImageParallelAlgo.h"
 
 #include "IECore/CompoundParameter.h"
+#include "IECore/DataAlgo.h"
 #include "IECore/Math.h"
 #include "IECore/ObjectVector.h"
 #include "IECore/TypedObjectParameter.h"
 
 #include "boost/format.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 using namespace std;
@@ -152,64 +155,56 @@ const Box2fParameter * HdrMergeOp::windowingParameter() const
 	return m_windowingParameter.get();
 }
 
-template< typename T >
-inline void merge( bool firstImage, size_t &pixelCount,
-					const ImagePrimitive * img, ImagePrimitive * outImg,
-					const Imath::Box2f &windowing, float intensityMultiplier,
-					FloatVectorData * outR, FloatVectorData * outG, FloatVectorData * outB, FloatVectorData * outA )
+namespace
 {
 
-	const TypedData< std::vector< T > > *inR = img->getChannel< T >( "R" );
-	const TypedData< std::vector< T > > *inG = img->getChannel< T >( "G" );
-	const TypedData< std::vector< T > > *inB = img->getChannel< T >( "B" );
-
-	if ( firstImage )
-	{
-		pixelCount = inR->readable().size();
-		outR->writable().resize( pixelCount, 0 );
-		outG->writable().resize( pixelCount, 0 );
-		outB->writable().resize( pixelCount, 0 );
-		outA->writable().resize( pixelCount, 0 );
-		outImg->setDisplayWindow( img->getDisplayWindow() );
-		outImg->setDataWindow( img->getDataWindow() );
-	}
-	else
-	{
-		if ( pixelCount != inR->readable().size() ||
-			 pixelCount != inG->readable().size() ||
-			 pixelCount != inB->readable().size() )
-		{
-			throw Exception( "Images are not of the same resolution!!" );
-		}
-	}
+struct Input
+{
+	const void *r;
+	const void *g;
+	const void *b;
+	bool isHalf;
+	float intensityMultiplier;
+};
 
-	const T *ptrInR = &(inR->readable()[0]);
-	const T *ptrInG = &(inG->readable()[0]);
-	const T *ptrInB = &(inB->readable()[0]);
-	float *ptrOutR = &(outR->writable()[0]);
-	float *ptrOutG = &(outG->writable()[0]);
-	float *ptrOutB = &(outB->writable()[0]);
-	float *ptrOutA = &(outA->writable()[0]);
+template< typename T >
+inline void merge( const Input &input, bool firstImage, size_t begin, size_t end,
+					const Imath::Box2f &windowing,
+					float *outR, float *outG, float *outB, float *outA )
+{
+	const T *inR = static_cast<const T *>( input.r );
+	const T *inG = static_cast<const T *>( input.g );
+	const T *inB = static_cast<const T *>( input.b );
 
-	for ( size_t i = 0; i < pixelCount; i++ )
+	for ( size_t i = begin; i < end; i++ )
 	{
-		float intensity = (*ptrInR + *ptrInG + *ptrInB) / 3.0;
+		float intensity = (inR[i] + inG[i] + inB[i]) / 3.0;
 		float weight = smoothstep( windowing.min[0], windowing.min[1], intensity );
 		if ( !firstImage )
 		{
 			weight *= 1.0f - smoothstep( windowing.max[0], windowing.max[1], intensity );
 		}
-		float m = weight * intensityMultiplier;
-		*ptrOutR += *ptrInR * m;
-		*ptrOutG += *ptrInG * m;
-		*ptrOutB += *ptrInB * m;
-		*ptrOutA += weight;
-
-		ptrInR++; ptrInG++; ptrInB++;
-		ptrOutR++; ptrOutG++; ptrOutB++; ptrOutA++;
+		float m = weight * input.intensityMultiplier;
+		outR[i] += inR[i] * m;
+		outG[i] += inG[i] * m;
+		outB[i] += inB[i] * m;
+		outA[i] += weight;
 	}
 }
 
+template< typename T >
+const void *channelData( const ImagePrimitive *img, const char *name, size_t pixelCount )
+{
+	const TypedData< std::vector< T > > *channel = img->getChannel< T >( name );
+	if( channel->readable().size() != pixelCount )
+	{
+		throw Exception( "Images are not of the same resolution!!" );
+	}
+	return channel->readable().data();
+}
+
+} // namespace
+
 ObjectPtr HdrMergeOp::doOperation( const CompoundObject * operands )
 {
 	const ObjectVector *images = operands->member<const ObjectVector>( "inputImages" );
@@ -256,46 +251,85 @@ ObjectPtr HdrMergeOp::doOperation( const CompoundObject * operands )
 	outImg->channels["B"] = outB;
 	outImg->channels["A"] = outA;
 
-	// loop over inputs accumulating them into the buffer
+	// gather the inputs, checking that they match.
 	int numInputs = images->members().size();
 
 	float exposure = exposureStep * (numInputs-1)/2.0;
-	size_t pixelCount = 0;
-	bool firstImage = true;
+	const ImagePrimitive *firstImg = static_cast<const ImagePrimitive *>( images->members()[0].get() );
+	const size_t pixelCount = IECore::size( firstImg->channels.find( "R" )->second.get() );
+	std::vector<Input> inputs;
 	for( const auto &object : images->members() )
 	{
 		const ImagePrimitive *img = static_cast<const ImagePrimitive *>( object.get() );
-		float intensityMultiplier = pow( 2.0f, exposure );
-		if ( img->getChannel< float >( "R" ) )
+		Input input;
+		input.isHalf = !img->getChannel< float >( "R" );
+		if( input.isHalf )
 		{
-			merge< float >( firstImage, pixelCount, img, outImg.get(), windowing, intensityMultiplier, outR.get(), outG.get(), outB.get(), outA.get() );
+			input.r = channelData< half >( img, "R", pixelCount );
+			input.g = channelData< half >( img, "G", pixelCount );
+			input.b = channelData< half >( img, "B", pixelCount );
 		}
 		else
 		{
-			merge< half >( firstImage, pixelCount, img, outImg.get(), windowing, intensityMultiplier, outR.get(), outG.get(), outB.get(), outA.get() );
+			input.r = channelData< float >( img, "R", pixelCount );
+			input.g = channelData< float >( img, "G", pixelCount );
+			input.b = channelData< float >( img, "B", pixelCount );
 		}
+		input.intensityMultiplier = pow( 2.0f, exposure );
+		inputs.push_back( input );
 
 		exposure -= exposureStep;
-		firstImage = false;
 	}
 
-	// normalize the outputs
-	float adjustment = pow( 2.0f, -exposureAdjustment );
-	float *ptrOutR = &(outR->writable()[0]);
-	float *ptrOutG = &(outG->writable()[0]);
-	float *ptrOutB = &(outB->writable()[0]);
-	float *ptrOutA = &(outA->writable()[0]);
-
-	for ( size_t i = 0; i < pixelCount; i++ )
-	{
-		float w = adjustment * ptrOutA[i];
-		if ( w > 0 )
+	outImg->setDisplayWindow( firstImg->getDisplayWindow() );
+	outImg->setDataWindow( firstImg->getDataWindow() );
+	outR->writable().resize( pixelCount, 0 );
+	outG->writable().resize( pixelCount, 0 );
+	outB->writable().resize( pixelCount, 0 );
+	outA->writable().resize( pixelCount, 0 );
+
+	float *ptrOutR = outR->writable().data();
+	float *ptrOutG = outG->writable().data();
+	float *ptrOutB = outB->writable().data();
+	float *ptrOutA = outA->writable().data();
+
+	// accumulate all the inputs and normalize the outputs in a single pass,
+	// in parallel over bands of rows, so that each output value is only
+	// loaded and stored once per band while it is still in cache.
+	const float adjustment = pow( 2.0f, -exposureAdjustment );
+	const size_t width = std::max( firstImg->getDataWindow().size().x + 1, 1 );
+	const int numRows = ( pixelCount + width - 1 ) / width;
+	ImageParallelAlgo::parallelForRows(
+		Box2i( V2i( 0 ), V2i( (int)width - 1, numRows - 1 ) ),
+		[&]( int yBegin, int yEnd )
 		{
-			ptrOutR[i] /= w;
-			ptrOutG[i] /= w;
-			ptrOutB[i] /= w;
+			const size_t begin = yBegin * width;
+			const size_t end = std::min( yEnd * width, pixelCount );
+
+			for( size_t j = 0; j < inputs.size(); ++j )
+			{
+				if( inputs[j].isHalf )
+				{
+					merge< half >( inputs[j], j == 0, begin, end, windowing, ptrOutR, ptrOutG, ptrOutB, ptrOutA );
+				}
+				else
+				{
+					merge< float >( inputs[j], j == 0, begin, end, windowing, ptrOutR, ptrOutG, ptrOutB, ptrOutA );
+				}
+			}
+
+			for ( size_t i = begin; i < end; i++ )
+			{
+				float w = adjustment * ptrOutA[i];
+				if ( w > 0 )
+				{
+					ptrOutR[i] /= w;
+					ptrOutG[i] /= w;
+					ptrOutB[i] /= w;
+				}
+			}
 		}
-	}
+	);
 
 	return outImg;
 }
@@ -36,13 +36,13 @@
 
 #include "IECoreImage/ImageCropOp.h"
 #include "IECoreImage/ImagePrimitive.h"
+#include "IECoreImage/Private/ImageParallelAlgo.h"
 
 #include "IECore/CompoundObject.h"
 #include "IECore/CompoundParameter.h"
 #include "IECore/DataConvert.h"
 #include "IECore/DespatchTypedData.h"
 #include "IECore/Exception.h"
-#include "IECore/MeanSquaredError.h"
 #include "IECore/MessageHandler.h"
 #include "IECore/Object.h"
 #include "IECore/ObjectParameter.h"
@@ -52,7 +52,11 @@
 
 #include "boost/format.hpp"
 
+#include "tbb/parallel_invoke.h"
+
 #include <cassert>
+#include <cmath>
+#include <functional>
 #include <iostream>
 
 using namespace std;
@@ -312,8 +316,14 @@ ObjectPtr ImageDiffOp::doOperation( const CompoundObject * operands )
 
 		try
 		{
-			aFloatData = despatchTypedData< FloatConverter, TypeTraits::IsNumericVectorTypedData > ( aData.get() );
-			bFloatData = despatchTypedData< FloatConverter, TypeTraits::IsNumericVectorTypedData > ( bData.get() );
+			tbb::this_task_arena::isolate(
+				[&] {
+					tbb::parallel_invoke(
+						[&] { aFloatData = despatchTypedData< FloatConverter, TypeTraits::IsNumericVectorTypedData > ( aData.get() ); },
+						[&] { bFloatData = despatchTypedData< FloatConverter, TypeTraits::IsNumericVectorTypedData > ( bData.get() ); }
+					);
+				}
+			);
 		}
 
 		catch ( Exception & )
@@ -326,7 +336,32 @@ ObjectPtr ImageDiffOp::doOperation( const CompoundObject * operands )
 		assert( bFloatData );
 		assert( aFloatData->readable().size() == bFloatData->readable().size() );
 
-		float rms = sqrt( MeanSquaredError<FloatVectorData>()( aFloatData, bFloatData ) );
+		// Both images have been cropped to the display window, so
+		// the channels cover it exactly.
+		const Box2i &window = imageA->getDataWindow();
+		const size_t width = window.size().x + 1;
+		const float *a = aFloatData->readable().data();
+		const float *b = bFloatData->readable().data();
+		const double sumSquaredError = ImageParallelAlgo::parallelReduceTiles(
+			window, 0.0,
+			[&]( const Box2i &tile, double sum )
+			{
+				for( int y = tile.min.y; y <= tile.max.y; ++y )
+				{
+					const size_t rowOffset = ( y - window.min.y ) * width - window.min.x;
+					for( int x = tile.min.x; x <= tile.max.x; ++x )
+					{
+						const float d = a[rowOffset + x] - b[rowOffset + x];
+						sum += d * d;
+					}
+				}
+				return sum;
+			},
+			std::plus<double>()
+		);
+
+		const size_t n = aFloatData->readable().size();
+		const float rms = n ? sqrt( sumSquaredError / n ) : 0.0f;
 		if ( rms > maxError )
 		{
 			return new BoolData( true );
@@ -36,7 +36,13 @@
 
 #include "boost/algorithm/string/predicate.hpp"
 
+#include "tbb/blocked_range2d.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include <cstring>
 #include <mutex>
+#include <type_traits>
 
 using namespace std;
 using namespace boost;
@@ -48,17 +54,69 @@ IE_CORE_DEFINERUNTIMETYPED( ImageDisplayDriver );
 
 const DisplayDriver::DisplayDriverDescription<ImageDisplayDriver> ImageDisplayDriver::g_description;
 
-typedef std::map<std::string, ConstImagePrimitivePtr> ImagePool;
+// While a driver is still receiving data, its pool entry refers to the driver
+// itself, so that `storedImage()` can return a snapshot rather than an image
+// which is still being written to. When the driver is closed or destroyed,
+// the entry is replaced with a final snapshot.
+struct PoolEntry
+{
+	const ImageDisplayDriver *driver;
+	ConstImagePrimitivePtr image;
+};
+
+typedef std::map<std::string, PoolEntry> ImagePool;
 static ImagePool g_pool;
 static std::mutex g_poolMutex;
 
+namespace
+{
+
+// Copies interleaved pixel data into separate channels. When `Stride` is an
+// `std::integral_constant`, the stride is known at compile time and the inner
+// loop can be vectorised.
+template<typename Stride>
+void deinterleave( const float *source, size_t width, size_t height, Stride stride, const std::vector<float *> &channels, size_t targetOffset, size_t targetWidth )
+{
+	for( size_t c = 0; c < channels.size(); ++c )
+	{
+		const float *sourceRow = source + c;
+		float *targetRow = channels[c] + targetOffset;
+		for( size_t y = 0; y < height; ++y )
+		{
+			for( size_t x = 0; x < width; ++x )
+			{
+				targetRow[x] = sourceRow[x * stride];
+			}
+			sourceRow += width * stride;
+			targetRow += targetWidth;
+		}
+	}
+}
+
+template<size_t N>
+using FixedStride = std::integral_constant<size_t, N>;
+
+} // namespace
+
 ImageDisplayDriver::ImageDisplayDriver( const Box2i &displayWindow, const Box2i &dataWindow, const vector<string> &channelNames, ConstCompoundDataPtr parameters ) :
 		DisplayDriver( displayWindow, dataWindow, channelNames, parameters ),
-		m_image( new ImagePrimitive( dataWindow, displayWindow ) )
+		m_image( new ImagePrimitive( dataWindow, displayWindow ) ),
+		m_generation( 0 ),
+		m_snapshotGeneration( 0 )
 {
-	for ( vector<string>::const_iterator it = channelNames.begin(); it != channelNames.end(); it++ )
+	for( const auto &name : channelNames )
 	{
-		m_image->createChannel<float>( *it );
+		if( !m_image->getChannel<float>( name ) )
+		{
+			m_image->createChannel<float>( name );
+		}
+	}
+
+	// Repeated channel names all refer to the same channel, with the
+	// last occurrence taking precedence in each bucket.
+	for( const auto &name : channelNames )
+	{
+		m_channelData.push_back( m_image->getChannel<float>( name )->baseWritable() );
 	}
 	if( parameters )
 	{
@@ -78,14 +136,16 @@ ImageDisplayDriver::ImageDisplayDriver( const Box2i &displayWindow, const Box2i
 		ConstStringDataPtr handle = parameters->member<StringData>( "handle" );
 		if( handle )
 		{
+			m_handle = handle->readable();
 			std::lock_guard<std::mutex> lock( g_poolMutex );
-			g_pool[handle->readable()] = m_image;
+			g_pool[m_handle] = { this, nullptr };
 		}
 	}
 }
 
 ImageDisplayDriver::~ImageDisplayDriver()
 {
+	storeFinalImage();
 }
 
 bool ImageDisplayDriver::scanLineOrderOnly() const
@@ -101,51 +161,63 @@ bool ImageDisplayDriver::acceptsRepeatedData() const
 void ImageDisplayDriver::imageData( const Box2i &box, const float *data, size_t dataSize )
 {
 	Box2i tmpBox = box;
-	Box2i dataWindow = m_image->getDataWindow();
+	const Box2i &dataWindow = m_image->getDataWindow();
 	tmpBox.extendBy( dataWindow );
 	if ( tmpBox != dataWindow )
 	{
 		throw Exception("The box is outside image data window.");
 	}
 
-	int pixelSize = channelNames().size();
-	if ( dataSize != (box.max.x - box.min.x + 1) * (box.max.y - box.min.y + 1) * channelNames().size() )
+	const size_t numChannels = m_channelData.size();
+	const size_t sourceWidth = box.max.x - box.min.x + 1;
+	const size_t sourceHeight = box.max.y - box.min.y + 1;
+	if ( dataSize != sourceWidth * sourceHeight * numChannels )
 	{
 		throw Exception("Invalid dataSize value.");
 	}
 
-	int channelId, targetX, targetY, sourceWidth, sourceHeight, targetWidth;
-	sourceWidth = box.max.x - box.min.x + 1;
-	sourceHeight = box.max.y - box.min.y + 1;
-	targetWidth = dataWindow.max.x - dataWindow.min.x + 1;
-	channelId = 0;
-	targetX = box.min.x - dataWindow.min.x;
-	targetY = box.min.y - dataWindow.min.y;
+	const size_t targetWidth = dataWindow.max.x - dataWindow.min.x + 1;
+	const size_t targetOffset = targetWidth * ( box.min.y - dataWindow.min.y ) + ( box.min.x - dataWindow.min.x );
 
-	for( const auto &name : channelNames() )
+	switch( numChannels )
 	{
-		vector< float > &target = boost::static_pointer_cast< FloatVectorData >( m_image->channels[name] )->writable();
-		vector< float >::iterator targetIt;
-		const float *sourceIt = data+channelId;
-		targetIt = target.begin()+targetWidth*targetY+targetX;
-
-		for ( int y = 0; y < sourceHeight; y++ )
-		{
-			for ( int x = 0; x < sourceWidth; x++ )
-			{
-				*targetIt = *sourceIt;
-				sourceIt += pixelSize;
-				targetIt++;
-			}
-			targetIt += targetWidth - sourceWidth;
-		}
-
-		++channelId;
+		case 1 :
+			deinterleave( data, sourceWidth, sourceHeight, FixedStride<1>(), m_channelData, targetOffset, targetWidth );
+			break;
+		case 2 :
+			deinterleave( data, sourceWidth, sourceHeight, FixedStride<2>(), m_channelData, targetOffset, targetWidth );
+			break;
+		case 3 :
+			deinterleave( data, sourceWidth, sourceHeight, FixedStride<3>(), m_channelData, targetOffset, targetWidth );
+			break;
+		case 4 :
+			deinterleave( data, sourceWidth, sourceHeight, FixedStride<4>(), m_channelData, targetOffset, targetWidth );
+			break;
+		default :
+			deinterleave( data, sourceWidth, sourceHeight, numChannels, m_channelData, targetOffset, targetWidth );
 	}
+
+	m_generation.fetch_add( 1, std::memory_order_release );
 }
 
 void ImageDisplayDriver::imageClose()
 {
+	storeFinalImage();
+}
+
+void ImageDisplayDriver::storeFinalImage()
+{
+	if( m_handle.empty() )
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock( g_poolMutex );
+	ImagePool::iterator it = g_pool.find( m_handle );
+	if( it != g_pool.end() && it->second.driver == this )
+	{
+		it->second = { nullptr, snapshot() };
+	}
 }
 
 ConstImagePrimitivePtr ImageDisplayDriver::image() const
@@ -153,13 +225,68 @@ ConstImagePrimitivePtr ImageDisplayDriver::image() const
 	return m_image;
 }
 
+ConstImagePrimitivePtr ImageDisplayDriver::snapshot() const
+{
+	std::lock_guard<std::mutex> lock( m_snapshotMutex );
+
+	// Any buckets which arrive while we are copying will increment
+	// the generation again, so the next call will take a fresh copy.
+	const uint64_t generation = m_generation.load( std::memory_order_acquire );
+	if( m_snapshot && generation == m_snapshotGeneration )
+	{
+		return m_snapshot;
+	}
+
+	ImagePrimitivePtr result = new ImagePrimitive( m_image->getDataWindow(), m_image->getDisplayWindow() );
+	result->blindData()->writable() = m_image->blindData()->copy()->readable();
+
+	// Copy each channel only once, even if its name is repeated.
+	const std::vector<std::string> &names = channelNames();
+	std::vector<const float *> sources;
+	std::vector<float *> targets;
+	for( size_t c = 0; c < names.size(); ++c )
+	{
+		if( !result->getChannel<float>( names[c] ) )
+		{
+			sources.push_back( m_channelData[c] );
+			targets.push_back( result->createChannel<float>( names[c] )->baseWritable() );
+		}
+	}
+
+	const size_t numPixels = m_image->channelSize();
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			tbb::parallel_for(
+				tbb::blocked_range2d<size_t>( 0, targets.size(), 1, 0, numPixels, 64 * 1024 ),
+				[&]( const tbb::blocked_range2d<size_t> &range )
+				{
+					for( size_t c = range.rows().begin(); c != range.rows().end(); ++c )
+					{
+						memcpy(
+							targets[c] + range.cols().begin(),
+							sources[c] + range.cols().begin(),
+							range.cols().size() * sizeof( float )
+						);
+					}
+				},
+				taskGroupContext
+			);
+		}
+	);
+
+	m_snapshot = result;
+	m_snapshotGeneration = generation;
+	return m_snapshot;
+}
+
 ConstImagePrimitivePtr ImageDisplayDriver::storedImage( const std::string &handle )
 {
 	std::lock_guard<std::mutex> lock( g_poolMutex );
 	ImagePool::const_iterator it = g_pool.find( handle );
 	if( it != g_pool.end() )
 	{
-		return it->second;
+		return it->second.driver ? it->second.driver->snapshot() : it->second.image;
 	}
 	return nullptr;
 }
@@ -171,7 +298,7 @@ ConstImagePrimitivePtr ImageDisplayDriver::removeStoredImage( const std::string
 	ImagePool::iterator it = g_pool.find( handle );
 	if( it != g_pool.end() )
 	{
-		result = it->second;
+		result = it->second.driver ? it->second.driver->snapshot() : it->second.image;
 		g_pool.erase( it );
 	}
 	return result;
@@ -39,12 +39,11 @@
 #include "IECoreImage/OpenImageIOAlgo.h"
 
 #include "IECore/CompoundParameter.h"
-#include "IECore/DataInterleaveOp.h"
 #include "IECore/DespatchTypedData.h"
 #include "IECore/Exception.h"
 #include "IECore/FileNameParameter.h"
 #include "IECore/MessageHandler.h"
-#include "IECore/ObjectVector.h"
+#include "IECore/NumericParameter.h"
 #include "IECore/TypedParameter.h"
 #include "IECore/Version.h"
 
@@ -60,6 +59,13 @@
 #include "boost/static_assert.hpp"
 #include "boost/type_traits.hpp"
 
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_invoke.h"
+#include "tbb/task_arena.h"
+
+#include <cstring>
+
 #ifndef _MSC_VER
 #include <sys/utsname.h>
 #else
@@ -243,6 +249,15 @@ void setImageSpecFormatOptions( const CompoundObject *operands, ImageSpec *spec,
 		spec->attribute( "compression", compression->readable() );
 	}
 
+	if( const IntData *tileSize = settings->member<const IntData>( "tileSize" ) )
+	{
+		if( tileSize->readable() > 0 )
+		{
+			spec->tile_width = spec->tile_height = tileSize->readable();
+			spec->tile_depth = 1;
+		}
+	}
+
 	if( fileFormatName == "jpeg" )
 	{
 		spec->attribute( "CompressionQuality", settings->member<const IntData>( "quality" )->readable() );
@@ -262,6 +277,161 @@ void setImageSpecFormatOptions( const CompoundObject *operands, ImageSpec *spec,
 	}
 }
 
+// Writes the image in chunks of rows, so that we never need an interleaved
+// copy of the whole image. Chunks are interleaved and converted to the file's
+// pixel format in parallel, while previously converted chunks are written to
+// the file in order.
+void writeChunks( ImageOutput *out, const std::vector<const Data *> &channelData, const Box2i &dataWindow, const std::string &fileName )
+{
+	const ImageSpec &spec = out->spec();
+
+	TypeDesc srcType = TypeDesc::UNKNOWN;
+	std::vector<const unsigned char *> srcData;
+	for( const auto &data : channelData )
+	{
+		const OpenImageIOAlgo::DataView dataView( data );
+		srcType = TypeDesc( (TypeDesc::BASETYPE)dataView.type.basetype );
+		if( srcType == TypeDesc::UNKNOWN )
+		{
+			throw IECore::Exception( boost::str( boost::format( "IECoreImage::ImageWriter : Failed to write \"%s\". Unsupported dataType %s." ) % fileName % data->typeName() ) );
+		}
+		srcData.push_back( static_cast<const unsigned char *>( dataView.data ) );
+	}
+
+	// We do the conversion to the file format ourselves, so that it is done
+	// in parallel. If the file has a different format per channel we leave
+	// the conversion to OpenImageIO.
+	TypeDesc dstType = spec.format;
+	if( dstType == TypeDesc::UNKNOWN || spec.channelformats.size() )
+	{
+		dstType = srcType;
+	}
+
+	const size_t srcSize = srcType.size();
+	const size_t dstSize = dstType.size();
+	const size_t srcStride = ( dataWindow.size().x + 1 ) * srcSize;
+	const size_t pixelBytes = dstSize * channelData.size();
+	const size_t rowBytes = pixelBytes * spec.width;
+
+	// Chunks must consist of whole rows of tiles for tiled files. For
+	// scanline files we use a multiple of 16 rows, the most used by any
+	// OpenEXR compression. We aim for chunks of around 4Mb.
+	const bool tiled = spec.tile_width > 0;
+	const int chunkQuantum = tiled ? spec.tile_height : 16;
+	const int chunkHeight = chunkQuantum * std::max<size_t>( 1, ( 4 * 1024 * 1024 ) / ( rowBytes * chunkQuantum ) );
+	const int numChunks = ( spec.height + chunkHeight - 1 ) / chunkHeight;
+
+	auto convertChunk = [&]( int chunk, std::vector<unsigned char> &buffer )
+	{
+		const Box2i region(
+			V2i( spec.x, spec.y + chunk * chunkHeight ),
+			V2i( spec.x + spec.width - 1, std::min( spec.y + ( chunk + 1 ) * chunkHeight, spec.y + spec.height ) - 1 )
+		);
+
+		buffer.resize( ( region.size().y + 1 ) * rowBytes );
+
+		const Box2i validRegion(
+			V2i( std::max( region.min.x, dataWindow.min.x ), std::max( region.min.y, dataWindow.min.y ) ),
+			V2i( std::min( region.max.x, dataWindow.max.x ), std::min( region.max.y, dataWindow.max.y ) )
+		);
+
+		if( validRegion != region )
+		{
+			// Formats without support for data windows must be padded
+			// to the display window. Zero has the same representation
+			// in all the formats we support.
+			memset( buffer.data(), 0, buffer.size() );
+		}
+
+		if( validRegion.isEmpty() )
+		{
+			return;
+		}
+
+		// Convert each channel directly into its interleaved
+		// position in the buffer.
+		for( size_t c = 0, numChannels = srcData.size(); c < numChannels; ++c )
+		{
+			const unsigned char *src = srcData[c] +
+				( validRegion.min.y - dataWindow.min.y ) * srcStride +
+				( validRegion.min.x - dataWindow.min.x ) * srcSize
+			;
+			unsigned char *dst = buffer.data() +
+				( validRegion.min.y - region.min.y ) * rowBytes +
+				( validRegion.min.x - region.min.x ) * pixelBytes +
+				c * dstSize
+			;
+			convert_image(
+				/* nchannels */ 1, validRegion.size().x + 1, validRegion.size().y + 1, /* depth */ 1,
+				src, srcType, /* xstride */ srcSize, /* ystride */ srcStride, /* zstride */ AutoStride,
+				dst, dstType, /* xstride */ pixelBytes, /* ystride */ rowBytes, /* zstride */ AutoStride
+			);
+		}
+	};
+
+	auto writeChunk = [&]( int chunk, const std::vector<unsigned char> &buffer )
+	{
+		const int yBegin = spec.y + chunk * chunkHeight;
+		const int yEnd = std::min( yBegin + chunkHeight, spec.y + spec.height );
+		const bool status = tiled ?
+			out->write_tiles( spec.x, spec.x + spec.width, yBegin, yEnd, 0, 1, dstType, buffer.data() ) :
+			out->write_scanlines( yBegin, yEnd, 0, dstType, buffer.data() )
+		;
+
+		if( !status )
+		{
+			throw IECore::Exception( boost::str( boost::format( "IECoreImage::ImageWriter : Failed to write \"%s\", error = %s" ) % fileName % out->geterror() ) );
+		}
+	};
+
+	// We convert a batch of chunks in parallel while writing the previous
+	// batch, double buffering to bound the memory used.
+	const int batchSize = std::max( 1, tbb::this_task_arena::max_concurrency() );
+	const int numBatches = ( numChunks + batchSize - 1 ) / batchSize;
+	std::vector<std::vector<unsigned char>> buffers( 2 * batchSize );
+
+	tbb::this_task_arena::isolate(
+		[&]
+		{
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			for( int batch = 0; batch <= numBatches; ++batch )
+			{
+				tbb::parallel_invoke(
+					[&] {
+						if( batch == 0 )
+						{
+							return;
+						}
+						const int begin = ( batch - 1 ) * batchSize;
+						for( int chunk = begin, end = std::min( begin + batchSize, numChunks ); chunk < end; ++chunk )
+						{
+							writeChunk( chunk, buffers[( ( batch - 1 ) % 2 ) * batchSize + chunk - begin] );
+						}
+					},
+					[&] {
+						if( batch == numBatches )
+						{
+							return;
+						}
+						const int begin = batch * batchSize;
+						tbb::parallel_for(
+							tbb::blocked_range<int>( begin, std::min( begin + batchSize, numChunks ), 1 ),
+							[&]( const tbb::blocked_range<int> &range )
+							{
+								for( int chunk = range.begin(); chunk != range.end(); ++chunk )
+								{
+									convertChunk( chunk, buffers[( batch % 2 ) * batchSize + chunk - begin] );
+								}
+							}
+						);
+					},
+					taskGroupContext
+				);
+			}
+		}
+	);
+}
+
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -321,6 +491,22 @@ ImageWriter::ImageWriter()
 		)
 	);
 
+	exrSettings->addParameter(
+		new IntParameter(
+			"tileSize",
+			"Writes a tiled file with tiles of this size, or a scanline file if 0. "
+			"Tiled files can be read more efficiently when only part of the image is needed.",
+			0,
+			/* presets = */ {
+				{ "scanline", 0 },
+				{ "32", 32 },
+				{ "64", 64 },
+				{ "128", 128 },
+				{ "256", 256 }
+			}
+		)
+	);
+
 	CompoundParameterPtr dpxSettings = new CompoundParameter( "dpx", "dpx specific settings" );
 	m_formatSettingsParameter->addParameter( dpxSettings );
 	dpxSettings->addParameter(
@@ -620,83 +806,14 @@ void ImageWriter::doWrite( const CompoundObject *operands )
 
 	const auto &channelMap = ( correctedImage ) ? correctedImage->channels : image->channels;
 
-	DataInterleaveOpPtr op = new DataInterleaveOp();
-	op->targetTypeParameter()->setNumericValue( firstChannelData->typeId() );
-	auto &vectors = static_cast<ObjectVector *>( op->dataParameter()->getValue() )->members();
-	vectors.reserve( (size_t)spec.nchannels );
+	std::vector<const Data *> channelData;
+	channelData.reserve( channels.size() );
 	for( const auto &channel : channels )
 	{
-		vectors.push_back( channelMap.find( channel )->second );
-	}
-
-	DataPtr buffer = static_pointer_cast<Data>( op->operate() );
-	const OpenImageIOAlgo::DataView dataView( buffer.get() );
-	if( dataView.type == TypeDesc::UNKNOWN )
-	{
-		throw IECore::Exception( boost::str( boost::format( "IECoreImage::ImageWriter : Failed to write \"%s\". Unsupported dataType %s." ) % fileName() % buffer->typeName() ) );
+		channelData.push_back( channelMap.find( channel )->second.get() );
 	}
 
-	const unsigned char *rawBuffer = (const unsigned char *)dataView.data;
-	size_t stride = spec.nchannels * spec.width * dataView.type.elementsize();
-
-	IECore::UCharVectorDataPtr scanLineData = new IECore::UCharVectorData();
-	std::vector<unsigned char>& scanLineBuffer = scanLineData->writable();
-	scanLineBuffer.resize(stride);
-
-	auto getScanLine = [&rawBuffer, &spec, &stride, &dataWindow, &dataView, validDisplayWindow, &scanLineBuffer](int y) -> const unsigned char*
-	{
-		if ( validDisplayWindow )
-		{
-			return &rawBuffer[stride * y];
-		}
-		else
-		{
-			memset( &scanLineBuffer[0], 0, stride );
-
-			// ensure the dataWindow is inside the image display window
-			int clampedXStart = std::max( dataWindow.min.x, 0 );
-			int clampedWidth = std::min( dataWindow.size().x + 1, (spec.width - clampedXStart) );
-
-			size_t dataWindowStride = ( dataWindow.size().x + 1) * spec.nchannels * dataView.type.elementsize();
-			size_t bytesToCopy = clampedWidth  * spec.nchannels * dataView.type.elementsize();
-
-			if( y < dataWindow.min.y )
-			{
-				return &scanLineBuffer[0];
-			}
-			else if( y > dataWindow.max.y )
-			{
-				return &scanLineBuffer[0];
-			}
-			else
-			{
-				if ( clampedWidth > 0 )
-				{
-					memcpy(
-						&scanLineBuffer[clampedXStart * spec.nchannels * dataView.type.elementsize()],
-						&rawBuffer[dataWindowStride * ( y - dataWindow.min.y )],
-						bytesToCopy
-					);
-				}
-				return &scanLineBuffer[0];
-			}
-		}
-	};
-
-	for( int y = 0; y < spec.height; ++y )
-	{
-		bool status = out->write_scanline(
-			/* y */ spec.y + y,
-			/* z */ 0,
-			/* format */ dataView.type,
-			/* data */ getScanLine( y )
-		);
-
-		if( !status )
-		{
-			throw IECore::Exception( boost::str( boost::format( "IECoreImage::ImageWriter : Failed to write \"%s\", error = %s" ) % fileName() % out->geterror() ) );
-		}
-	}
+	writeChunks( out.get(), channelData, dataWindow, fileName() );
 
 	out->close();
 }
@@ -46,6 +46,10 @@
 #include "IECore/ObjectParameter.h"
 #include "IECore/TypeTraits.h"
 
+#include "tbb/blocked_range2d.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
 #include <cassert>
 
 using namespace boost;
@@ -81,8 +85,17 @@ LensDistortOp::LensDistortOp()
 		CompoundObjectTypeId
 	);
 
+	m_cacheSTMapParameter = new BoolParameter(
+		"cacheSTMap",
+		"Stores the distortion in the process-wide cache of ST-maps managed by the lens model, "
+		"so that it can be reused by subsequent images with the same lens and format. This "
+		"is beneficial when processing many images, but wastes memory when processing just one.",
+		false
+	);
+
 	parameters()->addParameter( m_modeParameter );
 	parameters()->addParameter( m_lensParameter );
+	parameters()->addParameter( m_cacheSTMapParameter );
 
 }
 
@@ -118,8 +131,8 @@ void LensDistortOp::begin( const CompoundObject * operands )
 
 	Imath::Box2i dataWindow( inputImage->getDataWindow() );
 	Imath::Box2i displayWindow( inputImage->getDisplayWindow() );
-	double displayWH[2] = { static_cast<double>( displayWindow.size().x + 1 ), static_cast<double>( displayWindow.size().y + 1 ) };
-	double displayOrigin[2] = { static_cast<double>( displayWindow.min[0] ), static_cast<double>( displayWindow.min[1] ) };
+	m_displaySize = Imath::V2d( displayWindow.size().x + 1, displayWindow.size().y + 1 );
+	m_displayOrigin = Imath::V2d( displayWindow.min[0], displayWindow.min[1] );
 
 	// Get the distorted window.
 	// As the LensModel::bounds() method requires that the display window has it's origin at (0,0) in the bottom left of the image and the ImagePrimitive has it's origin in the top left,
@@ -130,41 +143,85 @@ void LensDistortOp::begin( const CompoundObject * operands )
 	);
 
 	// Calculate the distorted data window.
-	Imath::Box2i distortedWindow = m_lensModel->bounds( m_mode, distortionSpaceBox, ( displayWindow.size().x + 1 ), ( displayWindow.size().y + 1 ) );
+	m_distortionSpaceWindow = m_lensModel->bounds( m_mode, distortionSpaceBox, ( displayWindow.size().x + 1 ), ( displayWindow.size().y + 1 ) );
 
 	// Convert the distorted data window back to the same image space as ImagePrimitive.
 	m_distortedDataWindow =  Imath::Box2i(
-		Imath::V2i( distortedWindow.min[0] + displayWindow.min[0], ( displayWindow.size().y - distortedWindow.max[1] ) + displayWindow.min[1] ),
-		Imath::V2i( distortedWindow.max[0] + displayWindow.min[0], ( displayWindow.size().y - distortedWindow.min[1] ) + displayWindow.min[1] )
+		Imath::V2i( m_distortionSpaceWindow.min[0] + displayWindow.min[0], ( displayWindow.size().y - m_distortionSpaceWindow.max[1] ) + displayWindow.min[1] ),
+		Imath::V2i( m_distortionSpaceWindow.max[0] + displayWindow.min[0], ( displayWindow.size().y - m_distortionSpaceWindow.min[1] ) + displayWindow.min[1] )
 	);
+}
 
-	// Compute a 2D cache of the warped points for use in the warp() method.
-	IECore::FloatVectorDataPtr cachePtr = new IECore::FloatVectorData;
-	std::vector<float> &cache( cachePtr->writable() );
-	cache.resize( ( m_distortedDataWindow.size().x + 1 ) * ( m_distortedDataWindow.size().y + 1 ) * 2 ); // We interleave the X and Y vector components within the cache.
+Imath::V2f LensDistortOp::distortedPosition( int x, int y, const LensModel::STMap *stMap ) const
+{
+	// Get the distorted uv coordinate, from the ST-map if it covers the point,
+	// and otherwise from the lens model itself.
+	Imath::V2d duv;
+	if( stMap && x >= 0 && y >= 0 && x <= stMap->resolution().x && y <= stMap->resolution().y )
+	{
+		duv = stMap->sample( x, y );
+	}
+	else
+	{
+		// Convert to UV space with the origin in the bottom left.
+		const Imath::V2d uv( x / m_displaySize[0], y / m_displaySize[1] );
+		duv = m_mode == kDistort ? m_lensModel->distort( uv ) : m_lensModel->undistort( uv );
+	}
 
-	for( int y = distortedWindow.max.y, pixelIndex = 0; y >= distortedWindow.min.y; --y )
+	// Transform it to image space.
+	return Imath::V2f(
+		duv[0] * m_displaySize[0] + m_displayOrigin[0], ( ( m_displaySize[1] - 1. ) - ( duv[1] * m_displaySize[1] ) ) + m_displayOrigin[1]
+	);
+}
+
+IECore::ConstV2fVectorDataPtr LensDistortOp::computeWarpField( const Imath::Box2i &warpedDataWindow ) const
+{
+	assert( warpedDataWindow == m_distortedDataWindow );
+
+	// The ST-map is baked at the pixel corners of the display window, which
+	// coincide with the positions we need, and is shared by all images with
+	// the same lens and format. When we're not caching it, we just evaluate
+	// the lens model directly, since we'd need each sample only once anyway.
+	LensModel::STMap::ConstPtr stMap;
+	if( m_cacheSTMapParameter->getTypedValue() )
 	{
-		for( int x = distortedWindow.min.x; x <= distortedWindow.max.x; ++x )
-		{
-			// Convert to UV space with the origin in the bottom left.
-			Imath::V2f p( Imath::V2f( x, y ) );
-			Imath::V2d uv( p[0] / displayWH[0], p[1] / displayWH[1] );
-
-			// Get the distorted uv coordinate.
-			Imath::V2d duv( m_mode == kDistort ? m_lensModel->distort( uv ) : m_lensModel->undistort( uv ) );
-
-			// Transform it to image space.
-			p = Imath::V2f(
-				duv[0] * displayWH[0] + displayOrigin[0], ( ( displayWH[1] - 1. ) - ( duv[1] * displayWH[1] ) ) + displayOrigin[1]
-			);
+		stMap = m_lensModel->stMap(
+			m_mode == kDistort ? LensModel::Distort : LensModel::Undistort,
+			Imath::V2i( int( m_displaySize[0] ), int( m_displaySize[1] ) )
+		);
+	}
 
-			cache[pixelIndex++] = p[0];
-			cache[pixelIndex++] = p[1];
+	IECore::V2fVectorDataPtr result = new IECore::V2fVectorData;
+	std::vector<Imath::V2f> &field = result->writable();
+	const int width = m_distortionSpaceWindow.size().x + 1;
+	const int height = m_distortionSpaceWindow.size().y + 1;
+	field.resize( width * height );
+
+	// Rows of the image run from the top down, whereas rows in distortion
+	// space run from the bottom up.
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			tbb::parallel_for(
+				tbb::blocked_range2d<int>( 0, height, 0, width ),
+				[&]( const tbb::blocked_range2d<int> &tile )
+				{
+					for( int row = tile.rows().begin(); row != tile.rows().end(); ++row )
+					{
+						const int y = m_distortionSpaceWindow.max.y - row;
+						Imath::V2f *out = field.data() + row * width;
+						for( int col = tile.cols().begin(); col != tile.cols().end(); ++col )
+						{
+							out[col] = distortedPosition( m_distortionSpaceWindow.min.x + col, y, stMap.get() );
+						}
+					}
+				},
+				taskGroupContext
+			);
 		}
-	}
+	);
 
-	m_cachePtr = cachePtr;
+	return result;
 }
 
 Imath::Box2i LensDistortOp::warpedDataWindow( const Imath::Box2i &dataWindow ) const
@@ -174,12 +231,10 @@ Imath::Box2i LensDistortOp::warpedDataWindow( const Imath::Box2i &dataWindow ) c
 
 Imath::V2f LensDistortOp::warp( const Imath::V2f &p ) const
 {
-	// Just pull the distorted point from the cache.
-	const int w( m_distortedDataWindow.size().x + 1 );
-	const int xIdx( int( p[0] ) - m_distortedDataWindow.min.x );
-	const int yIdx( int( p[1] ) - m_distortedDataWindow.min.y );
-	const float *vector( &(( m_cachePtr->readable() )[ ( w * yIdx + xIdx ) * 2 ] ) );
-	return Imath::V2f( vector[0], vector[1] );
+	return distortedPosition(
+		int( p[0] ) - m_distortedDataWindow.min.x + m_distortionSpaceWindow.min.x,
+		m_distortionSpaceWindow.max.y - ( int( p[1] ) - m_distortedDataWindow.min.y )
+	);
 }
 
 void LensDistortOp::end()
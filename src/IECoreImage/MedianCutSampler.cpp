@@ -35,7 +35,7 @@
 #include "IECoreImage/MedianCutSampler.h"
 
 #include "IECoreImage/ImagePrimitive.h"
-#include "IECoreImage/SummedAreaOp.h"
+#include "IECoreImage/Private/ImageParallelAlgo.h"
 
 #include "IECore/CompoundObject.h"
 #include "IECore/CompoundParameter.h"
@@ -45,6 +45,9 @@
 #include "boost/format.hpp"
 #include "boost/multi_array.hpp"
 
+#include "tbb/parallel_invoke.h"
+#include "tbb/task_arena.h"
+
 using namespace std;
 using namespace boost;
 using namespace Imath;
@@ -151,9 +154,6 @@ const IntParameter * MedianCutSampler::projectionParameter() const
 	return m_projectionParameter.get();
 }
 
-/// \todo This functionality and the code in SummedAreaOp should be
-/// refactored into a low level templated SummedAreaTable class that
-/// operates on data passed to it.
 typedef boost::multi_array_ref<float, 2> Array2D;
 static inline float energy( const Array2D &summedLuminance, const Box2i &area )
 {
@@ -210,59 +210,85 @@ static void medianCut( const Array2D &luminance, const Array2D &summedLuminance,
 		}
 		Box2i highArea = area;
 		highArea.min[cutAxis] = lowArea.max[cutAxis] + 1;
-		medianCut( luminance, summedLuminance, projection, lowArea, areas, centroids, depth + 1, maxDepth );
-		medianCut( luminance, summedLuminance, projection, highArea, areas, centroids, depth + 1, maxDepth );
+		if( maxDepth - depth > 4 )
+		{
+			// Plenty of work left, so process the two halves in parallel, and then
+			// append the results for the high half to preserve the serial ordering.
+			vector<Box2i> highAreas;
+			vector<V2f> highCentroids;
+			tbb::parallel_invoke(
+				[&] { medianCut( luminance, summedLuminance, projection, lowArea, areas, centroids, depth + 1, maxDepth ); },
+				[&] { medianCut( luminance, summedLuminance, projection, highArea, highAreas, highCentroids, depth + 1, maxDepth ); }
+			);
+			areas.insert( areas.end(), highAreas.begin(), highAreas.end() );
+			centroids.insert( centroids.end(), highCentroids.begin(), highCentroids.end() );
+		}
+		else
+		{
+			medianCut( luminance, summedLuminance, projection, lowArea, areas, centroids, depth + 1, maxDepth );
+			medianCut( luminance, summedLuminance, projection, highArea, areas, centroids, depth + 1, maxDepth );
+		}
 	}
 }
 
 
 ObjectPtr MedianCutSampler::doOperation( const CompoundObject * operands )
 {
-	ImagePrimitivePtr image = static_cast<ImagePrimitive *>( imageParameter()->getValue() )->copy();
+	const ImagePrimitive *image = static_cast<const ImagePrimitive *>( imageParameter()->getValue() );
 	Box2i dataWindow = image->getDataWindow();
 
 	// find the right channel
 	const std::string &channelName = m_channelNameParameter->getTypedValue();
-	FloatVectorDataPtr luminance = image->getChannel<float>( channelName );
-	if( !luminance )
+	ConstFloatVectorDataPtr channel = image->getChannel<float>( channelName );
+	if( !channel )
 	{
 		throw Exception( str( format( "No FloatVectorData channel named \"%s\"." ) % channelName ) );
 	}
 
+	FloatVectorDataPtr luminance = channel->copy();
+	const int width = dataWindow.size().x + 1;
+	const int height = dataWindow.size().y + 1;
+
 	// if the projection requires it, weight the luminances so they're less
 	// important towards the poles of the sphere
 	Projection projection = (Projection)m_projectionParameter->getNumericValue();
 	if( projection==LatLong )
 	{
-		float radiansPerPixel = M_PI / (dataWindow.size().y + 1);
+		float radiansPerPixel = M_PI / height;
 		float angle = ( M_PI - radiansPerPixel ) / 2.0f;
 
-		float *p = &(luminance->writable()[0]);
-
-		for( int y=dataWindow.min.y; y<=dataWindow.max.y; y++ )
+		vector<float> weights( height );
+		for( auto &w : weights )
 		{
-			float *pEnd = p + dataWindow.size().x + 1;
-			float w = cosf( angle );
-			while( p < pEnd )
-			{
-				*p *= w;
-				p++;
-			}
+			w = cosf( angle );
 			angle -= radiansPerPixel;
 		}
 
+		float *data = luminance->writable().data();
+		ImageParallelAlgo::parallelForRows(
+			dataWindow,
+			[&]( int yBegin, int yEnd )
+			{
+				for( int y = yBegin; y < yEnd; y++ )
+				{
+					const int row = y - dataWindow.min.y;
+					const float w = weights[row];
+					float *p = data + (size_t)row * width;
+					float *pEnd = p + width;
+					while( p < pEnd )
+					{
+						*p *= w;
+						p++;
+					}
+				}
+			}
+		);
 	}
 
-	// make a summed area table for speed
-	FloatVectorDataPtr summedLuminance = luminance;
-	luminance = luminance->copy(); // we need this for the centroid computation
-
-	SummedAreaOpPtr summedAreaOp = new SummedAreaOp();
-	summedAreaOp->inputParameter()->setValue( image );
-	summedAreaOp->copyParameter()->setTypedValue( false );
-	summedAreaOp->channelNamesParameter()->getTypedValue().clear();
-	summedAreaOp->channelNamesParameter()->getTypedValue().push_back( "Y" );
-	summedAreaOp->operate();
+	// make a summed area table for speed, keeping the original
+	// luminances for the centroid computation
+	FloatVectorDataPtr summedLuminance = luminance->copy();
+	ImageParallelAlgo::summedAreaTable( summedLuminance->writable().data(), width, height );
 
 	// do the median cut thing
 	CompoundObjectPtr result = new CompoundObject;
@@ -275,8 +301,11 @@ ObjectPtr MedianCutSampler::doOperation( const CompoundObject * operands )
 	dataWindow.min -= dataWindow.min; // let's start indexing from 0 shall we?
 	Array2D array( &(luminance->writable()[0]), extents[dataWindow.size().x+1][dataWindow.size().y+1], fortran_storage_order() );
 	Array2D summedArray( &(summedLuminance->writable()[0]), extents[dataWindow.size().x+1][dataWindow.size().y+1], fortran_storage_order() );
-	medianCut( array, summedArray, projection, dataWindow, areas->writable(), centroids->writable(), 0, subdivisionDepthParameter()->getNumericValue() );
+	tbb::this_task_arena::isolate(
+		[&] {
+			medianCut( array, summedArray, projection, dataWindow, areas->writable(), centroids->writable(), 0, subdivisionDepthParameter()->getNumericValue() );
+		}
+	);
 
 	return result;
 }
-
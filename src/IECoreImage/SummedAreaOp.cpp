@@ -34,6 +34,8 @@
 
 #include "IECoreImage/SummedAreaOp.h"
 
+#include "IECoreImage/Private/ImageParallelAlgo.h"
+
 #include "IECore/DespatchTypedData.h"
 #include "IECore/TypeTraits.h"
 
@@ -65,31 +67,7 @@ struct SummedAreaOp::SumArea
 	template<typename T>
 	ReturnType operator()( T * data )
 	{
-		typedef typename T::ValueType Container;
-		typedef typename Container::value_type V;
-
-		Container &buffer = data->writable();
-
-		// deal with first row alone, as it doesn't have values above it
-		unsigned pixelIndex=0;
-		V rowSum = 0;
-		for( int x=m_dataWindow.min.x; x<=m_dataWindow.max.x; x++, pixelIndex++ )
-		{
-			rowSum += buffer[pixelIndex];
-			buffer[pixelIndex] = rowSum;
-		}
-		// now do the other rows
-		unsigned upperPixelIndex = 0;
-		pixelIndex = m_dataWindow.size().x + 1;
-		for( int y=m_dataWindow.min.y + 1; y<=m_dataWindow.max.y; y++ )
-		{
-			rowSum = 0;
-			for( int x=m_dataWindow.min.x; x<=m_dataWindow.max.x; x++ )
-			{
-				rowSum += buffer[pixelIndex];
-				buffer[pixelIndex++] = rowSum + buffer[upperPixelIndex++];
-			}
-		}
+		ImageParallelAlgo::summedAreaTable( data->writable().data(), m_dataWindow.size().x + 1, m_dataWindow.size().y + 1 );
 	}
 
 	private :
@@ -106,4 +84,3 @@ void SummedAreaOp::modifyChannels( const Imath::Box2i &displayWindow, const Imat
 		despatchTypedData<SumArea, TypeTraits::IsNumericVectorTypedData>( channels[i].get(), summer );
 	}
 }
-
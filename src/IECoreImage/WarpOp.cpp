@@ -36,12 +36,21 @@
 
 #include "IECoreImage/ImagePrimitive.h"
 #include "IECoreImage/ImagePrimitiveParameter.h"
+#include "IECoreImage/Private/ImageParallelAlgo.h"
 
 #include "IECore/CompoundParameter.h"
 #include "IECore/DespatchTypedData.h"
-#include "IECore/Interpolator.h"
+#include "IECore/NullObject.h"
 #include "IECore/TypeTraits.h"
 
+#include "boost/format.hpp"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include <memory>
+
 using namespace boost;
 using namespace Imath;
 using namespace IECore;
@@ -82,6 +91,19 @@ WarpOp::WarpOp( const std::string &description )
 
 	parameters()->addParameter( m_boundModeParameter );
 
+	static TypeId warpFieldTypes[] = { V2fVectorDataTypeId, NullObjectTypeId, InvalidTypeId };
+	m_warpFieldParameter = new ObjectParameter(
+		"warpField",
+		"A precomputed warp field, containing the input position for every pixel of "
+		"the warped data window in scanline order. This can be retrieved with lastWarpField() "
+		"after a previous operation using the same warp and data window. When it is not "
+		"specified, the warp field is computed.",
+		NullObject::defaultNullObject(),
+		warpFieldTypes
+	);
+
+	parameters()->addParameter( m_warpFieldParameter );
+
 }
 
 WarpOp::~WarpOp()
@@ -98,148 +120,313 @@ const IntParameter * WarpOp::filterParameter() const
 	return m_filterParameter.get();
 }
 
-struct WarpOp::Warp
+ObjectParameter *WarpOp::warpFieldParameter()
 {
-	typedef void ReturnType;
+	return m_warpFieldParameter.get();
+}
 
-	Warp( WarpOp * warp, WarpOp::FilterType filter, WarpOp::BoundMode boundMode, const Imath::Box2i &warpedDataWindow, const Imath::Box2i &originalDataWindow )
-		:	m_warpOp( warp ), m_filter( filter ), m_boundMode( boundMode ), m_outputDataWindow( warpedDataWindow ), m_inputDataWindow( originalDataWindow )
-	{
-	}
+const ObjectParameter *WarpOp::warpFieldParameter() const
+{
+	return m_warpFieldParameter.get();
+}
+
+ConstV2fVectorDataPtr WarpOp::lastWarpField() const
+{
+	return m_lastWarpField;
+}
+
+namespace
+{
+
+// The input pixels contributing to a single output pixel. Indices
+// refer to the input channel buffers, and are -1 for samples outside
+// the input which should be treated as black.
+struct Sample
+{
+	int index[4];
+	float ratioX;
+	float ratioY;
+};
 
-	inline void computePixelCoordinates( float x, float y, int &x1, int &y1, int &x2, int &y2, float &ratioX, float &ratioY )
+inline int sampleIndex( int x, int y, int width, int height, WarpOp::BoundMode boundMode )
+{
+	if( boundMode == WarpOp::SetToBlack || !width || !height )
 	{
-		Imath::V2f inPos = m_warpOp->warp( Imath::V2f( x, y ) );
-		x1 = int(inPos.x);
-		y1 = int(inPos.y);
-		if ( x1 > inPos.x )
-		{
-			ratioX = x1 - inPos.x;
-			x2 = x1;
-			x1--;
-		}
-		else
+		if( x < 0 || x >= width || y < 0 || y >= height )
 		{
-			x2 = x1 + 1;
-			ratioX = inPos.x - x1;
+			return -1;
 		}
-		if ( y1 > inPos.y )
-		{
-			ratioY = y1 - inPos.y;
-			y2 = y1;
-			y1--;
-		}
-		else
-		{
-			y2 = y1 + 1;
-			ratioY = inPos.y - y1;
-		}
-		x1 -= m_inputDataWindow.min.x;
-		y1 -= m_inputDataWindow.min.y;
-		x2 -= m_inputDataWindow.min.x;
-		y2 -= m_inputDataWindow.min.y;
+		return x + y * width;
 	}
 
-	template<typename V>
-	inline V clampXY( const std::vector<V> &buffer, int x, int y, int width, int height ) const
+	x = ( x < 0 ? 0 : ( x >= width ? width - 1 : x ));
+	y = ( y < 0 ? 0 : ( y >= height ? height - 1 : y ));
+	return x + y * width;
+}
+
+inline Sample computeSample( const V2f &inPos, WarpOp::FilterType filter, WarpOp::BoundMode boundMode, const Box2i &inputDataWindow )
+{
+	const int inputWidth = inputDataWindow.size().x + 1;
+	const int inputHeight = inputDataWindow.size().y + 1;
+
+	Sample result = { { -1, -1, -1, -1 }, 0.0f, 0.0f };
+	if( filter == WarpOp::None )
 	{
-		if( m_boundMode == WarpOp::SetToBlack )
+		const int x1 = int(inPos.x) - inputDataWindow.min.x;
+		const int y1 = int(inPos.y) - inputDataWindow.min.y;
+		result.index[0] = sampleIndex( x1, y1, inputWidth, inputHeight, boundMode );
+		return result;
+	}
+
+	int x1 = int(inPos.x);
+	int y1 = int(inPos.y);
+	int x2, y2;
+	if ( x1 > inPos.x )
+	{
+		result.ratioX = x1 - inPos.x;
+		x2 = x1;
+		x1--;
+	}
+	else
+	{
+		x2 = x1 + 1;
+		result.ratioX = inPos.x - x1;
+	}
+	if ( y1 > inPos.y )
+	{
+		result.ratioY = y1 - inPos.y;
+		y2 = y1;
+		y1--;
+	}
+	else
+	{
+		y2 = y1 + 1;
+		result.ratioY = inPos.y - y1;
+	}
+	x1 -= inputDataWindow.min.x;
+	y1 -= inputDataWindow.min.y;
+	x2 -= inputDataWindow.min.x;
+	y2 -= inputDataWindow.min.y;
+
+	result.index[0] = sampleIndex( x1, y1, inputWidth, inputHeight, boundMode );
+	result.index[1] = sampleIndex( x2, y1, inputWidth, inputHeight, boundMode );
+	result.index[2] = sampleIndex( x1, y2, inputWidth, inputHeight, boundMode );
+	result.index[3] = sampleIndex( x2, y2, inputWidth, inputHeight, boundMode );
+	return result;
+}
+
+/// Resamples a single channel from a range of precomputed samples.
+class ChannelResampler
+{
+	public :
+
+		virtual ~ChannelResampler()
 		{
-			if( x < 0 || x >= width || y < 0 || y >= height )
-			{
-				return 0;
-			}
-			return buffer[ x + y * width ];
 		}
 
-		x = ( x < 0 ? 0 : ( x >= width ? width - 1 : x ));
-		y = ( y < 0 ? 0 : ( y >= height ? height - 1 : y ));
-		return buffer[ x + y * width ];
-	}
+		virtual void resample( const Sample *samples, size_t begin, size_t end ) = 0;
+		virtual DataPtr output() const = 0;
 
-	template<typename T>
-	ReturnType operator()( T * data )
-	{
-		typedef typename T::ValueType Container;
-		typedef typename Container::value_type V;
-		typename T::Ptr inData = data->copy();
-		const Container &inBuffer = inData->readable();
-		unsigned int outputWidth = m_outputDataWindow.size().x + 1;
-		unsigned int inputWidth = m_inputDataWindow.size().x + 1;
-		unsigned int inputHeight = m_inputDataWindow.size().y + 1;
-		Container &outBuffer = data->writable();
-		outBuffer.resize( outputWidth * (m_outputDataWindow.size().y + 1) );
-		int x1, x2, y1, y2;
-		float ratioX, ratioY;
-		unsigned pixelIndex=0;
-		double r1, r2, r;
-
-		switch( m_filter )
+};
+
+template<typename T>
+class TypedChannelResampler : public ChannelResampler
+{
+
+	public :
+
+		typedef typename T::ValueType::value_type V;
+
+		TypedChannelResampler( const T *input, size_t outputSize, WarpOp::FilterType filter )
+			:	m_input( input ), m_output( new T ), m_filter( filter )
+		{
+			m_output->writable().resize( outputSize );
+		}
+
+		void resample( const Sample *samples, size_t begin, size_t end ) override
 		{
-		case WarpOp::None:
-			for( int y=m_outputDataWindow.min.y; y<=m_outputDataWindow.max.y; y++ )
+			const auto &in = m_input->readable();
+			auto &out = m_output->writable();
+
+			if( m_filter == WarpOp::None )
 			{
-				for( int x=m_outputDataWindow.min.x; x<=m_outputDataWindow.max.x; x++, pixelIndex++ )
+				for( size_t i = begin; i < end; ++i, ++samples )
 				{
-					Imath::V2f inPos = m_warpOp->warp( Imath::V2f( x, y ) );
-					x1 = int(inPos.x) - m_inputDataWindow.min.x;
-					y1 = int(inPos.y) - m_inputDataWindow.min.y;
-					outBuffer[pixelIndex] = clampXY<V>( inBuffer, x1, y1, inputWidth, inputHeight);
+					out[i] = value( in, samples->index[0] );
 				}
+				return;
 			}
-			break;
 
-		case WarpOp::Bilinear:
-			for( int y=m_outputDataWindow.min.y; y<=m_outputDataWindow.max.y; y++ )
+			for( size_t i = begin; i < end; ++i, ++samples )
 			{
-				for( int x=m_outputDataWindow.min.x; x<=m_outputDataWindow.max.x; x++, pixelIndex++ )
-				{
-					computePixelCoordinates( x, y, x1, y1, x2, y2, ratioX, ratioY );
-					LinearInterpolator<double>()( (double)clampXY<V>( inBuffer, x1, y1, inputWidth, inputHeight ),
-												  (double)clampXY<V>( inBuffer, x2, y1, inputWidth, inputHeight ), ratioX, r1 );
-					LinearInterpolator<double>()( (double)clampXY<V>( inBuffer, x1, y2, inputWidth, inputHeight ),
-												  (double)clampXY<V>( inBuffer, x2, y2, inputWidth, inputHeight ), ratioX, r2 );
-					LinearInterpolator<double>()( r1, r2, ratioY, r );
-					outBuffer[pixelIndex] = (V)r;
-				}
+				const double v00 = value( in, samples->index[0] );
+				const double v10 = value( in, samples->index[1] );
+				const double v01 = value( in, samples->index[2] );
+				const double v11 = value( in, samples->index[3] );
+				const double r1 = v00 + ( v10 - v00 ) * samples->ratioX;
+				const double r2 = v01 + ( v11 - v01 ) * samples->ratioX;
+				out[i] = (V)( r1 + ( r2 - r1 ) * samples->ratioY );
 			}
-			break;
+		}
 
-		default:
-			throw Exception("Invalid filter type!");
+		DataPtr output() const override
+		{
+			return m_output;
 		}
-	}
 
 	private :
-		WarpOp * m_warpOp;
+
+		static inline V value( const typename T::ValueType &buffer, int index )
+		{
+			return index < 0 ? V( 0 ) : buffer[index];
+		}
+
+		typename T::ConstPtr m_input;
+		typename T::Ptr m_output;
 		WarpOp::FilterType m_filter;
-		WarpOp::BoundMode m_boundMode;
-		Imath::Box2i m_outputDataWindow;
-		Imath::Box2i m_inputDataWindow;
+
+};
+
+struct CreateResampler
+{
+	typedef std::unique_ptr<ChannelResampler> ReturnType;
+
+	CreateResampler( size_t outputSize, WarpOp::FilterType filter )
+		:	m_outputSize( outputSize ), m_filter( filter )
+	{
+	}
+
+	template<typename T>
+	ReturnType operator()( const T *data ) const
+	{
+		return ReturnType( new TypedChannelResampler<T>( data, m_outputSize, m_filter ) );
+	}
+
+	size_t m_outputSize;
+	WarpOp::FilterType m_filter;
 };
 
+} // namespace
+
 void WarpOp::modify( Object *object, const CompoundObject *operands )
 {
 	ImagePrimitive *image = runTimeCast<ImagePrimitive>( object );
 
+	const FilterType filter = (FilterType)m_filterParameter->getNumericValue();
+	if( filter != None && filter != Bilinear )
+	{
+		throw Exception("Invalid filter type!");
+	}
+	const BoundMode boundMode = (BoundMode)m_boundModeParameter->getNumericValue();
+
 	Imath::Box2i originalDataWindow = image->getDataWindow();
 
 	begin( operands );
 	Imath::Box2i newDataWindow = warpedDataWindow( originalDataWindow );
+
+	const size_t outputWidth = newDataWindow.size().x + 1;
+	const size_t outputHeight = newDataWindow.size().y + 1;
+
+	// Get the input position for every output pixel, either from
+	// the field we were given or by computing it.
+
+	ConstV2fVectorDataPtr warpField = runTimeCast<const V2fVectorData>( m_warpFieldParameter->getValue() );
+	if( warpField )
+	{
+		if( warpField->readable().size() != outputWidth * outputHeight )
+		{
+			throw InvalidArgumentException(
+				boost::str(
+					boost::format( "WarpOp : Warp field has %d elements but the warped data window has %d pixels" ) %
+						warpField->readable().size() % ( outputWidth * outputHeight )
+				)
+			);
+		}
+	}
+	else
+	{
+		warpField = computeWarpField( newDataWindow );
+	}
+	m_lastWarpField = warpField;
+
 	std::string error;
-	Warp w( this, (FilterType)m_filterParameter->getNumericValue(), (BoundMode)m_boundModeParameter->getNumericValue(), newDataWindow, originalDataWindow );
+	std::vector<std::unique_ptr<ChannelResampler>> resamplers;
+	std::vector<std::string> channelNames;
+	CreateResampler createResampler( outputWidth * outputHeight, filter );
 	for( const auto &channel : image->channels )
 	{
 		if ( !image->channelValid( channel.second.get(), &error ) )
 		{
 			throw Exception( error );
 		}
-		despatchTypedData<Warp, TypeTraits::IsNumericVectorTypedData>( channel.second.get(), w );
+		resamplers.push_back( despatchTypedData<CreateResampler, TypeTraits::IsNumericVectorTypedData>( channel.second.get(), createResampler ) );
+		channelNames.push_back( channel.first );
 	}
+
+	// Resample all channels in parallel over blocks of rows. The samples
+	// for each block are computed once and shared by all channels.
+
+	const std::vector<V2f> &field = warpField->readable();
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			tbb::parallel_for(
+				tbb::blocked_range<size_t>( 0, outputHeight ),
+				[&]( const tbb::blocked_range<size_t> &rows )
+				{
+					const size_t begin = rows.begin() * outputWidth;
+					const size_t end = rows.end() * outputWidth;
+
+					std::vector<Sample> samples( end - begin );
+					for( size_t i = begin; i < end; ++i )
+					{
+						samples[i-begin] = computeSample( field[i], filter, boundMode, originalDataWindow );
+					}
+
+					for( const auto &resampler : resamplers )
+					{
+						resampler->resample( samples.data(), begin, end );
+					}
+				},
+				taskGroupContext
+			);
+		}
+	);
+
+	for( size_t i = 0; i < resamplers.size(); ++i )
+	{
+		image->channels[channelNames[i]] = resamplers[i]->output();
+	}
+
 	end();
 	image->setDataWindow( newDataWindow );
 }
 
+ConstV2fVectorDataPtr WarpOp::computeWarpField( const Imath::Box2i &warpedDataWindow ) const
+{
+	V2fVectorDataPtr result = new V2fVectorData;
+	std::vector<V2f> &field = result->writable();
+	const int width = warpedDataWindow.size().x + 1;
+	field.resize( width * ( warpedDataWindow.size().y + 1 ) );
+
+	ImageParallelAlgo::parallelForTiles(
+		warpedDataWindow,
+		[&]( const Box2i &tile )
+		{
+			for( int y = tile.min.y; y <= tile.max.y; ++y )
+			{
+				V2f *out = field.data() + ( y - warpedDataWindow.min.y ) * width - warpedDataWindow.min.x;
+				for( int x = tile.min.x; x <= tile.max.x; ++x )
+				{
+					out[x] = warp( V2f( x, y ) );
+				}
+			}
+		}
+	);
+
+	return result;
+}
+
 Imath::Box2i WarpOp::warpedDataWindow( const Imath::Box2i &dataWindow ) const
 {
 	return dataWindow;
@@ -39,6 +39,7 @@
 #include "IECore/VectorTypedData.h"
 
 #include "IECorePython/RunTimeTypedBinding.h"
+#include "IECorePython/ScopedGILRelease.h"
 
 #include "IECoreImage/ImageDisplayDriver.h"
 #include "IECoreImageBindings/ImageDisplayDriverBinding.h"
@@ -67,7 +68,10 @@ static ImageDisplayDriverPtr imageDisplayDriverConstructor( const Imath::Box2i &
 
 static ImagePrimitivePtr image( ImageDisplayDriverPtr dd )
 {
-	return dd->image()->copy();
+	// We copy from a snapshot, because copies of the image
+	// itself would share data which is still being written to.
+	ScopedGILRelease gilRelease;
+	return dd->snapshot()->copy();
 }
 
 static ImagePrimitivePtr storedImage( const std::string &handle )
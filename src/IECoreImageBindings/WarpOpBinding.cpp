@@ -51,7 +51,9 @@ namespace IECoreImageBindings
 void bindWarpOp()
 {
 
-	scope s = RunTimeTypedClass<WarpOp>();
+	scope s = RunTimeTypedClass<WarpOp>()
+		.def( "lastWarpField", &WarpOp::lastWarpField )
+	;
 	enum_<WarpOp::BoundMode>( "BoundMode" )
 		.value( "Clamp", WarpOp::Clamp )
 		.value( "SetToBlack", WarpOp::SetToBlack )
@@ -37,6 +37,7 @@
 #include "IECorePython/BoundedKDTreeBinding.h"
 
 #include "IECore/BoundedKDTree.h"
+#include "IECore/IndexedIO.h"
 #include "IECore/RefCounted.h"
 #include "IECore/TypedData.h"
 #include "IECore/VectorTypedData.h"
@@ -77,6 +78,13 @@ struct BoundedKDTreeWrapper
 		m_tree = new T(m_bounds->readable().begin(), m_bounds->readable().end());
 	}
 
+	BoundedKDTreeWrapper( BoundDataPtr bounds, ConstIndexedIOPtr directory )
+	{
+		m_bounds = bounds->copy();
+		m_tree = new T;
+		m_tree->load( directory.get(), m_bounds->readable().begin(), m_bounds->readable().end() );
+	}
+
 	virtual ~BoundedKDTreeWrapper()
 	{
 		assert(m_tree);
@@ -107,6 +115,16 @@ struct BoundedKDTreeWrapper
 
 	}
 
+	void save( IndexedIOPtr directory )
+	{
+		m_tree->save( directory.get() );
+	}
+
+	size_t numNodes()
+	{
+		return m_tree->numNodes();
+	}
+
 };
 
 
@@ -115,8 +133,11 @@ void bindBoundedKDTree(const char *bindName)
 {
 	class_<BoundedKDTreeWrapper<T>, boost::noncopyable>(bindName, no_init)
 		.def(init< typename BoundedKDTreeWrapper<T>::BoundDataPtr >() )
+		.def(init< typename BoundedKDTreeWrapper<T>::BoundDataPtr, ConstIndexedIOPtr >() )
 		.def("intersectingBounds", &BoundedKDTreeWrapper<T>::template intersectingBounds<typename T::Bound> )
 		.def("intersectingBounds", &BoundedKDTreeWrapper<T>::template intersectingBounds<typename T::BaseType> )
+		.def("save", &BoundedKDTreeWrapper<T>::save )
+		.def("numNodes", &BoundedKDTreeWrapper<T>::numNodes )
 	;
 
 }
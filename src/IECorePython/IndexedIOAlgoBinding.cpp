@@ -35,7 +35,9 @@
 #include "boost/python.hpp"
 
 #include "IECorePython/IndexedIOAlgoBinding.h"
+#include "IECorePython/ScopedGILRelease.h"
 
+#include "IECore/CompoundData.h"
 #include "IECore/IndexedIOAlgo.h"
 
 using namespace boost::python;
@@ -66,6 +68,33 @@ list parallelReadAll( const IndexedIO* src )
 	return result;
 }
 
+list benchmarkCompression( const IndexedIO *src, const std::string &fileName, object pythonCandidates )
+{
+	std::vector<ConstCompoundDataPtr> candidates;
+	for( size_t i = 0, e = len( pythonCandidates ); i < e; ++i )
+	{
+		candidates.push_back( extract<ConstCompoundDataPtr>( pythonCandidates[i] )() );
+	}
+
+	std::vector<IndexedIOAlgo::CompressionBenchmark> benchmarks;
+	{
+		IECorePython::ScopedGILRelease gilRelease;
+		benchmarks = IndexedIOAlgo::benchmarkCompression( src, fileName, candidates );
+	}
+
+	list result;
+	for( const auto &benchmark : benchmarks )
+	{
+		dict d;
+		d["fileSize"] = benchmark.fileSize;
+		d["writeTime"] = benchmark.writeTime;
+		d["readTime"] = benchmark.readTime;
+		result.append( d );
+	}
+
+	return result;
+}
+
 }
 
 namespace IECorePython
@@ -81,6 +110,7 @@ void bindIndexedIOAlgo()
 
 	def( "copy", &IndexedIOAlgo::copy );
 	def( "parallelReadAll", &::parallelReadAll );
+	def( "benchmarkCompression", &::benchmarkCompression, ( arg( "src" ), arg( "fileName" ), arg( "candidates" ) ) );
 }
 
 } //IECorePython
@@ -37,6 +37,7 @@
 #include "boost/python.hpp"
 
 #include "IECorePython/KDTreeBinding.h"
+#include "IECorePython/ScopedGILRelease.h"
 
 #include "IECore/KDTree.h"
 #include "IECore/RefCounted.h"
@@ -162,6 +163,55 @@ struct KDTreeWrapper
 		return indices;
 	}
 
+	IntVectorDataPtr batchNearestNeighbour( const PointData *points )
+	{
+		std::vector<typename T::PointIndex> neighbours;
+		{
+			ScopedGILRelease gilRelease;
+			m_tree->batchNearestNeighbour( points->readable().begin(), points->readable().end(), neighbours );
+		}
+		return toIndices( neighbours );
+	}
+
+	tuple batchNearestNeighbours( const PointData *points, typename T::Point::BaseType r )
+	{
+		std::vector<typename T::PointIndex> neighbours;
+		std::vector<size_t> offsets;
+		{
+			ScopedGILRelease gilRelease;
+			m_tree->batchNearestNeighbours( points->readable().begin(), points->readable().end(), r, neighbours, offsets );
+		}
+
+		IntVectorDataPtr offsetsData = new IntVectorData();
+		offsetsData->writable().assign( offsets.begin(), offsets.end() );
+		return make_tuple( toIndices( neighbours ), offsetsData );
+	}
+
+	IntVectorDataPtr batchNearestNNeighbours( const PointData *points, unsigned int numNeighbours )
+	{
+		std::vector<typename T::PointIndex> neighbours;
+		{
+			ScopedGILRelease gilRelease;
+			m_tree->batchNearestNNeighbours( points->readable().begin(), points->readable().end(), numNeighbours, neighbours );
+		}
+		return toIndices( neighbours );
+	}
+
+	private :
+
+		// Converts to signed indices, mapping `invalidPointIndex` to -1.
+		static IntVectorDataPtr toIndices( const std::vector<typename T::PointIndex> &neighbours )
+		{
+			IntVectorDataPtr indices = new IntVectorData();
+			std::vector<int> &writable = indices->writable();
+			writable.reserve( neighbours.size() );
+			for( const auto &n : neighbours )
+			{
+				writable.push_back( n == T::invalidPointIndex ? -1 : (int)n );
+			}
+			return indices;
+		}
+
 };
 
 
@@ -174,6 +224,9 @@ void bindKDTree(const char *bindName)
 		.def("nearestNeighbours", &KDTreeWrapper<T>::nearestNeighbours )
 		.def("nearestNNeighbours", &KDTreeWrapper<T>::nearestNNeighbours )
 		.def("enclosedPoints", &KDTreeWrapper<T>::enclosedPoints )
+		.def("batchNearestNeighbour", &KDTreeWrapper<T>::batchNearestNeighbour )
+		.def("batchNearestNeighbours", &KDTreeWrapper<T>::batchNearestNeighbours )
+		.def("batchNearestNNeighbours", &KDTreeWrapper<T>::batchNearestNNeighbours )
 		;
 }
 
@@ -39,7 +39,9 @@
 #include "IECorePython/LensModelBinding.h"
 
 #include "IECorePython/ObjectBinding.h"
+#include "IECorePython/RefCountedBinding.h"
 #include "IECorePython/RunTimeTypedBinding.h"
+#include "IECorePython/ScopedGILRelease.h"
 
 #include "IECore/LensModel.h"
 #include "IECore/VectorTypedData.h"
@@ -61,6 +63,18 @@ static boost::python::list lensModelList()
 	return result;
 }
 
+static LensModel::STMap::ConstPtr stMap( LensModel &lensModel, int mode, const Imath::V2i &resolution )
+{
+	ScopedGILRelease gilRelease;
+	return lensModel.stMap( mode, resolution );
+}
+
+static double stMapError( LensModel &lensModel, const LensModel::STMap *stMap )
+{
+	ScopedGILRelease gilRelease;
+	return lensModel.stMapError( stMap );
+}
+
 namespace IECorePython
 {
 
@@ -82,6 +96,21 @@ void bindLensModel()
 	bind.def( "create", creator2 );
 	bind.def( "create", creator3 ).staticmethod( "create" );
 	bind.def( "lensModels", &lensModelList ).staticmethod("lensModels");
+	bind.def( "stMap", &stMap );
+	bind.def( "stMapError", &stMapError );
+	bind.def( "setSTMapCacheMemoryLimit", &LensModel::setSTMapCacheMemoryLimit ).staticmethod( "setSTMapCacheMemoryLimit" );
+	bind.def( "getSTMapCacheMemoryLimit", &LensModel::getSTMapCacheMemoryLimit ).staticmethod( "getSTMapCacheMemoryLimit" );
+
+	{
+		scope s( bind );
+		RefCountedClass<LensModel::STMap, RefCounted>( "STMap" )
+			.def( "mode", &LensModel::STMap::mode )
+			.def( "resolution", &LensModel::STMap::resolution, return_value_policy<copy_const_reference>() )
+			.def( "sample", &LensModel::STMap::sample )
+			.def( "lookup", &LensModel::STMap::lookup )
+			.def( "memoryUsage", &LensModel::STMap::memoryUsage )
+		;
+	}
 }
 
 } // namespace IECorePython
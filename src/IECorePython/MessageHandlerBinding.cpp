@@ -39,7 +39,9 @@
 #include "IECorePython/ExceptionAlgo.h"
 #include "IECorePython/RefCountedBinding.h"
 #include "IECorePython/ScopedGILLock.h"
+#include "IECorePython/ScopedGILRelease.h"
 
+#include "IECore/AsyncMessageHandler.h"
 #include "IECore/CompoundMessageHandler.h"
 #include "IECore/FilteredMessageHandler.h"
 #include "IECore/LevelFilteredMessageHandler.h"
@@ -94,12 +96,71 @@ LevelFilteredMessageHandlerPtr levelFilteredMessageHandlerConstructor(MessageHan
 	return new LevelFilteredMessageHandler( handle, level );
 }
 
+// Output may be slow, and may be forwarded to handlers which need the
+// GIL on other threads. So we release the GIL before outputting.
+
+void msgWrapper( MessageHandler::Level level, const std::string &context, const std::string &message )
+{
+	ScopedGILRelease gilRelease;
+	msg( level, context, message );
+}
+
+void outputWrapper( MessageHandler::Level level, const std::string &context, const std::string &message )
+{
+	ScopedGILRelease gilRelease;
+	MessageHandler::output( level, context, message );
+}
+
+class AsyncMessageHandlerWrapper : public AsyncMessageHandler
+{
+
+	public :
+
+		AsyncMessageHandlerWrapper( MessageHandlerPtr handler, size_t capacity )
+			:	AsyncMessageHandler( handler, capacity )
+		{
+		}
+
+		~AsyncMessageHandlerWrapper() override
+		{
+			// The base class destructor waits for the remaining messages to be
+			// forwarded, which would deadlock if we held the GIL and the wrapped
+			// handler needed it. Forward them now with the GIL released, so that
+			// the destructor has nothing left to wait for.
+			if( Py_IsInitialized() && PyGILState_Check() )
+			{
+				ScopedGILRelease gilRelease;
+				flush();
+			}
+		}
+
+};
+
+AsyncMessageHandlerPtr asyncMessageHandlerConstructor( MessageHandlerPtr handler, size_t capacity )
+{
+	return new AsyncMessageHandlerWrapper( handler, capacity );
+}
+
+void asyncMessageHandlerHandle( AsyncMessageHandler &h, MessageHandler::Level level, const std::string &context, const std::string &message )
+{
+	ScopedGILRelease gilRelease;
+	h.handle( level, context, message );
+}
+
+void flush( AsyncMessageHandler &h )
+{
+	// The wrapped handler may need the GIL
+	// to process the remaining messages.
+	ScopedGILRelease gilRelease;
+	h.flush();
+}
+
 } // namespace
 
 void IECorePython::bindMessageHandler()
 {
 
-	def( "msg", (void (*)( MessageHandler::Level, const std::string &, const std::string &))&msg );
+	def( "msg", &msgWrapper );
 
 	object mh = RefCountedClass<MessageHandler, RefCounted, MessageHandlerWrapper>( "MessageHandler" )
 		.def( init<>() )
@@ -110,8 +171,11 @@ void IECorePython::bindMessageHandler()
 		.staticmethod( "getDefaultHandler" )
 		.def( "currentHandler", &MessageHandler::currentHandler, return_value_policy<CastToIntrusivePtr>() )
 		.staticmethod( "currentHandler" )
-		.def( "output", (void (*)( MessageHandler::Level, const std::string &, const std::string &))&MessageHandler::output )
+		.def( "output", &outputWrapper )
 		.staticmethod( "output" )
+		.def( "enabled", &MessageHandler::enabled )
+		.staticmethod( "enabled" )
+		.def( "maximumLevel", &MessageHandler::maximumLevel )
 		.def( "levelAsString", MessageHandler::levelAsString )
 		.staticmethod( "levelAsString" )
 		.def( "stringAsLevel", MessageHandler::stringAsLevel )
@@ -145,6 +209,12 @@ void IECorePython::bindMessageHandler()
 		.def( "defaultLevel", &LevelFilteredMessageHandler::defaultLevel ).staticmethod( "defaultLevel" )
 	;
 
+	RefCountedClass<AsyncMessageHandler, FilteredMessageHandler>( "AsyncMessageHandler" )
+		.def( "__init__", make_constructor( &asyncMessageHandlerConstructor, default_call_policies(), ( arg( "handler" ), arg( "capacity" ) = 1024 ) ) )
+		.def( "handle", &asyncMessageHandlerHandle )
+		.def( "flush", &flush )
+	;
+
 	scope mhS( mh );
 
 	enum_<MessageHandler::Level>( "Level" )
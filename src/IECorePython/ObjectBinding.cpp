@@ -69,10 +69,10 @@ void registerType( TypeId typeId, const std::string &typeName, object creator )
 	}
 }
 
-ObjectPtr loadWrapper( ConstIndexedIOPtr ioInterface, const IndexedIO::EntryID &name, const IECore::Canceller *canceller )
+ObjectPtr loadWrapper( ConstIndexedIOPtr ioInterface, const IndexedIO::EntryID &name, const IECore::Canceller *canceller, bool parallel )
 {
 	IECorePython::ScopedGILRelease gilRelease;
-	return Object::load( ioInterface, name, canceller );
+	return Object::load( ioInterface, name, canceller, parallel );
 }
 
 } // namespace
@@ -97,7 +97,7 @@ void bindObject()
 		.def( "create", (ObjectPtr (*)( const std::string &) )&Object::create )
 		.def( "create", (ObjectPtr (*)( TypeId ) )&Object::create )
 		.staticmethod( "create" )
-		.def( "load", loadWrapper, ( arg( "ioInterface" ), arg( "name" ), arg( "canceller" ) = object() ) )
+		.def( "load", loadWrapper, ( arg( "ioInterface" ), arg( "name" ), arg( "canceller" ) = object(), arg( "parallel" ) = false ) )
 		.staticmethod( "load" )
 		.def( "save", (void (Object::*)( IndexedIOPtr, const IndexedIO::EntryID & )const )&Object::save )
 		.def( "memoryUsage", (size_t (Object::*)()const )&Object::memoryUsage, "Returns the number of bytes this instance occupies in memory" )
@@ -38,6 +38,7 @@
 #include "IECoreScene/Group.h"
 #include "IECoreScene/PatchMeshPrimitive.h"
 #include "IECoreScene/TypedObjectParameter.h"
+#include "IECoreScene/private/PrimitiveVariableAlgos.h"
 
 #include "IECore/CompoundParameter.h"
 #include "IECore/DespatchTypedData.h"
@@ -571,25 +572,39 @@ ObjectPtr CurveExtrudeOp::doOperation( const CompoundObject * operands )
 	assert( curves );
 	assert( curves->arePrimitiveVariablesValid() );
 
-	GroupPtr group = new Group();
-
 	const IntVectorData * verticesPerCurve = curves->verticesPerCurve();
 	assert( verticesPerCurve );
 
-	unsigned numCurves = verticesPerCurve->readable().size();
-	unsigned vertexOffset = 0;
-	unsigned varyingOffset = 0;
-	for ( unsigned curveIndex = 0; curveIndex < numCurves; curveIndex++ )
-	{
-		int numVertices = curves->variableSize( PrimitiveVariable::Vertex, curveIndex );
+	// Find the offsets to the data for each curve up front, so
+	// that the patches can be built in parallel.
 
-		PatchMeshPrimitivePtr patchMesh = buildPatchMesh( curves, curveIndex, vertexOffset, varyingOffset );
-		assert( patchMesh );
+	const size_t numCurves = verticesPerCurve->readable().size();
+	std::vector<int> vertexOffsets;
+	std::vector<int> varyingOffsets;
+	PrimitiveVariableAlgos::exclusiveScan(
+		numCurves, [&]( size_t curveIndex ) { return verticesPerCurve->readable()[curveIndex]; }, vertexOffsets, nullptr
+	);
+	PrimitiveVariableAlgos::exclusiveScan(
+		numCurves, [&]( size_t curveIndex ) { return curves->variableSize( PrimitiveVariable::Varying, curveIndex ); }, varyingOffsets, nullptr
+	);
 
-		group->addChild( patchMesh );
+	std::vector<PatchMeshPrimitivePtr> patchMeshes( numCurves );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		numCurves, nullptr,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t curveIndex = begin; curveIndex != end; ++curveIndex )
+			{
+				patchMeshes[curveIndex] = buildPatchMesh( curves, curveIndex, vertexOffsets[curveIndex], varyingOffsets[curveIndex] );
+				assert( patchMeshes[curveIndex] );
+			}
+		}
+	);
 
-		vertexOffset += numVertices;
-		varyingOffset += curves->variableSize( PrimitiveVariable::Varying, curveIndex );
+	GroupPtr group = new Group();
+	for( const auto &patchMesh : patchMeshes )
+	{
+		group->addChild( patchMesh );
 	}
 
 	assert( group->children().size() == numCurves );
@@ -34,13 +34,9 @@
 
 #include "IECoreScene/CurveLineariser.h"
 
-#include "IECoreScene/CurvesPrimitiveEvaluator.h"
+#include "IECoreScene/CurvesAlgo.h"
 
 #include "IECore/CompoundParameter.h"
-#include "IECore/FastFloat.h"
-#include "IECore/MessageHandler.h"
-
-#include "boost/format.hpp"
 
 using namespace IECore;
 using namespace IECoreScene;
@@ -83,116 +79,14 @@ void CurveLineariser::modifyTypedPrimitive( CurvesPrimitive * curves, const Comp
 		return;
 	}
 
-	CurvesPrimitiveEvaluatorPtr evaluator = new CurvesPrimitiveEvaluator( curves );
-	PrimitiveEvaluator::ResultPtr evaluatorResult = evaluator->createResult();
+	const float verticesPerSegment = operands->member<FloatData>( "verticesPerSegment" )->readable();
+	CurvesPrimitivePtr linearised = CurvesAlgo::linearise( curves, verticesPerSegment );
 
-	std::vector<PrimitiveVariable> primitiveVariables;
-	std::vector<IECore::TypeId> primitiveVariableTypes;
-	std::vector<void *> primitiveVariableVectors;
-	for( PrimitiveVariableMap::iterator it=curves->variables.begin(); it!=curves->variables.end(); it++ )
+	// Primitive variables that couldn't be linearised are left in place, as they
+	// always have been.
+	curves->setTopology( linearised->verticesPerCurve(), CubicBasisf::linear(), curves->periodic() );
+	for( const auto &variable : linearised->variables )
 	{
-		switch( it->second.interpolation )
-		{
-			case PrimitiveVariable::Invalid :
-			case PrimitiveVariable::Constant :
-			case PrimitiveVariable::Uniform :
-				// we don't need to process these as they're not interpolated
-				continue;
-			default :
-				// fall through to process the variable
-				;
-		}
-
-		switch( it->second.data->typeId() )
-		{
-			case V3fVectorDataTypeId :
-			{
-				primitiveVariables.push_back( evaluator->primitive()->variables.find( it->first )->second );
-				primitiveVariableTypes.push_back( V3fVectorDataTypeId );
-				std::vector<V3f> &v = static_cast<V3fVectorData *>( it->second.data.get() )->writable();
-				v.clear();
-				primitiveVariableVectors.push_back( &v );
-				break;
-			}
-			case FloatVectorDataTypeId :
-			{
-				primitiveVariables.push_back( evaluator->primitive()->variables.find( it->first )->second );
-				primitiveVariableTypes.push_back( FloatVectorDataTypeId );
-				std::vector<float> &v = static_cast<FloatVectorData *>( it->second.data.get() )->writable();
-				v.clear();
-				primitiveVariableVectors.push_back( &v );
-				break;
-			}
-			case IntVectorDataTypeId :
-			{
-				primitiveVariables.push_back( evaluator->primitive()->variables.find( it->first )->second );
-				primitiveVariableTypes.push_back( IntVectorDataTypeId );
-				std::vector<int> &v = static_cast<IntVectorData *>( it->second.data.get() )->writable();
-				v.clear();
-				primitiveVariableVectors.push_back( &v );
-				break;
-			}
-			case Color3fVectorDataTypeId :
-			{
-				primitiveVariables.push_back( evaluator->primitive()->variables.find( it->first )->second );
-				primitiveVariableTypes.push_back( Color3fVectorDataTypeId );
-				std::vector<Color3f> &v = static_cast<Color3fVectorData *>( it->second.data.get() )->writable();
-				v.clear();
-				primitiveVariableVectors.push_back( &v );
-				break;
-			}
-			default :
-				msg(
-					Msg::Warning,
-					"CurveLineariser::modifyTypedPrimitive",
-					boost::format( "Ignoring primitive variable \"%s\" with unsupported type \"%s\"" ) % it->first % it->second.data->typeName()
-				);
-		}
+		curves->variables[variable.first] = variable.second;
 	}
-
-	size_t numCurves = curves->numCurves();
-	bool periodic = curves->periodic();
-
-	IntVectorDataPtr newVerticesPerCurveData = new IntVectorData();
-	std::vector<int> &newVerticesPerCurve = newVerticesPerCurveData->writable();
-	newVerticesPerCurve.resize( numCurves );
-
-	float verticesPerSegment = operands->member<FloatData>( "verticesPerSegment" )->readable();
-
-	for( size_t curveIndex=0; curveIndex<numCurves; curveIndex++ )
-	{
-		int numVertices = fastFloatFloor( verticesPerSegment * (float)curves->numSegments( curveIndex ) );
-		numVertices = std::max( numVertices, periodic ? 3 : 2 );
-
-		float vStep = periodic ? ( 1.0f / (float)( numVertices ) ) : ( 1.0f / (float)( numVertices - 1 ) );
-		for( int i=0; i<numVertices; i++ )
-		{
-			float v = std::min( vStep * i, 1.0f );
-			evaluator->pointAtV( curveIndex, v, evaluatorResult.get() );
-			for( size_t j=0; j<primitiveVariables.size(); j++ )
-			{
-				switch( primitiveVariableTypes[j] )
-				{
-					case V3fVectorDataTypeId :
-						static_cast<std::vector<V3f> *>( primitiveVariableVectors[j] )->push_back( evaluatorResult->vectorPrimVar( primitiveVariables[j] ) );
-						break;
-					case FloatVectorDataTypeId :
-						static_cast<std::vector<float> *>( primitiveVariableVectors[j] )->push_back( evaluatorResult->floatPrimVar( primitiveVariables[j] ) );
-						break;
-					case IntVectorDataTypeId :
-						static_cast<std::vector<int> *>( primitiveVariableVectors[j] )->push_back( evaluatorResult->intPrimVar( primitiveVariables[j] ) );
-						break;
-					case Color3fVectorDataTypeId :
-						static_cast<std::vector<Color3f> *>( primitiveVariableVectors[j] )->push_back( evaluatorResult->colorPrimVar( primitiveVariables[j] ) );
-						break;
-					default :
-						assert( 0 ); // shouldn't get here
-				}
-			}
-		}
-
-		newVerticesPerCurve[curveIndex] = numVertices;
-	}
-
-	curves->setTopology( newVerticesPerCurveData, CubicBasisf::linear(), periodic );
 }
@@ -102,73 +102,50 @@ Imath::Color3f evalPrimVar<Imath::Color3f>( PrimitiveEvaluator::Result *result,
 }
 
 
-struct  CurvesUniformToVertex
+// Returns the offset of the first Vertex or Varying element of each curve,
+// followed by the total number of elements.
+std::vector<int> curveOffsets( const CurvesPrimitive *curves, PrimitiveVariable::Interpolation interpolation, const Canceller *canceller )
 {
-	typedef DataPtr ReturnType;
-
-	CurvesUniformToVertex( const std::vector<int> &offsets, const Canceller *canceller )	:	m_offsets( offsets ), m_canceller( canceller )
+	const std::vector<int> &verticesPerCurve = curves->verticesPerCurve()->readable();
+	if( interpolation == PrimitiveVariable::Vertex )
 	{
+		return IECoreScene::PrimitiveVariableAlgos::primitiveOffsets(
+			verticesPerCurve.size(), [&]( size_t i ) { return verticesPerCurve[i]; }, canceller
+		);
 	}
 
-	template<typename From> ReturnType operator()( typename From::ConstPtr data )
-	{
-		typename From::Ptr result = static_cast< From* >( Object::create( data->typeId() ).get() );
-		typename From::ValueType &trg = result->writable();
-		typename From::ValueType::const_iterator srcIt = data->readable().begin();
-
-		trg.reserve( m_offsets.size() );
-
-		for ( std::vector<int>::const_iterator oIt = m_offsets.begin(); oIt != m_offsets.end(); oIt++, srcIt++ )
-		{
-			Canceller::check( m_canceller );
-			for ( int i = 0; i < *oIt; i++ )
-			{
-				trg.push_back( *srcIt );
-			}
-		}
-
-		IECoreScene::PrimitiveVariableAlgos::GeometricInterpretationCopier<From> copier;
-		copier( data.get(), result.get() );
-
-		return result;
-	}
-
-	const std::vector<int> &m_offsets;
-	const Canceller *m_canceller;
-};
+	return IECoreScene::PrimitiveVariableAlgos::primitiveOffsets(
+		verticesPerCurve.size(), [&]( size_t i ) { return (int)curves->numSegments( i ) + 1; }, canceller
+	);
+}
 
-struct  CurvesVertexToUniform
+struct CurvesUniformToElements
 {
 	typedef DataPtr ReturnType;
 
-	CurvesVertexToUniform( const CurvesPrimitive *curves, const Canceller *canceller ) : m_curves( curves ), m_canceller( canceller )
+	CurvesUniformToElements( const std::vector<int> &offsets, const Canceller *canceller )	:	m_offsets( offsets ), m_canceller( canceller )
 	{
 	}
 
-	template<typename From> ReturnType operator()( const From* data )
+	template<typename From> ReturnType operator()( const From *data )
 	{
 		typename From::Ptr result = static_cast< From* >( Object::create( data->typeId() ).get() );
 		typename From::ValueType &trg = result->writable();
-		typename From::ValueType::const_iterator srcIt = data->readable().begin();
+		const typename From::ValueType &src = data->readable();
 
-		trg.reserve( m_curves->variableSize( PrimitiveVariable::Uniform ) );
-
-		const std::vector<int> &offsets = m_curves->verticesPerCurve()->readable();
-		for( std::vector<int>::const_iterator oIt = offsets.begin(); oIt != offsets.end(); ++oIt )
-		{
-			Canceller::check( m_canceller );
-			// initialize with the first value to avoid
-			// ambiguitity during default construction
-			typename From::ValueType::value_type total = *srcIt;
-			++srcIt;
-
-			for( int i = 1; i < *oIt; ++i, ++srcIt )
+		trg.resize( m_offsets.back() );
+		IECoreScene::PrimitiveVariableAlgos::parallelForBlocks(
+			m_offsets.size() - 1, m_canceller,
+			[&]( size_t begin, size_t end )
 			{
-				total += *srcIt;
-			}
-
-			trg.push_back( total / *oIt );
-		}
+				for( size_t i = begin; i != end; ++i )
+				{
+					std::fill( trg.begin() + m_offsets[i], trg.begin() + m_offsets[i+1], src[i] );
+				}
+			},
+			// The packed storage of `std::vector<bool>` means it can't be written concurrently.
+			!std::is_same_v<typename From::ValueType::value_type, bool>
+		);
 
 		IECoreScene::PrimitiveVariableAlgos::GeometricInterpretationCopier<From> copier;
 		copier( data, result.get() );
@@ -176,79 +153,25 @@ struct  CurvesVertexToUniform
 		return result;
 	}
 
-	const CurvesPrimitive *m_curves;
-	const Canceller *m_canceller;
-};
-
-struct  CurvesUniformToVarying
-{
-	typedef DataPtr ReturnType;
-
-	CurvesUniformToVarying( const CurvesPrimitive *curves, const Canceller *canceller ) : m_curves( curves ), m_canceller( canceller )
-	{
-	}
-
-	template<typename From> ReturnType operator()( typename From::ConstPtr data )
-	{
-		typename From::Ptr result = static_cast< From* >( Object::create( data->typeId() ).get() );
-		typename From::ValueType &trg = result->writable();
-		typename From::ValueType::const_iterator srcIt = data->readable().begin();
-
-		trg.reserve( m_curves->variableSize( PrimitiveVariable::Varying ) );
-
-		size_t numCurves = m_curves->numCurves();
-		for( size_t i = 0; i < numCurves; ++i, ++srcIt )
-		{
-			Canceller::check( m_canceller );
-			for( size_t j = 0; j < m_curves->numSegments( i ) + 1; ++j )
-			{
-				trg.push_back( *srcIt );
-			}
-		}
-
-		IECoreScene::PrimitiveVariableAlgos::GeometricInterpretationCopier<From> copier;
-		copier( data.get(), result.get() );
-
-		return result;
-	}
-
-	const CurvesPrimitive *m_curves;
+	const std::vector<int> &m_offsets;
 	const Canceller *m_canceller;
 };
 
-struct  CurvesVaryingToUniform
+struct CurvesElementsToUniform
 {
 	typedef DataPtr ReturnType;
 
-	CurvesVaryingToUniform( const CurvesPrimitive *curves, const Canceller *canceller ) : m_curves( curves ), m_canceller( canceller )
+	CurvesElementsToUniform( const std::vector<int> &offsets, const Canceller *canceller )	:	m_offsets( offsets ), m_canceller( canceller )
 	{
 	}
 
-	template<typename From> ReturnType operator()( const From* data )
+	template<typename From> ReturnType operator()( const From *data )
 	{
 		typename From::Ptr result = static_cast< From* >( Object::create( data->typeId() ).get() );
-		typename From::ValueType &trg = result->writable();
-		typename From::ValueType::const_iterator srcIt = data->readable().begin();
-
-		trg.reserve( m_curves->variableSize( PrimitiveVariable::Uniform ) );
-
-		size_t numCurves = m_curves->numCurves();
-		for( size_t i = 0; i < numCurves; ++i )
-		{
-			Canceller::check( m_canceller );
-			// initialize with the first value to avoid
-			// ambiguitity during default construction
-			typename From::ValueType::value_type total = *srcIt;
-			++srcIt;
 
-			size_t varyingSize = m_curves->numSegments( i ) + 1;
-			for( size_t j = 1; j < varyingSize; ++j, ++srcIt )
-			{
-				total += *srcIt;
-			}
-
-			trg.push_back( total / varyingSize );
-		}
+		IECoreScene::PrimitiveVariableAlgos::averageElements(
+			m_offsets, []( int j ) { return j; }, data->readable(), result->writable(), m_canceller
+		);
 
 		IECoreScene::PrimitiveVariableAlgos::GeometricInterpretationCopier<From> copier;
 		copier( data, result.get() );
@@ -256,7 +179,7 @@ struct  CurvesVaryingToUniform
 		return result;
 	}
 
-	const CurvesPrimitive *m_curves;
+	const std::vector<int> &m_offsets;
 	const Canceller *m_canceller;
 };
 
@@ -383,70 +306,69 @@ CurvesPrimitivePtr deleteCurves(
 	const Canceller *canceller
 )
 {
-	IECoreScene::PrimitiveVariableAlgos::DeleteFlaggedUniformFunctor<T> deleteUniformFn( deleteFlagView, invert );
-	IECoreScene::PrimitiveVariableAlgos::DeleteFlaggedVaryingFunctor<T> deleteVaryingFn ( deleteFlagView, curvesPrimitive, invert );
-	IECoreScene::PrimitiveVariableAlgos::DeleteFlaggedVertexFunctor<T> deleteVertexFn(
-		curvesPrimitive->variableSize( PrimitiveVariable::Vertex ),
-		/* vertexIds */ nullptr,
-		curvesPrimitive->verticesPerCurve(),
-		deleteFlagView,
-		invert
-	);
-
-	const IECore::Data *inputVertsPerCurve = IECore::runTimeCast<const IECore::Data>( curvesPrimitive->verticesPerCurve() );
-
-	IECoreScene::PrimitiveVariableAlgos::IndexedData outputVertsPerCurve = dispatch( inputVertsPerCurve, deleteUniformFn );
-
-	IntVectorDataPtr verticesPerCurve = IECore::runTimeCast<IECore::IntVectorData>( outputVertsPerCurve.data );
-
-	CurvesPrimitivePtr outCurvesPrimitive = new CurvesPrimitive( verticesPerCurve, curvesPrimitive->basis(), curvesPrimitive->periodic() );
-
-	for (PrimitiveVariableMap::const_iterator it = curvesPrimitive->variables.begin(), e = curvesPrimitive->variables.end(); it != e; ++it)
+	for( const auto &p : curvesPrimitive->variables )
 	{
-		Canceller::check( canceller );
-		if( !curvesPrimitive->isPrimitiveVariableValid( it->second ) )
+		if( !curvesPrimitive->isPrimitiveVariableValid( p.second ) )
 		{
 			throw InvalidArgumentException(
-				boost::str ( boost::format( "CurvesAlgo::deleteCurves cannot process invalid primitive variable \"%s\"" ) % it->first ) );
+				boost::str ( boost::format( "CurvesAlgo::deleteCurves cannot process invalid primitive variable \"%s\"" ) % p.first ) );
 		}
+	}
+
+	const std::vector<int> &inputVerticesPerCurve = curvesPrimitive->verticesPerCurve()->readable();
+	const CubicBasisf &basis = curvesPrimitive->basis();
+	const bool periodic = curvesPrimitive->periodic();
 
-		switch( it->second.interpolation )
+	const std::vector<int> keptCurves = IECoreScene::PrimitiveVariableAlgos::keptElements(
+		inputVerticesPerCurve.size(),
+		[&]( size_t i ) { return IECoreScene::PrimitiveVariableAlgos::keepFlagged( deleteFlagView[i], invert ); },
+		canceller
+	);
+
+	const std::vector<int> keptVertices = IECoreScene::PrimitiveVariableAlgos::keptPrimitiveElements(
+		keptCurves, inputVerticesPerCurve.size(), [&]( size_t i ) { return inputVerticesPerCurve[i]; }, canceller
+	);
+
+	const std::vector<int> keptVaryings = IECoreScene::PrimitiveVariableAlgos::keptPrimitiveElements(
+		keptCurves, inputVerticesPerCurve.size(),
+		[&]( size_t i ) { return (int)curvesPrimitive->numSegments( i ) + 1; },
+		canceller
+	);
+
+	IntVectorDataPtr verticesPerCurveData = new IntVectorData;
+	std::vector<int> &verticesPerCurve = verticesPerCurveData->writable();
+	verticesPerCurve.resize( keptCurves.size() );
+	IECoreScene::PrimitiveVariableAlgos::parallelForBlocks(
+		keptCurves.size(), canceller,
+		[&]( size_t begin, size_t end )
 		{
-			case PrimitiveVariable::Constant:
-			case PrimitiveVariable::Invalid:
+			for( size_t i = begin; i != end; ++i )
 			{
-				outCurvesPrimitive->variables[it->first] = it->second;
-				break;
+				verticesPerCurve[i] = inputVerticesPerCurve[ keptCurves[i] ];
 			}
-			case PrimitiveVariable::Uniform:
-			{
-				const IECore::Data *inputData = it->second.data.get();
-				deleteUniformFn.setIndices( it->second.indices.get() );
-				IECoreScene::PrimitiveVariableAlgos::IndexedData outputData = dispatch( inputData, deleteUniformFn );
-				outCurvesPrimitive->variables[it->first] = PrimitiveVariable( it->second.interpolation, outputData.data, outputData.indices );
+		}
+	);
 
-				break;
-			}
-			case PrimitiveVariable::Varying:
-			case PrimitiveVariable::FaceVarying:
-			{
-				const IECore::Data *inputData = it->second.data.get();
-				deleteVaryingFn.setIndices( it->second.indices.get() );
-				IECoreScene::PrimitiveVariableAlgos::IndexedData outputData = dispatch( inputData, deleteVaryingFn );
-				outCurvesPrimitive->variables[it->first] = PrimitiveVariable( it->second.interpolation, outputData.data, outputData.indices );
+	CurvesPrimitivePtr outCurvesPrimitive = new CurvesPrimitive( verticesPerCurveData, basis, periodic );
 
-				break;
-			}
-			case PrimitiveVariable::Vertex:
+	IECoreScene::PrimitiveVariableAlgos::compactPrimitiveVariables(
+		curvesPrimitive->variables, outCurvesPrimitive->variables,
+		[&]( PrimitiveVariable::Interpolation interpolation ) -> const std::vector<int> * {
+			switch( interpolation )
 			{
-				const IECore::Data *inputData = it->second.data.get();
-				deleteVertexFn.setIndices( it->second.indices.get() );
-				IECoreScene::PrimitiveVariableAlgos::IndexedData outputData = dispatch( inputData, deleteVertexFn );
-				outCurvesPrimitive->variables[it->first] = PrimitiveVariable( it->second.interpolation, outputData.data, outputData.indices );
-				break;
+				case PrimitiveVariable::Uniform :
+					return &keptCurves;
+				case PrimitiveVariable::Vertex :
+					return &keptVertices;
+				case PrimitiveVariable::Varying :
+				case PrimitiveVariable::FaceVarying :
+					return &keptVaryings;
+				default :
+					return nullptr;
 			}
-		}
-	}
+		},
+		canceller
+	);
 
 	return outCurvesPrimitive;
 }
@@ -519,23 +441,20 @@ void resamplePrimitiveVariable( const CurvesPrimitive *curves, PrimitiveVariable
 	}
 	else if ( interpolation == PrimitiveVariable::Uniform )
 	{
-		if ( primitiveVariable.interpolation == PrimitiveVariable::Vertex )
-		{
-			CurvesVertexToUniform fn( curves, canceller );
-			dstData = despatchTypedData<CurvesVertexToUniform, Detail::IsArithmeticVectorTypedData>( const_cast< Data * >( srcData.get() ), fn );
-		}
-		else if ( primitiveVariable.interpolation == PrimitiveVariable::Varying || primitiveVariable.interpolation == PrimitiveVariable::FaceVarying )
+		if ( primitiveVariable.interpolation == PrimitiveVariable::Vertex || primitiveVariable.interpolation == PrimitiveVariable::Varying || primitiveVariable.interpolation == PrimitiveVariable::FaceVarying )
 		{
-			CurvesVaryingToUniform fn( curves, canceller );
-			dstData = despatchTypedData<CurvesVaryingToUniform, Detail::IsArithmeticVectorTypedData>( const_cast< Data * >( srcData.get() ), fn );
+			const std::vector<int> offsets = curveOffsets( curves, primitiveVariable.interpolation, canceller );
+			CurvesElementsToUniform fn( offsets, canceller );
+			dstData = despatchTypedData<CurvesElementsToUniform, Detail::IsArithmeticVectorTypedData>( const_cast< Data * >( srcData.get() ), fn );
 		}
 	}
 	else if ( interpolation == PrimitiveVariable::Vertex )
 	{
 		if ( primitiveVariable.interpolation == PrimitiveVariable::Uniform )
 		{
-			CurvesUniformToVertex fn( curves->verticesPerCurve()->readable(), canceller );
-			dstData = despatchTypedData<CurvesUniformToVertex, TypeTraits::IsNumericBasedVectorTypedData>( const_cast< Data * >( srcData.get() ), fn );
+			const std::vector<int> offsets = curveOffsets( curves, interpolation, canceller );
+			CurvesUniformToElements fn( offsets, canceller );
+			dstData = despatchTypedData<CurvesUniformToElements, TypeTraits::IsNumericBasedVectorTypedData>( const_cast< Data * >( srcData.get() ), fn );
 		}
 		else if ( primitiveVariable.interpolation == PrimitiveVariable::Varying || primitiveVariable.interpolation == PrimitiveVariable::FaceVarying )
 		{
@@ -547,8 +466,9 @@ void resamplePrimitiveVariable( const CurvesPrimitive *curves, PrimitiveVariable
 	{
 		if ( primitiveVariable.interpolation == PrimitiveVariable::Uniform )
 		{
-			CurvesUniformToVarying fn( curves, canceller );
-			dstData = despatchTypedData<CurvesUniformToVarying, TypeTraits::IsNumericBasedVectorTypedData>( const_cast< Data * >( srcData.get()), fn );
+			const std::vector<int> offsets = curveOffsets( curves, interpolation, canceller );
+			CurvesUniformToElements fn( offsets, canceller );
+			dstData = despatchTypedData<CurvesUniformToElements, TypeTraits::IsNumericBasedVectorTypedData>( const_cast< Data * >( srcData.get()), fn );
 		}
 		else if ( primitiveVariable.interpolation == PrimitiveVariable::Vertex )
 		{
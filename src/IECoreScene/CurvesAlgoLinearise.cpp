@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2026, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "IECoreScene/CurvesAlgo.h"
+#include "IECoreScene/CurvesPrimitiveEvaluator.h"
+#include "IECoreScene/private/PrimitiveVariableAlgos.h"
+
+#include "IECore/FastFloat.h"
+#include "IECore/MessageHandler.h"
+
+#include "boost/format.hpp"
+
+using namespace IECore;
+using namespace IECoreScene;
+using namespace Imath;
+
+CurvesPrimitivePtr IECoreScene::CurvesAlgo::linearise( const CurvesPrimitive *curves, float verticesPerSegment, const Canceller *canceller )
+{
+	if( curves->basis() == CubicBasisf::linear() )
+	{
+		return curves->copy();
+	}
+
+	const size_t numCurves = curves->numCurves();
+	const bool periodic = curves->periodic();
+
+	// Compute the number of output vertices for each curve, and the offset to
+	// the first vertex of each, so that the curves can be filled in parallel.
+
+	IntVectorDataPtr verticesPerCurveData = new IntVectorData();
+	std::vector<int> &verticesPerCurve = verticesPerCurveData->writable();
+	verticesPerCurve.resize( numCurves );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		numCurves, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t curveIndex = begin; curveIndex != end; ++curveIndex )
+			{
+				const int numVertices = fastFloatFloor( verticesPerSegment * (float)curves->numSegments( curveIndex ) );
+				verticesPerCurve[curveIndex] = std::max( numVertices, periodic ? 3 : 2 );
+			}
+		}
+	);
+
+	std::vector<int> vertexOffsets;
+	const size_t numVertices = PrimitiveVariableAlgos::exclusiveScan(
+		numCurves, [&]( size_t curveIndex ) { return verticesPerCurve[curveIndex]; }, vertexOffsets, canceller
+	);
+
+	// Generate the curve parameters for the new vertices, and evaluate
+	// the primitive variables at them in a batch.
+
+	std::vector<int> curveIndices( numVertices );
+	std::vector<float> v( numVertices );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		numCurves, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t curveIndex = begin; curveIndex != end; ++curveIndex )
+			{
+				const int numCurveVertices = verticesPerCurve[curveIndex];
+				const float vStep = periodic ? ( 1.0f / (float)( numCurveVertices ) ) : ( 1.0f / (float)( numCurveVertices - 1 ) );
+				const size_t offset = vertexOffsets[curveIndex];
+				for( int i = 0; i < numCurveVertices; ++i )
+				{
+					curveIndices[offset+i] = curveIndex;
+					v[offset+i] = std::min( vStep * i, 1.0f );
+				}
+			}
+		}
+	);
+
+	CurvesPrimitivePtr result = new CurvesPrimitive( verticesPerCurveData, CubicBasisf::linear(), periodic );
+	CurvesPrimitiveEvaluatorPtr evaluator = new CurvesPrimitiveEvaluator( curves );
+
+	for( const auto &variable : curves->variables )
+	{
+		switch( variable.second.interpolation )
+		{
+			case PrimitiveVariable::Invalid :
+				continue;
+			case PrimitiveVariable::Constant :
+			case PrimitiveVariable::Uniform :
+				// we don't need to process these as they're not interpolated
+				result->variables.insert( variable );
+				continue;
+			default :
+				// fall through to process the variable
+				;
+		}
+
+		switch( variable.second.data->typeId() )
+		{
+			case V3fVectorDataTypeId :
+			case FloatVectorDataTypeId :
+			case IntVectorDataTypeId :
+			case Color3fVectorDataTypeId :
+				result->variables[variable.first] = PrimitiveVariable(
+					variable.second.interpolation,
+					evaluator->primVarAtV( variable.second, curveIndices, v, canceller )
+				);
+				break;
+			default :
+				msg(
+					Msg::Warning,
+					"CurvesAlgo::linearise",
+					boost::format( "Ignoring primitive variable \"%s\" with unsupported type \"%s\"" ) % variable.first % variable.second.data->typeName()
+				);
+		}
+	}
+
+	return result;
+}
@@ -35,7 +35,9 @@
 #include "IECoreScene/CurvesPrimitiveEvaluator.h"
 
 #include "IECoreScene/CurvesPrimitive.h"
+#include "IECoreScene/private/PrimitiveVariableAlgos.h"
 
+#include "IECore/DataAlgo.h"
 #include "IECore/Exception.h"
 #include "IECore/FastFloat.h"
 #include "IECore/LineSegment.h"
@@ -49,6 +51,12 @@
 #include "Imath/ImathFun.h"
 #endif
 
+#include "boost/format.hpp"
+
+#include "tbb/task_arena.h"
+
+#include <algorithm>
+
 using namespace IECore;
 using namespace IECoreScene;
 using namespace Imath;
@@ -313,6 +321,10 @@ struct CurvesPrimitiveEvaluator::Line
 {
 	public :
 
+		Line()
+		{
+		}
+
 		Line( const V3f &p1, const V3f &p2, unsigned curveIndex, float vMin, float vMax )
 			:	m_lineSegment( p1, p2 ), m_curveIndex( curveIndex ), m_vMin( vMin ), m_vMax( vMax )
 		{
@@ -341,7 +353,7 @@ struct CurvesPrimitiveEvaluator::Line
 //////////////////////////////////////////////////////////////////////////
 
 CurvesPrimitiveEvaluator::CurvesPrimitiveEvaluator( ConstCurvesPrimitivePtr curves )
-	:	m_curvesPrimitive( curves->copy() ), m_verticesPerCurve( m_curvesPrimitive->verticesPerCurve()->readable() ), m_haveTree( false )
+	:	m_curvesPrimitive( curves->copy() ), m_verticesPerCurve( m_curvesPrimitive->verticesPerCurve()->readable() ), m_haveTree( false ), m_haveArcLengths( false )
 {
 	m_vertexDataOffsets.reserve( m_verticesPerCurve.size() );
 	m_varyingDataOffsets.reserve( m_verticesPerCurve.size() );
@@ -438,10 +450,10 @@ void CurvesPrimitiveEvaluator::closestPointWalk( Box3fTree::NodeIndex nodeIndex,
 	const Box3fTree::Node &node = m_tree.node( nodeIndex );
 	if( node.isLeaf() )
 	{
-		Box3fTree::Iterator *permLast = node.permLast();
-		for( Box3fTree::Iterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		const size_t lastBound = node.lastBound();
+		for( size_t i = node.firstBound(); i != lastBound; ++i )
 		{
-			const Line &line = m_treeLines[*perm - m_treeBounds.begin()];
+			const Line &line = m_treeLines[m_tree.boundIndex( i )];
 
 			float t;
 			V3f cp = line.lineSegment().closestPointTo( p, t );
@@ -458,8 +470,8 @@ void CurvesPrimitiveEvaluator::closestPointWalk( Box3fTree::NodeIndex nodeIndex,
 	else
 	{
 
-		Box3fTree::NodeIndex lowChild = Box3fTree::lowChildIndex( nodeIndex );
-		Box3fTree::NodeIndex highChild = Box3fTree::highChildIndex( nodeIndex );
+		Box3fTree::NodeIndex lowChild = m_tree.lowChildIndex( nodeIndex );
+		Box3fTree::NodeIndex highChild = m_tree.highChildIndex( nodeIndex );
 
 		float d2Low = ( closestPointInBox( p, m_tree.node( lowChild ).bound() ) - p ).length2();
 		float d2High = ( closestPointInBox( p, m_tree.node( highChild ).bound() ) - p ).length2();
@@ -661,60 +673,417 @@ void CurvesPrimitiveEvaluator::buildTree()
 		return;
 	}
 
-	bool linear = m_curvesPrimitive->basis() == CubicBasisf::linear();
+	const bool linear = m_curvesPrimitive->basis() == CubicBasisf::linear();
+	const bool periodic = m_curvesPrimitive->periodic();
 	const std::vector<V3f> &p = static_cast<const V3fVectorData *>( m_p.data.get() )->readable();
-	PrimitiveEvaluator::ResultPtr result = createResult();
+	const size_t numCurves = m_verticesPerCurve.size();
 
-	size_t numCurves = m_curvesPrimitive->numCurves();
-	for( size_t curveIndex = 0; curveIndex<numCurves; curveIndex++ )
-	{
+	// Count the lines for each curve up front, so that each curve
+	// can be written directly to its final position in parallel.
+	auto numLines = [&]( size_t curveIndex ) -> size_t {
 		if( linear )
 		{
-			int numVertices = m_verticesPerCurve[curveIndex];
-			int vertIndex = m_vertexDataOffsets[curveIndex];
-			float prevV = 0.0f;
-			for( int i=0; i<numVertices; i++, vertIndex++ )
-			{
-				float v = Imath::clamp( (float)i/(float)(numVertices-1), 0.0f, 1.0f );
-				if( i!=0 )
+			return std::max( m_verticesPerCurve[curveIndex] - 1, 0 );
+		}
+		else
+		{
+			const int steps = m_curvesPrimitive->numSegments( curveIndex ) * Line::linesPerCurveSegment();
+			return std::max( steps - 1, 0 );
+		}
+	};
+
+	// We're holding a lock, so must isolate to avoid picking up
+	// unrelated tasks that might require the same lock.
+	tbb::this_task_arena::isolate(
+		[&] {
+			std::vector<int> lineOffsets;
+			const size_t totalLines = PrimitiveVariableAlgos::exclusiveScan( numCurves, numLines, lineOffsets, nullptr );
+			m_treeBounds.resize( totalLines );
+			m_treeLines.resize( totalLines );
+
+			PrimitiveVariableAlgos::parallelForBlocks(
+				numCurves, nullptr,
+				[&]( size_t begin, size_t end )
 				{
-					Box3f b;
-					b.extendBy( p[vertIndex-1] );
-					b.extendBy( p[vertIndex] );
-					m_treeBounds.push_back( b );
-					m_treeLines.push_back( Line(  p[vertIndex-1], p[vertIndex], curveIndex, prevV, v ) );
+					Result result( m_p, linear, periodic );
+					for( size_t curveIndex = begin; curveIndex != end; ++curveIndex )
+					{
+						Box3f *bounds = m_treeBounds.data() + lineOffsets[curveIndex];
+						Line *lines = m_treeLines.data() + lineOffsets[curveIndex];
+						if( linear )
+						{
+							int numVertices = m_verticesPerCurve[curveIndex];
+							int vertIndex = m_vertexDataOffsets[curveIndex];
+							float prevV = 0.0f;
+							for( int i=0; i<numVertices; i++, vertIndex++ )
+							{
+								float v = Imath::clamp( (float)i/(float)(numVertices-1), 0.0f, 1.0f );
+								if( i!=0 )
+								{
+									Box3f &b = *bounds++;
+									b.extendBy( p[vertIndex-1] );
+									b.extendBy( p[vertIndex] );
+									*lines++ = Line( p[vertIndex-1], p[vertIndex], curveIndex, prevV, v );
+								}
+								prevV = v;
+							}
+						}
+						else
+						{
+							int steps = m_curvesPrimitive->numSegments( curveIndex ) * Line::linesPerCurveSegment();
+							V3f prevP( 0 );
+							float prevV = 0;
+							for( int i=0; i<steps; i++ )
+							{
+								float v = Imath::clamp( (float)i/(float)(steps-1), 0.0f, 1.0f );
+								(result.*result.m_init)( curveIndex, v, this );
+								V3f newP = result.primVar<V3f>( m_p, result.m_coefficients );
+								if( i!=0 )
+								{
+									Box3f &b = *bounds++;
+									b.extendBy( prevP );
+									b.extendBy( newP );
+									*lines++ = Line( prevP, newP, curveIndex, prevV, v );
+								}
+
+								prevP = newP;
+								prevV = v;
+							}
+						}
+					}
 				}
-				prevV = v;
-			}
+			);
+
+			m_tree.init( m_treeBounds.begin(), m_treeBounds.end() );
 		}
-		else
+	);
+
+	m_haveTree = true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Arc lengths
+//////////////////////////////////////////////////////////////////////////
+
+unsigned CurvesPrimitiveEvaluator::arcLengthSamples( unsigned curveIndex ) const
+{
+	// Linear curves are sampled exactly at their vertices. Cubic curves use
+	// the same number of samples per segment as `curveLength()`.
+	const unsigned numSegments = m_curvesPrimitive->numSegments( curveIndex );
+	const unsigned samplesPerSegment = m_curvesPrimitive->basis() == CubicBasisf::linear() ? 1 : 10;
+	return numSegments * samplesPerSegment + 1;
+}
+
+void CurvesPrimitiveEvaluator::buildArcLengths()
+{
+	if( m_haveArcLengths )
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock( m_arcLengthMutex );
+	if( m_haveArcLengths )
+	{
+		return;
+	}
+
+	const bool linear = m_curvesPrimitive->basis() == CubicBasisf::linear();
+	const bool periodic = m_curvesPrimitive->periodic();
+	const size_t numCurves = m_verticesPerCurve.size();
+
+	tbb::this_task_arena::isolate(
+		[&] {
+			const size_t totalSamples = PrimitiveVariableAlgos::exclusiveScan(
+				numCurves, [&]( size_t curveIndex ) -> size_t { return arcLengthSamples( curveIndex ); },
+				m_arcLengthOffsets, nullptr
+			);
+			m_arcLengthOffsets.push_back( totalSamples );
+			m_arcLengths.resize( totalSamples );
+
+			PrimitiveVariableAlgos::parallelForBlocks(
+				numCurves, nullptr,
+				[&]( size_t begin, size_t end )
+				{
+					Result result( m_p, linear, periodic );
+					for( size_t curveIndex = begin; curveIndex != end; ++curveIndex )
+					{
+						float *lengths = m_arcLengths.data() + m_arcLengthOffsets[curveIndex];
+						const int numSamples = m_arcLengthOffsets[curveIndex+1] - m_arcLengthOffsets[curveIndex];
+						float length = 0;
+						V3f previous( 0 );
+						for( int i = 0; i < numSamples; ++i )
+						{
+							const float v = numSamples > 1 ? std::min( (float)i / (float)( numSamples - 1 ), 1.0f ) : 0.0f;
+							(result.*result.m_init)( curveIndex, v, this );
+							const V3f current = result.primVar<V3f>( m_p, result.m_coefficients );
+							if( i )
+							{
+								length += ( current - previous ).length();
+							}
+							lengths[i] = length;
+							previous = current;
+						}
+					}
+				}
+			);
+		}
+	);
+
+	m_haveArcLengths = true;
+}
+
+float CurvesPrimitiveEvaluator::vAtLengthInternal( unsigned curveIndex, float length ) const
+{
+	const float *lengths = m_arcLengths.data() + m_arcLengthOffsets[curveIndex];
+	const int numSamples = m_arcLengthOffsets[curveIndex+1] - m_arcLengthOffsets[curveIndex];
+	if( numSamples < 2 || !( length > 0.0f ) )
+	{
+		return 0.0f;
+	}
+	if( length >= lengths[numSamples-1] )
+	{
+		return 1.0f;
+	}
+
+	// Find the first sample beyond `length`, and interpolate linearly from the
+	// sample before it. We know that `lengths[i] > length >= lengths[i-1]`, so
+	// the division is safe.
+	const int i = std::upper_bound( lengths, lengths + numSamples, length ) - lengths;
+	const float t = ( length - lengths[i-1] ) / ( lengths[i] - lengths[i-1] );
+	return std::min( ( (float)( i - 1 ) + t ) / (float)( numSamples - 1 ), 1.0f );
+}
+
+float CurvesPrimitiveEvaluator::vAtLength( unsigned curveIndex, float length ) const
+{
+	if( curveIndex >= m_verticesPerCurve.size() )
+	{
+		throw InvalidArgumentException( boost::str( boost::format( "CurvesPrimitiveEvaluator::vAtLength : Curve index %d out of range" ) % curveIndex ) );
+	}
+
+	// See comment in closestPoint().
+	const_cast<CurvesPrimitiveEvaluator *>( this )->buildArcLengths();
+	return vAtLengthInternal( curveIndex, length );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Batch queries
+//////////////////////////////////////////////////////////////////////////
+
+template<typename F>
+void CurvesPrimitiveEvaluator::parallelForQueries( const std::vector<int> &curveIndices, const std::vector<float> &v, const Canceller *canceller, F &&f ) const
+{
+	if( curveIndices.size() != v.size() )
+	{
+		throw InvalidArgumentException(
+			boost::str( boost::format( "CurvesPrimitiveEvaluator : Number of curve indices (%d) does not match number of v values (%d)" ) % curveIndices.size() % v.size() )
+		);
+	}
+
+	const bool linear = m_curvesPrimitive->basis() == CubicBasisf::linear();
+	const bool periodic = m_curvesPrimitive->periodic();
+	const size_t numCurves = m_verticesPerCurve.size();
+
+	PrimitiveVariableAlgos::parallelForBlocks(
+		curveIndices.size(), canceller,
+		[&]( size_t begin, size_t end )
 		{
-			unsigned numSegments = m_curvesPrimitive->numSegments( curveIndex );
-			int steps = numSegments * Line::linesPerCurveSegment();
-			V3f prevP( 0 );
-			float prevV = 0;
-			for( int i=0; i<steps; i++ )
+			Result result( m_p, linear, periodic );
+			for( size_t i = begin; i != end; ++i )
 			{
-				float v = Imath::clamp( (float)i/(float)(steps-1), 0.0f, 1.0f );
-				pointAtV( curveIndex, v, result.get() );
-				V3f newP = result->point();
-				if( i!=0 )
+				const int curveIndex = curveIndices[i];
+				if( curveIndex < 0 || (size_t)curveIndex >= numCurves )
 				{
-					Box3f b;
-					b.extendBy( prevP );
-					b.extendBy( newP );
-					m_treeBounds.push_back( b );
-					m_treeLines.push_back( Line( prevP, newP, curveIndex, prevV, v ) );
+					throw InvalidArgumentException( boost::str( boost::format( "CurvesPrimitiveEvaluator : Curve index %d out of range" ) % curveIndex ) );
 				}
+				if( !( v[i] >= 0.0f && v[i] <= 1.0f ) )
+				{
+					throw InvalidArgumentException( boost::str( boost::format( "CurvesPrimitiveEvaluator : V value %f out of range" ) % v[i] ) );
+				}
+				(result.*result.m_init)( curveIndex, v[i], this );
+				f( i, result );
+			}
+		}
+	);
+}
+
+void CurvesPrimitiveEvaluator::pointsAtV( const std::vector<int> &curveIndices, const std::vector<float> &v, std::vector<Imath::V3f> &positions, std::vector<Imath::V3f> *tangents, const Canceller *canceller ) const
+{
+	positions.resize( curveIndices.size() );
+	if( tangents )
+	{
+		tangents->resize( curveIndices.size() );
+		parallelForQueries(
+			curveIndices, v, canceller,
+			[&]( size_t i, const Result &result )
+			{
+				positions[i] = result.primVar<V3f>( m_p, result.m_coefficients );
+				(*tangents)[i] = result.primVar<V3f>( m_p, result.m_derivativeCoefficients );
+			}
+		);
+	}
+	else
+	{
+		parallelForQueries(
+			curveIndices, v, canceller,
+			[&]( size_t i, const Result &result )
+			{
+				positions[i] = result.primVar<V3f>( m_p, result.m_coefficients );
+			}
+		);
+	}
+}
+
+IECore::DataPtr CurvesPrimitiveEvaluator::primVarAtV( const PrimitiveVariable &primVar, const std::vector<int> &curveIndices, const std::vector<float> &v, const Canceller *canceller ) const
+{
+	if( !m_curvesPrimitive->isPrimitiveVariableValid( primVar ) )
+	{
+		throw InvalidArgumentException( "CurvesPrimitiveEvaluator::primVarAtV : Invalid primitive variable" );
+	}
+
+	// Result doesn't support indexed primitive variables, so we expand them first.
+	const PrimitiveVariable expandedPrimVar = primVar.indices ? PrimitiveVariable( primVar.interpolation, primVar.expandedData() ) : primVar;
+
+	auto evaluate = [&]( auto *typeTag ) -> DataPtr {
+		using DataType = typename std::remove_pointer<decltype( typeTag )>::type;
+		using ValueType = typename DataType::ValueType::value_type;
+		typename DataType::Ptr resultData = new DataType;
+		auto &values = resultData->writable();
+		values.resize( curveIndices.size() );
+		parallelForQueries(
+			curveIndices, v, canceller,
+			[&]( size_t i, const Result &result )
+			{
+				values[i] = result.primVar<ValueType>( expandedPrimVar, result.m_coefficients );
+			}
+		);
+		setGeometricInterpretation( resultData.get(), getGeometricInterpretation( primVar.data.get() ) );
+		return resultData;
+	};
+
+	switch( primVar.data->typeId() )
+	{
+		case FloatDataTypeId :
+		case FloatVectorDataTypeId :
+			return evaluate( (FloatVectorData *)nullptr );
+		case IntDataTypeId :
+		case IntVectorDataTypeId :
+			return evaluate( (IntVectorData *)nullptr );
+		case HalfDataTypeId :
+		case HalfVectorDataTypeId :
+			return evaluate( (HalfVectorData *)nullptr );
+		case V2fDataTypeId :
+		case V2fVectorDataTypeId :
+			return evaluate( (V2fVectorData *)nullptr );
+		case V3fDataTypeId :
+		case V3fVectorDataTypeId :
+			return evaluate( (V3fVectorData *)nullptr );
+		case Color3fDataTypeId :
+		case Color3fVectorDataTypeId :
+			return evaluate( (Color3fVectorData *)nullptr );
+		default :
+			throw InvalidArgumentException(
+				boost::str( boost::format( "CurvesPrimitiveEvaluator::primVarAtV : Unsupported data type \"%s\"" ) % primVar.data->typeName() )
+			);
+	}
+}
+
+bool CurvesPrimitiveEvaluator::closestPoints( const std::vector<Imath::V3f> &points, std::vector<int> &curveIndices, std::vector<float> &v, const Canceller *canceller ) const
+{
+	if( !m_verticesPerCurve.size() )
+	{
+		curveIndices.clear();
+		v.clear();
+		return false;
+	}
 
-				prevP = newP;
-				prevV = v;
+	// See comment in closestPoint().
+	const_cast<CurvesPrimitiveEvaluator *>( this )->buildTree();
+
+	curveIndices.resize( points.size() );
+	v.resize( points.size() );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		points.size(), canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
+			{
+				unsigned curveIndex = 0;
+				float closestV = -1;
+				float distSquared = std::numeric_limits<float>::max();
+				closestPointWalk( m_tree.rootIndex(), points[i], curveIndex, closestV, distSquared );
+				curveIndices[i] = curveIndex;
+				v[i] = closestV;
 			}
 		}
+	);
+
+	return true;
+}
+
+void CurvesPrimitiveEvaluator::vAtLengths( const std::vector<int> &curveIndices, const std::vector<float> &lengths, std::vector<float> &v, const Canceller *canceller ) const
+{
+	if( curveIndices.size() != lengths.size() )
+	{
+		throw InvalidArgumentException(
+			boost::str( boost::format( "CurvesPrimitiveEvaluator::vAtLengths : Number of curve indices (%d) does not match number of lengths (%d)" ) % curveIndices.size() % lengths.size() )
+		);
 	}
 
-	m_tree.init( m_treeBounds.begin(), m_treeBounds.end() );
-	m_haveTree = true;
+	const_cast<CurvesPrimitiveEvaluator *>( this )->buildArcLengths();
+
+	const size_t numCurves = m_verticesPerCurve.size();
+	v.resize( curveIndices.size() );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		curveIndices.size(), canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
+			{
+				const int curveIndex = curveIndices[i];
+				if( curveIndex < 0 || (size_t)curveIndex >= numCurves )
+				{
+					throw InvalidArgumentException( boost::str( boost::format( "CurvesPrimitiveEvaluator::vAtLengths : Curve index %d out of range" ) % curveIndex ) );
+				}
+				v[i] = vAtLengthInternal( curveIndex, lengths[i] );
+			}
+		}
+	);
+}
+
+void CurvesPrimitiveEvaluator::uniformLengthSamples( unsigned samplesPerCurve, std::vector<int> &curveIndices, std::vector<float> &v, const Canceller *canceller ) const
+{
+	const_cast<CurvesPrimitiveEvaluator *>( this )->buildArcLengths();
+
+	const size_t numCurves = m_verticesPerCurve.size();
+	curveIndices.resize( numCurves * samplesPerCurve );
+	v.resize( numCurves * samplesPerCurve );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		numCurves, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t curveIndex = begin; curveIndex != end; ++curveIndex )
+			{
+				const float length = m_arcLengths[m_arcLengthOffsets[curveIndex+1]-1];
+				const size_t offset = curveIndex * samplesPerCurve;
+				for( unsigned i = 0; i < samplesPerCurve; ++i )
+				{
+					curveIndices[offset+i] = curveIndex;
+					if( i == 0 )
+					{
+						v[offset+i] = 0.0f;
+					}
+					else if( i == samplesPerCurve - 1 )
+					{
+						v[offset+i] = 1.0f;
+					}
+					else
+					{
+						v[offset+i] = vAtLengthInternal( curveIndex, length * (float)i / (float)( samplesPerCurve - 1 ) );
+					}
+				}
+			}
+		}
+	);
 }
 
 const std::vector<int> &CurvesPrimitiveEvaluator::verticesPerCurve() const
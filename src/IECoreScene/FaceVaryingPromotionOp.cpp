@@ -34,11 +34,9 @@
 
 #include "IECoreScene/FaceVaryingPromotionOp.h"
 
-#include "IECoreScene/PolygonVertexIterator.h"
-#include "IECoreScene/private/PrimitiveVariableAlgos.h"
+#include "IECoreScene/MeshAlgo.h"
 
 #include "IECore/CompoundParameter.h"
-#include "IECore/DespatchTypedData.h"
 
 #include "boost/format.hpp"
 #include "boost/regex.hpp"
@@ -129,70 +127,6 @@ const BoolParameter *FaceVaryingPromotionOp::promoteVertexParameter() const
 	return parameters()->parameter<BoolParameter>( "promoteVertex" );
 }
 
-struct FaceVaryingPromotionOp::Promoter
-{
-	typedef DataPtr ReturnType;
-
-	Promoter( const std::vector<int> &vertsPerFace,  const std::vector<int> &vertIds )
-		:	m_interpolation( PrimitiveVariable::Invalid ), m_vertsPerFace( vertsPerFace ), m_vertIds( vertIds )
-	{
-	}
-
-	void setInterpolation( PrimitiveVariable::Interpolation interpolation )
-	{
-		m_interpolation = interpolation;
-	}
-
-	template<typename T>
-	ReturnType operator()( T *data )
-	{
-		typedef typename T::ValueType Container;
-		typedef typename Container::const_iterator ConstIterator;
-
-		typename T::Ptr result = new T;
-		result->writable().reserve( m_vertIds.size() );
-		std::back_insert_iterator<Container> inserter( result->writable() );
-		switch( m_interpolation )
-		{
-			case PrimitiveVariable::Uniform :
-			{
-				ConstIterator dataIt = data->readable().begin();
-				for( std::vector<int>::const_iterator it=m_vertsPerFace.begin(); it!=m_vertsPerFace.end(); ++it, ++dataIt )
-				{
-					std::fill_n( inserter, *it, *dataIt );
-				}
-				break;
-			}
-			case PrimitiveVariable::Vertex :
-			case PrimitiveVariable::Varying :
-			{
-				std::copy(
-					PolygonVertexIterator<ConstIterator>( m_vertIds.begin(), data->readable().begin() ),
-					PolygonVertexIterator<ConstIterator>( m_vertIds.end(), data->readable().begin() ),
-					inserter
-				);
-				break;
-			}
-			default :
-				assert( 0 ); // shouldn't get here
-		}
-
-		assert( result->readable().size() == m_vertIds.size() );
-
-		IECoreScene::PrimitiveVariableAlgos::GeometricInterpretationCopier<T> copier;
-		copier( data, result.get() );
-
-		return result;
-	}
-
-	private :
-
-		PrimitiveVariable::Interpolation m_interpolation;
-		const std::vector<int> &m_vertsPerFace;
-		const std::vector<int> &m_vertIds;
-
-};
-
 void FaceVaryingPromotionOp::modifyTypedPrimitive( MeshPrimitive *mesh, const CompoundObject *operands )
 {
 	const std::vector<std::string> &names = operands->member<StringVectorData>( "primVarNames" )->readable();
@@ -206,7 +140,7 @@ void FaceVaryingPromotionOp::modifyTypedPrimitive( MeshPrimitive *mesh, const Co
 	bool promoteVarying = operands->member<BoolData>( "promoteVarying" )->readable();
 	bool promoteVertex = operands->member<BoolData>( "promoteVertex" )->readable();
 
-	Promoter promoter( mesh->verticesPerFace()->readable(), mesh->vertexIds()->readable() );
+	std::vector<PrimitiveVariableMap::iterator> toPromote;
 	for( PrimitiveVariableMap::iterator it=mesh->variables.begin(); it!=mesh->variables.end(); ++it )
 	{
 		switch( it->second.interpolation )
@@ -258,19 +192,25 @@ void FaceVaryingPromotionOp::modifyTypedPrimitive( MeshPrimitive *mesh, const Co
 			throw Exception( boost::str( boost::format( "Primitive variable \"%s\" is not valid." ) % it->first ) );
 		}
 
-		promoter.setInterpolation( it->second.interpolation );
+		toPromote.push_back( it );
+	}
 
-		if( it->second.indices )
-		{
-			it->second.indices = runTimeCast<IntVectorData>( despatchTypedData<Promoter, TypeTraits::IsVectorTypedData>( it->second.indices.get(), promoter ) );
-		}
-		else
-		{
-			it->second.data = despatchTypedData<Promoter, TypeTraits::IsVectorTypedData>( it->second.data.get(), promoter );
-		}
+	// Promote all the variables in parallel, sharing the mapping
+	// tables computed from the mesh topology.
 
-		it->second.interpolation = PrimitiveVariable::FaceVarying;
+	std::vector<PrimitiveVariable> variables;
+	variables.reserve( toPromote.size() );
+	for( const auto &it : toPromote )
+	{
+		variables.push_back( it->second );
+	}
 
-		assert( mesh->isPrimitiveVariableValid( it->second ) );
+	MeshAlgo::PrimitiveVariableResampler resampler( mesh );
+	resampler.resample( variables, PrimitiveVariable::FaceVarying );
+
+	for( size_t i = 0; i < toPromote.size(); ++i )
+	{
+		toPromote[i]->second = variables[i];
+		assert( mesh->isPrimitiveVariableValid( toPromote[i]->second ) );
 	}
 }
@@ -35,9 +35,11 @@
 #include "IECoreScene/MeshAlgo.h"
 #include "IECoreScene/private/PrimitiveVariableAlgos.h"
 
-#include "IECore/DespatchTypedData.h"
 #include "IECore/DataAlgo.h"
 
+#include "tbb/parallel_invoke.h"
+#include "tbb/task_arena.h"
+
 using namespace Imath;
 using namespace IECore;
 using namespace IECoreScene;
@@ -59,26 +61,29 @@ void deleteCorners( MeshPrimitive *out, const MeshPrimitive *in, const std::vect
 
 	const auto &sharpnesses = in->cornerSharpnesses()->readable();
 
+	const std::vector<int> keptCorners = PrimitiveVariableAlgos::keptElements(
+		ids.size(), [&]( size_t i ) { return remapping[ ids[i] ] != -1; }, canceller
+	);
+
 	IntVectorDataPtr outIdData = new IntVectorData;
 	auto &outIds = outIdData->writable();
+	outIds.resize( keptCorners.size() );
 
 	FloatVectorDataPtr outSharpnessData = new FloatVectorData;
 	auto &outSharpnesses = outSharpnessData->writable();
+	outSharpnesses.resize( keptCorners.size() );
 
-	for( size_t i = 0; i < ids.size(); ++i )
-	{
-		if( i % 1000 == 0 )
+	PrimitiveVariableAlgos::parallelForBlocks(
+		keptCorners.size(), canceller,
+		[&]( size_t begin, size_t end )
 		{
-			Canceller::check( canceller );
-		}
-
-		int id = remapping[ ids[i] ];
-		if( id != -1 )
-		{
-			outIds.push_back( id );
-			outSharpnesses.push_back( sharpnesses[i] );
+			for( size_t i = begin; i != end; ++i )
+			{
+				outIds[i] = remapping[ ids[ keptCorners[i] ] ];
+				outSharpnesses[i] = sharpnesses[ keptCorners[i] ];
+			}
 		}
-	}
+	);
 
 	out->setCorners( outIdData.get(), outSharpnessData.get() );
 };
@@ -151,89 +156,106 @@ void deleteCreases( MeshPrimitive *out, const MeshPrimitive *in, const std::vect
 template<typename T>
 MeshPrimitivePtr deleteFaces( const MeshPrimitive *meshPrimitive, PrimitiveVariable::IndexedView<T> &deleteFlagView, bool invert, const Canceller *canceller )
 {
-	// construct 3 functors for deleting (uniform, vertex & face varying) primvars
-	IECoreScene::PrimitiveVariableAlgos::DeleteFlaggedUniformFunctor<T> uniformFunctor( deleteFlagView, invert );
-	IECoreScene::PrimitiveVariableAlgos::DeleteFlaggedFaceVaryingFunctor<T> faceVaryingFunctor( deleteFlagView, meshPrimitive->verticesPerFace(), invert );
-	IECoreScene::PrimitiveVariableAlgos::DeleteFlaggedVertexFunctor<T> vertexFunctor(
-		meshPrimitive->variableSize( PrimitiveVariable::Vertex ), meshPrimitive->vertexIds(), meshPrimitive->verticesPerFace(), deleteFlagView, invert );
-
-	// filter verticesPerFace using DeleteFlaggedUniformFunctor
-	const IECore::Data *inputVerticesPerFace = IECore::runTimeCast<const IECore::Data>( meshPrimitive->verticesPerFace() );
-	uniformFunctor.setIndices( nullptr );
-	IECoreScene::PrimitiveVariableAlgos::IndexedData outputVerticesPerFace = dispatch( inputVerticesPerFace, uniformFunctor );
-	IntVectorDataPtr verticesPerFace = IECore::runTimeCast<IECore::IntVectorData>( outputVerticesPerFace.data );
-
-	// filter VertexIds using DeleteFlaggedFaceVaryingFunctor
-	const IECore::Data *inputVertexIds = IECore::runTimeCast<const IECore::Data>( meshPrimitive->vertexIds() );
-	faceVaryingFunctor.setIndices( nullptr );
-	IECoreScene::PrimitiveVariableAlgos::IndexedData outputVertexIds = dispatch( inputVertexIds, faceVaryingFunctor );
-
-	// remap the indices also
-	ConstIntVectorDataPtr remappingData = vertexFunctor.getRemapping();
-	const std::vector<int> &remapping = remappingData->readable();
-	IntVectorDataPtr vertexIdsData = IECore::runTimeCast<IECore::IntVectorData>( outputVertexIds.data );
-	IntVectorData::ValueType &vertexIds = vertexIdsData->writable();
-	for( size_t i = 0; i < vertexIds.size(); ++i )
+	for( const auto &p : meshPrimitive->variables )
 	{
-		if( i % 1000 == 0 )
+		if( !meshPrimitive->isPrimitiveVariableValid( p.second ) )
 		{
-			Canceller::check( canceller );
+			throw InvalidArgumentException(
+				boost::str ( boost::format( "MeshAlgo::deleteFaces cannot process invalid primitive variable \"%s\"" ) % p.first ) );
 		}
-
-		vertexIds[i] = remapping[vertexIds[i]];
 	}
 
-	// construct mesh without positions as they'll be set when filtering the primvars
-	MeshPrimitivePtr outMeshPrimitive = new MeshPrimitive( verticesPerFace, vertexIdsData, meshPrimitive->interpolation() );
+	const std::vector<int> &inputVerticesPerFace = meshPrimitive->verticesPerFace()->readable();
+	const std::vector<int> &inputVertexIds = meshPrimitive->vertexIds()->readable();
 
-	deleteCorners( outMeshPrimitive.get(), meshPrimitive, remapping, canceller );
-	deleteCreases( outMeshPrimitive.get(), meshPrimitive, remapping, canceller );
+	// Find the elements to keep for each interpolation. These are all computed in
+	// parallel using prefix sums, so that the output positions are known up front.
 
-	for( PrimitiveVariableMap::const_iterator it = meshPrimitive->variables.begin(), e = meshPrimitive->variables.end(); it != e; ++it )
-	{
-		Canceller::check( canceller );
-		if( !meshPrimitive->isPrimitiveVariableValid( it->second ) )
-		{
-			throw InvalidArgumentException(
-				boost::str ( boost::format( "MeshAlgo::deleteFaces cannot process invalid primitive variable \"%s\"" ) % it->first ) );
-		}
+	const std::vector<int> keptFaces = PrimitiveVariableAlgos::keptElements(
+		inputVerticesPerFace.size(),
+		[&]( size_t i ) { return PrimitiveVariableAlgos::keepFlagged( deleteFlagView[i], invert ); },
+		canceller
+	);
+
+	const std::vector<int> keptFaceVertices = PrimitiveVariableAlgos::keptPrimitiveElements(
+		keptFaces, inputVerticesPerFace.size(), [&]( size_t i ) { return inputVerticesPerFace[i]; }, canceller
+	);
 
-		switch( it->second.interpolation )
+	std::vector<int> remapping;
+	const std::vector<int> keptVertices = PrimitiveVariableAlgos::keptVertices(
+		keptFaceVertices, inputVertexIds, meshPrimitive->variableSize( PrimitiveVariable::Vertex ), remapping, canceller
+	);
+
+	// Build the topology.
+
+	IntVectorDataPtr verticesPerFaceData = new IntVectorData;
+	std::vector<int> &verticesPerFace = verticesPerFaceData->writable();
+	verticesPerFace.resize( keptFaces.size() );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		keptFaces.size(), canceller,
+		[&]( size_t begin, size_t end )
 		{
-			case PrimitiveVariable::Uniform:
+			for( size_t i = begin; i != end; ++i )
 			{
-				const IECore::Data *inputData = it->second.data.get();
-				uniformFunctor.setIndices( it->second.indices.get() );
-				IECoreScene::PrimitiveVariableAlgos::IndexedData outputData = dispatch( inputData, uniformFunctor );
-				outMeshPrimitive->variables[it->first] = PrimitiveVariable( it->second.interpolation, outputData.data, outputData.indices );
-				break;
+				verticesPerFace[i] = inputVerticesPerFace[ keptFaces[i] ];
 			}
-			case PrimitiveVariable::Vertex:
-			case PrimitiveVariable::Varying:
+		}
+	);
+
+	IntVectorDataPtr vertexIdsData = new IntVectorData;
+	std::vector<int> &vertexIds = vertexIdsData->writable();
+	vertexIds.resize( keptFaceVertices.size() );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		keptFaceVertices.size(), canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
 			{
-				const IECore::Data *inputData = it->second.data.get();
-				vertexFunctor.setIndices( it->second.indices.get() );
-				IECoreScene::PrimitiveVariableAlgos::IndexedData outputData = dispatch( inputData, vertexFunctor );
-				outMeshPrimitive->variables[it->first] = PrimitiveVariable( it->second.interpolation, outputData.data, outputData.indices );
-				break;
+				vertexIds[i] = remapping[ inputVertexIds[ keptFaceVertices[i] ] ];
 			}
+		}
+	);
 
-			case PrimitiveVariable::FaceVarying:
-			{
-				const IECore::Data *inputData = it->second.data.get();
-				faceVaryingFunctor.setIndices( it->second.indices.get() );
-				IECoreScene::PrimitiveVariableAlgos::IndexedData outputData = dispatch(inputData, faceVaryingFunctor );
-				outMeshPrimitive->variables[it->first] = PrimitiveVariable( it->second.interpolation, outputData.data, outputData.indices );
-				break;
-			}
-			case PrimitiveVariable::Constant:
-			case PrimitiveVariable::Invalid:
-			{
-				outMeshPrimitive->variables[it->first] = it->second;
-				break;
-			}
+	// construct mesh without positions as they'll be set when filtering the primvars
+	MeshPrimitivePtr outMeshPrimitive = new MeshPrimitive( verticesPerFaceData, vertexIdsData, meshPrimitive->interpolation() );
+
+	// Compact the primitive variables concurrently with the corners and creases.
+
+	PrimitiveVariableMap variables;
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			tbb::parallel_invoke(
+				[&] {
+					deleteCorners( outMeshPrimitive.get(), meshPrimitive, remapping, canceller );
+					deleteCreases( outMeshPrimitive.get(), meshPrimitive, remapping, canceller );
+				},
+				[&] {
+					PrimitiveVariableAlgos::compactPrimitiveVariables(
+						meshPrimitive->variables, variables,
+						[&]( PrimitiveVariable::Interpolation interpolation ) -> const std::vector<int> * {
+							switch( interpolation )
+							{
+								case PrimitiveVariable::Uniform :
+									return &keptFaces;
+								case PrimitiveVariable::Vertex :
+								case PrimitiveVariable::Varying :
+									return &keptVertices;
+								case PrimitiveVariable::FaceVarying :
+									return &keptFaceVertices;
+								default :
+									return nullptr;
+							}
+						},
+						canceller
+					);
+				},
+				taskGroupContext
+			);
 		}
-	}
+	);
+
+	outMeshPrimitive->variables = variables;
 	return outMeshPrimitive;
 }
 
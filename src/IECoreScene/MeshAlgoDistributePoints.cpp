@@ -33,7 +33,6 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "IECoreScene/MeshAlgo.h"
-#include "IECoreScene/MeshPrimitiveEvaluator.h"
 #include "IECoreScene/PrimitiveVariable.h"
 
 #include "IECore/PointDistribution.h"
@@ -41,7 +40,11 @@
 #include "IECore/TriangleAlgo.h"
 
 #include "tbb/blocked_range.h"
-#include "tbb/parallel_reduce.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_invoke.h"
+#include "tbb/task_arena.h"
+
+#include <algorithm>
 
 using namespace Imath;
 using namespace IECore;
@@ -89,178 +92,414 @@ MeshPrimitivePtr processMesh( const MeshPrimitive *mesh, const std::string &dens
 	return result;
 }
 
-struct Emitter
+// Evaluates the density mask in the same way as `MeshPrimitiveEvaluator::Result::floatPrimVar()`,
+// but without the overhead of an evaluator and result per triangle.
+class DensitySampler
 {
+
 	public :
 
-		Emitter( MeshPrimitiveEvaluator *evaluator, const PrimitiveVariable &densityVar, std::vector<Imath::V3f> &positions, size_t triangleIndex, const Imath::V2f &v0, const Imath::V2f &v1, const Imath::V2f &v2, const Canceller *canceller )
-			: m_meshEvaluator( evaluator ), m_densityVar( densityVar ), m_p( positions ), m_triangleIndex( triangleIndex ), m_v0( v0 ), m_v1( v1 ), m_v2( v2 ), m_canceller( canceller ), m_cancelCounter( 0 )
+		DensitySampler( const PrimitiveVariable &densityVar )
+			:	m_interpolation( densityVar.interpolation ), m_constant( nullptr )
 		{
-
-			m_evaluatorResult = boost::static_pointer_cast<MeshPrimitiveEvaluator::Result>( m_meshEvaluator->createResult() );
+			if( m_interpolation == PrimitiveVariable::Constant )
+			{
+				if( const FloatData *data = runTimeCast<const FloatData>( densityVar.data.get() ) )
+				{
+					m_constant = &data->readable();
+					return;
+				}
+			}
+			m_view = PrimitiveVariable::IndexedView<float>( densityVar );
 		}
 
-		void operator() ( const Imath::V2f pos, float densityThreshold )
+		float operator()( size_t triangleIndex, const V3i &vertexIds, const V3f &bary ) const
 		{
-			Imath::V3f bary;
-			m_cancelCounter++;
-			if( m_canceller && ( m_cancelCounter % 1000 ) == 0 )
+			if( m_constant )
 			{
-				Canceller::check( m_canceller );
+				return *m_constant;
 			}
-			if( triangleContainsPoint( m_v0, m_v1, m_v2, pos, bary ) )
+
+			switch( m_interpolation )
 			{
-				m_meshEvaluator->barycentricPosition( m_triangleIndex, bary, m_evaluatorResult.get() );
-				if ( m_evaluatorResult->floatPrimVar( m_densityVar ) >= densityThreshold )
-				{
-					m_p.push_back( m_evaluatorResult->point() );
-				}
+				case PrimitiveVariable::Constant :
+					return m_view[0];
+				case PrimitiveVariable::Uniform :
+					return m_view[triangleIndex];
+				case PrimitiveVariable::Vertex :
+				case PrimitiveVariable::Varying :
+					return m_view[vertexIds[0]] * bary[0] + m_view[vertexIds[1]] * bary[1] + m_view[vertexIds[2]] * bary[2];
+				case PrimitiveVariable::FaceVarying :
+					return
+						m_view[triangleIndex * 3] * bary[0] +
+						m_view[triangleIndex * 3 + 1] * bary[1] +
+						m_view[triangleIndex * 3 + 2] * bary[2]
+					;
+				default :
+					return 0.0f;
 			}
 		}
 
 	private :
 
-		MeshPrimitiveEvaluator *m_meshEvaluator;
-		const PrimitiveVariable &m_densityVar;
-		std::vector<Imath::V3f> &m_p;
-		size_t m_triangleIndex;
-		Imath::V2f m_v0;
-		Imath::V2f m_v1;
-		Imath::V2f m_v2;
-		const Canceller *m_canceller;
-		int m_cancelCounter;
-
-		MeshPrimitiveEvaluator::ResultPtr m_evaluatorResult;
+		PrimitiveVariable::Interpolation m_interpolation;
+		const float *m_constant;
+		PrimitiveVariable::IndexedView<float> m_view;
 
 };
 
-struct Generator
+// Faces are divided into ranges containing roughly this many points, so that
+// the work is balanced between tasks regardless of the size of each face.
+const double g_pointsPerRange = 10000;
+// But we also limit the number of faces per range, to balance the work of
+// visiting faces which generate few or no points.
+const size_t g_maxFacesPerRange = 10000;
+
+} // namespace
+
+struct MeshAlgo::PointDistributor::Tables
 {
-	public :
 
-		Generator( MeshPrimitiveEvaluator *evaluator, const PrimitiveVariable::IndexedView<Imath::V2f> &uvs, bool faceVaryingUVs, const std::vector<float> &faceArea, const std::vector<float> &textureArea, float density, const PrimitiveVariable &densityVar, Imath::V2f offset, const Canceller *canceller )
-			: m_meshEvaluator( evaluator ), m_uvs( uvs ), m_faceVaryingUVs( faceVaryingUVs ), m_faceArea( faceArea ), m_textureArea( textureArea ), m_density( density ), m_densityVar( densityVar ), m_offset( offset ), m_canceller( canceller ), m_positions()
+	Tables( const MeshPrimitive *mesh, const std::string &densityMask, const std::string &uvSet, const std::string &position, const Canceller *canceller )
+		:	mesh( processMesh( mesh, densityMask, uvSet, position, canceller ) ),
+			densityVar( this->mesh->variables.find( densityMask )->second ),
+			densitySampler( densityVar )
+	{
+		uvs = this->mesh->variableIndexedView<V2fVectorData>( uvSet, PrimitiveVariable::FaceVarying, /* throwOnInvalid */ false );
+		faceVaryingUVs = uvs.has_value();
+		if( !uvs )
+		{
+			uvs = this->mesh->variableIndexedView<V2fVectorData>( uvSet, PrimitiveVariable::Vertex, /* throwOnInvalid */ false );
+		}
+
+		if( !uvs )
+		{
+			std::string e = boost::str( boost::format( "MeshAlgo::distributePoints : MeshPrimitive has no uv primitive variable named \"%s\" of type FaceVarying or Vertex." ) % uvSet );
+			throw InvalidArgumentException( e );
+		}
+
+		const V3fVectorData *pData = this->mesh->variableData<V3fVectorData>( "P", PrimitiveVariable::Vertex );
+		if( !pData )
 		{
+			throw InvalidArgumentException( "MeshAlgo::distributePoints : MeshPrimitive has no Vertex \"P\" primitive variable." );
 		}
 
-		Generator( Generator &that, tbb::split )
-			: m_meshEvaluator( that.m_meshEvaluator ), m_uvs( that.m_uvs ), m_faceVaryingUVs( that.m_faceVaryingUVs ), m_faceArea( that.m_faceArea ), m_textureArea( that.m_textureArea ), m_density( that.m_density ), m_densityVar( that.m_densityVar ), m_offset( that.m_offset ), m_canceller( that.m_canceller ), m_positions()
+		p = &pData->readable();
+		vertexIds = &this->mesh->vertexIds()->readable();
+		faceArea = &this->mesh->variableData<FloatVectorData>( "faceArea", PrimitiveVariable::Uniform )->readable();
+		textureArea = &this->mesh->variableData<FloatVectorData>( "textureArea", PrimitiveVariable::Uniform )->readable();
+
+		faceAreaCDF.resize( faceArea->size() + 1 );
+		faceAreaCDF[0] = 0;
+		for( size_t i = 0, e = faceArea->size(); i < e; ++i )
+		{
+			if( i % 100000 == 0 )
+			{
+				Canceller::check( canceller );
+			}
+			faceAreaCDF[i+1] = faceAreaCDF[i] + std::max( (*faceArea)[i], 0.0f );
+		}
+	}
+
+	size_t numFaces() const
+	{
+		return faceArea->size();
+	}
+
+	// Divides the faces into ranges, returning the boundaries between them. Uses the
+	// cumulative face area to find the ranges quickly, without visiting every face.
+	std::vector<size_t> faceRanges( float density ) const
+	{
+		const double areaPerRange = density > 0 ? g_pointsPerRange / density : std::numeric_limits<double>::infinity();
+
+		std::vector<size_t> result = { 0 };
+		const size_t n = numFaces();
+		while( result.back() < n )
 		{
+			const size_t begin = result.back();
+			const size_t end = std::lower_bound( faceAreaCDF.begin() + begin + 1, faceAreaCDF.end(), faceAreaCDF[begin] + areaPerRange ) - faceAreaCDF.begin();
+			result.push_back( std::min( { end, n, begin + g_maxFacesPerRange } ) );
 		}
 
-		void operator()( const tbb::blocked_range<size_t> &r )
+		return result;
+	}
+
+	void distribute( size_t begin, size_t end, float density, const V2f &offset, float maxPointsPerFace, const std::vector<V3f> &positions, std::vector<V3f> &result, const Canceller *canceller ) const
+	{
+		Canceller::check( canceller );
+
+		int cancelCounter = 0;
+		for( size_t i = begin; i != end; ++i )
 		{
-			Canceller::check( m_canceller );
-			for ( size_t i=r.begin(); i!=r.end(); ++i )
+			const float textureDensity = std::min(
+				density * (*faceArea)[i] / (*textureArea)[i],
+				maxPointsPerFace / (*textureArea)[i]
+			);
+
+			const size_t v0I = i * 3;
+			const size_t v1I = v0I + 1;
+			const size_t v2I = v1I + 1;
+
+			const V3i triangleVertexIds( (*vertexIds)[v0I], (*vertexIds)[v1I], (*vertexIds)[v2I] );
+
+			V2f uv0, uv1, uv2;
+			if( faceVaryingUVs )
 			{
-				float textureDensity = m_density * m_faceArea[i] / m_textureArea[i];
+				uv0 = (*uvs)[v0I];
+				uv1 = (*uvs)[v1I];
+				uv2 = (*uvs)[v2I];
+			}
+			else
+			{
+				uv0 = (*uvs)[triangleVertexIds[0]];
+				uv1 = (*uvs)[triangleVertexIds[1]];
+				uv2 = (*uvs)[triangleVertexIds[2]];
+			}
 
-				size_t v0I = i * 3;
-				size_t v1I = v0I + 1;
-				size_t v2I = v1I + 1;
+			uv0 += offset;
+			uv1 += offset;
+			uv2 += offset;
 
-				Imath::V2f uv0, uv1, uv2;
+			Box2f uvBounds;
+			uvBounds.extendBy( uv0 );
+			uvBounds.extendBy( uv1 );
+			uvBounds.extendBy( uv2 );
 
-				if( m_faceVaryingUVs )
+			const V3f &p0 = positions[triangleVertexIds[0]];
+			const V3f &p1 = positions[triangleVertexIds[1]];
+			const V3f &p2 = positions[triangleVertexIds[2]];
+
+			auto emitter = [&] ( const V2f &pos, float densityThreshold ) {
+				if( canceller && ( ++cancelCounter % 1000 ) == 0 )
 				{
-					uv0 = m_uvs[v0I];
-					uv1 = m_uvs[v1I];
-					uv2 = m_uvs[v2I];
+					Canceller::check( canceller );
 				}
-				else
+
+				V3f bary;
+				if( triangleContainsPoint( uv0, uv1, uv2, pos, bary ) )
 				{
-					const std::vector<int> &ids = m_meshEvaluator->mesh()->vertexIds()->readable();
-					uv0 = m_uvs[ids[v0I]];
-					uv1 = m_uvs[ids[v1I]];
-					uv2 = m_uvs[ids[v2I]];
+					if( densitySampler( i, triangleVertexIds, bary ) >= densityThreshold )
+					{
+						result.push_back( trianglePoint( p0, p1, p2, bary ) );
+					}
 				}
+			};
 
-				uv0 += m_offset;
-				uv1 += m_offset;
-				uv2 += m_offset;
-
-				Imath::Box2f uvBounds;
-				uvBounds.extendBy( uv0 );
-				uvBounds.extendBy( uv1 );
-				uvBounds.extendBy( uv2 );
-
-				Emitter emitter( m_meshEvaluator, m_densityVar, m_positions, i, uv0, uv1, uv2, m_canceller );
-				PointDistribution::defaultInstance()( uvBounds, textureDensity, emitter );
-			}
+			PointDistribution::defaultInstance()( uvBounds, textureDensity, emitter );
 		}
+	}
 
-		void join( Generator &that )
-		{
-			size_t numThisPoints = this->m_positions.size();
-			Canceller::check( m_canceller );
-			this->m_positions.resize( numThisPoints + that.m_positions.size() );
-			Canceller::check( m_canceller );
-			std::copy( that.m_positions.begin(), that.m_positions.end(), this->m_positions.begin() + numThisPoints );
-		}
+	// Triangulated mesh, with additional "faceArea" and "textureArea" primitive variables.
+	ConstMeshPrimitivePtr mesh;
 
-		std::vector<Imath::V3f> &positions()
-		{
-			return m_positions;
-		}
+	std::optional<PrimitiveVariable::IndexedView<V2f>> uvs;
+	bool faceVaryingUVs;
 
-	private :
+	const PrimitiveVariable densityVar;
+	const DensitySampler densitySampler;
 
-		MeshPrimitiveEvaluator *m_meshEvaluator;
-		const PrimitiveVariable::IndexedView<Imath::V2f> &m_uvs;
-		bool m_faceVaryingUVs;
-		const std::vector<float> &m_faceArea;
-		const std::vector<float> &m_textureArea;
-		float m_density;
-		const PrimitiveVariable &m_densityVar;
-		Imath::V2f m_offset;
-		const Canceller *m_canceller;
+	const std::vector<V3f> *p;
+	const std::vector<int> *vertexIds;
+	const std::vector<float> *faceArea;
+	const std::vector<float> *textureArea;
 
-		std::vector<Imath::V3f> m_positions;
+	// `faceAreaCDF[i]` is the total area of faces `[0, i)`.
+	std::vector<double> faceAreaCDF;
 
 };
 
-} // namespace
+namespace
+{
 
-PointsPrimitivePtr MeshAlgo::distributePoints( const MeshPrimitive *mesh, float density, const Imath::V2f &offset, const std::string &densityMask, const std::string &uvSet, const std::string &position, const Canceller *canceller )
+void validateArguments( float density, float maxPointsPerFace, const std::vector<V3f> *positions, const std::vector<V3f> &meshPositions )
 {
 	if( density < 0 )
 	{
-		throw InvalidArgumentException( "MeshAlgo::distributePoints : The density of the distribution cannot be negative." );
+		throw InvalidArgumentException( "MeshAlgo::PointDistributor : The density of the distribution cannot be negative." );
 	}
 
-	MeshPrimitivePtr updatedMesh = processMesh( mesh, densityMask, uvSet, position, canceller );
-	MeshPrimitiveEvaluatorPtr meshEvaluator = new MeshPrimitiveEvaluator( updatedMesh );
-
-	bool faceVaryingUVs = true;
-	std::optional<PrimitiveVariable::IndexedView<V2f>> uvView = updatedMesh->variableIndexedView<V2fVectorData>( uvSet, PrimitiveVariable::FaceVarying, /* throwOnInvalid */ false );
-	if( !uvView )
+	if( maxPointsPerFace < 0 )
 	{
-		faceVaryingUVs = false;
-		uvView = updatedMesh->variableIndexedView<V2fVectorData>( uvSet, PrimitiveVariable::Vertex, /* throwOnInvalid */ false );
+		throw InvalidArgumentException( "MeshAlgo::PointDistributor : The maximum number of points per face cannot be negative." );
 	}
 
-	if( !uvView )
+	if( positions && positions->size() != meshPositions.size() )
 	{
-		std::string e = boost::str( boost::format( "MeshAlgo::distributePoints : MeshPrimitive has no uv primitive variable named \"%s\" of type FaceVarying or Vertex." ) % uvSet );
-		throw InvalidArgumentException( e );
+		throw InvalidArgumentException(
+			boost::str(
+				boost::format( "MeshAlgo::PointDistributor : Expected %1% positions but got %2%." ) % meshPositions.size() % positions->size()
+			)
+		);
 	}
+}
+
+} // namespace
+
+MeshAlgo::PointDistributor::PointDistributor( const MeshPrimitive *mesh, const std::string &densityMask, const std::string &uvSet, const std::string &position, const Canceller *canceller )
+	:	m_tables( new Tables( mesh, densityMask, uvSet, position, canceller ) )
+{
+}
+
+MeshAlgo::PointDistributor::~PointDistributor()
+{
+}
+
+PointsPrimitivePtr MeshAlgo::PointDistributor::distribute( float density, const V2f &offset, float maxPointsPerFace, const std::vector<V3f> *positions, const Canceller *canceller ) const
+{
+	validateArguments( density, maxPointsPerFace, positions, *m_tables->p );
+	const std::vector<V3f> &p = positions ? *positions : *m_tables->p;
 
-	const std::vector<float> &faceArea = updatedMesh->variableData<FloatVectorData>( "faceArea", PrimitiveVariable::Uniform )->readable();
-	const std::vector<float> &textureArea = updatedMesh->variableData<FloatVectorData>( "textureArea", PrimitiveVariable::Uniform )->readable();
-	const PrimitiveVariable &densityVar = updatedMesh->variables.find( densityMask )->second;
+	// Generate the points for each range in parallel.
 
-	size_t numFaces = updatedMesh->verticesPerFace()->readable().size();
-	Generator gen( meshEvaluator.get(), *uvView, faceVaryingUVs, faceArea, textureArea, density, densityVar, offset, canceller );
+	const std::vector<size_t> ranges = m_tables->faceRanges( density );
+	const size_t numRanges = ranges.size() - 1;
+	std::vector<std::vector<V3f>> rangePoints( numRanges );
 
 	tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
-	tbb::auto_partitioner partitioner;
-	tbb::parallel_reduce( tbb::blocked_range<size_t>( 0, numFaces ), gen, partitioner, taskGroupContext );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, numRanges, 1 ),
+		[&]( const tbb::blocked_range<size_t> &r )
+		{
+			for( size_t i = r.begin(); i != r.end(); ++i )
+			{
+				m_tables->distribute( ranges[i], ranges[i+1], density, offset, maxPointsPerFace, p, rangePoints[i], canceller );
+			}
+		},
+		taskGroupContext
+	);
 
+	// Concatenate them in order, so that the result is independent of the
+	// way the work was scheduled.
+
+	std::vector<size_t> offsets( numRanges, 0 );
+	size_t numPoints = 0;
+	for( size_t i = 0; i < numRanges; ++i )
+	{
+		offsets[i] = numPoints;
+		numPoints += rangePoints[i].size();
+	}
 
 	Canceller::check( canceller );
 	V3fVectorDataPtr pData = new V3fVectorData();
-	pData->writable().swap( gen.positions() );
+	std::vector<V3f> &points = pData->writable();
+	points.resize( numPoints );
+
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, numRanges, 1 ),
+		[&]( const tbb::blocked_range<size_t> &r )
+		{
+			for( size_t i = r.begin(); i != r.end(); ++i )
+			{
+				std::copy( rangePoints[i].begin(), rangePoints[i].end(), points.begin() + offsets[i] );
+				std::vector<V3f>().swap( rangePoints[i] );
+			}
+		},
+		taskGroupContext
+	);
 
 	Canceller::check( canceller );
 	return new PointsPrimitive( pData );
 }
+
+void MeshAlgo::PointDistributor::distribute( const ChunkFunction &chunkFunction, size_t chunkSize, float density, const V2f &offset, float maxPointsPerFace, const std::vector<V3f> *positions, const Canceller *canceller ) const
+{
+	if( !chunkSize )
+	{
+		throw InvalidArgumentException( "MeshAlgo::PointDistributor : The chunk size must be greater than zero." );
+	}
+
+	validateArguments( density, maxPointsPerFace, positions, *m_tables->p );
+	const std::vector<V3f> &p = positions ? *positions : *m_tables->p;
+
+	const std::vector<size_t> ranges = m_tables->faceRanges( density );
+	const size_t numRanges = ranges.size() - 1;
+
+	// We process the ranges in batches, generating the points for one batch in parallel
+	// while the points from the previous batch are passed to `chunkFunction`. This bounds
+	// memory usage to that of two batches, and keeps the points in a deterministic order.
+
+	const size_t batchSize = std::max( tbb::this_task_arena::max_concurrency(), 1 ) * 4;
+	const size_t numBatches = ( numRanges + batchSize - 1 ) / batchSize;
+	std::vector<std::vector<V3f>> buffers( batchSize * 2 );
+
+	std::vector<V3f> chunk;
+	chunk.reserve( chunkSize );
+
+	auto emit = [&] ( std::vector<V3f> &points ) {
+		for( size_t i = 0; i < points.size(); )
+		{
+			const size_t n = std::min( chunkSize - chunk.size(), points.size() - i );
+			chunk.insert( chunk.end(), points.begin() + i, points.begin() + i + n );
+			i += n;
+			if( chunk.size() == chunkSize )
+			{
+				Canceller::check( canceller );
+				chunkFunction( chunk );
+				chunk.clear();
+			}
+		}
+		points.clear();
+	};
+
+	tbb::this_task_arena::isolate(
+		[&] {
+			tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+			for( size_t batch = 0; batch <= numBatches; ++batch )
+			{
+				tbb::parallel_invoke(
+					[&] {
+						if( batch == 0 )
+						{
+							return;
+						}
+						const size_t begin = ( batch - 1 ) * batchSize;
+						const size_t end = std::min( begin + batchSize, numRanges );
+						std::vector<V3f> *batchBuffers = buffers.data() + ( ( batch - 1 ) % 2 ) * batchSize;
+						for( size_t i = begin; i < end; ++i )
+						{
+							emit( batchBuffers[i-begin] );
+						}
+					},
+					[&] {
+						if( batch == numBatches )
+						{
+							return;
+						}
+						const size_t begin = batch * batchSize;
+						const size_t end = std::min( begin + batchSize, numRanges );
+						std::vector<V3f> *batchBuffers = buffers.data() + ( batch % 2 ) * batchSize;
+						tbb::parallel_for(
+							tbb::blocked_range<size_t>( begin, end, 1 ),
+							[&]( const tbb::blocked_range<size_t> &r )
+							{
+								for( size_t i = r.begin(); i != r.end(); ++i )
+								{
+									m_tables->distribute( ranges[i], ranges[i+1], density, offset, maxPointsPerFace, p, batchBuffers[i-begin], canceller );
+								}
+							},
+							taskGroupContext
+						);
+					},
+					taskGroupContext
+				);
+			}
+		}
+	);
+
+	Canceller::check( canceller );
+	if( !chunk.empty() )
+	{
+		chunkFunction( chunk );
+	}
+}
+
+PointsPrimitivePtr MeshAlgo::distributePoints( const MeshPrimitive *mesh, float density, const Imath::V2f &offset, const std::string &densityMask, const std::string &uvSet, const std::string &position, const Canceller *canceller )
+{
+	if( density < 0 )
+	{
+		throw InvalidArgumentException( "MeshAlgo::distributePoints : The density of the distribution cannot be negative." );
+	}
+
+	const PointDistributor distributor( mesh, densityMask, uvSet, position, canceller );
+	return distributor.distribute( density, offset, std::numeric_limits<float>::infinity(), nullptr, canceller );
+}
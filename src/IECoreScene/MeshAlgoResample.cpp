@@ -32,17 +32,24 @@
 //
 //////////////////////////////////////////////////////////////////////////
 
-#include "IECoreScene/FaceVaryingPromotionOp.h"
 #include "IECoreScene/MeshAlgo.h"
 #include "IECoreScene/private/PrimitiveAlgoUtils.h"
 #include "IECoreScene/private/PrimitiveVariableAlgos.h"
 
 #include "IECore/DataAlgo.h"
-#include "IECore/DespatchTypedData.h"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 using namespace Imath;
 using namespace IECore;
 using namespace IECoreScene;
+using namespace IECoreScene::MeshAlgo;
 
 //////////////////////////////////////////////////////////////////////////
 // Resample Primitive Variables
@@ -51,240 +58,187 @@ using namespace IECoreScene;
 namespace
 {
 
-struct MeshVertexToUniform
+struct ResampleTables
 {
-	typedef DataPtr ReturnType;
-
-	MeshVertexToUniform( const MeshPrimitive *mesh, const Canceller *canceller )	:	m_mesh( mesh ), m_canceller( canceller )
-	{
-	}
-
-	template<typename From> ReturnType operator()( const From* data )
-	{
-		typename From::Ptr result = static_cast< From* >( Object::create( data->typeId() ).get() );
-		typename From::ValueType &trg = result->writable();
-		const typename From::ValueType &src = data->readable();
 
-		// TODO sipmlify this code by using polygon face & vertex iterators
-		trg.reserve( m_mesh->numFaces() );
+	// The offset of the first face vertex of each face, followed
+	// by the total number of face vertices.
+	std::vector<int> faceOffsets;
+	// The face owning each face vertex.
+	std::vector<int> faceIndices;
 
-		std::vector<int>::const_iterator vId = m_mesh->vertexIds()->readable().begin();
-		const std::vector<int> &verticesPerFace = m_mesh->verticesPerFace()->readable();
-		for( std::vector<int>::const_iterator it = verticesPerFace.begin(); it < verticesPerFace.end(); ++it )
-		{
-			Canceller::check( m_canceller );
+	// The offset of the first entry in `vertexFaceVertices` for each
+	// vertex, followed by the total number of entries.
+	std::vector<int> vertexOffsets;
+	// The face vertices referencing each vertex, in ascending order.
+	std::vector<int> vertexFaceVertices;
 
-			// initialize with the first value to avoid
-			// ambiguitity during default construction
-			typename From::ValueType::value_type total = src[ *vId ];
-			++vId;
+	std::once_flag faceTablesFlag;
+	std::once_flag vertexTablesFlag;
 
-			for( int j = 1; j < *it; ++j, ++vId )
-			{
-				total += src[ *vId ];
-			}
-
-			trg.push_back( total / *it );
-		}
-
-		IECoreScene::PrimitiveVariableAlgos::GeometricInterpretationCopier<From> copier;
-		copier( data, result.get() );
-
-		return result;
-	}
-
-	const MeshPrimitive *m_mesh;
-	const Canceller *m_canceller;
-};
-
-struct MeshUniformToVertex
-{
-	typedef DataPtr ReturnType;
-
-	MeshUniformToVertex( const MeshPrimitive *mesh, const Canceller *canceller )	:	m_mesh( mesh ), m_canceller( canceller )
-	{
-	}
-
-	template<typename From> ReturnType operator()( const From* data )
+	void computeFaceTables( const MeshPrimitive *mesh, const Canceller *canceller )
 	{
-		typename From::Ptr result = static_cast< From* >( Object::create( data->typeId() ).get() );
-		typename From::ValueType &trg = result->writable();
-		const typename From::ValueType &src = data->readable();
-
-		size_t numVerts = m_mesh->variableSize( PrimitiveVariable::Vertex );
-		std::vector<int> count( numVerts, 0 );
-		trg.resize( numVerts, typename From::ValueType::value_type( 0.0f ) );
-
-		typename From::ValueType::const_iterator srcIt = src.begin();
-		std::vector<int>::const_iterator vId = m_mesh->vertexIds()->readable().begin();
-		const std::vector<int> &verticesPerFace = m_mesh->verticesPerFace()->readable();
-		for( std::vector<int>::const_iterator it = verticesPerFace.begin(); it < verticesPerFace.end(); ++it, ++srcIt )
-		{
-			Canceller::check( m_canceller );
-
-			for( int j = 0; j < *it; ++j, ++vId )
-			{
-				trg[ *vId ] += *srcIt;
-				++count[ *vId ];
-			}
-		}
-
-		std::vector<int>::const_iterator cIt = count.begin();
-		typename From::ValueType::iterator trgIt = trg.begin(), trgEnd = trg.end();
-		for( trgIt = trg.begin(); trgIt != trgEnd ; ++trgIt, ++cIt )
-		{
-			*trgIt /= *cIt;
-		}
-
-		IECoreScene::PrimitiveVariableAlgos::GeometricInterpretationCopier<From> copier;
-		copier( data, result.get() );
-
-		return result;
+		// We isolate the parallel table computation, so that this thread can't
+		// steal an outer task which would then wait on the same flag.
+		std::call_once( faceTablesFlag, [&] { tbb::this_task_arena::isolate( [&] { buildFaceTables( mesh, canceller ); } ); } );
 	}
 
-	const MeshPrimitive *m_mesh;
-	const Canceller *m_canceller;
-};
-
-struct MeshFaceVaryingToVertex
-{
-	typedef DataPtr ReturnType;
-
-	MeshFaceVaryingToVertex( const MeshPrimitive *mesh, const Canceller *canceller )	:	m_mesh( mesh ), m_canceller( canceller )
+	void computeVertexTables( const MeshPrimitive *mesh, const Canceller *canceller )
 	{
+		std::call_once( vertexTablesFlag, [&] { tbb::this_task_arena::isolate( [&] { buildVertexTables( mesh, canceller ); } ); } );
 	}
 
-	template<typename From> ReturnType operator()( const From* data )
-	{
-		typename From::Ptr result = static_cast< From* >( Object::create( data->typeId() ).get() );
-		typename From::ValueType &trg = result->writable();
-		const typename From::ValueType &src = data->readable();
-
-		size_t numVerts = m_mesh->variableSize( PrimitiveVariable::Vertex );
-		std::vector<int> count( numVerts, 0 );
-		trg.resize( numVerts, typename From::ValueType::value_type( 0.0f ) );
+	private :
 
-		const std::vector<int>& vertexIds = m_mesh->vertexIds()->readable();
-		std::vector<int>::const_iterator vertexIdIt = vertexIds.begin();
-		typename From::ValueType::const_iterator srcIt = src.begin(), srcEnd = src.end();
-
-		int cancelTestCounter = 0;
-		for( ; srcIt != srcEnd ; ++srcIt, ++vertexIdIt )
+		void buildFaceTables( const MeshPrimitive *mesh, const Canceller *canceller )
 		{
-			if( cancelTestCounter++ == 1000 )
-			{
-				Canceller::check( m_canceller );
-				cancelTestCounter = 0;
-			}
-			trg[ *vertexIdIt ] += *srcIt;
-			++count[ *vertexIdIt ];
+			const std::vector<int> &verticesPerFace = mesh->verticesPerFace()->readable();
+			faceOffsets = PrimitiveVariableAlgos::primitiveOffsets(
+				verticesPerFace.size(), [&]( size_t i ) { return verticesPerFace[i]; }, canceller
+			);
+			faceIndices = PrimitiveVariableAlgos::primitiveIndices( faceOffsets, canceller );
 		}
 
-		std::vector<int>::const_iterator cIt = count.begin();
-		typename From::ValueType::iterator trgIt = trg.begin(), trgEnd = trg.end();
-		for( trgIt = trg.begin(); trgIt != trgEnd ; ++trgIt, ++cIt )
+		void buildVertexTables( const MeshPrimitive *mesh, const Canceller *canceller )
 		{
-			if( cancelTestCounter++ == 1000 )
-			{
-				Canceller::check( m_canceller );
-				cancelTestCounter = 0;
-			}
-			*trgIt /= *cIt;
+			const std::vector<int> &vertexIds = mesh->vertexIds()->readable();
+			const size_t numVertices = mesh->variableSize( PrimitiveVariable::Vertex );
+
+			// Count the face vertices referencing each vertex.
+
+			std::vector<std::atomic<int>> counts( numVertices );
+			PrimitiveVariableAlgos::parallelForBlocks(
+				vertexIds.size(), canceller,
+				[&]( size_t begin, size_t end )
+				{
+					for( size_t i = begin; i != end; ++i )
+					{
+						counts[vertexIds[i]].fetch_add( 1, std::memory_order_relaxed );
+					}
+				}
+			);
+
+			vertexOffsets = PrimitiveVariableAlgos::primitiveOffsets(
+				numVertices, [&]( size_t i ) { return counts[i].load( std::memory_order_relaxed ); }, canceller
+			);
+
+			// Bucket the face vertices by vertex. The order within each
+			// bucket depends on scheduling, so we sort the buckets afterwards
+			// to give deterministic results from the averaging.
+
+			PrimitiveVariableAlgos::parallelForBlocks(
+				numVertices, canceller,
+				[&]( size_t begin, size_t end )
+				{
+					for( size_t i = begin; i != end; ++i )
+					{
+						counts[i].store( vertexOffsets[i], std::memory_order_relaxed );
+					}
+				}
+			);
+
+			vertexFaceVertices.resize( vertexIds.size() );
+			PrimitiveVariableAlgos::parallelForBlocks(
+				vertexIds.size(), canceller,
+				[&]( size_t begin, size_t end )
+				{
+					for( size_t i = begin; i != end; ++i )
+					{
+						vertexFaceVertices[counts[vertexIds[i]].fetch_add( 1, std::memory_order_relaxed )] = i;
+					}
+				}
+			);
+
+			PrimitiveVariableAlgos::parallelForBlocks(
+				numVertices, canceller,
+				[&]( size_t begin, size_t end )
+				{
+					for( size_t i = begin; i != end; ++i )
+					{
+						std::sort( vertexFaceVertices.begin() + vertexOffsets[i], vertexFaceVertices.begin() + vertexOffsets[i+1] );
+					}
+				}
+			);
 		}
 
-		IECoreScene::PrimitiveVariableAlgos::GeometricInterpretationCopier<From> copier;
-		copier( data, result.get() );
-
-		return result;
-	}
-
-	const MeshPrimitive *m_mesh;
-	const Canceller *m_canceller;
 };
 
-struct MeshFaceVaryingToUniform
+DataPtr resampleData( const MeshPrimitive *mesh, ResampleTables &tables, const Data *data, PrimitiveVariable::Interpolation srcInterpolation, PrimitiveVariable::Interpolation interpolation, const Canceller *canceller )
 {
-	typedef DataPtr ReturnType;
-
-	MeshFaceVaryingToUniform( const MeshPrimitive *mesh, const Canceller *canceller )	:	m_mesh( mesh ), m_canceller( canceller )
+	tables.computeFaceTables( mesh, canceller );
+	if( interpolation == PrimitiveVariable::Vertex || interpolation == PrimitiveVariable::Varying )
 	{
+		tables.computeVertexTables( mesh, canceller );
 	}
 
-	template<typename From> ReturnType operator()( const From* data )
-	{
-		typename From::Ptr result = static_cast< From* >( Object::create( data->typeId() ).get() );
-		typename From::ValueType &trg = result->writable();
-		const typename From::ValueType &src = data->readable();
-
-		trg.reserve( m_mesh->numFaces() );
-
-		typename From::ValueType::const_iterator srcIt = src.begin();
+	const std::vector<int> &vertexIds = mesh->vertexIds()->readable();
 
-		const std::vector<int> &verticesPerFace = m_mesh->verticesPerFace()->readable();
-		for( std::vector<int>::const_iterator it = verticesPerFace.begin(); it < verticesPerFace.end(); ++it )
+	return dispatch(
+		data,
+		[&]( const auto *typedData ) -> DataPtr
 		{
-			Canceller::check( m_canceller );
-
-			// initialize with the first value to avoid
-			// ambiguity during default construction
-			typename From::ValueType::value_type total = *srcIt;
-			++srcIt;
-
-			for( int j = 1; j < *it; ++j, ++srcIt )
+			using DataType = typename std::remove_const_t<std::remove_pointer_t<decltype( typedData )>>;
+			if constexpr( TypeTraits::IsVectorTypedData<DataType>::value )
 			{
-				total += *srcIt;
+				typename DataType::Ptr result = new DataType;
+				if constexpr( TypeTraits::IsGeometricTypedData<DataType>::value )
+				{
+					result->setInterpretation( typedData->getInterpretation() );
+				}
+
+				const auto &src = typedData->readable();
+				auto &trg = result->writable();
+
+				if( interpolation == PrimitiveVariable::FaceVarying )
+				{
+					// Upsampling is a simple lookup, and is supported for all types.
+					PrimitiveVariableAlgos::gatherElements(
+						srcInterpolation == PrimitiveVariable::Uniform ? tables.faceIndices : vertexIds,
+						src, trg, canceller
+					);
+					return result;
+				}
+
+				if constexpr( IECoreScene::Detail::IsArithmeticVectorTypedData<DataType>::value )
+				{
+					if( interpolation == PrimitiveVariable::Uniform )
+					{
+						if( srcInterpolation == PrimitiveVariable::FaceVarying )
+						{
+							PrimitiveVariableAlgos::averageElements( tables.faceOffsets, []( int j ) { return j; }, src, trg, canceller );
+						}
+						else
+						{
+							PrimitiveVariableAlgos::averageElements( tables.faceOffsets, [&]( int j ) { return vertexIds[j]; }, src, trg, canceller );
+						}
+					}
+					else
+					{
+						if( srcInterpolation == PrimitiveVariable::Uniform )
+						{
+							PrimitiveVariableAlgos::averageElements(
+								tables.vertexOffsets, [&]( int j ) { return tables.faceIndices[tables.vertexFaceVertices[j]]; }, src, trg, canceller
+							);
+						}
+						else
+						{
+							PrimitiveVariableAlgos::averageElements(
+								tables.vertexOffsets, [&]( int j ) { return tables.vertexFaceVertices[j]; }, src, trg, canceller
+							);
+						}
+					}
+					return result;
+				}
 			}
 
-			trg.push_back( total / *it );
+			throw InvalidArgumentException(
+				boost::str( boost::format( "MeshAlgo::resamplePrimitiveVariable : Variable has unsupported data type \"%s\"." ) % typedData->typeName() )
+			);
 		}
+	);
+}
 
-		IECoreScene::PrimitiveVariableAlgos::GeometricInterpretationCopier<From> copier;
-		copier( data, result.get() );
-
-		return result;
-	}
-
-	const MeshPrimitive *m_mesh;
-	const Canceller *m_canceller;
-};
-
-struct MeshAnythingToFaceVarying
-{
-	typedef DataPtr ReturnType;
-
-	MeshAnythingToFaceVarying( const MeshPrimitive *mesh, PrimitiveVariable::Interpolation srcInterpolation, const Canceller *canceller )
-		: m_mesh( mesh ), m_srcInterpolation( srcInterpolation ), m_canceller( canceller )
-	{
-	}
-
-	template<typename From> ReturnType operator()( const From* data )
-	{
-
-		// TODO replace the call to the IECore::FaceVaryingPromotionOpPtr and include the logic in this file ( with cancellation ).
-
-		// we need to duplicate because the Op expects a primvar to manipulate..
-		MeshPrimitivePtr tmpMesh = m_mesh->copy();
-		// cast OK due to read-only access.
-		tmpMesh->variables["tmpPrimVar"] = PrimitiveVariable( m_srcInterpolation, const_cast< From * >(data) );
-		FaceVaryingPromotionOpPtr promoteOp = new FaceVaryingPromotionOp();
-		promoteOp->inputParameter()->setValue( tmpMesh );
-		IECore::StringVectorDataPtr names = new StringVectorData();
-		names->writable().push_back( "tmpPrimVar" );
-		promoteOp->primVarNamesParameter()->setValue( names );
-		ReturnType result = runTimeCast< MeshPrimitive >( promoteOp->operate() )->variables["tmpPrimVar"].data;
-
-
-		return result;
-	}
-
-	const MeshPrimitive *m_mesh;
-	PrimitiveVariable::Interpolation m_srcInterpolation;
-	const Canceller *m_canceller;
-};
-
-} // namespace
-
-void IECoreScene::MeshAlgo::resamplePrimitiveVariable( const MeshPrimitive *mesh, PrimitiveVariable& primitiveVariable, PrimitiveVariable::Interpolation interpolation, const Canceller *canceller )
+void resample( const MeshPrimitive *mesh, ResampleTables &tables, PrimitiveVariable &primitiveVariable, PrimitiveVariable::Interpolation interpolation, const Canceller *canceller )
 {
 	PrimitiveVariable::Interpolation srcInterpolation = primitiveVariable.interpolation;
 	if ( srcInterpolation == interpolation )
@@ -338,40 +292,15 @@ void IECoreScene::MeshAlgo::resamplePrimitiveVariable( const MeshPrimitive *mesh
 		return;
 	}
 
-	if( interpolation == PrimitiveVariable::Uniform )
-	{
-		if( srcInterpolation == PrimitiveVariable::Varying || srcInterpolation == PrimitiveVariable::Vertex )
-		{
-			MeshVertexToUniform fn( mesh, canceller );
-			dstData = despatchTypedData<MeshVertexToUniform, IECoreScene::Detail::IsArithmeticVectorTypedData>( srcData.get(), fn );
-		}
-		else if( srcInterpolation == PrimitiveVariable::FaceVarying )
-		{
-			MeshFaceVaryingToUniform fn( mesh, canceller );
-			dstData = despatchTypedData<MeshFaceVaryingToUniform, IECoreScene::Detail::IsArithmeticVectorTypedData>( srcData.get(), fn );
-		}
-	}
-	else if( interpolation == PrimitiveVariable::Varying || interpolation == PrimitiveVariable::Vertex )
+	const bool srcIsVertex = srcInterpolation == PrimitiveVariable::Varying || srcInterpolation == PrimitiveVariable::Vertex;
+	const bool dstIsVertex = interpolation == PrimitiveVariable::Varying || interpolation == PrimitiveVariable::Vertex;
+	if( srcIsVertex && dstIsVertex )
 	{
-		if( srcInterpolation == PrimitiveVariable::Uniform )
-		{
-			MeshUniformToVertex fn( mesh, canceller );
-			dstData = despatchTypedData<MeshUniformToVertex, IECoreScene::Detail::IsArithmeticVectorTypedData>( srcData.get(), fn );
-		}
-		else if( srcInterpolation == PrimitiveVariable::FaceVarying )
-		{
-			MeshFaceVaryingToVertex fn( mesh, canceller );
-			dstData = despatchTypedData<MeshFaceVaryingToVertex, IECoreScene::Detail::IsArithmeticVectorTypedData>( srcData.get(), fn );
-		}
-		else if( srcInterpolation == PrimitiveVariable::Varying || srcInterpolation == PrimitiveVariable::Vertex )
-		{
-			dstData = srcData;
-		}
+		dstData = srcData;
 	}
-	else if( interpolation == PrimitiveVariable::FaceVarying )
+	else
 	{
-		MeshAnythingToFaceVarying fn( mesh, srcInterpolation, canceller );
-		dstData = despatchTypedData<MeshAnythingToFaceVarying, IECoreScene::Detail::IsArithmeticVectorTypedData>( srcData.get(), fn );
+		dstData = resampleData( mesh, tables, srcData.get(), srcInterpolation, interpolation, canceller );
 	}
 
 	if( primitiveVariable.indices )
@@ -383,3 +312,49 @@ void IECoreScene::MeshAlgo::resamplePrimitiveVariable( const MeshPrimitive *mesh
 		primitiveVariable = PrimitiveVariable( interpolation, dstData );
 	}
 }
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// PrimitiveVariableResampler
+//////////////////////////////////////////////////////////////////////////
+
+struct PrimitiveVariableResampler::Tables : public ResampleTables
+{
+};
+
+PrimitiveVariableResampler::PrimitiveVariableResampler( ConstMeshPrimitivePtr mesh )
+	:	m_mesh( mesh ), m_tables( new Tables )
+{
+}
+
+PrimitiveVariableResampler::~PrimitiveVariableResampler()
+{
+}
+
+void PrimitiveVariableResampler::resample( PrimitiveVariable &primitiveVariable, PrimitiveVariable::Interpolation interpolation, const Canceller *canceller ) const
+{
+	::resample( m_mesh.get(), *m_tables, primitiveVariable, interpolation, canceller );
+}
+
+void PrimitiveVariableResampler::resample( std::vector<PrimitiveVariable> &primitiveVariables, PrimitiveVariable::Interpolation interpolation, const Canceller *canceller ) const
+{
+	tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, primitiveVariables.size(), 1 ),
+		[&]( const tbb::blocked_range<size_t> &r )
+		{
+			for( size_t i = r.begin(); i != r.end(); ++i )
+			{
+				resample( primitiveVariables[i], interpolation, canceller );
+			}
+		},
+		taskGroupContext
+	);
+}
+
+void IECoreScene::MeshAlgo::resamplePrimitiveVariable( const MeshPrimitive *mesh, PrimitiveVariable& primitiveVariable, PrimitiveVariable::Interpolation interpolation, const Canceller *canceller )
+{
+	ResampleTables tables;
+	::resample( mesh, tables, primitiveVariable, interpolation, canceller );
+}
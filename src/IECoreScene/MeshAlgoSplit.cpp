@@ -37,6 +37,9 @@
 
 #include "IECoreScene/MeshAlgo.h"
 
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
 #include <unordered_map>
 
 using namespace Imath;
@@ -764,25 +767,46 @@ struct ResamplePrimitiveVariableFunctor
 	}
 };
 
-} // namespace
-
-
-MeshPrimitivePtr IECoreScene::MeshAlgo::MeshSplitter::mesh( int segmentId, const IECore::Canceller *canceller ) const
+// Loop through every face in a range of faceRemap, and all the vertices in each face, and extend
+// the result by the position for each vertex index
+Box3f segmentBound(
+	int startIndex, int endIndex, const std::vector<V3f> &p, const std::vector<int> &sourceVertexIds,
+	const std::vector<int> &sourceVerticesPerFace, const std::vector<int> &faceRemap, const std::vector<int> &faceIndices,
+	const Canceller *canceller
+)
 {
-	if( segmentId < 0 || segmentId > (int)m_meshIndices.size() )
+	Box3f result;
+	for( int i = startIndex; i < endIndex; i++ )
 	{
-		throw IECore::Exception( "Invalid segment id " + std::to_string( segmentId ) );
+		if( i % 10000 == 0 )
+		{
+			Canceller::check( canceller );
+		}
+
+		int originalFaceIndex = faceRemap[i];
+		int faceVerts = sourceVerticesPerFace[ originalFaceIndex ];
+		int faceStart = faceIndices[ originalFaceIndex ];
+		for( int j = 0; j < faceVerts; j++ )
+		{
+			result.extendBy( p[ sourceVertexIds[ faceStart + j ] ] );
+		}
 	}
+	return result;
+}
 
-	// Based on our index, and the index of the next mesh in m_meshIndices, we know how many faces to output
-	const int startIndex = m_meshIndices[ segmentId ];
-	const int endIndex = ( segmentId + 1 < (int)m_meshIndices.size() ) ? m_meshIndices[ segmentId + 1 ] : m_faceRemap.size();
+} // namespace
+
+
+MeshPrimitivePtr IECoreScene::MeshAlgo::MeshSplitter::meshTopology( int segmentId, std::vector<int> &vertRemapBackwards, int &totalFaceVerts, const IECore::Canceller *canceller ) const
+{
+	int startIndex, endIndex;
+	faceRange( segmentId, startIndex, endIndex );
 	const int numFaces = endIndex - startIndex;
 
 	IntVectorDataPtr verticesPerFaceData = new IntVectorData();
 	std::vector<int> &verticesPerFace = verticesPerFaceData->writable();
 	verticesPerFace.reserve( numFaces );
-	int totalFaceVerts = 0;
+	totalFaceVerts = 0;
 	const std::vector<int> &sourceVertexIds = m_mesh->vertexIds()->readable();
 	const std::vector<int> &sourceVerticesPerFace = m_mesh->verticesPerFace()->readable();
 
@@ -819,7 +843,6 @@ MeshPrimitivePtr IECoreScene::MeshAlgo::MeshSplitter::mesh( int segmentId, const
 
 	// We need to track which original vertex our vertices came from so we can pull primvar data from them.
 	Canceller::check( canceller );
-	std::vector<int> vertRemapBackwards;
 	vertReindexer.getDataRemapping( vertRemapBackwards );
 
 	MeshPrimitivePtr ret = new MeshPrimitive( verticesPerFaceData, vertReindexer.getNewIndices(), m_mesh->interpolation() );
@@ -905,6 +928,19 @@ MeshPrimitivePtr IECoreScene::MeshAlgo::MeshSplitter::mesh( int segmentId, const
 		ret->setCreases( creaseLengthsData.get(), creaseIdsData.get(), creaseSharpnessesData.get() );
 	}
 
+	return ret;
+}
+
+MeshPrimitivePtr IECoreScene::MeshAlgo::MeshSplitter::mesh( int segmentId, const IECore::Canceller *canceller ) const
+{
+	std::vector<int> vertRemapBackwards;
+	int totalFaceVerts;
+	MeshPrimitivePtr ret = meshTopology( segmentId, vertRemapBackwards, totalFaceVerts, canceller );
+
+	const int startIndex = m_meshIndices[ segmentId ];
+	const int numFaces = ret->numFaces();
+	const std::vector<int> &sourceVerticesPerFace = m_mesh->verticesPerFace()->readable();
+
 	// Now split all primvars using	ResamplePrimitiveVariableFunctor()
 	for( const auto &p : m_mesh->variables )
 	{
@@ -920,13 +956,77 @@ MeshPrimitivePtr IECoreScene::MeshAlgo::MeshSplitter::mesh( int segmentId, const
 	return ret;
 }
 
-Imath::Box3f IECoreScene::MeshAlgo::MeshSplitter::bound( int segmentId, const IECore::Canceller *canceller ) const
+std::vector<MeshPrimitivePtr> IECoreScene::MeshAlgo::MeshSplitter::meshes( const std::vector<int> &segmentIds, const IECore::Canceller *canceller ) const
 {
-	if( segmentId < 0 || segmentId > (int)m_meshIndices.size() )
+	for( int segmentId : segmentIds )
+	{
+		int startIndex, endIndex;
+		faceRange( segmentId, startIndex, endIndex );
+	}
+
+	std::vector<MeshPrimitivePtr> result( segmentIds.size() );
+	std::vector< std::vector<int> > vertRemapsBackwards( segmentIds.size() );
+	std::vector<int> totalFaceVerts( segmentIds.size() );
+
+	// Build all the topologies first, since we need the vertex remapping for each output
+	// before we can split any Vertex or Varying primvars.
+	tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, segmentIds.size() ),
+		[&]( const tbb::blocked_range<size_t> &r )
+		{
+			for( size_t i = r.begin(); i != r.end(); ++i )
+			{
+				result[i] = meshTopology( segmentIds[i], vertRemapsBackwards[i], totalFaceVerts[i], canceller );
+			}
+		},
+		taskGroupContext
+	);
+
+	const std::vector<int> &sourceVerticesPerFace = m_mesh->verticesPerFace()->readable();
+
+	// Then split each primvar for all the outputs at once. Working one primvar at a time
+	// means we only pay for the dispatch once per primvar, and keeps the source data hot
+	// in the cache.
+	for( const auto &p : m_mesh->variables )
 	{
-		throw IECore::Exception( "Invalid segment id " + std::to_string( segmentId ) );
+		if( !m_mesh->isPrimitiveVariableValid( p.second ) )
+		{
+			IECore::msg( Msg::Error, "MeshAlgoSplit", "Cannot resample " + p.first + " because it is not valid to start with." );
+			continue;
+		}
+		Canceller::check( canceller );
+
+		IECore::dispatch( p.second.data.get(),
+			[&]( const auto *data )
+			{
+				tbb::task_group_context primVarTaskGroupContext( tbb::task_group_context::isolated );
+				tbb::parallel_for(
+					tbb::blocked_range<size_t>( 0, segmentIds.size() ),
+					[&]( const tbb::blocked_range<size_t> &r )
+					{
+						for( size_t i = r.begin(); i != r.end(); ++i )
+						{
+							result[i]->variables[ p.first ] = ResamplePrimitiveVariableFunctor()(
+								data, p.second, m_meshIndices[ segmentIds[i] ], result[i]->numFaces(), totalFaceVerts[i],
+								m_faceRemap, sourceVerticesPerFace, m_faceIndices, vertRemapsBackwards[i], canceller
+							);
+						}
+					},
+					primVarTaskGroupContext
+				);
+			}
+		);
 	}
 
+	return result;
+}
+
+Imath::Box3f IECoreScene::MeshAlgo::MeshSplitter::bound( int segmentId, const IECore::Canceller *canceller ) const
+{
+	int startIndex, endIndex;
+	faceRange( segmentId, startIndex, endIndex );
+
 	Box3f result;
 	PrimitiveVariableMap::const_iterator it = m_mesh->variables.find( "P" );
 	if( it == m_mesh->variables.end() )
@@ -940,33 +1040,46 @@ Imath::Box3f IECoreScene::MeshAlgo::MeshSplitter::bound( int segmentId, const IE
 		return result;
 	}
 
-	const std::vector<V3f> &p = pData->readable();
+	Canceller::check( canceller );
 
-	// Based on our index, and the index of the next mesh in m_meshIndices, we know how many faces to scan
-	const int startIndex = m_meshIndices[ segmentId ];
-	const int endIndex = ( segmentId + 1 < (int)m_meshIndices.size() ) ? m_meshIndices[ segmentId + 1 ] : m_faceRemap.size();
+	return segmentBound( startIndex, endIndex, pData->readable(), m_mesh->vertexIds()->readable(), m_mesh->verticesPerFace()->readable(), m_faceRemap, m_faceIndices, canceller );
+}
 
-	const std::vector<int> &sourceVertexIds = m_mesh->vertexIds()->readable();
-	const std::vector<int> &sourceVerticesPerFace = m_mesh->verticesPerFace()->readable();
+std::vector<Imath::Box3f> IECoreScene::MeshAlgo::MeshSplitter::bounds( const IECore::Canceller *canceller ) const
+{
+	std::vector<Box3f> result( m_meshIndices.size() );
 
-	Canceller::check( canceller );
+	PrimitiveVariableMap::const_iterator it = m_mesh->variables.find( "P" );
+	if( it == m_mesh->variables.end() )
+	{
+		return result;
+	}
 
-	// Loop through every face in this output, and all the vertices in each face, and extend the result
-	// by the position for each vertex index
-	for( int i = startIndex; i < endIndex; i++ )
+	ConstV3fVectorDataPtr pData = runTimeCast<const V3fVectorData>( it->second.data );
+	if( !pData )
 	{
-		if( i % 10000 == 0 )
+		return result;
+	}
+
+	const std::vector<V3f> &p = pData->readable();
+	const std::vector<int> &sourceVertexIds = m_mesh->vertexIds()->readable();
+	const std::vector<int> &sourceVerticesPerFace = m_mesh->verticesPerFace()->readable();
+
+	tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, m_meshIndices.size() ),
+		[&]( const tbb::blocked_range<size_t> &r )
 		{
 			Canceller::check( canceller );
-		}
+			for( size_t i = r.begin(); i != r.end(); ++i )
+			{
+				const int startIndex = m_meshIndices[i];
+				const int endIndex = i + 1 < m_meshIndices.size() ? m_meshIndices[i+1] : m_faceRemap.size();
+				result[i] = segmentBound( startIndex, endIndex, p, sourceVertexIds, sourceVerticesPerFace, m_faceRemap, m_faceIndices, canceller );
+			}
+		},
+		taskGroupContext
+	);
 
-		int originalFaceIndex = m_faceRemap[i];
-		int faceVerts = sourceVerticesPerFace[ originalFaceIndex ];
-		int faceStart = m_faceIndices[ originalFaceIndex ];
-		for( int j = 0; j < faceVerts; j++ )
-		{
-			result.extendBy( p[ sourceVertexIds[ faceStart + j ] ] );
-		}
-	}
 	return result;
 }
@@ -0,0 +1,420 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2026, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "IECoreScene/MeshAlgo.h"
+#include "IECoreScene/private/PrimitiveVariableAlgos.h"
+
+#include "IECore/DataAlgo.h"
+#include "IECore/TypeTraits.h"
+
+#include "boost/format.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+
+using namespace std;
+using namespace IECore;
+using namespace IECoreScene;
+
+//////////////////////////////////////////////////////////////////////////
+// Triangulate indexed
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+// Compares the values of a primitive variable at two face-vertices.
+// `divisor` maps from face-vertices to the elements of the primitive
+// variable : 1 for FaceVarying and 3 for Uniform on a triangle mesh.
+class ElementComparator
+{
+
+	public :
+
+		virtual ~ElementComparator() = default;
+		virtual bool equal( size_t faceVertex0, size_t faceVertex1 ) const = 0;
+
+};
+
+template<typename T>
+class TypedElementComparator : public ElementComparator
+{
+
+	public :
+
+		TypedElementComparator( const std::vector<T> &data, const std::vector<int> *indices, size_t divisor )
+			:	m_data( data ), m_indices( indices ), m_divisor( divisor )
+		{
+		}
+
+		bool equal( size_t faceVertex0, size_t faceVertex1 ) const override
+		{
+			size_t i0 = faceVertex0 / m_divisor;
+			size_t i1 = faceVertex1 / m_divisor;
+			if( m_indices )
+			{
+				i0 = (*m_indices)[i0];
+				i1 = (*m_indices)[i1];
+			}
+			return i0 == i1 || m_data[i0] == m_data[i1];
+		}
+
+	private :
+
+		const std::vector<T> &m_data;
+		const std::vector<int> *m_indices;
+		const size_t m_divisor;
+
+};
+
+std::unique_ptr<ElementComparator> elementComparator( const std::string &name, const PrimitiveVariable &primitiveVariable, size_t divisor )
+{
+	return dispatch(
+		primitiveVariable.data.get(),
+		[&]( const auto *data ) -> std::unique_ptr<ElementComparator>
+		{
+			using DataType = typename std::remove_const_t<std::remove_pointer_t<decltype( data )>>;
+			if constexpr( TypeTraits::IsVectorTypedData<DataType>::value )
+			{
+				using ValueType = typename DataType::ValueType::value_type;
+				return std::make_unique<TypedElementComparator<ValueType>>(
+					data->readable(), primitiveVariable.indices ? &primitiveVariable.indices->readable() : nullptr, divisor
+				);
+			}
+			else
+			{
+				throw InvalidArgumentException(
+					boost::str( boost::format( "MeshAlgo::triangulateIndexed : Primitive variable \"%s\" has unsupported type \"%s\"" ) % name % data->typeName() )
+				);
+			}
+		}
+	);
+}
+
+} // namespace
+
+MeshPrimitivePtr IECoreScene::MeshAlgo::triangulateIndexed( const MeshPrimitive *mesh, const Canceller *canceller )
+{
+	for( const auto &p : mesh->variables )
+	{
+		if( !mesh->isPrimitiveVariableValid( p.second ) )
+		{
+			throw InvalidArgumentException(
+				boost::str( boost::format( "MeshAlgo::triangulateIndexed : Primitive variable \"%s\" is invalid" ) % p.first )
+			);
+		}
+	}
+
+	MeshPrimitivePtr triangulated = triangulate( mesh, canceller );
+
+	const std::vector<int> &vertexIds = triangulated->vertexIds()->readable();
+	const size_t numFaceVertices = vertexIds.size();
+	const size_t numVertices = triangulated->variableSize( PrimitiveVariable::Vertex );
+
+	// Make comparators for all the primitive variables which may have
+	// different values at the face-vertices sharing a vertex.
+
+	std::vector<std::unique_ptr<ElementComparator>> comparators;
+	for( const auto &p : triangulated->variables )
+	{
+		switch( p.second.interpolation )
+		{
+			case PrimitiveVariable::Uniform :
+				comparators.push_back( elementComparator( p.first, p.second, 3 ) );
+				break;
+			case PrimitiveVariable::FaceVarying :
+				comparators.push_back( elementComparator( p.first, p.second, 1 ) );
+				break;
+			default :
+				break;
+		}
+	}
+
+	auto equal = [&]( size_t faceVertex0, size_t faceVertex1 ) {
+		for( const auto &c : comparators )
+		{
+			if( !c->equal( faceVertex0, faceVertex1 ) )
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// Find the face-vertices using each vertex, in ascending order
+	// so that the output is deterministic.
+
+	std::vector<int> vertexFaceVertexOffsets( numVertices + 1, 0 );
+	for( int v : vertexIds )
+	{
+		vertexFaceVertexOffsets[v+1]++;
+	}
+	std::partial_sum( vertexFaceVertexOffsets.begin(), vertexFaceVertexOffsets.end(), vertexFaceVertexOffsets.begin() );
+
+	Canceller::check( canceller );
+	std::vector<int> vertexFaceVertices( numFaceVertices );
+	{
+		std::vector<int> next( vertexFaceVertexOffsets.begin(), vertexFaceVertexOffsets.end() - 1 );
+		for( size_t i = 0; i < numFaceVertices; ++i )
+		{
+			vertexFaceVertices[next[vertexIds[i]]++] = i;
+		}
+	}
+
+	// Weld the face-vertices around each vertex. Each face-vertex is assigned
+	// the index of the first equal face-vertex, local to its vertex.
+
+	std::vector<int> localIndices( numFaceVertices );
+	std::vector<int> numUnique( numVertices );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		numVertices, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			std::vector<int> representatives;
+			for( size_t v = begin; v != end; ++v )
+			{
+				representatives.clear();
+				for( int j = vertexFaceVertexOffsets[v]; j < vertexFaceVertexOffsets[v+1]; ++j )
+				{
+					const int faceVertex = vertexFaceVertices[j];
+					size_t k = 0;
+					while( k < representatives.size() && !equal( representatives[k], faceVertex ) )
+					{
+						++k;
+					}
+					if( k == representatives.size() )
+					{
+						representatives.push_back( faceVertex );
+					}
+					localIndices[faceVertex] = k;
+				}
+				numUnique[v] = representatives.size();
+			}
+		}
+	);
+
+	std::vector<int> vertexOffsets;
+	const size_t numOutputVertices = PrimitiveVariableAlgos::exclusiveScan(
+		numVertices, [&]( size_t v ) { return numUnique[v]; }, vertexOffsets, canceller
+	);
+
+	// Build the index buffer, and find the face-vertex each output vertex
+	// gets its values from.
+
+	IntVectorDataPtr outVertexIdsData = new IntVectorData;
+	std::vector<int> &outVertexIds = outVertexIdsData->writable();
+	outVertexIds.resize( numFaceVertices );
+
+	std::vector<int> sourceFaceVertices( numOutputVertices );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		numVertices, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t v = begin; v != end; ++v )
+			{
+				int numAssigned = 0;
+				for( int j = vertexFaceVertexOffsets[v]; j < vertexFaceVertexOffsets[v+1]; ++j )
+				{
+					const int faceVertex = vertexFaceVertices[j];
+					const int localIndex = localIndices[faceVertex];
+					outVertexIds[faceVertex] = vertexOffsets[v] + localIndex;
+					if( localIndex == numAssigned )
+					{
+						sourceFaceVertices[vertexOffsets[v] + localIndex] = faceVertex;
+						numAssigned++;
+					}
+				}
+			}
+		}
+	);
+
+	std::vector<int> sourceVertices( numOutputVertices );
+	std::vector<int> sourceFaces( numOutputVertices );
+	PrimitiveVariableAlgos::parallelForBlocks(
+		numOutputVertices, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
+			{
+				sourceVertices[i] = vertexIds[sourceFaceVertices[i]];
+				sourceFaces[i] = sourceFaceVertices[i] / 3;
+			}
+		}
+	);
+
+	// Gather the primitive variables.
+
+	MeshPrimitivePtr result = new MeshPrimitive( triangulated->verticesPerFace(), outVertexIdsData, triangulated->interpolation() );
+
+	PrimitiveVariableAlgos::compactPrimitiveVariables(
+		triangulated->variables, result->variables,
+		[&]( PrimitiveVariable::Interpolation interpolation ) -> const std::vector<int> * {
+			switch( interpolation )
+			{
+				case PrimitiveVariable::Uniform :
+					return &sourceFaces;
+				case PrimitiveVariable::Vertex :
+				case PrimitiveVariable::Varying :
+					return &sourceVertices;
+				case PrimitiveVariable::FaceVarying :
+					return &sourceFaceVertices;
+				default :
+					return nullptr;
+			}
+		},
+		canceller
+	);
+
+	for( auto &p : result->variables )
+	{
+		if( p.second.interpolation != PrimitiveVariable::Constant )
+		{
+			p.second.interpolation = PrimitiveVariable::Vertex;
+		}
+	}
+
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Interleave vertex data
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+// Returns the base data for a float-based primitive variable, or
+// nullptr if the data is not float-based.
+const float *floatBaseData( const PrimitiveVariable &primitiveVariable, size_t &numComponents )
+{
+	return dispatch(
+		primitiveVariable.data.get(),
+		[&]( const auto *data ) -> const float *
+		{
+			using DataType = typename std::remove_const_t<std::remove_pointer_t<decltype( data )>>;
+			if constexpr( TypeTraits::IsVectorTypedData<DataType>::value )
+			{
+				if constexpr( std::is_same_v<typename DataType::BaseType, float> )
+				{
+					using ValueType = typename DataType::ValueType::value_type;
+					numComponents = sizeof( ValueType ) / sizeof( float );
+					return data->baseReadable();
+				}
+			}
+			return nullptr;
+		}
+	);
+}
+
+} // namespace
+
+MeshAlgo::InterleavedVertexData IECoreScene::MeshAlgo::interleaveVertexData( const MeshPrimitive *mesh, const std::vector<std::string> &names, const Canceller *canceller )
+{
+	struct Source
+	{
+		const float *data;
+		const std::vector<int> *indices;
+	};
+
+	InterleavedVertexData result;
+	std::vector<Source> sources;
+
+	auto addAttribute = [&]( const std::string &name, const PrimitiveVariable &primitiveVariable, size_t numComponents, const float *data ) {
+		result.attributes.push_back( { name, result.stride, numComponents } );
+		result.stride += numComponents;
+		sources.push_back( { data, primitiveVariable.indices ? &primitiveVariable.indices->readable() : nullptr } );
+	};
+
+	if( names.empty() )
+	{
+		for( const auto &p : mesh->variables )
+		{
+			size_t numComponents = 0;
+			const float *data = floatBaseData( p.second, numComponents );
+			if( p.second.interpolation == PrimitiveVariable::Vertex && data && mesh->isPrimitiveVariableValid( p.second ) )
+			{
+				addAttribute( p.first, p.second, numComponents, data );
+			}
+		}
+	}
+	else
+	{
+		for( const auto &name : names )
+		{
+			auto it = mesh->variables.find( name );
+			if( it == mesh->variables.end() )
+			{
+				throw InvalidArgumentException( boost::str( boost::format( "MeshAlgo::interleaveVertexData : Primitive variable \"%s\" does not exist" ) % name ) );
+			}
+			if( it->second.interpolation != PrimitiveVariable::Vertex || !mesh->isPrimitiveVariableValid( it->second ) )
+			{
+				throw InvalidArgumentException( boost::str( boost::format( "MeshAlgo::interleaveVertexData : Primitive variable \"%s\" must be valid and have Vertex interpolation" ) % name ) );
+			}
+			size_t numComponents = 0;
+			const float *data = floatBaseData( it->second, numComponents );
+			if( !data )
+			{
+				throw InvalidArgumentException( boost::str( boost::format( "MeshAlgo::interleaveVertexData : Primitive variable \"%s\" does not have float-based data" ) % name ) );
+			}
+			addAttribute( name, it->second, numComponents, data );
+		}
+	}
+
+	const size_t numVertices = mesh->variableSize( PrimitiveVariable::Vertex );
+	result.data = new FloatVectorData;
+	std::vector<float> &out = result.data->writable();
+	out.resize( numVertices * result.stride );
+
+	PrimitiveVariableAlgos::parallelForBlocks(
+		numVertices, canceller,
+		[&]( size_t begin, size_t end )
+		{
+			for( size_t i = begin; i != end; ++i )
+			{
+				float *o = out.data() + i * result.stride;
+				for( size_t a = 0; a < sources.size(); ++a )
+				{
+					const Source &source = sources[a];
+					const size_t numComponents = result.attributes[a].numComponents;
+					const size_t element = source.indices ? (*source.indices)[i] : i;
+					std::copy( source.data + element * numComponents, source.data + ( element + 1 ) * numComponents, o );
+					o += numComponents;
+				}
+			}
+		}
+	);
+
+	return result;
+}
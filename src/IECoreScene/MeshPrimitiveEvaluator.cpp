@@ -887,10 +887,10 @@ void MeshPrimitiveEvaluator::closestPointWalk( TriangleBoundTree::NodeIndex node
 	const TriangleBoundTree::Node &node = m_tree->node( nodeIndex );
 	if( node.isLeaf() )
 	{
-		TriangleBoundTree::Iterator *permLast = node.permLast();
-		for( TriangleBoundTree::Iterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		const size_t lastBound = node.lastBound();
+		for( size_t i = node.firstBound(); i != lastBound; ++i )
 		{
-			size_t triangleIndex = *perm - m_triangles.begin(); // triangle index is just the distance of the triangle from the beginning of the vector
+			size_t triangleIndex = m_tree->boundIndex( i );
 			size_t vertIdOffset = triangleIndex * 3;
 			Imath::V3i vertexIds( (*m_meshVertexIds)[vertIdOffset], (*m_meshVertexIds)[vertIdOffset+1], (*m_meshVertexIds)[vertIdOffset+2] );
 
@@ -934,12 +934,12 @@ void MeshPrimitiveEvaluator::closestPointWalk( TriangleBoundTree::NodeIndex node
 		/// Descend into the closest box first
 
 		float dHigh = vecDistance(
-			closestPointInBox( p, m_tree->node( TriangleBoundTree::highChildIndex( nodeIndex ) ).bound() ),
+			closestPointInBox( p, m_tree->node( m_tree->highChildIndex( nodeIndex ) ).bound() ),
 			p
 		);
 
 		float dLow = vecDistance(
-			closestPointInBox( p, m_tree->node( TriangleBoundTree::lowChildIndex( nodeIndex ) ).bound() ),
+			closestPointInBox( p, m_tree->node( m_tree->lowChildIndex( nodeIndex ) ).bound() ),
 			p
 		);
 
@@ -949,14 +949,14 @@ void MeshPrimitiveEvaluator::closestPointWalk( TriangleBoundTree::NodeIndex node
 
 		if (dHigh < dLow)
 		{
-			firstChild = TriangleBoundTree::highChildIndex( nodeIndex );
-			secondChild = TriangleBoundTree::lowChildIndex( nodeIndex );
+			firstChild = m_tree->highChildIndex( nodeIndex );
+			secondChild = m_tree->lowChildIndex( nodeIndex );
 			dSecond = dLow;
 		}
 		else
 		{
-			firstChild = TriangleBoundTree::lowChildIndex( nodeIndex );
-			secondChild = TriangleBoundTree::highChildIndex( nodeIndex );
+			firstChild = m_tree->lowChildIndex( nodeIndex );
+			secondChild = m_tree->highChildIndex( nodeIndex );
 			dSecond = dHigh;
 		}
 
@@ -984,10 +984,10 @@ bool MeshPrimitiveEvaluator::pointAtUVWalk( UVBoundTree::NodeIndex nodeIndex, co
 	if( node.isLeaf() )
 	{
 
-		UVBoundTree::Iterator *permLast = node.permLast();
-		for( UVBoundTree::Iterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		const size_t lastBound = node.lastBound();
+		for( size_t i = node.firstBound(); i != lastBound; ++i )
 		{
-			size_t triangleIndex = *perm - m_uvTriangles.begin(); // triangle index is just the distance of the triangle from the beginning of the vector
+			size_t triangleIndex = m_uvTree->boundIndex( i );
 			size_t vertIdOffset = triangleIndex * 3;
 			Imath::V3i vertexIds( (*m_meshVertexIds)[vertIdOffset], (*m_meshVertexIds)[vertIdOffset+1], (*m_meshVertexIds)[vertIdOffset+2] );
 
@@ -1022,12 +1022,12 @@ bool MeshPrimitiveEvaluator::pointAtUVWalk( UVBoundTree::NodeIndex nodeIndex, co
 	}
 	else
 	{
-		if( pointAtUVWalk( UVBoundTree::lowChildIndex( nodeIndex ), targetUV, result ) )
+		if( pointAtUVWalk( m_uvTree->lowChildIndex( nodeIndex ), targetUV, result ) )
 		{
 			return true;
 		}
 
-		if( pointAtUVWalk( UVBoundTree::highChildIndex( nodeIndex ), targetUV, result ) )
+		if( pointAtUVWalk( m_uvTree->highChildIndex( nodeIndex ), targetUV, result ) )
 		{
 			return true;
 		}
@@ -1046,12 +1046,12 @@ bool MeshPrimitiveEvaluator::intersectionPointWalk( TriangleBoundTree::NodeIndex
 
 	if( node.isLeaf() )
 	{
-		TriangleBoundTree::Iterator *permLast = node.permLast();
+		const size_t lastBound = node.lastBound();
 		bool intersects = false;
 
-		for( TriangleBoundTree::Iterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		for( size_t i = node.firstBound(); i != lastBound; ++i )
 		{
-			size_t triangleIndex = *perm - m_triangles.begin(); // triangle index is just the distance of the triangle from the beginning of the vector
+			size_t triangleIndex = m_tree->boundIndex( i );
 			size_t vertIdOffset = triangleIndex * 3;
 			Imath::V3i vertexIds( (*m_meshVertexIds)[vertIdOffset], (*m_meshVertexIds)[vertIdOffset+1], (*m_meshVertexIds)[vertIdOffset+2] );
 
@@ -1099,7 +1099,7 @@ bool MeshPrimitiveEvaluator::intersectionPointWalk( TriangleBoundTree::NodeIndex
 	{
 		V3f highHitPoint;
 		bool highHit = boxIntersects(
-			m_tree->node( TriangleBoundTree::highChildIndex( nodeIndex ) ).bound(),
+			m_tree->node( m_tree->highChildIndex( nodeIndex ) ).bound(),
 			ray.pos,
 			ray.dir,
 			highHitPoint
@@ -1107,7 +1107,7 @@ bool MeshPrimitiveEvaluator::intersectionPointWalk( TriangleBoundTree::NodeIndex
 
 		V3f lowHitPoint;
 		bool lowHit = boxIntersects(
-			m_tree->node( TriangleBoundTree::lowChildIndex( nodeIndex ) ).bound(),
+			m_tree->node( m_tree->lowChildIndex( nodeIndex ) ).bound(),
 			ray.pos,
 			ray.dir,
 			lowHitPoint
@@ -1151,14 +1151,14 @@ bool MeshPrimitiveEvaluator::intersectionPointWalk( TriangleBoundTree::NodeIndex
 				float dSecond;
 				if (dHigh < dLow)
 				{
-					firstChild = TriangleBoundTree::highChildIndex( nodeIndex );
-					secondChild = TriangleBoundTree::lowChildIndex( nodeIndex );
+					firstChild = m_tree->highChildIndex( nodeIndex );
+					secondChild = m_tree->lowChildIndex( nodeIndex );
 					dSecond = dLow;
 				}
 				else
 				{
-					firstChild = TriangleBoundTree::lowChildIndex( nodeIndex );
-					secondChild = TriangleBoundTree::highChildIndex( nodeIndex );
+					firstChild = m_tree->lowChildIndex( nodeIndex );
+					secondChild = m_tree->highChildIndex( nodeIndex );
 					dSecond = dHigh;
 				}
 
@@ -1180,13 +1180,13 @@ bool MeshPrimitiveEvaluator::intersectionPointWalk( TriangleBoundTree::NodeIndex
 			}
 			else
 			{
-				return intersectionPointWalk( TriangleBoundTree::lowChildIndex( nodeIndex ), ray, maxDistSqrd, result, hit );
+				return intersectionPointWalk( m_tree->lowChildIndex( nodeIndex ), ray, maxDistSqrd, result, hit );
 			}
 
 		}
 		else if (highHit)
 		{
-			return intersectionPointWalk( TriangleBoundTree::highChildIndex( nodeIndex ), ray, maxDistSqrd, result, hit );
+			return intersectionPointWalk( m_tree->highChildIndex( nodeIndex ), ray, maxDistSqrd, result, hit );
 		}
 
 
@@ -1203,11 +1203,11 @@ void MeshPrimitiveEvaluator::intersectionPointsWalk( TriangleBoundTree::NodeInde
 
 	if( node.isLeaf() )
 	{
-		TriangleBoundTree::Iterator *permLast = node.permLast();
+		const size_t lastBound = node.lastBound();
 
-		for( TriangleBoundTree::Iterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		for( size_t i = node.firstBound(); i != lastBound; ++i )
 		{
-			size_t triangleIndex = *perm - m_triangles.begin(); // triangle index is just the distance of the triangle from the beginning of the vector
+			size_t triangleIndex = m_tree->boundIndex( i );
 			size_t vertIdOffset = triangleIndex * 3;
 			Imath::V3i vertexIds( (*m_meshVertexIds)[vertIdOffset], (*m_meshVertexIds)[vertIdOffset+1], (*m_meshVertexIds)[vertIdOffset+2] );
 
@@ -1254,7 +1254,7 @@ void MeshPrimitiveEvaluator::intersectionPointsWalk( TriangleBoundTree::NodeInde
 
 		/// Test highChild bound for intersection, descending into children if necessary
 		bool hit = boxIntersects(
-			m_tree->node( TriangleBoundTree::highChildIndex( nodeIndex ) ).bound(),
+			m_tree->node( m_tree->highChildIndex( nodeIndex ) ).bound(),
 			ray.pos,
 			ray.dir,
 			hitPoint
@@ -1262,12 +1262,12 @@ void MeshPrimitiveEvaluator::intersectionPointsWalk( TriangleBoundTree::NodeInde
 
 		if ( hit && vecDistance2( hitPoint, ray.pos ) < maxDistSqrd )
 		{
-			intersectionPointsWalk( TriangleBoundTree::highChildIndex( nodeIndex ), ray, maxDistSqrd, results );
+			intersectionPointsWalk( m_tree->highChildIndex( nodeIndex ), ray, maxDistSqrd, results );
 		}
 
 		/// Test lowChild bound for intersection, descending into children if necessary
 		hit = boxIntersects(
-			m_tree->node( TriangleBoundTree::lowChildIndex( nodeIndex ) ).bound(),
+			m_tree->node( m_tree->lowChildIndex( nodeIndex ) ).bound(),
 			ray.pos,
 			ray.dir,
 			hitPoint
@@ -1275,7 +1275,7 @@ void MeshPrimitiveEvaluator::intersectionPointsWalk( TriangleBoundTree::NodeInde
 
 		if ( hit && vecDistance2( hitPoint, ray.pos ) < maxDistSqrd )
 		{
-			intersectionPointsWalk( TriangleBoundTree::lowChildIndex( nodeIndex ), ray, maxDistSqrd, results );
+			intersectionPointsWalk( m_tree->lowChildIndex( nodeIndex ), ray, maxDistSqrd, results );
 		}
 	}
 }
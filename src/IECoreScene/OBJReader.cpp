@@ -37,325 +37,994 @@
 
 #include "IECoreScene/MeshPrimitive.h"
 
-#include "IECore/CompoundData.h"
-#include "IECore/CompoundParameter.h"
 #include "IECore/FileNameParameter.h"
-#include "IECore/MessageHandler.h"
 #include "IECore/NullObject.h"
-#include "IECore/NumericParameter.h"
 #include "IECore/ObjectParameter.h"
-#include "IECore/SimpleTypedData.h"
-#include "IECore/TypedParameter.h"
 #include "IECore/VectorTypedData.h"
 
-#include "boost/bind/bind.hpp"
-#include "boost/version.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/format.hpp"
+#include "boost/iostreams/device/mapped_file.hpp"
 
-#if BOOST_VERSION >= 103600
-#define BOOST_SPIRIT_USE_OLD_NAMESPACE
-#include "boost/spirit/include/classic.hpp"
-#else
-#include "boost/spirit.hpp"
-#endif
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <fstream>
-#include <iostream>
-#include <iterator>
 
 using namespace std;
 using namespace IECore;
 using namespace IECoreScene;
 using namespace Imath;
-using namespace boost;
-using namespace boost::placeholders;
-using namespace boost::spirit;
 
 IE_CORE_DEFINERUNTIMETYPED(OBJReader);
 
-// syntactic sugar for specifying our grammar
-typedef boost::spirit::rule<boost::spirit::phrase_scanner_t> srule;
-
 const Reader::ReaderDescription<OBJReader> OBJReader::m_readerDescription("obj");
 
-OBJReader::OBJReader( const std::string &fileName )
-	: Reader( "Alias Wavefront OBJ 3D data reader", new ObjectParameter("result", "the loaded 3D object", new
-	NullObject, MeshPrimitive::staticTypeId()))
+//////////////////////////////////////////////////////////////////////////
+// Scanning utilities. These are hand written rather than using `strtof()`
+// and friends because they operate on ranges that aren't null terminated,
+// and avoid the locale lookups that dominate the standard functions.
+//////////////////////////////////////////////////////////////////////////
+
+namespace
 {
-	m_fileNameParameter->setTypedValue( fileName );
+
+inline bool isWhitespace( char c )
+{
+	return c == ' ' || c == '\t' || c == '\r';
 }
 
-bool OBJReader::canRead( const string &fileName )
+inline bool isDigit( char c )
 {
-	// there really are no magic numbers, .obj is a simple ascii text file
+	return c >= '0' && c <= '9';
+}
 
-	// so: enforce at least that the file has '.obj' extension
-	if(fileName.rfind(".obj") != fileName.length() - 4)
-		return false;
+inline const char *skipWhitespace( const char *p, const char *end )
+{
+	while( p != end && isWhitespace( *p ) )
+	{
+		++p;
+	}
+	return p;
+}
 
-	// attempt to open the file
-	ifstream in(fileName.c_str());
-	return in.is_open();
+inline const char *skipToWhitespace( const char *p, const char *end )
+{
+	while( p != end && !isWhitespace( *p ) )
+	{
+		++p;
+	}
+	return p;
 }
 
-ObjectPtr OBJReader::doOperation(const CompoundObject * operands)
+// Returns the end of the parsed integer, or `nullptr` if there
+// is no integer at `p`.
+inline const char *parseInt( const char *p, const char *end, int &result )
 {
-	// for now we are going to retrieve vertex, texture, normal coordinates, faces.
-	// later (when we have the primitives), we will handle a larger subset of the
-	// OBJ format
+	bool negative = false;
+	if( p != end && ( *p == '-' || *p == '+' ) )
+	{
+		negative = *p == '-';
+		++p;
+	}
+
+	if( p == end || !isDigit( *p ) )
+	{
+		return nullptr;
+	}
+
+	int value = 0;
+	for( ; p != end && isDigit( *p ); ++p )
+	{
+		value = value * 10 + ( *p - '0' );
+	}
 
-	IntVectorDataPtr vpf = new IntVectorData();
-	m_vpf = &vpf->writable();
+	result = negative ? -value : value;
+	return p;
+}
 
-	IntVectorDataPtr vids = new IntVectorData();
-	m_vids = &vids->writable();
+const double g_powersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
 
-	V3fVectorDataPtr vertices = new V3fVectorData();
-	m_vertices = &vertices->writable();
+// As above, but for floating point values. Accumulates up to 18
+// significant digits in an integer mantissa and applies the decimal
+// exponent at the end, which is more than sufficient precision for
+// the single precision result.
+inline const char *parseFloat( const char *p, const char *end, float &result )
+{
+	const char *start = p;
 
- 	// separate texture coordinates
-	FloatVectorDataPtr sTextureCoordinates = new FloatVectorData();
-	m_sTextureCoordinates = &sTextureCoordinates->writable();
+	bool negative = false;
+	if( p != end && ( *p == '-' || *p == '+' ) )
+	{
+		negative = *p == '-';
+		++p;
+	}
 
-	FloatVectorDataPtr tTextureCoordinates = new FloatVectorData();
-	m_tTextureCoordinates = &tTextureCoordinates->writable();
+	const uint64_t maxMantissa = 100000000000000000ull;
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	bool haveDigits = false;
 
-	// build normals
-	V3fVectorDataPtr normals = new V3fVectorData();
-	m_normals = &normals->writable();
+	for( ; p != end && isDigit( *p ); ++p )
+	{
+		haveDigits = true;
+		if( mantissa < maxMantissa )
+		{
+			mantissa = mantissa * 10 + ( *p - '0' );
+		}
+		else
+		{
+			exponent++;
+		}
+	}
 
-	// parse the file
-	parseOBJ();
+	if( p != end && *p == '.' )
+	{
+		++p;
+		for( ; p != end && isDigit( *p ); ++p )
+		{
+			haveDigits = true;
+			if( mantissa < maxMantissa )
+			{
+				mantissa = mantissa * 10 + ( *p - '0' );
+				exponent--;
+			}
+		}
+	}
 
-	// create our MeshPrimitive
-	MeshPrimitivePtr mesh = new MeshPrimitive( vpf, vids, "linear", vertices );
-	if( sTextureCoordinates->readable().size() )
+	if( !haveDigits )
 	{
-		mesh->variables.insert(PrimitiveVariableMap::value_type("s", PrimitiveVariable( PrimitiveVariable::FaceVarying, sTextureCoordinates)));
+		// Fall back to the standard library for the rare
+		// special cases like "nan" and "inf".
+		const char *tokenEnd = skipToWhitespace( start, end );
+		const string token( start, tokenEnd );
+		char *parseEnd = nullptr;
+		result = strtof( token.c_str(), &parseEnd );
+		if( parseEnd == token.c_str() )
+		{
+			return nullptr;
+		}
+		return start + ( parseEnd - token.c_str() );
+	}
 
+	if( p != end && ( *p == 'e' || *p == 'E' ) )
+	{
+		int e = 0;
+		if( const char *exponentEnd = parseInt( p + 1, end, e ) )
+		{
+			exponent += e;
+			p = exponentEnd;
+		}
 	}
-	if( tTextureCoordinates->readable().size() )
+
+	double value = (double)mantissa;
+	if( exponent < 0 )
 	{
-		mesh->variables.insert(PrimitiveVariableMap::value_type("t", PrimitiveVariable(  PrimitiveVariable::FaceVarying, tTextureCoordinates)));
+		value = -exponent <= 22 ? value / g_powersOfTen[-exponent] : value * pow( 10.0, exponent );
 	}
-	if( normals->readable().size() )
+	else if( exponent > 0 )
 	{
-		mesh->variables.insert(PrimitiveVariableMap::value_type("N", PrimitiveVariable(  PrimitiveVariable::FaceVarying, normals)));
+		value = exponent <= 22 ? value * g_powersOfTen[exponent] : value * pow( 10.0, exponent );
 	}
-	return mesh;
+
+	result = negative ? -value : value;
+	return p;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Chunk parsing
+//////////////////////////////////////////////////////////////////////////
 
-// parse a vertex
-void OBJReader::parseVertex(const char * begin, const char * end)
+// Chunks are sized so that there are plenty to distribute among threads,
+// while keeping the per-chunk overhead insignificant.
+const size_t g_chunkSize = 4 * 1024 * 1024;
+// Number of chunks parsed at a time by `readGroups()`.
+const size_t g_chunksPerBatch = 64;
+
+// The results of parsing a contiguous range of lines.
+struct Chunk
 {
-	vector<float> vec;
-	srule vertex = "v" >> real_p[append(vec)] >> real_p[append(vec)] >> real_p[append(vec)];
-	parse(begin, vertex, space_p);
-
-	// build v
-	V3f v;
-	v[0] = vec[0];
- 	v[1] = vec[1];
- 	v[2] = vec[2];
-
-	// add this vertex
-	m_vertices->push_back(v);
-}
 
-// parse a texture coordinate
-void OBJReader::parseTextureCoordinate(const char * begin, const char * end)
+	std::vector<V3f> positions;
+	std::vector<V2f> uvs;
+	std::vector<V3f> normals;
+
+	std::vector<int> verticesPerFace;
+	std::vector<int> vertexIds;
+	// These are only populated if the chunk contains faces with
+	// uvs or normals, in which case they match `vertexIds` in size.
+	// Missing values are stored as -1.
+	std::vector<int> uvIds;
+	std::vector<int> normalIds;
+
+	// OBJ allows negative indices, which are relative to the
+	// current end of the respective list. We can't resolve these
+	// until we know how many elements precede the chunk, so
+	// store them relative to the start of the chunk and record
+	// their positions so they can be fixed up when merging.
+	std::vector<size_t> relativeVertexIds;
+	std::vector<size_t> relativeUVIds;
+	std::vector<size_t> relativeNormalIds;
+
+	// The groups started within the chunk, as pairs of the
+	// index of the first face and the group name.
+	std::vector<std::pair<size_t, std::string>> groups;
+
+};
+
+[[noreturn]] void throwParseError( const char *lineBegin, const char *lineEnd )
 {
-	vector<float> vec;
-	srule vertex = "vt" >> real_p[append(vec)] >> real_p[append(vec)] >> *(real_p[append(vec)]);
-	parse(begin, vertex, space_p);
-
-	// build v
-	V3f vt;
-	vt[0] = vec[0];
- 	vt[1] = vec[1];
-	vt[2] = vec.size() == 3 ? vec[2] : 0.0f;
-
-	// add this texture coordinate
-	m_introducedTextureCoordinates.push_back(vt);
+	throw IECore::Exception(
+		boost::str( boost::format( "OBJReader : Error parsing statement \"%s\"" ) % string( lineBegin, lineEnd ) )
+	);
 }
 
-// parse a normal
-void OBJReader::parseNormal(const char * begin, const char * end)
+// Parses between `minComponents` and `maxComponents` floats into `result`.
+// Parsing stops at the first token which isn't a float, and any remaining
+// tokens on the line are ignored.
+void parseFloats( const char *p, const char *end, float *result, int minComponents, int maxComponents, const char *lineBegin )
 {
-	vector<float> vec;
-	srule vertex = "vn" >> real_p[append(vec)] >> real_p[append(vec)] >> real_p[append(vec)];
-	parse(begin, vertex, space_p);
-
-	// build v
-	V3f vn;
-	vn[0] = vec[0];
-	vn[1] = vec[1];
-	vn[2] = vec[2];
-
-	// add this normal
-	m_introducedNormals.push_back(vn);
+	for( int i = 0; i < maxComponents; ++i )
+	{
+		p = skipWhitespace( p, end );
+		float value = 0;
+		const char *valueEnd = p != end ? parseFloat( p, end, value ) : nullptr;
+		if( !valueEnd || ( valueEnd != end && !isWhitespace( *valueEnd ) ) )
+		{
+			if( i < minComponents )
+			{
+				throwParseError( lineBegin, end );
+			}
+			return;
+		}
+
+		result[i] = value;
+		p = valueEnd;
+	}
 }
 
-// parse face
-void OBJReader::parseFace(const char * begin, const char * end)
+// Parses a single "v", "v/vt", "v//vn" or "v/vt/vn" face vertex,
+// returning nullptr if `p` doesn't point to one. Throws if the vertex
+// is well formed but refers to index 0, which can't be resolved since
+// OBJ indices start at 1.
+const char *parseFaceVertex( const char *p, const char *end, int &v, int &vt, int &vn, const char *lineBegin )
 {
-	vector<int> vec;
-	vector<int> tvec;
-	vector<int> nvec;
-
-	srule entry = int_p[append(vec)] >>
-		(
-			("/" >> (int_p[append(tvec)] | epsilon_p) >> "/" >> (int_p[append(nvec)] | epsilon_p))
-			| epsilon_p
-		);
+	v = vt = vn = 0;
+	p = parseInt( p, end, v );
+	if( !p )
+	{
+		return nullptr;
+	}
 
-	srule face = "f"  >> entry >> entry >> entry >> *(entry);
-	parse(begin, face, space_p);
+	bool hasUV = false;
+	bool hasNormal = false;
+	if( p != end && *p == '/' )
+	{
+		++p;
+		if( p != end && *p != '/' )
+		{
+			p = parseInt( p, end, vt );
+			if( !p )
+			{
+				return nullptr;
+			}
+			hasUV = true;
+		}
+		if( p != end && *p == '/' )
+		{
+			p = parseInt( p + 1, end, vn );
+			if( !p )
+			{
+				return nullptr;
+			}
+			hasNormal = true;
+		}
+	}
 
-	// push back the degree of the face
-	m_vpf->push_back(vec.size());
+	if( p != end && !isWhitespace( *p ) )
+	{
+		return nullptr;
+	}
 
-	// merge in the edges.  we index from 0, so shift them down.
-	// also, vertices may be indexed negatively, in which case they are relative to
-	// the current set of vertices
-	for(vector<int>::const_iterator i = vec.begin(); i != vec.end(); ++i)
+	if( v == 0 || ( hasUV && vt == 0 ) || ( hasNormal && vn == 0 ) )
 	{
-		m_vids->push_back(*i > 0 ? *i - 1 : m_vertices->size() + *i);
+		throwParseError( lineBegin, end );
 	}
 
+	return p;
+}
 
-	// merge in texture coordinates and normals, if present
-	// OBJ format requires an encoding for faces which uses one of the vertex/texture/normal specifications
-	// consistently across the entire face.  eg. we can have all v/vt/vn, or all v//vn, or all v, but not
-	// v//vn then v/vt/vn ...
-	if(!nvec.empty())
+void appendIndex( int index, size_t count, std::vector<int> &ids, std::vector<size_t> &relativeIds )
+{
+	if( index > 0 )
 	{
-		if(nvec.size() != vec.size())
-			throw Exception("invalid face specification");
+		ids.push_back( index - 1 );
+	}
+	else
+	{
+		// Validity of the resolved index is checked when merging.
+		relativeIds.push_back( ids.size() );
+		ids.push_back( (int)count + index );
+	}
+}
+
+void parseFace( const char *p, const char *end, Chunk &chunk, const char *lineBegin )
+{
+	const size_t firstVertex = chunk.vertexIds.size();
+	bool hasUVs = false;
+	bool hasNormals = false;
+
+	int numVertices = 0;
+	while( true )
+	{
+		p = skipWhitespace( p, end );
+		if( p == end )
+		{
+			break;
+		}
+
+		// As with `parseFloats()`, parsing stops at the first token which
+		// isn't a vertex, and the remainder of the line is ignored.
+		int v, vt, vn;
+		const char *vertexEnd = parseFaceVertex( p, end, v, vt, vn, lineBegin );
+		if( !vertexEnd )
+		{
+			break;
+		}
+		p = vertexEnd;
+
+		// OBJ requires that a face uses the same form of vertex
+		// specification for all its vertices.
+		if( numVertices == 0 )
+		{
+			hasUVs = vt != 0;
+			hasNormals = vn != 0;
+		}
+		else if( hasUVs != ( vt != 0 ) || hasNormals != ( vn != 0 ) )
+		{
+			throw IECore::Exception(
+				boost::str( boost::format( "OBJReader : Invalid face specification \"%s\"" ) % string( lineBegin, end ) )
+			);
+		}
+
+		appendIndex( v, chunk.positions.size(), chunk.vertexIds, chunk.relativeVertexIds );
+
+		if( hasUVs )
+		{
+			if( chunk.uvIds.empty() )
+			{
+				chunk.uvIds.resize( firstVertex + numVertices, -1 );
+			}
+			appendIndex( vt, chunk.uvs.size(), chunk.uvIds, chunk.relativeUVIds );
+		}
+		else if( chunk.uvIds.size() )
+		{
+			chunk.uvIds.push_back( -1 );
+		}
 
-		// copy in these references to normal vectors to the mesh's normal vector
-		for(vector<int>::const_iterator i = nvec.begin(); i != nvec.end(); ++i)
+		if( hasNormals )
 		{
-			m_normals->push_back(m_introducedNormals[*i > 0 ? *i - 1 : m_introducedNormals.size() + *i]);
+			if( chunk.normalIds.empty() )
+			{
+				chunk.normalIds.resize( firstVertex + numVertices, -1 );
+			}
+			appendIndex( vn, chunk.normals.size(), chunk.normalIds, chunk.relativeNormalIds );
 		}
+		else if( chunk.normalIds.size() )
+		{
+			chunk.normalIds.push_back( -1 );
+		}
+
+		numVertices++;
 	}
-	// otherwise, check if we have specified normals in some previous face
-	// if so, and no normals were given here (examples, encoders that do this?), pump in
-	// default normal.  the default normal defined here is the zero normal, which is by
-	// definition orthogonal to every other vector.  this might result in odd lighting.
-	else
+
+	if( numVertices < 3 )
 	{
-		V3f zero(0.0f, 0.0f, 0.0f);
-		for(unsigned int i = 0; i < nvec.size(); ++i)
+		throwParseError( lineBegin, end );
+	}
+
+	chunk.verticesPerFace.push_back( numVertices );
+}
+
+void parseLine( const char *begin, const char *end, Chunk &chunk )
+{
+	// Comments may start anywhere on a line, and extend to its end.
+	if( const char *comment = static_cast<const char *>( memchr( begin, '#', end - begin ) ) )
+	{
+		end = comment;
+	}
+
+	const char *p = skipWhitespace( begin, end );
+	if( p == end )
+	{
+		return;
+	}
+
+	const char *keywordEnd = skipToWhitespace( p, end );
+	const size_t keywordLength = keywordEnd - p;
+
+	if( keywordLength == 1 && *p == 'v' )
+	{
+		V3f v( 0 );
+		parseFloats( keywordEnd, end, v.getValue(), 3, 3, begin );
+		chunk.positions.push_back( v );
+	}
+	else if( keywordLength == 2 && p[0] == 'v' && p[1] == 't' )
+	{
+		V2f vt( 0 );
+		parseFloats( keywordEnd, end, vt.getValue(), 1, 2, begin );
+		chunk.uvs.push_back( vt );
+	}
+	else if( keywordLength == 2 && p[0] == 'v' && p[1] == 'n' )
+	{
+		V3f vn( 0 );
+		parseFloats( keywordEnd, end, vn.getValue(), 3, 3, begin );
+		chunk.normals.push_back( vn );
+	}
+	else if( keywordLength == 1 && *p == 'f' )
+	{
+		parseFace( keywordEnd, end, chunk, begin );
+	}
+	else if( keywordLength == 1 && *p == 'g' )
+	{
+		const char *nameBegin = skipWhitespace( keywordEnd, end );
+		const char *nameEnd = end;
+		while( nameEnd != nameBegin && isWhitespace( nameEnd[-1] ) )
 		{
-			m_normals->push_back(zero);
+			--nameEnd;
 		}
+		// From http://paulbourke.net/dataformats/obj/ :
+		// The default group name is default.
+		chunk.groups.push_back(
+			{ chunk.verticesPerFace.size(), nameBegin != nameEnd ? string( nameBegin, nameEnd ) : string( "default" ) }
+		);
 	}
 
-	//
-	// merge in texture coordinates, if present
-	//
-	if(!tvec.empty())
+	// Other statements (objects, materials, smoothing groups, free-form
+	// geometry etc) are not supported, and are ignored.
+}
+
+void parseChunk( const char *begin, const char *end, Chunk &chunk )
+{
+	const char *p = begin;
+	while( p < end )
 	{
-		if(tvec.size() != vec.size())
-			throw Exception("invalid face specification");
+		const char *lineEnd = static_cast<const char *>( memchr( p, '\n', end - p ) );
+		if( !lineEnd )
+		{
+			lineEnd = end;
+		}
+		parseLine( p, lineEnd, chunk );
+		p = lineEnd + 1;
+	}
+}
 
-		for(unsigned int i = 0; i < tvec.size(); ++i)
+// Splits the file into ranges of approximately `g_chunkSize`,
+// with each range ending on a line boundary.
+std::vector<std::pair<const char *, const char *>> chunkRanges( const char *begin, const char *end )
+{
+	std::vector<std::pair<const char *, const char *>> result;
+	const char *p = begin;
+	while( p < end )
+	{
+		const char *chunkEnd = end;
+		if( (size_t)( end - p ) > g_chunkSize )
 		{
-			int index = tvec[i] > 0 ? tvec[i] - 1 : m_introducedTextureCoordinates.size() + tvec[i];
-			m_sTextureCoordinates->push_back(m_introducedTextureCoordinates[index][0]);
-			m_tTextureCoordinates->push_back(m_introducedTextureCoordinates[index][1]);
+			chunkEnd = static_cast<const char *>( memchr( p + g_chunkSize, '\n', end - p - g_chunkSize ) );
+			chunkEnd = chunkEnd ? chunkEnd + 1 : end;
 		}
+		result.push_back( { p, chunkEnd } );
+		p = chunkEnd;
 	}
-	else
+	return result;
+}
+
+void parseChunks( const std::vector<std::pair<const char *, const char *>> &ranges, size_t begin, size_t end, std::vector<Chunk> &chunks )
+{
+	chunks.clear();
+	chunks.resize( end - begin );
+
+	tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( begin, end, 1 ),
+		[&ranges, &chunks, begin]( const tbb::blocked_range<size_t> &r ) {
+			for( size_t i = r.begin(); i != r.end(); ++i )
+			{
+				parseChunk( ranges[i].first, ranges[i].second, chunks[i-begin] );
+			}
+		},
+		taskGroupContext
+	);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Merging
+//////////////////////////////////////////////////////////////////////////
+
+// Copies `ids` to `result`, converting chunk-relative indices to file-relative
+// ones by adding `offset`, and returns the largest resulting index, or -1 if
+// there are none. Positive indices may refer to vertices defined anywhere in
+// the file, so it is up to the caller to check the result with `checkIndex()`
+// once the number of vertices is known.
+int resolveIndices( const std::vector<int> &ids, const std::vector<size_t> &relativeIds, size_t offset, int *result )
+{
+	std::copy( ids.begin(), ids.end(), result );
+	for( auto i : relativeIds )
 	{
-		for(unsigned int i = 0; i < tvec.size(); ++i)
+		result[i] += offset;
+		if( result[i] < 0 )
 		{
-			m_sTextureCoordinates->push_back(0.0f);
-			m_tTextureCoordinates->push_back(0.0f);
+			throw IECore::Exception( "OBJReader : Relative index out of range" );
 		}
 	}
+
+	int maxIndex = -1;
+	for( size_t i = 0, e = ids.size(); i < e; ++i )
+	{
+		maxIndex = std::max( maxIndex, result[i] );
+	}
+	return maxIndex;
 }
 
-void OBJReader::parseGroup(const char *begin, const char *end)
+void checkIndex( int maxIndex, size_t size )
 {
-	// set current group
-	vector<string> groupNames;
-	srule grouping = "g" >> *(lexeme_d[alnum_p >> *(alnum_p)][append(groupNames)]);
+	if( maxIndex >= (int)size )
+	{
+		throw IECore::Exception( boost::str( boost::format( "OBJReader : Index %d out of range" ) % ( maxIndex + 1 ) ) );
+	}
+}
 
-	parse(begin, grouping, space_p);
+// Builds a mesh, converting uvs and normals to the "s", "t" and "N"
+// FaceVarying primitive variables.
+MeshPrimitivePtr buildMesh(
+	IntVectorDataPtr verticesPerFace, IntVectorDataPtr vertexIds, V3fVectorDataPtr positions,
+	const std::vector<int> &uvIds, const std::vector<V2f> &uvs,
+	const std::vector<int> &normalIds, const std::vector<V3f> &normals
+)
+{
+	MeshPrimitivePtr mesh = new MeshPrimitive( verticesPerFace, vertexIds, "linear", positions );
+
+	if( uvIds.size() )
+	{
+		FloatVectorDataPtr sData = new FloatVectorData;
+		FloatVectorDataPtr tData = new FloatVectorData;
+		std::vector<float> &s = sData->writable();
+		std::vector<float> &t = tData->writable();
+		s.resize( uvIds.size() );
+		t.resize( uvIds.size() );
+
+		tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+		tbb::parallel_for(
+			tbb::blocked_range<size_t>( 0, uvIds.size() ),
+			[&]( const tbb::blocked_range<size_t> &r ) {
+				for( size_t i = r.begin(); i != r.end(); ++i )
+				{
+					const V2f uv = uvIds[i] >= 0 ? uvs[uvIds[i]] : V2f( 0 );
+					s[i] = uv[0];
+					t[i] = uv[1];
+				}
+			},
+			taskGroupContext
+		);
+
+		mesh->variables["s"] = PrimitiveVariable( PrimitiveVariable::FaceVarying, sData );
+		mesh->variables["t"] = PrimitiveVariable( PrimitiveVariable::FaceVarying, tData );
+	}
+
+	if( normalIds.size() )
+	{
+		// Faces without normals receive the zero normal, which is
+		// orthogonal to everything, and may result in odd lighting.
+		V3fVectorDataPtr nData = new V3fVectorData;
+		std::vector<V3f> &n = nData->writable();
+		n.resize( normalIds.size() );
+
+		tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+		tbb::parallel_for(
+			tbb::blocked_range<size_t>( 0, normalIds.size() ),
+			[&]( const tbb::blocked_range<size_t> &r ) {
+				for( size_t i = r.begin(); i != r.end(); ++i )
+				{
+					n[i] = normalIds[i] >= 0 ? normals[normalIds[i]] : V3f( 0 );
+				}
+			},
+			taskGroupContext
+		);
+
+		mesh->variables["N"] = PrimitiveVariable( PrimitiveVariable::FaceVarying, nData );
+	}
+
+	return mesh;
+}
+
+// Merges all the chunks into a single mesh, using a parallel
+// pass over the chunks once their offsets have been computed.
+MeshPrimitivePtr mergeChunks( const std::vector<Chunk> &chunks )
+{
+	struct Offsets
+	{
+		size_t positions = 0;
+		size_t uvs = 0;
+		size_t normals = 0;
+		size_t faces = 0;
+		size_t faceVertices = 0;
+	};
 
-	// from 'http://local.wasp.uwa.edu.au/~pbourke/dataformats/obj/':
-	// The default group name is default.
-	if(groupNames.empty())
+	std::vector<Offsets> offsets( chunks.size() + 1 );
+	bool haveUVs = false;
+	bool haveNormals = false;
+	for( size_t i = 0; i < chunks.size(); ++i )
 	{
-		groupNames.push_back("default");
+		const Chunk &c = chunks[i];
+		offsets[i+1].positions = offsets[i].positions + c.positions.size();
+		offsets[i+1].uvs = offsets[i].uvs + c.uvs.size();
+		offsets[i+1].normals = offsets[i].normals + c.normals.size();
+		offsets[i+1].faces = offsets[i].faces + c.verticesPerFace.size();
+		offsets[i+1].faceVertices = offsets[i].faceVertices + c.vertexIds.size();
+		haveUVs = haveUVs || c.uvIds.size();
+		haveNormals = haveNormals || c.normalIds.size();
 	}
 
-	// \todo associate mesh objects with group names
+	const Offsets &totals = offsets.back();
+
+	V3fVectorDataPtr positionsData = new V3fVectorData;
+	std::vector<V3f> &positions = positionsData->writable();
+	positions.resize( totals.positions );
+
+	std::vector<V2f> uvs( totals.uvs );
+	std::vector<V3f> normals( totals.normals );
+
+	IntVectorDataPtr verticesPerFaceData = new IntVectorData;
+	std::vector<int> &verticesPerFace = verticesPerFaceData->writable();
+	verticesPerFace.resize( totals.faces );
+
+	IntVectorDataPtr vertexIdsData = new IntVectorData;
+	std::vector<int> &vertexIds = vertexIdsData->writable();
+	vertexIds.resize( totals.faceVertices );
+
+	std::vector<int> uvIds( haveUVs ? totals.faceVertices : 0 );
+	std::vector<int> normalIds( haveNormals ? totals.faceVertices : 0 );
+
+	tbb::task_group_context taskGroupContext( tbb::task_group_context::isolated );
+	tbb::parallel_for(
+		tbb::blocked_range<size_t>( 0, chunks.size(), 1 ),
+		[&]( const tbb::blocked_range<size_t> &r ) {
+			for( size_t i = r.begin(); i != r.end(); ++i )
+			{
+				const Chunk &c = chunks[i];
+				const Offsets &o = offsets[i];
+
+				std::copy( c.positions.begin(), c.positions.end(), positions.begin() + o.positions );
+				std::copy( c.uvs.begin(), c.uvs.end(), uvs.begin() + o.uvs );
+				std::copy( c.normals.begin(), c.normals.end(), normals.begin() + o.normals );
+				std::copy( c.verticesPerFace.begin(), c.verticesPerFace.end(), verticesPerFace.begin() + o.faces );
+
+				checkIndex( resolveIndices( c.vertexIds, c.relativeVertexIds, o.positions, vertexIds.data() + o.faceVertices ), totals.positions );
+
+				if( haveUVs )
+				{
+					if( c.uvIds.size() )
+					{
+						checkIndex( resolveIndices( c.uvIds, c.relativeUVIds, o.uvs, uvIds.data() + o.faceVertices ), totals.uvs );
+					}
+					else
+					{
+						std::fill( uvIds.begin() + o.faceVertices, uvIds.begin() + offsets[i+1].faceVertices, -1 );
+					}
+				}
+
+				if( haveNormals )
+				{
+					if( c.normalIds.size() )
+					{
+						checkIndex( resolveIndices( c.normalIds, c.relativeNormalIds, o.normals, normalIds.data() + o.faceVertices ), totals.normals );
+					}
+					else
+					{
+						std::fill( normalIds.begin() + o.faceVertices, normalIds.begin() + offsets[i+1].faceVertices, -1 );
+					}
+				}
+			}
+		},
+		taskGroupContext
+	);
+
+	return buildMesh( verticesPerFaceData, vertexIdsData, positionsData, uvIds, uvs, normalIds, normals );
 }
 
-void OBJReader::parseOBJ() {
-
-	srule comment = comment_p("#");
-
-	// see
-	// http://local.wasp.uwa.edu.au/~pbourke/dataformats/obj/
-
-	// vertices
-	srule vertex         = ("v"  >> real_p >> real_p >> real_p) [bind(&OBJReader::parseVertex,            this, _1, _2)];
-	srule vertex_texture = ("vt" >> real_p >> real_p)           [bind(&OBJReader::parseTextureCoordinate, this, _1, _2)];
-	srule vertex_normal  = ("vn" >> real_p >> real_p >> real_p) [bind(&OBJReader::parseNormal,            this, _1, _2)];
-	//srule vertex_parameter_space  = "vp" >> real_p >> real_p >> real_p;
-
-	// srule cs_types = ("bmatrix" | "bezier" | "bspline" | "cardinal" | "taylor");
-	// srule vertex_curve_or_surface = "cstype" >> "rat" >> cs_types;
-	// srule vertex_degree  = "deg" >> real_p >> real_p;
-	// srule vertex_basis_matrix  = "bmat";
-	// srule vertex_step_size  = "step" >> int_p >> int_p;
-	srule vertex_type = vertex | vertex_texture | vertex_normal;
-
-	// elements
-	srule point = "p" >> real_p >> *(real_p);
-	srule  line = "l" >> int_p >> int_p >> *(int_p);
-	srule  face = (ch_p('f') >> *(anychar_p))[bind(&OBJReader::parseFace, this, _1, _2)];
-	// srule curve = "curv";
-	// srule curve_2d = "curv2";
-	// srule surface = "surf";
-	srule element = point | line | face;
-
- 	// free-form curve / surface statements
-	// srule parameter = "parm";
-	// srule trim_loop = "trim";
-	// srule hole_loop = "hole";
-	// srule special_curve = "scrv";
-	// srule special_point = "sp";
-	// srule end_statement = "end";
-
-	// connectivity
-	//srule connect = "con";
-
-	// grouping
-	srule group_name = ("g" >> *(anychar_p))[bind(&OBJReader::parseGroup, this, _1, _2)];
-	//	srule smoothing_group = "s";
-	//	srule merging_group = "mg";
-	srule object_name = "o" >> int_p;
-	srule grouping = group_name | object_name;
-
-	// display and render attributes
-	// srule bevel_interpretation = "bevel";
-	// srule color_interpolation = "c_interp";
-	// srule dissolve_interpolation = "d_interp";
-	// srule level_of_detail = "lod";
-	// srule material_name = "usemtl";
-	// srule material_library = "mtllib";
-	// srule shadow_casting = "shadow_obj";
-	// srule ray_tracing = "trace_obj";
-	// srule curve_approximation_technique = "ctech";
-	// srule surface_approximation_technique = "stech";
-
-	ifstream in(fileName().c_str());
-	string str;
-	while(getline(in, str))
-		parse(str.c_str(), vertex_type | element | grouping | comment, space_p);
+// Accumulates chunks in file order, emitting a mesh each time
+// a group ends. Vertex data is retained for the whole file, since
+// faces may reference any vertex. Faces may also reference vertices
+// which haven't been parsed yet, in which case their group is held
+// back until the vertices arrive, so that the same files are accepted
+// as by `mergeChunks()`.
+class GroupStream
+{
+
+	public :
+
+		GroupStream( const OBJReader::GroupFunction &groupFunction )
+			:	m_groupFunction( groupFunction )
+		{
+			m_groups.emplace_back( "default" );
+		}
+
+		void append( const Chunk &chunk )
+		{
+			const size_t positionsOffset = m_positions.size();
+			const size_t uvsOffset = m_uvs.size();
+			const size_t normalsOffset = m_normals.size();
+
+			m_positions.insert( m_positions.end(), chunk.positions.begin(), chunk.positions.end() );
+			m_uvs.insert( m_uvs.end(), chunk.uvs.begin(), chunk.uvs.end() );
+			m_normals.insert( m_normals.end(), chunk.normals.begin(), chunk.normals.end() );
+
+			std::vector<int> vertexIds( chunk.vertexIds.size() );
+			resolveIndices( chunk.vertexIds, chunk.relativeVertexIds, positionsOffset, vertexIds.data() );
+
+			std::vector<int> uvIds( chunk.uvIds.size() );
+			resolveIndices( chunk.uvIds, chunk.relativeUVIds, uvsOffset, uvIds.data() );
+
+			std::vector<int> normalIds( chunk.normalIds.size() );
+			resolveIndices( chunk.normalIds, chunk.relativeNormalIds, normalsOffset, normalIds.data() );
+
+			auto groupIt = chunk.groups.begin();
+			size_t faceVertexIndex = 0;
+			for( size_t faceIndex = 0; faceIndex <= chunk.verticesPerFace.size(); ++faceIndex )
+			{
+				for( ; groupIt != chunk.groups.end() && groupIt->first == faceIndex; ++groupIt )
+				{
+					if( m_groups.back().verticesPerFace.empty() )
+					{
+						m_groups.back().name = groupIt->second;
+					}
+					else
+					{
+						m_groups.emplace_back( groupIt->second );
+					}
+				}
+
+				if( faceIndex == chunk.verticesPerFace.size() )
+				{
+					break;
+				}
+
+				Group &group = m_groups.back();
+				const int numVertices = chunk.verticesPerFace[faceIndex];
+				group.verticesPerFace.push_back( numVertices );
+				for( int i = 0; i < numVertices; ++i, ++faceVertexIndex )
+				{
+					group.vertexIds.push_back( vertexIds[faceVertexIndex] );
+					group.maxVertexId = std::max( group.maxVertexId, vertexIds[faceVertexIndex] );
+					appendOptionalIndex( uvIds, faceVertexIndex, group.uvIds, group.hasUVs, group.maxUVId );
+					appendOptionalIndex( normalIds, faceVertexIndex, group.normalIds, group.hasNormals, group.maxNormalId );
+				}
+			}
+
+			emitCompleteGroups( /* final = */ false );
+		}
+
+		// Must be called after the last chunk has been appended, to emit
+		// the last group. Throws if any group refers to vertices which
+		// were never defined.
+		void finish()
+		{
+			emitCompleteGroups( /* final = */ true );
+		}
+
+	private :
+
+		struct Group
+		{
+			Group( const std::string &name )
+				:	name( name )
+			{
+			}
+
+			std::string name;
+			std::vector<int> verticesPerFace;
+			std::vector<int> vertexIds;
+			std::vector<int> uvIds;
+			std::vector<int> normalIds;
+			bool hasUVs = false;
+			bool hasNormals = false;
+			int maxVertexId = -1;
+			int maxUVId = -1;
+			int maxNormalId = -1;
+		};
+
+		static void appendOptionalIndex( const std::vector<int> &chunkIds, size_t index, std::vector<int> &groupIds, bool &groupHasIds, int &groupMaxId )
+		{
+			const int id = chunkIds.size() ? chunkIds[index] : -1;
+			groupIds.push_back( id );
+			groupHasIds = groupHasIds || id != -1;
+			groupMaxId = std::max( groupMaxId, id );
+		}
+
+		// Emits groups in order for as long as their vertices are available.
+		// The last group is only emitted when `final` is true, since it may
+		// still be receiving faces.
+		void emitCompleteGroups( bool final )
+		{
+			while( m_groups.size() > ( final ? 0 : 1 ) )
+			{
+				const Group &group = m_groups.front();
+				if(
+					group.maxVertexId >= (int)m_positions.size() ||
+					group.maxUVId >= (int)m_uvs.size() ||
+					group.maxNormalId >= (int)m_normals.size()
+				)
+				{
+					if( !final )
+					{
+						return;
+					}
+					checkIndex( group.maxVertexId, m_positions.size() );
+					checkIndex( group.maxUVId, m_uvs.size() );
+					checkIndex( group.maxNormalId, m_normals.size() );
+				}
+
+				if( group.verticesPerFace.size() )
+				{
+					const std::string name = group.name;
+					MeshPrimitivePtr mesh = buildGroupMesh( group );
+					m_groups.pop_front();
+					m_groupFunction( name, mesh );
+				}
+				else
+				{
+					m_groups.pop_front();
+				}
+			}
+		}
+
+		// Compacts the vertices so that the mesh only contains
+		// those referenced by the group.
+		MeshPrimitivePtr buildGroupMesh( const Group &group )
+		{
+			m_vertexRemap.resize( m_positions.size(), -1 );
+
+			V3fVectorDataPtr positionsData = new V3fVectorData;
+			std::vector<V3f> &positions = positionsData->writable();
+
+			IntVectorDataPtr vertexIdsData = new IntVectorData;
+			std::vector<int> &vertexIds = vertexIdsData->writable();
+			vertexIds.reserve( group.vertexIds.size() );
+
+			for( auto id : group.vertexIds )
+			{
+				int &remapped = m_vertexRemap[id];
+				if( remapped == -1 )
+				{
+					remapped = positions.size();
+					positions.push_back( m_positions[id] );
+				}
+				vertexIds.push_back( remapped );
+			}
+
+			for( auto id : group.vertexIds )
+			{
+				m_vertexRemap[id] = -1;
+			}
+
+			IntVectorDataPtr verticesPerFaceData = new IntVectorData( group.verticesPerFace );
+			return buildMesh(
+				verticesPerFaceData, vertexIdsData, positionsData,
+				group.hasUVs ? group.uvIds : std::vector<int>(), m_uvs,
+				group.hasNormals ? group.normalIds : std::vector<int>(), m_normals
+			);
+		}
+
+		const OBJReader::GroupFunction &m_groupFunction;
+
+		std::vector<V3f> m_positions;
+		std::vector<V2f> m_uvs;
+		std::vector<V3f> m_normals;
+		std::vector<int> m_vertexRemap;
+
+		// Groups which haven't been emitted yet. The last is the
+		// one currently receiving faces.
+		std::deque<Group> m_groups;
+
+};
+
+// Memory maps a file, taking care of the empty file
+// case, which can't be mapped.
+class MappedFile
+{
+
+	public :
+
+		MappedFile( const std::string &fileName )
+		{
+			if( boost::filesystem::file_size( fileName ) )
+			{
+				m_file.open( fileName );
+			}
+		}
+
+		const char *begin() const
+		{
+			return m_file.is_open() ? m_file.data() : nullptr;
+		}
+
+		const char *end() const
+		{
+			return m_file.is_open() ? m_file.data() + m_file.size() : nullptr;
+		}
+
+	private :
+
+		boost::iostreams::mapped_file_source m_file;
+
+};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// OBJReader
+//////////////////////////////////////////////////////////////////////////
+
+OBJReader::OBJReader( const std::string &fileName )
+	: Reader( "Alias Wavefront OBJ 3D data reader", new ObjectParameter("result", "the loaded 3D object", new
+	NullObject, MeshPrimitive::staticTypeId()))
+{
+	m_fileNameParameter->setTypedValue( fileName );
+}
+
+bool OBJReader::canRead( const string &fileName )
+{
+	// there really are no magic numbers, .obj is a simple ascii text file
+
+	// so: enforce at least that the file has '.obj' extension
+	if(fileName.rfind(".obj") != fileName.length() - 4)
+		return false;
+
+	// attempt to open the file
+	ifstream in(fileName.c_str());
+	return in.is_open();
+}
+
+ObjectPtr OBJReader::doOperation(const CompoundObject * operands)
+{
+	// for now we are going to retrieve vertex, texture, normal coordinates, faces.
+	// later (when we have the primitives), we will handle a larger subset of the
+	// OBJ format
+
+	MappedFile file( fileName() );
+	const auto ranges = chunkRanges( file.begin(), file.end() );
+
+	std::vector<Chunk> chunks;
+	parseChunks( ranges, 0, ranges.size(), chunks );
+
+	return mergeChunks( chunks );
+}
+
+void OBJReader::readGroups( const GroupFunction &groupFunction )
+{
+	MappedFile file( fileName() );
+	const auto ranges = chunkRanges( file.begin(), file.end() );
+
+	GroupStream stream( groupFunction );
+	std::vector<Chunk> chunks;
+	for( size_t batchBegin = 0; batchBegin < ranges.size(); batchBegin += g_chunksPerBatch )
+	{
+		const size_t batchEnd = std::min( batchBegin + g_chunksPerBatch, ranges.size() );
+		parseChunks( ranges, batchBegin, batchEnd, chunks );
+		for( const auto &chunk : chunks )
+		{
+			stream.append( chunk );
+		}
+	}
+
+	stream.finish();
 }
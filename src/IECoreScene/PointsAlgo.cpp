@@ -110,45 +110,47 @@ struct PointsUniformToVertex
 template<typename T>
 PointsPrimitivePtr deletePoints( const PointsPrimitive *pointsPrimitive, IECoreScene::PrimitiveVariable::IndexedView<T>& deleteFlagView, bool invert, const Canceller *canceller )
 {
-	PointsPrimitivePtr outPointsPrimitive = new PointsPrimitive( 0 );
-
-	IECoreScene::PrimitiveVariableAlgos::DeleteFlaggedUniformFunctor<T> vertexFunctor( deleteFlagView, invert );
-
-	for( PrimitiveVariableMap::const_iterator it = pointsPrimitive->variables.begin(), e = pointsPrimitive->variables.end(); it != e; ++it )
+	for( const auto &p : pointsPrimitive->variables )
 	{
-		Canceller::check( canceller );
-		switch( it->second.interpolation )
+		switch( p.second.interpolation )
 		{
 			case PrimitiveVariable::Vertex:
 			case PrimitiveVariable::Varying:
 			case PrimitiveVariable::FaceVarying:
-			{
-				if( !pointsPrimitive->isPrimitiveVariableValid( it->second ) )
+				if( !pointsPrimitive->isPrimitiveVariableValid( p.second ) )
 				{
 					throw InvalidArgumentException(
-						boost::str ( boost::format( "PointsAlgo::deletePoints cannot process invalid primitive variable \"%s\"" ) % it->first ) );
+						boost::str ( boost::format( "PointsAlgo::deletePoints cannot process invalid primitive variable \"%s\"" ) % p.first ) );
 				}
-				const IECore::Data *inputData = it->second.data.get();
-				vertexFunctor.setIndices( it->second.indices.get() );
-				IECoreScene::PrimitiveVariableAlgos::IndexedData indexedData = dispatch( inputData, vertexFunctor );
-				outPointsPrimitive->variables[it->first] = PrimitiveVariable( it->second.interpolation, indexedData.data, indexedData.indices );
 				break;
-			}
-			case PrimitiveVariable::Uniform:
-			case PrimitiveVariable::Constant:
-			case PrimitiveVariable::Invalid:
-			{
-				outPointsPrimitive->variables[it->first] = it->second;
+			default :
 				break;
-			}
 		}
 	}
 
-	V3fVectorDataPtr positionData = outPointsPrimitive->variableData<V3fVectorData>( "P" );
-	if( positionData )
-	{
-		outPointsPrimitive->setNumPoints( positionData->readable().size() );
-	}
+	const std::vector<int> keptPoints = IECoreScene::PrimitiveVariableAlgos::keptElements(
+		pointsPrimitive->getNumPoints(),
+		[&]( size_t i ) { return IECoreScene::PrimitiveVariableAlgos::keepFlagged( deleteFlagView[i], invert ); },
+		canceller
+	);
+
+	PointsPrimitivePtr outPointsPrimitive = new PointsPrimitive( keptPoints.size() );
+
+	IECoreScene::PrimitiveVariableAlgos::compactPrimitiveVariables(
+		pointsPrimitive->variables, outPointsPrimitive->variables,
+		[&]( PrimitiveVariable::Interpolation interpolation ) -> const std::vector<int> * {
+			switch( interpolation )
+			{
+				case PrimitiveVariable::Vertex :
+				case PrimitiveVariable::Varying :
+				case PrimitiveVariable::FaceVarying :
+					return &keptPoints;
+				default :
+					return nullptr;
+			}
+		},
+		canceller
+	);
 
 	return outPointsPrimitive;
 }
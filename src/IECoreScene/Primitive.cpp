@@ -374,24 +374,29 @@ void Primitive::load( IECore::Object::LoadContextPtr context )
 	variables.clear();
 	IndexedIO::EntryIDList names;
 	ioVariables->entryIds( names, IndexedIO::Directory );
-	IndexedIO::EntryIDList::const_iterator it;
-	for( it=names.begin(); it!=names.end(); it++ )
-	{
-		ConstIndexedIOPtr ioPrimVar = ioVariables->subdirectory( *it );
-		int i;
-		ioPrimVar->read( g_interpolationEntry, i );
 
-		Canceller::check( canceller );
-		IntVectorDataPtr indices = nullptr;
-		if( ioPrimVar->hasEntry( g_indicesEntry ) )
-		{
-			indices = context->load<IntVectorData>( ioPrimVar.get(), g_indicesEntry );
+	std::vector<PrimitiveVariable> loadedVariables( names.size() );
+	context->parallelFor(
+		names.size(),
+		[&]( size_t j ) {
+			ConstIndexedIOPtr ioPrimVar = ioVariables->subdirectory( names[j] );
+			int i;
+			ioPrimVar->read( g_interpolationEntry, i );
+
+			IntVectorDataPtr indices = nullptr;
+			if( ioPrimVar->hasEntry( g_indicesEntry ) )
+			{
+				indices = context->load<IntVectorData>( ioPrimVar.get(), g_indicesEntry );
+			}
+
+			Canceller::check( canceller );
+			loadedVariables[j] = PrimitiveVariable( (PrimitiveVariable::Interpolation)i, context->load<Data>( ioPrimVar.get(), g_dataEntry ), indices );
 		}
+	);
 
-		Canceller::check( canceller );
-		variables.insert(
-			PrimitiveVariableMap::value_type( *it, PrimitiveVariable( (PrimitiveVariable::Interpolation)i, context->load<Data>( ioPrimVar.get(), g_dataEntry ), indices ) )
-		);
+	for( size_t j = 0; j < names.size(); ++j )
+	{
+		variables.insert( PrimitiveVariableMap::value_type( names[j], loadedVariables[j] ) );
 	}
 
 	if( v < 2 )
@@ -34,6 +34,7 @@
 
 #include "IECoreScene/SceneCache.h"
 
+#include "SceneCacheEncoding.h"
 #include "TagSetAlgo.h"
 
 #include "IECoreScene/Primitive.h"
@@ -42,6 +43,7 @@
 #include "IECoreScene/VisibleRenderable.h"
 
 #include "IECore/ComputationCache.h"
+#include "IECore/DataAlgo.h"
 #include "IECore/FileIndexedIO.h"
 #include "IECore/HeaderGenerator.h"
 #include "IECore/MessageHandler.h"
@@ -49,6 +51,7 @@
 #include "IECore/SimpleTypedData.h"
 #include "IECore/TransformationMatrixData.h"
 #include "IECore/PathMatcherData.h"
+#include "IECore/VectorTypedData.h"
 
 #include "OpenEXR/OpenEXRConfig.h"
 #if OPENEXR_VERSION_MAJOR < 3
@@ -66,6 +69,7 @@ using namespace IECore;
 using namespace IECoreScene;
 using namespace Imath;
 using namespace boost;
+using namespace IECoreScene::Private::SceneCacheEncoding;
 
 IE_CORE_DEFINERUNTIMETYPEDDESCRIPTION( SceneCache )
 
@@ -94,6 +98,13 @@ static InternedString ancestorTagsEntry("ancestorTags");
 static InternedString descendentTagsEntry("descendentTags");
 static InternedString setsEntry("sets");
 static InternedString childSetsEntry("childSets");
+// Object samples with delta encoded or quantized primitive variables are stored
+// in "object/encoded" rather than "object", so that older readers fail to find
+// them rather than returning garbage. The information needed to decode them is
+// stored in "object/deltaVariables" and "object/quantizedVariables".
+static InternedString objectEncodedEntry("encoded");
+static InternedString objectDeltaVariablesEntry("deltaVariables");
+static InternedString objectQuantizedVariablesEntry("quantizedVariables");
 
 const SceneInterface::Name &SceneCache::animatedObjectTopologyAttribute = InternedString( "sceneInterface:animatedObjectTopology" );
 const SceneInterface::Name &SceneCache::animatedObjectPrimVarsAttribute = InternedString( "sceneInterface:animatedObjectPrimVars" );
@@ -595,7 +606,128 @@ class SceneCache::ReaderImplementation : public SceneCache::Implementation
 
 		static PrimitiveVariableMap readObjectPrimitiveVariablesAtSample( const IndexedIOPtr &io, const std::vector<InternedString> &primVarNames, size_t sample, const Canceller *canceller )
 		{
-			return Primitive::loadPrimitiveVariables( io->subdirectory( objectEntry ).get(), sampleEntry(sample), primVarNames, canceller );
+			return loadObjectPrimitiveVariables( io->subdirectory( objectEntry ).get(), primVarNames, sample, canceller );
+		}
+
+		/// Returns the subdirectory holding the encoded sample, or null if the sample isn't encoded.
+		static ConstIndexedIOPtr objectEncodedIO( const IndexedIO *objectIO, size_t sample )
+		{
+			ConstIndexedIOPtr encodedIO = objectIO->subdirectory( objectEncodedEntry, IndexedIO::NullIfMissing );
+			if( !encodedIO || !encodedIO->hasEntry( sampleEntry( sample ) ) )
+			{
+				return nullptr;
+			}
+			return encodedIO;
+		}
+
+		/// Returns the object or primitive variables from the
+		/// encoding tables for the sample, or null if not present.
+		template<typename T>
+		static typename T::ConstPtr loadEncodingTable( const IndexedIO *objectIO, const IndexedIO::EntryID &tableEntry, size_t sample )
+		{
+			ConstIndexedIOPtr tableIO = objectIO->subdirectory( tableEntry, IndexedIO::NullIfMissing );
+			if( !tableIO || !tableIO->hasEntry( sampleEntry( sample ) ) )
+			{
+				return nullptr;
+			}
+			typename T::ConstPtr result = runTimeCast<const T>( Object::load( tableIO, sampleEntry( sample ) ) );
+			if( !result )
+			{
+				throw Exception( "Corrupted file! Unexpected type for object encoding table." );
+			}
+			return result;
+		}
+
+		/// Replaces the encoded variables in `variables` with their decoded values. Delta
+		/// encoded variables are decoded by recursively loading the previous samples back
+		/// to the last full sample.
+		static void decodeObjectPrimitiveVariables( const IndexedIO *objectIO, size_t sample, PrimitiveVariableMap &variables, const Canceller *canceller )
+		{
+			if( ConstCompoundDataPtr quantizedVariables = loadEncodingTable<CompoundData>( objectIO, objectQuantizedVariablesEntry, sample ) )
+			{
+				for( const auto &q : quantizedVariables->readable() )
+				{
+					PrimitiveVariableMap::iterator it = variables.find( q.first );
+					if( it == variables.end() )
+					{
+						continue;
+					}
+					const CompoundData *parameters = runTimeCast<const CompoundData>( q.second.get() );
+					if( !parameters )
+					{
+						throw Exception( "Corrupted file! Missing parameters for quantized primitive variable." );
+					}
+					it->second.data = dequantizeData( it->second.data.get(), parameters );
+				}
+			}
+
+			ConstInternedStringVectorDataPtr deltaVariables = loadEncodingTable<InternedStringVectorData>( objectIO, objectDeltaVariablesEntry, sample );
+			if( !deltaVariables )
+			{
+				return;
+			}
+
+			std::vector<InternedString> names;
+			for( const auto &name : deltaVariables->readable() )
+			{
+				if( variables.find( name ) != variables.end() )
+				{
+					names.push_back( name );
+				}
+			}
+
+			if( names.empty() )
+			{
+				return;
+			}
+
+			if( !sample )
+			{
+				throw Exception( "Corrupted file! Delta encoded primitive variables in first sample." );
+			}
+
+			const PrimitiveVariableMap previous = loadObjectPrimitiveVariables( objectIO, names, sample - 1, canceller );
+			for( const auto &name : names )
+			{
+				PrimitiveVariableMap::const_iterator it = previous.find( name );
+				if( it == previous.end() )
+				{
+					throw Exception( boost::str( boost::format( "Corrupted file! Missing reference for delta encoded primitive variable \"%s\"." ) % name.string() ) );
+				}
+				PrimitiveVariable &variable = variables[name];
+				variable.data = xorData( variable.data.get(), it->second.data.get() );
+			}
+		}
+
+		static ObjectPtr loadObject( const IndexedIO *objectIO, size_t sample, const Canceller *canceller )
+		{
+			ConstIndexedIOPtr encodedIO = objectEncodedIO( objectIO, sample );
+			if( !encodedIO )
+			{
+				return Object::load( objectIO, sampleEntry( sample ), canceller );
+			}
+
+			ObjectPtr result = Object::load( encodedIO, sampleEntry( sample ), canceller );
+			Primitive *primitive = runTimeCast<Primitive>( result.get() );
+			if( !primitive )
+			{
+				throw Exception( "Corrupted file! Encoded object is not a Primitive." );
+			}
+			decodeObjectPrimitiveVariables( objectIO, sample, primitive->variables, canceller );
+			return result;
+		}
+
+		static PrimitiveVariableMap loadObjectPrimitiveVariables( const IndexedIO *objectIO, const std::vector<InternedString> &primVarNames, size_t sample, const Canceller *canceller )
+		{
+			ConstIndexedIOPtr encodedIO = objectEncodedIO( objectIO, sample );
+			if( !encodedIO )
+			{
+				return Primitive::loadPrimitiveVariables( objectIO, sampleEntry( sample ), primVarNames, canceller );
+			}
+
+			PrimitiveVariableMap result = Primitive::loadPrimitiveVariables( encodedIO.get(), sampleEntry( sample ), primVarNames, canceller );
+			decodeObjectPrimitiveVariables( objectIO, sample, result, canceller );
+			return result;
 		}
 
 		PrimitiveVariableMap readObjectPrimitiveVariables( const std::vector<InternedString> &primVarNames, double time ) const
@@ -615,8 +747,8 @@ class SceneCache::ReaderImplementation : public SceneCache::Implementation
 			}
 
 			IndexedIOPtr objectIO = m_indexedIO->subdirectory( objectEntry );
-			PrimitiveVariableMap map1 = Primitive::loadPrimitiveVariables( objectIO.get(), sampleEntry(sample1), primVarNames );
-			PrimitiveVariableMap map2 = Primitive::loadPrimitiveVariables( objectIO.get(), sampleEntry(sample2), primVarNames );
+			PrimitiveVariableMap map1 = loadObjectPrimitiveVariables( objectIO.get(), primVarNames, sample1, nullptr );
+			PrimitiveVariableMap map2 = loadObjectPrimitiveVariables( objectIO.get(), primVarNames, sample2, nullptr );
 
 			for ( PrimitiveVariableMap::iterator it1 = map1.begin(); it1 != map1.end(); it1++ )
 			{
@@ -1121,7 +1253,7 @@ class SceneCache::ReaderImplementation : public SceneCache::Implementation
 		// static function used by the cache mechanism to actually load the object data from file.
 		static ObjectPtr doReadObjectAtSample( const SimpleCacheKey &key )
 		{
-			return Object::load( key.first->m_indexedIO->subdirectory( objectEntry ), sampleEntry(key.second) );
+			return loadObject( key.first->m_indexedIO->subdirectory( objectEntry ).get(), key.second, nullptr );
 		}
 
 		static MurmurHash attributeHash( const AttributeCacheKey &key )
@@ -1195,12 +1327,14 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 
 		IE_CORE_DECLAREPTR( WriterImplementation )
 
-		WriterImplementation( IndexedIOPtr io, Implementation *parent = nullptr) : SceneCache::Implementation( io ), m_parent(static_cast< WriterImplementation* >( parent ))
+		WriterImplementation( IndexedIOPtr io, Implementation *parent = nullptr) : SceneCache::Implementation( io ), m_parent(static_cast< WriterImplementation* >( parent )), m_objectDeltaKeyframeInterval( 0 ), m_objectQuantizationTolerance( 0 )
 		{
 			if ( m_parent )
 			{
 				// use same map from the root
 				m_sampleTimesMap = m_parent->m_sampleTimesMap;
+				m_objectDeltaKeyframeInterval = m_parent->m_objectDeltaKeyframeInterval;
+				m_objectQuantizationTolerance = m_parent->m_objectQuantizationTolerance;
 			}
 			else
 			{
@@ -1413,7 +1547,10 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 			size_t sampleIndex = m_objectSampleTimes.size();
 			m_objectSampleTimes.push_back( time );
 			IndexedIOPtr io = m_indexedIO->subdirectory( objectEntry, IndexedIO::CreateIfMissing );
-			object->save( io, sampleEntry(sampleIndex) );
+			if ( !writeEncodedObject( object, sampleIndex, io.get() ) )
+			{
+				object->save( io, sampleEntry(sampleIndex) );
+			}
 
 			const VisibleRenderable *renderable = runTimeCast< const VisibleRenderable >( object );
 			if ( renderable )
@@ -1464,6 +1601,12 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 					V3d( bf.min.x, bf.min.y, bf.min.z ),
 					V3f( bf.max.x, bf.max.y, bf.max.z )
 				);
+				if ( primitive && m_objectQuantizationTolerance > 0.0f && !bd.isEmpty() )
+				{
+					// account for the error in quantized positions
+					bd.min -= V3d( m_objectQuantizationTolerance );
+					bd.max += V3d( m_objectQuantizationTolerance );
+				}
 				m_objectSamples.push_back( bd );
 			}
 			else
@@ -1484,6 +1627,28 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 			}
 		}
 
+		void setObjectDeltaKeyframeInterval( unsigned keyframeInterval )
+		{
+			writable();
+			m_objectDeltaKeyframeInterval = keyframeInterval;
+		}
+
+		unsigned getObjectDeltaKeyframeInterval() const
+		{
+			return m_objectDeltaKeyframeInterval;
+		}
+
+		void setObjectQuantizationTolerance( float tolerance )
+		{
+			writable();
+			m_objectQuantizationTolerance = tolerance;
+		}
+
+		float getObjectQuantizationTolerance() const
+		{
+			return m_objectQuantizationTolerance;
+		}
+
 		void writeSet(const Name& name, IECore::PathMatcher set )
 		{
 			IECore::PathMatcherDataPtr setData = new IECore::PathMatcherData();
@@ -2211,6 +2376,100 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 
 		AnimatedHashTest m_animatedObjectTopology;
 		AnimatedPrimVarMap m_animatedObjectPrimVars;
+
+		unsigned m_objectDeltaKeyframeInterval;
+		float m_objectQuantizationTolerance;
+		// The primitive variables from the previous object sample which were
+		// stored exactly, and can therefore be used as a reference for delta
+		// encoding the current sample.
+		PrimitiveVariableMap m_previousObjectPrimVars;
+
+		// Saves the object with its primitive variables quantized and/or delta encoded
+		// against the previous sample, returning false if there is nothing to encode,
+		// in which case the caller should save the object as usual.
+		bool writeEncodedObject( const Object *object, size_t sampleIndex, IndexedIO *io )
+		{
+			PrimitiveVariableMap previousPrimVars;
+			previousPrimVars.swap( m_previousObjectPrimVars );
+
+			const Primitive *primitive = runTimeCast<const Primitive>( object );
+			if( !primitive || ( !m_objectDeltaKeyframeInterval && m_objectQuantizationTolerance <= 0.0f ) )
+			{
+				return false;
+			}
+
+			PrimitivePtr encodedPrimitive;
+			CompoundDataPtr quantizedVariables = new CompoundData;
+			InternedStringVectorDataPtr deltaVariables = new InternedStringVectorData;
+			for( const auto &p : primitive->variables )
+			{
+				if( m_objectQuantizationTolerance > 0.0f )
+				{
+					CompoundDataPtr parameters = new CompoundData;
+					if( DataPtr quantized = quantizeData( p.second.data.get(), m_objectQuantizationTolerance, parameters.get() ) )
+					{
+						if( !encodedPrimitive )
+						{
+							encodedPrimitive = primitive->copy();
+						}
+						encodedPrimitive->variables[p.first].data = quantized;
+						quantizedVariables->writable()[p.first] = parameters;
+						continue;
+					}
+				}
+
+				if( !m_objectDeltaKeyframeInterval || !deltaEncodable( p.second ) )
+				{
+					continue;
+				}
+
+				// Take a (cheap, copy-on-write) copy so we're not
+				// affected by subsequent edits to the object.
+				m_previousObjectPrimVars[p.first] = PrimitiveVariable( p.second.interpolation, p.second.data->copy() );
+
+				if( sampleIndex % m_objectDeltaKeyframeInterval == 0 )
+				{
+					continue;
+				}
+
+				PrimitiveVariableMap::const_iterator previous = previousPrimVars.find( p.first );
+				if(
+					previous == previousPrimVars.end() ||
+					previous->second.interpolation != p.second.interpolation ||
+					previous->second.data->typeId() != p.second.data->typeId() ||
+					IECore::size( previous->second.data.get() ) != IECore::size( p.second.data.get() ) ||
+					*previous->second.data == *p.second.data
+				)
+				{
+					// Unchanged data is deduplicated by the IndexedIO anyway,
+					// so there's no benefit in encoding it.
+					continue;
+				}
+
+				if( !encodedPrimitive )
+				{
+					encodedPrimitive = primitive->copy();
+				}
+				encodedPrimitive->variables[p.first].data = xorData( p.second.data.get(), previous->second.data.get() );
+				deltaVariables->writable().push_back( p.first );
+			}
+
+			if( !encodedPrimitive )
+			{
+				return false;
+			}
+
+			encodedPrimitive->save( io->subdirectory( objectEncodedEntry, IndexedIO::CreateIfMissing ), sampleEntry( sampleIndex ) );
+			if( !quantizedVariables->readable().empty() )
+			{
+				quantizedVariables->Object::save( io->subdirectory( objectQuantizedVariablesEntry, IndexedIO::CreateIfMissing ), sampleEntry( sampleIndex ) );
+			}
+			if( !deltaVariables->readable().empty() )
+			{
+				deltaVariables->Object::save( io->subdirectory( objectDeltaVariablesEntry, IndexedIO::CreateIfMissing ), sampleEntry( sampleIndex ) );
+			}
+			return true;
+		}
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -2661,3 +2920,27 @@ bool SceneCache::readOnly() const
 {
 	return dynamic_cast< const ReaderImplementation* >( m_implementation.get() ) != nullptr;
 }
+
+void SceneCache::setObjectDeltaKeyframeInterval( unsigned keyframeInterval )
+{
+	WriterImplementation *writer = WriterImplementation::writer( m_implementation.get() );
+	writer->setObjectDeltaKeyframeInterval( keyframeInterval );
+}
+
+unsigned SceneCache::getObjectDeltaKeyframeInterval() const
+{
+	WriterImplementation *writer = WriterImplementation::writer( m_implementation.get() );
+	return writer->getObjectDeltaKeyframeInterval();
+}
+
+void SceneCache::setObjectQuantizationTolerance( float tolerance )
+{
+	WriterImplementation *writer = WriterImplementation::writer( m_implementation.get() );
+	writer->setObjectQuantizationTolerance( tolerance );
+}
+
+float SceneCache::getObjectQuantizationTolerance() const
+{
+	WriterImplementation *writer = WriterImplementation::writer( m_implementation.get() );
+	return writer->getObjectQuantizationTolerance();
+}
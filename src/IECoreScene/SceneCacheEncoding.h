@@ -0,0 +1,456 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2026, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef IECORESCENE_SCENECACHEENCODING_H
+#define IECORESCENE_SCENECACHEENCODING_H
+
+#include "IECoreScene/PrimitiveVariable.h"
+
+#include "IECore/CompoundData.h"
+#include "IECore/Exception.h"
+#include "IECore/GeometricTypedData.h"
+#include "IECore/SimpleTypedData.h"
+#include "IECore/VectorTypedData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace IECoreScene
+{
+
+namespace Private
+{
+
+/// Utilities for the lossless and lossy encodings SceneCache can use to
+/// reduce the size of object samples.
+namespace SceneCacheEncoding
+{
+
+//////////////////////////////////////////////////////////////////////////
+// Delta encoding
+//////////////////////////////////////////////////////////////////////////
+
+// Animated primitive variables are stored as the XOR of their bit patterns
+// with those of the previous sample. For slowly changing values the sign,
+// exponent and high mantissa bits rarely change, so the result is dominated
+// by zero bytes, which compress very well once shuffled by blosc. Unlike
+// subtraction, this is exactly reversible.
+
+inline bool deltaEncodable( const PrimitiveVariable &primitiveVariable )
+{
+	if( primitiveVariable.indices )
+	{
+		return false;
+	}
+	const IECore::TypeId typeId = primitiveVariable.data->typeId();
+	return typeId == IECore::FloatVectorDataTypeId || typeId == IECore::V3fVectorDataTypeId;
+}
+
+inline void xorFloats( float *data, const float *reference, size_t size )
+{
+	for( size_t i = 0; i < size; ++i )
+	{
+		uint32_t d, r;
+		std::memcpy( &d, data + i, sizeof( d ) );
+		std::memcpy( &r, reference + i, sizeof( r ) );
+		d ^= r;
+		std::memcpy( data + i, &d, sizeof( d ) );
+	}
+}
+
+/// Used both to encode and decode, since XOR is its own inverse.
+inline IECore::DataPtr xorData( const IECore::Data *data, const IECore::Data *reference )
+{
+	if( data->typeId() != reference->typeId() )
+	{
+		throw IECore::Exception( "Corrupted file! Mismatched types for delta encoded primitive variable." );
+	}
+
+	IECore::DataPtr result = data->copy();
+	switch( result->typeId() )
+	{
+		case IECore::FloatVectorDataTypeId :
+		{
+			std::vector<float> &values = static_cast<IECore::FloatVectorData *>( result.get() )->writable();
+			const std::vector<float> &referenceValues = static_cast<const IECore::FloatVectorData *>( reference )->readable();
+			if( values.size() != referenceValues.size() )
+			{
+				throw IECore::Exception( "Corrupted file! Mismatched sizes for delta encoded primitive variable." );
+			}
+			xorFloats( values.data(), referenceValues.data(), values.size() );
+			break;
+		}
+		case IECore::V3fVectorDataTypeId :
+		{
+			std::vector<Imath::V3f> &values = static_cast<IECore::V3fVectorData *>( result.get() )->writable();
+			const std::vector<Imath::V3f> &referenceValues = static_cast<const IECore::V3fVectorData *>( reference )->readable();
+			if( values.size() != referenceValues.size() )
+			{
+				throw IECore::Exception( "Corrupted file! Mismatched sizes for delta encoded primitive variable." );
+			}
+			xorFloats( values.data()->getValue(), referenceValues.data()->getValue(), values.size() * 3 );
+			break;
+		}
+		default :
+			throw IECore::Exception( "Corrupted file! Unsupported type for delta encoded primitive variable." );
+	}
+
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Quantization
+//////////////////////////////////////////////////////////////////////////
+
+// Positions, vectors and UVs are stored as 8 or 16 bit fixed point values,
+// relative to the bounds of the data, and normals are stored using 8 or 16
+// bit octahedral encoding. The number of bits is chosen so that the error
+// in each component is at most the tolerance specified by the user. Data
+// which can't meet the tolerance using 16 bits is stored unquantized.
+
+namespace Detail
+{
+
+template<typename T>
+IECore::DataPtr quantizeFixedPoint( const float *values, size_t size, const std::vector<double> &offset, const std::vector<double> &step )
+{
+	const size_t numComponents = offset.size();
+	typename IECore::TypedData<std::vector<T>>::Ptr resultData = new IECore::TypedData<std::vector<T>>;
+	std::vector<T> &result = resultData->writable();
+	result.resize( size );
+	for( size_t i = 0; i < size; ++i )
+	{
+		const size_t c = i % numComponents;
+		result[i] = step[c] > 0 ? (T)std::round( ( values[i] - offset[c] ) / step[c] ) : 0;
+	}
+	return resultData;
+}
+
+template<typename T>
+void dequantizeFixedPoint( const std::vector<T> &quantized, const std::vector<double> &offset, const std::vector<double> &step, float *values )
+{
+	const size_t numComponents = offset.size();
+	for( size_t i = 0; i < quantized.size(); ++i )
+	{
+		const size_t c = i % numComponents;
+		values[i] = (float)( offset[c] + quantized[i] * step[c] );
+	}
+}
+
+inline float signNotZero( float f )
+{
+	return f < 0.0f ? -1.0f : 1.0f;
+}
+
+inline Imath::V2f octahedralEncode( const Imath::V3f &n )
+{
+	const float sum = std::abs( n.x ) + std::abs( n.y ) + std::abs( n.z );
+	Imath::V2f o( n.x / sum, n.y / sum );
+	if( n.z < 0.0f )
+	{
+		o = Imath::V2f(
+			( 1.0f - std::abs( o.y ) ) * signNotZero( o.x ),
+			( 1.0f - std::abs( o.x ) ) * signNotZero( o.y )
+		);
+	}
+	return o;
+}
+
+inline Imath::V3f octahedralDecode( const Imath::V2f &o )
+{
+	Imath::V3f n( o.x, o.y, 1.0f - std::abs( o.x ) - std::abs( o.y ) );
+	if( n.z < 0.0f )
+	{
+		n.x = ( 1.0f - std::abs( o.y ) ) * signNotZero( o.x );
+		n.y = ( 1.0f - std::abs( o.x ) ) * signNotZero( o.y );
+	}
+	return n.normalized();
+}
+
+template<typename T>
+IECore::DataPtr quantizeOctahedral( const std::vector<Imath::V3f> &normals, int bits, float tolerance )
+{
+	const float maxValue = (float)( ( 1u << bits ) - 1 );
+
+	typename IECore::TypedData<std::vector<T>>::Ptr resultData = new IECore::TypedData<std::vector<T>>;
+	std::vector<T> &result = resultData->writable();
+	result.resize( normals.size() * 2 );
+	for( size_t i = 0; i < normals.size(); ++i )
+	{
+		const Imath::V3f &n = normals[i];
+		if( n.x == 0.0f && n.y == 0.0f && n.z == 0.0f )
+		{
+			return nullptr;
+		}
+
+		const Imath::V2f o = octahedralEncode( n );
+		const T qx = (T)std::round( ( o.x * 0.5f + 0.5f ) * maxValue );
+		const T qy = (T)std::round( ( o.y * 0.5f + 0.5f ) * maxValue );
+
+		// Verify the tolerance directly, as the error depends on the
+		// position on the octahedron, and because normals which aren't
+		// unit length can't be represented at all.
+		const Imath::V3f d = octahedralDecode( Imath::V2f( qx / maxValue * 2.0f - 1.0f, qy / maxValue * 2.0f - 1.0f ) );
+		if( std::abs( d.x - n.x ) > tolerance || std::abs( d.y - n.y ) > tolerance || std::abs( d.z - n.z ) > tolerance )
+		{
+			return nullptr;
+		}
+
+		result[i*2] = qx;
+		result[i*2+1] = qy;
+	}
+	return resultData;
+}
+
+template<typename T>
+void dequantizeOctahedral( const std::vector<T> &quantized, int bits, std::vector<Imath::V3f> &normals )
+{
+	const float maxValue = (float)( ( 1u << bits ) - 1 );
+	normals.resize( quantized.size() / 2 );
+	for( size_t i = 0; i < normals.size(); ++i )
+	{
+		normals[i] = octahedralDecode(
+			Imath::V2f( quantized[i*2] / maxValue * 2.0f - 1.0f, quantized[i*2+1] / maxValue * 2.0f - 1.0f )
+		);
+	}
+}
+
+template<typename T>
+const std::vector<T> &quantizedValues( const IECore::Data *data )
+{
+	const auto *typedData = IECore::runTimeCast<const IECore::TypedData<std::vector<T>>>( data );
+	if( !typedData )
+	{
+		throw IECore::Exception( "Corrupted file! Unexpected type for quantized primitive variable." );
+	}
+	return typedData->readable();
+}
+
+inline IECore::DataPtr quantizeFixedPoint( const float *values, size_t size, size_t numComponents, float tolerance, IECore::CompoundData *parameters )
+{
+	std::vector<double> offset( numComponents, std::numeric_limits<double>::infinity() );
+	std::vector<double> maximum( numComponents, -std::numeric_limits<double>::infinity() );
+	for( size_t i = 0; i < size; ++i )
+	{
+		if( !std::isfinite( values[i] ) )
+		{
+			return nullptr;
+		}
+		const size_t c = i % numComponents;
+		offset[c] = std::min( offset[c], (double)values[i] );
+		maximum[c] = std::max( maximum[c], (double)values[i] );
+	}
+
+	// Leave a little headroom for rounding error during dequantization.
+	const double maxStep = 2.0 * tolerance * 0.99;
+	std::vector<double> step( numComponents, 0.0 );
+	double numLevels = 1;
+	for( size_t c = 0; c < numComponents; ++c )
+	{
+		if( !size )
+		{
+			offset[c] = 0.0;
+			continue;
+		}
+		const double range = maximum[c] - offset[c];
+		const double levels = std::ceil( range / maxStep ) + 1;
+		step[c] = levels > 1 ? range / ( levels - 1 ) : 0.0;
+		numLevels = std::max( numLevels, levels );
+	}
+
+	IECore::DataPtr result;
+	if( numLevels <= 256 )
+	{
+		result = quantizeFixedPoint<unsigned char>( values, size, offset, step );
+	}
+	else if( numLevels <= 65536 )
+	{
+		result = quantizeFixedPoint<unsigned short>( values, size, offset, step );
+	}
+	else
+	{
+		return nullptr;
+	}
+
+	parameters->writable()["encoding"] = new IECore::StringData( "fixedPoint" );
+	parameters->writable()["offset"] = new IECore::DoubleVectorData( offset );
+	parameters->writable()["step"] = new IECore::DoubleVectorData( step );
+	return result;
+}
+
+inline IECore::DataPtr quantizeNormals( const std::vector<Imath::V3f> &normals, float tolerance, IECore::CompoundData *parameters )
+{
+	// An estimate of the bits needed, assuming the error is
+	// no more than the step size in octahedral space.
+	int bits = (int)std::ceil( std::log2( 2.0 / tolerance + 1.0 ) );
+	bits = std::max( bits, 1 );
+	for( ; bits <= 16; ++bits )
+	{
+		IECore::DataPtr result = bits <= 8 ? quantizeOctahedral<unsigned char>( normals, bits, tolerance ) : quantizeOctahedral<unsigned short>( normals, bits, tolerance );
+		if( result )
+		{
+			parameters->writable()["encoding"] = new IECore::StringData( "octahedral" );
+			parameters->writable()["bits"] = new IECore::IntData( bits );
+			return result;
+		}
+	}
+	return nullptr;
+}
+
+} // namespace Detail
+
+/// Returns a quantized copy of `data`, filling `parameters` with the
+/// information needed by `dequantizeData()`, or null if the data can't
+/// be quantized to within `tolerance`.
+inline IECore::DataPtr quantizeData( const IECore::Data *data, float tolerance, IECore::CompoundData *parameters )
+{
+	IECore::DataPtr result;
+	IECore::GeometricData::Interpretation interpretation = IECore::GeometricData::None;
+	if( const auto *v3fData = IECore::runTimeCast<const IECore::V3fVectorData>( data ) )
+	{
+		interpretation = v3fData->getInterpretation();
+		const std::vector<Imath::V3f> &values = v3fData->readable();
+		switch( interpretation )
+		{
+			case IECore::GeometricData::Point :
+			case IECore::GeometricData::Vector :
+				result = Detail::quantizeFixedPoint( values.data()->getValue(), values.size() * 3, 3, tolerance, parameters );
+				break;
+			case IECore::GeometricData::Normal :
+				result = Detail::quantizeNormals( values, tolerance, parameters );
+				break;
+			default :
+				break;
+		}
+	}
+	else if( const auto *v2fData = IECore::runTimeCast<const IECore::V2fVectorData>( data ) )
+	{
+		interpretation = v2fData->getInterpretation();
+		if( interpretation == IECore::GeometricData::UV )
+		{
+			const std::vector<Imath::V2f> &values = v2fData->readable();
+			result = Detail::quantizeFixedPoint( values.data()->getValue(), values.size() * 2, 2, tolerance, parameters );
+		}
+	}
+
+	if( result )
+	{
+		parameters->writable()["typeId"] = new IECore::IntData( data->typeId() );
+		parameters->writable()["interpretation"] = new IECore::IntData( interpretation );
+	}
+	return result;
+}
+
+/// Inverse of `quantizeData()`.
+inline IECore::DataPtr dequantizeData( const IECore::Data *data, const IECore::CompoundData *parameters )
+{
+	const IECore::TypeId typeId = (IECore::TypeId)parameters->member<IECore::IntData>( "typeId", true )->readable();
+	const auto interpretation = (IECore::GeometricData::Interpretation)parameters->member<IECore::IntData>( "interpretation", true )->readable();
+	const std::string &encoding = parameters->member<IECore::StringData>( "encoding", true )->readable();
+
+	if( encoding == "octahedral" )
+	{
+		if( typeId != IECore::V3fVectorDataTypeId )
+		{
+			throw IECore::Exception( "Corrupted file! Unexpected type for octahedral encoded primitive variable." );
+		}
+		const int bits = parameters->member<IECore::IntData>( "bits", true )->readable();
+		IECore::V3fVectorDataPtr result = new IECore::V3fVectorData;
+		result->setInterpretation( interpretation );
+		if( bits <= 8 )
+		{
+			Detail::dequantizeOctahedral( Detail::quantizedValues<unsigned char>( data ), bits, result->writable() );
+		}
+		else
+		{
+			Detail::dequantizeOctahedral( Detail::quantizedValues<unsigned short>( data ), bits, result->writable() );
+		}
+		return result;
+	}
+	else if( encoding == "fixedPoint" )
+	{
+		const std::vector<double> &offset = parameters->member<IECore::DoubleVectorData>( "offset", true )->readable();
+		const std::vector<double> &step = parameters->member<IECore::DoubleVectorData>( "step", true )->readable();
+
+		IECore::DataPtr result;
+		float *values = nullptr;
+		const size_t size = data->typeId() == IECore::UCharVectorDataTypeId ?
+			Detail::quantizedValues<unsigned char>( data ).size() :
+			Detail::quantizedValues<unsigned short>( data ).size()
+		;
+
+		if( typeId == IECore::V3fVectorDataTypeId && offset.size() == 3 )
+		{
+			IECore::V3fVectorDataPtr v3fData = new IECore::V3fVectorData;
+			v3fData->setInterpretation( interpretation );
+			v3fData->writable().resize( size / 3 );
+			values = v3fData->writable().data()->getValue();
+			result = v3fData;
+		}
+		else if( typeId == IECore::V2fVectorDataTypeId && offset.size() == 2 )
+		{
+			IECore::V2fVectorDataPtr v2fData = new IECore::V2fVectorData;
+			v2fData->setInterpretation( interpretation );
+			v2fData->writable().resize( size / 2 );
+			values = v2fData->writable().data()->getValue();
+			result = v2fData;
+		}
+		else
+		{
+			throw IECore::Exception( "Corrupted file! Unexpected type for fixed point encoded primitive variable." );
+		}
+
+		if( data->typeId() == IECore::UCharVectorDataTypeId )
+		{
+			Detail::dequantizeFixedPoint( Detail::quantizedValues<unsigned char>( data ), offset, step, values );
+		}
+		else
+		{
+			Detail::dequantizeFixedPoint( Detail::quantizedValues<unsigned short>( data ), offset, step, values );
+		}
+		return result;
+	}
+
+	throw IECore::Exception( "Corrupted file! Unknown encoding for quantized primitive variable." );
+}
+
+} // namespace SceneCacheEncoding
+
+} // namespace Private
+
+} // namespace IECoreScene
+
+#endif // IECORESCENE_SCENECACHEENCODING_H
@@ -83,6 +83,12 @@ CurvesPrimitivePtr updateEndpointMultiplicityWrapper( const CurvesPrimitive *cur
 	return CurvesAlgo::updateEndpointMultiplicity( curves, cubicBasis, canceller );
 }
 
+CurvesPrimitivePtr lineariseWrapper( const CurvesPrimitive *curves, float verticesPerSegment, const IECore::Canceller *canceller )
+{
+	IECorePython::ScopedGILRelease gilRelease;
+	return CurvesAlgo::linearise( curves, verticesPerSegment, canceller );
+}
+
 BOOST_PYTHON_FUNCTION_OVERLOADS(segmentOverLoads, segmentWrapper, 2, 4);
 
 } // namepsace
@@ -101,6 +107,7 @@ void bindCurvesAlgo()
 	def( "deleteCurves", &deleteCurvesWrapper, ( arg_( "curvesPrimitive" ), arg_( "curvesToDelete" ), arg_( "invert" ) = false, arg_( "canceller" ) = object() ) );
 	def( "segment", ::segmentWrapper, segmentOverLoads());
 	def( "updateEndpointMultiplicity", &updateEndpointMultiplicityWrapper, ( arg_( "curves" ), arg_( "cubicBasis" ), arg_( "canceller" ) = object() ) );
+	def( "linearise", &lineariseWrapper, ( arg_( "curves" ), arg_( "verticesPerSegment" ), arg_( "canceller" ) = object() ) );
 }
 
 } // namespace IECoreSceneModule
@@ -41,6 +41,7 @@
 
 #include "IECorePython/RefCountedBinding.h"
 #include "IECorePython/RunTimeTypedBinding.h"
+#include "IECorePython/ScopedGILRelease.h"
 
 #include "OpenEXR/OpenEXRConfig.h"
 #if OPENEXR_VERSION_MAJOR < 3
@@ -73,6 +74,57 @@ bool pointAtV( const CurvesPrimitiveEvaluator &e, unsigned curveIndex, float v,
 	return e.pointAtV( curveIndex, v, r );
 }
 
+tuple pointsAtV( const CurvesPrimitiveEvaluator &e, const IntVectorData *curveIndices, const FloatVectorData *v )
+{
+	V3fVectorDataPtr positions = new V3fVectorData;
+	positions->setInterpretation( GeometricData::Point );
+	V3fVectorDataPtr tangents = new V3fVectorData;
+	tangents->setInterpretation( GeometricData::Vector );
+	{
+		ScopedGILRelease gilRelease;
+		e.pointsAtV( curveIndices->readable(), v->readable(), positions->writable(), &tangents->writable() );
+	}
+	return make_tuple( positions, tangents );
+}
+
+DataPtr primVarAtV( const CurvesPrimitiveEvaluator &e, const PrimitiveVariable &primVar, const IntVectorData *curveIndices, const FloatVectorData *v )
+{
+	ScopedGILRelease gilRelease;
+	return e.primVarAtV( primVar, curveIndices->readable(), v->readable() );
+}
+
+tuple closestPoints( const CurvesPrimitiveEvaluator &e, const V3fVectorData *points )
+{
+	IntVectorDataPtr curveIndices = new IntVectorData;
+	FloatVectorDataPtr v = new FloatVectorData;
+	{
+		ScopedGILRelease gilRelease;
+		e.closestPoints( points->readable(), curveIndices->writable(), v->writable() );
+	}
+	return make_tuple( curveIndices, v );
+}
+
+FloatVectorDataPtr vAtLengths( const CurvesPrimitiveEvaluator &e, const IntVectorData *curveIndices, const FloatVectorData *lengths )
+{
+	FloatVectorDataPtr v = new FloatVectorData;
+	{
+		ScopedGILRelease gilRelease;
+		e.vAtLengths( curveIndices->readable(), lengths->readable(), v->writable() );
+	}
+	return v;
+}
+
+tuple uniformLengthSamples( const CurvesPrimitiveEvaluator &e, unsigned samplesPerCurve )
+{
+	IntVectorDataPtr curveIndices = new IntVectorData;
+	FloatVectorDataPtr v = new FloatVectorData;
+	{
+		ScopedGILRelease gilRelease;
+		e.uniformLengthSamples( samplesPerCurve, curveIndices->writable(), v->writable() );
+	}
+	return make_tuple( curveIndices, v );
+}
+
 IntVectorDataPtr verticesPerCurve( const CurvesPrimitiveEvaluator &e )
 {
 	return new IntVectorData( e.verticesPerCurve() );
@@ -231,6 +283,12 @@ void bindCurvesPrimitiveEvaluator()
 				arg( "vEnd" ) = 1.0f
 			)
 		)
+		.def( "vAtLength", &CurvesPrimitiveEvaluator::vAtLength )
+		.def( "pointsAtV", &pointsAtV )
+		.def( "primVarAtV", &primVarAtV )
+		.def( "closestPoints", &closestPoints )
+		.def( "vAtLengths", &vAtLengths )
+		.def( "uniformLengthSamples", &uniformLengthSamples )
 		.def( "verticesPerCurve", &verticesPerCurve )
 		.def( "vertexDataOffsets", &vertexDataOffsets )
 		.def( "varyingDataOffsets", &varyingDataOffsets )
@@ -38,7 +38,9 @@
 
 #include "IECoreScene/MeshAlgo.h"
 
+#include "IECorePython/ExceptionAlgo.h"
 #include "IECorePython/RunTimeTypedBinding.h"
+#include "IECorePython/ScopedGILLock.h"
 
 #include "boost/python/suite/indexing/container_utils.hpp"
 
@@ -193,6 +195,37 @@ MeshPrimitivePtr triangulateWrapper( const MeshPrimitive *mesh, const IECore::Ca
 	return MeshAlgo::triangulate( mesh, canceller );
 }
 
+MeshPrimitivePtr triangulateIndexedWrapper( const MeshPrimitive *mesh, const IECore::Canceller *canceller )
+{
+	ScopedGILRelease gilRelease;
+	return MeshAlgo::triangulateIndexed( mesh, canceller );
+}
+
+MeshAlgo::InterleavedVertexData interleaveVertexDataWrapper( const MeshPrimitive *mesh, object pythonNames, const IECore::Canceller *canceller )
+{
+	std::vector<std::string> names;
+	boost::python::container_utils::extend_container( names, pythonNames );
+
+	ScopedGILRelease gilRelease;
+	return MeshAlgo::interleaveVertexData( mesh, names, canceller );
+}
+
+IECore::FloatVectorDataPtr interleavedVertexDataDataWrapper( const MeshAlgo::InterleavedVertexData &interleavedVertexData )
+{
+	return interleavedVertexData.data;
+}
+
+// Returns a list of `( name, offset, numComponents )` tuples.
+boost::python::list interleavedVertexDataAttributesWrapper( const MeshAlgo::InterleavedVertexData &interleavedVertexData )
+{
+	boost::python::list result;
+	for( const auto &a : interleavedVertexData.attributes )
+	{
+		result.append( boost::python::make_tuple( a.name, a.offset, a.numComponents ) );
+	}
+	return result;
+}
+
 std::pair<IECore::IntVectorDataPtr, IECore::IntVectorDataPtr> connectedVerticesWrapper( const IECoreScene::MeshPrimitive *mesh, const IECore::Canceller *canceller = nullptr )
 {
 	ScopedGILRelease gilRelease;
@@ -219,6 +252,101 @@ IECore::DataPtr meshSplitterValueWrapper( const IECoreScene::MeshAlgo::MeshSplit
 	);
 }
 
+boost::python::list meshSplitterMeshesWrapper( const IECoreScene::MeshAlgo::MeshSplitter &meshSplitter, boost::python::list &segmentIds, const IECore::Canceller *canceller )
+{
+	std::vector<int> ids;
+	boost::python::container_utils::extend_container( ids, segmentIds );
+
+	std::vector<MeshPrimitivePtr> meshes;
+	{
+		ScopedGILRelease gilRelease;
+		meshes = meshSplitter.meshes( ids, canceller );
+	}
+
+	boost::python::list returnList;
+	for( auto &m : meshes )
+	{
+		returnList.append( m );
+	}
+	return returnList;
+}
+
+boost::python::list meshSplitterBoundsWrapper( const IECoreScene::MeshAlgo::MeshSplitter &meshSplitter, const IECore::Canceller *canceller )
+{
+	std::vector<Imath::Box3f> bounds;
+	{
+		ScopedGILRelease gilRelease;
+		bounds = meshSplitter.bounds( canceller );
+	}
+
+	boost::python::list returnList;
+	for( const auto &b : bounds )
+	{
+		returnList.append( b );
+	}
+	return returnList;
+}
+
+void primitiveVariableResamplerResampleWrapper( const IECoreScene::MeshAlgo::PrimitiveVariableResampler &resampler, PrimitiveVariable &primitiveVariable, PrimitiveVariable::Interpolation interpolation, const IECore::Canceller *canceller )
+{
+	ScopedGILRelease gilRelease;
+	resampler.resample( primitiveVariable, interpolation, canceller );
+}
+
+// Resamples a list of primitive variables in place, matching the behaviour of the single variable version
+void primitiveVariableResamplerResampleListWrapper( const IECoreScene::MeshAlgo::PrimitiveVariableResampler &resampler, boost::python::list &primitiveVariables, PrimitiveVariable::Interpolation interpolation, const IECore::Canceller *canceller )
+{
+	std::vector<PrimitiveVariable *> targets;
+	std::vector<PrimitiveVariable> variables;
+	for( size_t i = 0, e = boost::python::len( primitiveVariables ); i < e; ++i )
+	{
+		PrimitiveVariable &primitiveVariable = extract<PrimitiveVariable &>( primitiveVariables[i] );
+		targets.push_back( &primitiveVariable );
+		variables.push_back( primitiveVariable );
+	}
+
+	{
+		ScopedGILRelease gilRelease;
+		resampler.resample( variables, interpolation, canceller );
+	}
+
+	for( size_t i = 0; i < targets.size(); ++i )
+	{
+		*targets[i] = variables[i];
+	}
+}
+
+MeshAlgo::PointDistributor *pointDistributorConstructor( const MeshPrimitive *mesh, const std::string &densityMask, const std::string &uvSet, const std::string &position, const IECore::Canceller *canceller )
+{
+	ScopedGILRelease gilRelease;
+	return new MeshAlgo::PointDistributor( mesh, densityMask, uvSet, position, canceller );
+}
+
+PointsPrimitivePtr pointDistributorDistributeWrapper( const MeshAlgo::PointDistributor &distributor, float density, const Imath::V2f &offset, float maxPointsPerFace, const IECore::V3fVectorData *positions, const IECore::Canceller *canceller )
+{
+	ScopedGILRelease gilRelease;
+	return distributor.distribute( density, offset, maxPointsPerFace, positions ? &positions->readable() : nullptr, canceller );
+}
+
+void pointDistributorDistributeChunksWrapper( const MeshAlgo::PointDistributor &distributor, object chunkFunction, size_t chunkSize, float density, const Imath::V2f &offset, float maxPointsPerFace, const IECore::V3fVectorData *positions, const IECore::Canceller *canceller )
+{
+	ScopedGILRelease gilRelease;
+	distributor.distribute(
+		[&chunkFunction] ( const std::vector<Imath::V3f> &points ) {
+			IECorePython::ScopedGILLock gilLock;
+			try
+			{
+				chunkFunction( IECore::V3fVectorDataPtr( new IECore::V3fVectorData( points ) ) );
+			}
+			catch( const error_already_set & )
+			{
+				IECorePython::ExceptionAlgo::translatePythonException();
+			}
+		},
+		chunkSize, density, offset, maxPointsPerFace, positions ? &positions->readable() : nullptr, canceller
+	);
+}
+
 } // namespace anonymous
 
 namespace IECoreSceneModule
@@ -251,15 +379,38 @@ void bindMeshAlgo()
 	def( "segment", &::segmentWrapper, segmentOverLoads() );
 	def( "merge", &::mergeWrapper, ( arg_( "meshes" ), arg_( "canceller" ) = object() ) );
 	def( "triangulate", &triangulateWrapper, (arg_("mesh"), arg_( "canceller" ) = object() ) );
+	def( "triangulateIndexed", &triangulateIndexedWrapper, ( arg_( "mesh" ), arg_( "canceller" ) = object() ) );
+	def( "interleaveVertexData", &interleaveVertexDataWrapper, ( arg_( "mesh" ), arg_( "names" ) = list(), arg_( "canceller" ) = object() ) );
 	def( "connectedVertices", &connectedVerticesWrapper, ( arg_("mesh"), arg_( "canceller" ) = object() ) );
 
+	class_< MeshAlgo::InterleavedVertexData >( "InterleavedVertexData", no_init )
+		.def_readonly( "stride", &MeshAlgo::InterleavedVertexData::stride )
+		.add_property( "data", &interleavedVertexDataDataWrapper )
+		.add_property( "attributes", &interleavedVertexDataAttributesWrapper )
+	;
+
 	class_< MeshAlgo::MeshSplitter >( "MeshSplitter", no_init )
 		.def( init< ConstMeshPrimitivePtr, const PrimitiveVariable &, optional< const IECore::Canceller *> >() )
 		.def( "numMeshes", &MeshAlgo::MeshSplitter::numMeshes )
 		.def( "mesh", &MeshAlgo::MeshSplitter::mesh, ( arg_( "segmentId" ), arg_( "canceller" ) = object() ) )
 		.def( "bound", &MeshAlgo::MeshSplitter::bound, ( arg_( "segmentId" ), arg_( "canceller" ) = object() ) )
+		.def( "numFaces", &MeshAlgo::MeshSplitter::numFaces )
+		.def( "meshes", &meshSplitterMeshesWrapper, ( arg_( "segmentIds" ), arg_( "canceller" ) = object() ) )
+		.def( "bounds", &meshSplitterBoundsWrapper, ( arg_( "canceller" ) = object() ) )
 		.def( "value", &meshSplitterValueWrapper, ( arg_( "segmentId" ) ) )
 	;
+
+	class_< MeshAlgo::PrimitiveVariableResampler, boost::noncopyable >( "PrimitiveVariableResampler", no_init )
+		.def( init< ConstMeshPrimitivePtr >( arg_( "mesh" ) ) )
+		.def( "resample", &primitiveVariableResamplerResampleWrapper, ( arg_( "primitiveVariable" ), arg_( "interpolation" ), arg_( "canceller" ) = object() ) )
+		.def( "resample", &primitiveVariableResamplerResampleListWrapper, ( arg_( "primitiveVariables" ), arg_( "interpolation" ), arg_( "canceller" ) = object() ) )
+	;
+
+	class_< MeshAlgo::PointDistributor, boost::noncopyable >( "PointDistributor", no_init )
+		.def( "__init__", make_constructor( &pointDistributorConstructor, default_call_policies(), ( arg_( "mesh" ), arg_( "densityMask" ) = "density", arg_( "uvSet" ) = "uv", arg_( "position" ) = "P", arg_( "canceller" ) = object() ) ) )
+		.def( "distribute", &pointDistributorDistributeWrapper, ( arg_( "density" ) = 100.0, arg_( "offset" ) = Imath::V2f( 0 ), arg_( "maxPointsPerFace" ) = std::numeric_limits<float>::infinity(), arg_( "positions" ) = object(), arg_( "canceller" ) = object() ) )
+		.def( "distributeChunks", &pointDistributorDistributeChunksWrapper, ( arg_( "chunkFunction" ), arg_( "chunkSize" ), arg_( "density" ) = 100.0, arg_( "offset" ) = Imath::V2f( 0 ), arg_( "maxPointsPerFace" ) = std::numeric_limits<float>::infinity(), arg_( "positions" ) = object(), arg_( "canceller" ) = object() ) )
+	;
 }
 
 } // namespace IECoreSceneModule
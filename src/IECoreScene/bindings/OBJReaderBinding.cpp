@@ -36,6 +36,7 @@
 
 #include "OBJReaderBinding.h"
 
+#include "IECoreScene/MeshPrimitive.h"
 #include "IECoreScene/OBJReader.h"
 
 #include "IECorePython/RunTimeTypedBinding.h"
@@ -48,6 +49,22 @@ using namespace boost::python;
 using namespace IECorePython;
 using namespace IECoreScene;
 
+namespace
+{
+
+void readGroups( OBJReader &reader, object groupFunction )
+{
+	// We don't release the GIL, because `groupFunction` is
+	// always called on this thread.
+	reader.readGroups(
+		[&groupFunction] ( const std::string &groupName, MeshPrimitivePtr mesh ) {
+			groupFunction( groupName, mesh );
+		}
+	);
+}
+
+} // namespace
+
 namespace IECoreSceneModule
 {
 
@@ -56,6 +73,7 @@ namespace IECoreSceneModule
 		RunTimeTypedClass<OBJReader>()
 			.def(init<const std::string &>())
 			.def( "canRead", &OBJReader::canRead ).staticmethod( "canRead" )
+			.def( "readGroups", &readGroups )
 		;
   	}
 
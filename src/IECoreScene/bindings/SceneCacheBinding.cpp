@@ -168,6 +168,10 @@ void bindSceneCache()
 	RunTimeTypedClass<SceneCache>()
 		.def( "__init__", make_constructor( &constructor ), "Opens a scene file for read or write." )
 		.def( "__init__", make_constructor( &constructor2 ), "Opens a scene from a previously opened file handle." )
+		.def( "setObjectDeltaKeyframeInterval", &SceneCache::setObjectDeltaKeyframeInterval )
+		.def( "getObjectDeltaKeyframeInterval", &SceneCache::getObjectDeltaKeyframeInterval )
+		.def( "setObjectQuantizationTolerance", &SceneCache::setObjectQuantizationTolerance )
+		.def( "getObjectQuantizationTolerance", &SceneCache::getObjectQuantizationTolerance )
 	;
 
 	def( "testSceneCacheParallelAttributeRead", &testSceneCacheParallelAttributeRead );
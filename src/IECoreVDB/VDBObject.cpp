@@ -274,7 +274,7 @@ IECore::CompoundObjectPtr VDBObject::metadata( const std::string &name )
 		}
 		else
 		{
-			IECore::msg(
+			IECORE_MSG(
 				IECore::MessageHandler::Warning,
 				"VDBObject::metadata",
 				boost::format( "'%1%' has unsupported metadata type: '%2%'" ) % metaIt->first % metaIt->second->typeName()
@@ -33,6 +33,7 @@
 ##########################################################################
 
 import math
+import os
 import random
 import unittest
 import imath
@@ -71,6 +72,42 @@ class TestBoundedKDTree:
 
 		self.assertEqual( len( bIdxArray ), numBounds )
 
+	def doSaveLoad( self, numBounds ) :
+
+		self.makeRandomTree( numBounds )
+
+		io = IECore.MemoryIndexedIO( IECore.CharVectorData(), [], IECore.IndexedIO.OpenMode.Write )
+		self.tree.save( io )
+
+		io = IECore.MemoryIndexedIO( io.buffer(), [], IECore.IndexedIO.OpenMode.Read )
+		loadedTree = type( self.tree )( self.bounds, io )
+		self.assertEqual( loadedTree.numNodes(), self.tree.numNodes() )
+
+		for i in range( 0, 25 ) :
+			bound = self.makeRandomBound()
+			self.assertEqual(
+				sorted( loadedTree.intersectingBounds( bound ) ),
+				sorted( self.tree.intersectingBounds( bound ) )
+			)
+
+		# Loading with the wrong number of bounds is an error.
+		self.bounds.append( self.makeRandomBound() )
+		self.assertRaises( RuntimeError, type( self.tree ), self.bounds, io )
+
+	def doEmptySaveLoad( self ) :
+
+		self.makeRandomTree( 0 )
+		self.assertEqual( self.tree.numNodes(), 1 )
+
+		io = IECore.MemoryIndexedIO( IECore.CharVectorData(), [], IECore.IndexedIO.OpenMode.Write )
+		self.tree.save( io )
+
+		io = IECore.MemoryIndexedIO( io.buffer(), [], IECore.IndexedIO.OpenMode.Read )
+		loadedTree = type( self.tree )( self.bounds, io )
+		self.assertEqual( loadedTree.numNodes(), 1 )
+
+		for bound in [ self.makeBound(), self.makeRandomBound() ] + [ self.makeRandomBound() for i in range( 0, 10 ) ] :
+			self.assertEqual( list( loadedTree.intersectingBounds( bound ) ), [] )
 
 
 class TestBoundedKDTreeBox3f(unittest.TestCase, TestBoundedKDTree):
@@ -121,6 +158,28 @@ class TestBoundedKDTreeBox3f(unittest.TestCase, TestBoundedKDTree):
 			self.doIntersectingRandomBounds(t)
 			self.doIntersectingBounds(t)
 
+	def testSaveLoad( self ) :
+
+		for t in self.treeSizes :
+			self.doSaveLoad( t )
+
+	def testEmptySaveLoad( self ) :
+
+		self.doEmptySaveLoad()
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testBuildPerformance( self ) :
+
+		random.seed( 0 )
+		bounds = IECore.Box3fVectorData()
+		for i in range( 0, 1000000 ) :
+			p = imath.V3f( random.random(), random.random(), random.random() )
+			bounds.append( imath.Box3f( p, p + imath.V3f( 0.001 ) ) )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		IECore.Box3fTree( bounds )
+		print( "Build : {:.3f}s".format( t.stop() ) )
+
 
 class TestBoundedKDTreeBox3d(unittest.TestCase, TestBoundedKDTree):
 
@@ -171,6 +230,15 @@ class TestBoundedKDTreeBox3d(unittest.TestCase, TestBoundedKDTree):
 			self.doIntersectingRandomBounds(t)
 			self.doIntersectingBounds(t)
 
+	def testSaveLoad( self ) :
+
+		for t in self.treeSizes :
+			self.doSaveLoad( t )
+
+	def testEmptySaveLoad( self ) :
+
+		self.doEmptySaveLoad()
+
 class TestBoundedKDTreeBox2f(unittest.TestCase, TestBoundedKDTree):
 
 	def makeRandomBound( self ) :
@@ -220,6 +288,15 @@ class TestBoundedKDTreeBox2f(unittest.TestCase, TestBoundedKDTree):
 			self.doIntersectingRandomBounds(t)
 			self.doIntersectingBounds(t)
 
+	def testSaveLoad( self ) :
+
+		for t in self.treeSizes :
+			self.doSaveLoad( t )
+
+	def testEmptySaveLoad( self ) :
+
+		self.doEmptySaveLoad()
+
 
 class TestBoundedKDTreeBox2d(unittest.TestCase, TestBoundedKDTree):
 
@@ -269,6 +346,15 @@ class TestBoundedKDTreeBox2d(unittest.TestCase, TestBoundedKDTree):
 			self.doIntersectingRandomBounds(t)
 			self.doIntersectingBounds(t)
 
+	def testSaveLoad( self ) :
+
+		for t in self.treeSizes :
+			self.doSaveLoad( t )
+
+	def testEmptySaveLoad( self ) :
+
+		self.doEmptySaveLoad()
+
 
 if __name__ == "__main__":
 	unittest.main()
@@ -32,6 +32,7 @@
 #
 ##########################################################################
 
+import os
 import unittest
 import sys
 import subprocess
@@ -223,6 +224,54 @@ class testCompoundObject( unittest.TestCase ) :
 				self.assertEqual( h, o.hash() )
 			h = o.hash()
 
+	def __largeCompound( self ) :
+
+		shared = IECore.IntData( 1 )
+
+		o = IECore.CompoundObject()
+		for i in range( 0, 100000 ) :
+			o["member{}".format( i )] = IECore.IntData( i ) if i % 2 else shared
+
+		return o
+
+	def testCopyPreservesSharing( self ) :
+
+		o = self.__largeCompound()
+		o2 = o.copy()
+		self.assertEqual( o2, o )
+		self.assertFalse( o2["member0"].isSame( o["member0"] ) )
+		for i in range( 0, 100000, 2 ) :
+			self.assertTrue( o2["member{}".format( i )].isSame( o2["member0"] ) )
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testCopyPerformance( self ) :
+
+		o = self.__largeCompound()
+
+		timer = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		for i in range( 0, 10 ) :
+			o.copy()
+		print( "Copy : {:.3f}s".format( timer.totalElapsed() ) )
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testSaveLoadPerformance( self ) :
+
+		o = self.__largeCompound()
+
+		timer = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		for i in range( 0, 10 ) :
+			io = IECore.MemoryIndexedIO( IECore.CharVectorData(), [], IECore.IndexedIO.OpenMode.Write )
+			o.save( io, "o" )
+		print( "Save : {:.3f}s".format( timer.totalElapsed() ) )
+
+		timer = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		for i in range( 0, 10 ) :
+			o2 = IECore.Object.load( io, "o" )
+		print( "Load : {:.3f}s".format( timer.totalElapsed() ) )
+
+		self.assertEqual( o2, o )
+		self.assertTrue( o2["member2"].isSame( o2["member0"] ) )
+
 if __name__ == "__main__":
         unittest.main()
 
@@ -38,6 +38,7 @@ import os
 import unittest
 import math
 import random
+import struct
 
 import IECore
 
@@ -670,6 +671,195 @@ class TestFileIndexedIO(unittest.TestCase):
 		self.assertEqual( f.metadata(),
 			IECore.CompoundData( { "compressor" : "lz4", "compressionLevel" : 0, 'version': IECore.IntData( 7 ), "compressionThreadCount" : 1, "decompressionThreadCount" : 1 } ) )
 
+	def testDuplicateDataIsWrittenOnce( self ) :
+
+		filePath = os.path.join( ".", "test", "FileIndexedIO.fio" )
+
+		data = IECore.FloatVectorData( [ random.random() for i in range( 1024 * 1024 ) ] )
+
+		for compressionLevel in ( 0, 9 ) :
+
+			options = IECore.CompoundData( { "compressor" : "lz4", "compressionLevel" : compressionLevel } )
+
+			f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Write, options = options )
+			f.write( "a", data )
+			del f
+
+			singleSize = os.path.getsize( filePath )
+
+			f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Write, options = options )
+			for i in range( 10 ) :
+				f.subdirectory( str( i ), IECore.IndexedIO.MissingBehaviour.CreateIfMissing ).write( "a", data )
+			del f
+
+			self.assertLess( os.path.getsize( filePath ), singleSize + 4096 )
+
+			f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Read )
+			for i in range( 10 ) :
+				self.assertEqual( f.subdirectory( str( i ) ).read( "a" ), data )
+			del f
+
+	def testIndexCacheSize( self ) :
+
+		filePath = os.path.join( ".", "test", "FileIndexedIO.fio" )
+
+		# Saving objects commits each one to its own subindex, which is paged in on demand.
+		f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Write )
+		for i in range( 100 ) :
+			IECore.IntVectorData( [ i ] * 100 ).save( f, "object{}".format( i ) )
+		del f
+
+		f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Read )
+		expectedEntryIds = f.subdirectory( "object0" ).entryIds()
+		expectedStats = IECore.IndexedIOAlgo.parallelReadAll( f )
+		del f
+
+		for cacheSize in ( 1, 1024, 1024 * 1024 ) :
+
+			f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Read, options = IECore.CompoundData( { "indexCacheSize" : IECore.UInt64Data( cacheSize ) } ) )
+
+			# Directories we hold must remain valid while others are paged in and evicted.
+			held = [ f.subdirectory( "object{}".format( i ) ) for i in range( 0, 100, 10 ) ]
+
+			for repeat in range( 2 ) :
+				for i in range( 100 ) :
+					self.assertEqual( IECore.Object.load( f, "object{}".format( i ) ), IECore.IntVectorData( [ i ] * 100 ) )
+
+			for d in held :
+				self.assertEqual( d.entryIds(), expectedEntryIds )
+				self.assertEqual( d.parentDirectory().subdirectory( d.currentEntryId() ).entryIds(), expectedEntryIds )
+
+			del held
+
+			self.assertEqual( IECore.IndexedIOAlgo.parallelReadAll( f ), expectedStats )
+
+	def testCompressionPolicies( self ) :
+
+		filePath = os.path.join( ".", "test", "FileIndexedIO.fio" )
+
+		floats = IECore.FloatVectorData( [ math.sin( i * 0.001 ) for i in range( 256 * 1024 ) ] )
+		ints = IECore.IntVectorData( [ i // 4 for i in range( 256 * 1024 ) ] )
+		strings = IECore.StringVectorData( [ "string{}".format( i % 100 ) for i in range( 64 * 1024 ) ] )
+
+		def write( options ) :
+			f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Write, options = options )
+			f.write( "floats", floats )
+			f.write( "ints", ints )
+			f.write( "strings", strings )
+			del f
+			return os.path.getsize( filePath )
+
+		defaultSize = write( IECore.CompoundData( { "compressor" : "lz4", "compressionLevel" : 9 } ) )
+
+		policySize = write(
+			IECore.CompoundData( {
+				"compressor" : "lz4",
+				"compressionLevel" : 9,
+				"compressionPolicies" : {
+					"float" : { "compressor" : "zlib", "shuffle" : "bit", "typeSize" : 0 },
+					"integer" : { "compressionLevel" : 5, "shuffle" : "byte" },
+					"string" : { "shuffle" : "none" },
+				}
+			} )
+		)
+
+		# The global settings are still reported in the metadata, and
+		# the policies don't need to be known in order to read the file.
+
+		f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Read )
+		self.assertEqual( f.metadata()["compressor"], IECore.StringData( "lz4" ) )
+		self.assertEqual( f.read( "floats" ), floats )
+		self.assertEqual( f.read( "ints" ), ints )
+		self.assertEqual( f.read( "strings" ), strings )
+
+		self.assertNotEqual( policySize, defaultSize )
+
+		# Disabling compression for one category only affects that category.
+
+		uncompressedFloatsSize = write(
+			IECore.CompoundData( {
+				"compressor" : "lz4",
+				"compressionLevel" : 9,
+				"compressionPolicies" : { "float" : { "compressionLevel" : 0 } }
+			} )
+		)
+		self.assertGreater( uncompressedFloatsSize, defaultSize )
+		self.assertLess( uncompressedFloatsSize, floats.size() * 4 + ints.size() * 4 )
+
+		with self.assertRaisesRegex( Exception, 'Invalid shuffle "foo"' ) :
+			write( IECore.CompoundData( { "compressionPolicies" : { "float" : { "shuffle" : "foo" } } } ) )
+
+	def testCompressionPoliciesWithIdenticalData( self ) :
+
+		filePath = os.path.join( ".", "test", "FileIndexedIO.fio" )
+
+		# Integers and floats with exactly the same bytes, so that they
+		# are candidates for deduplication despite being in different
+		# categories.
+		n = 256 * 1024
+		intValues = [ i // 4 for i in range( n ) ]
+		ints = IECore.IntVectorData( intValues )
+		floats = IECore.FloatVectorData( struct.unpack( "{}f".format( n ), struct.pack( "{}i".format( n ), *intValues ) ) )
+
+		for compressed, uncompressed in [ ( "integer", "float" ), ( "float", "integer" ) ] :
+
+			options = IECore.CompoundData( {
+				"compressor" : "lz4",
+				"compressionLevel" : 9,
+				"compressionPolicies" : { uncompressed : { "compressionLevel" : 0 } }
+			} )
+
+			# Whichever order the data is written in, each block must be
+			# stored according to its own category's policy, rather than
+			# reusing the block written for the other category.
+			for order in [ ( ints, floats ), ( floats, ints ) ] :
+
+				f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Write, options = options )
+				for i, d in enumerate( order ) :
+					f.write( "data{}".format( i ), d )
+				del f
+
+				size = os.path.getsize( filePath )
+				self.assertGreater( size, n * 4 )
+				self.assertLess( size, n * 4 * 2 )
+
+				f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Read )
+				for i, d in enumerate( order ) :
+					self.assertEqual( f.read( "data{}".format( i ) ), d )
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testDuplicateWritePerformance( self ) :
+
+		filePath = os.path.join( ".", "test", "FileIndexedIO.fio" )
+		options = IECore.CompoundData( { "compressor" : "lz4", "compressionLevel" : 9 } )
+
+		data = IECore.IntVectorData( [ i % 1000 for i in range( 10 * 1024 * 1024 ) ] )
+
+		f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Write, options = options )
+
+		timer = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		for i in range( 100 ) :
+			f.write( str( i ), data )
+		print( "Duplicate writes : {:.3f}s".format( timer.totalElapsed() ) )
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testUniqueWritePerformance( self ) :
+
+		filePath = os.path.join( ".", "test", "FileIndexedIO.fio" )
+		options = IECore.CompoundData( { "compressor" : "lz4", "compressionLevel" : 9 } )
+
+		data = [
+			IECore.IntVectorData( [ ( i + j ) % 1000 for i in range( 1024 * 1024 ) ] )
+			for j in range( 100 )
+		]
+
+		f = IECore.IndexedIO.create( filePath, [], IECore.IndexedIO.OpenMode.Write, options = options )
+
+		timer = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		for i, d in enumerate( data ) :
+			f.write( str( i ), d )
+		print( "Unique writes : {:.3f}s".format( timer.totalElapsed() ) )
+
 	def setUp( self ):
 
 		if os.path.isfile(os.path.join( ".", "test", "FileIndexedIO.fio" )) :
@@ -189,5 +189,37 @@ class TestIndexedIOAlgo( unittest.TestCase ) :
 		self.assertEqual( stats[0], [0, 0, 0, 0, 1, 1] )
 		self.assertEqual( stats[1], [0, 0, 0, 0, 9, 18] )
 
+	def testBenchmarkCompression( self ) :
+
+		self.makeManyDirectoryTestFile()
+
+		src = IECore.FileIndexedIO( os.path.join( ".", "test", "FileIndexedIO.fio" ), [], IECore.IndexedIO.OpenMode.Read )
+		candidates = [
+			IECore.CompoundData( { "compressor" : "lz4", "compressionLevel" : 0 } ),
+			IECore.CompoundData( { "compressor" : "lz4", "compressionLevel" : 9 } ),
+			IECore.CompoundData( {
+				"compressor" : "lz4",
+				"compressionLevel" : 9,
+				"compressionPolicies" : { "float" : { "compressor" : "zlib", "shuffle" : "bit" } }
+			} ),
+		]
+
+		results = IECore.IndexedIOAlgo.benchmarkCompression( src, os.path.join( ".", "test", "FileIndexedIO2.fio" ), candidates )
+		self.assertEqual( len( results ), len( candidates ) )
+		for r in results :
+			self.assertEqual( set( r.keys() ), { "fileSize", "writeTime", "readTime" } )
+			self.assertGreaterEqual( r["writeTime"], 0 )
+			self.assertGreaterEqual( r["readTime"], 0 )
+
+		self.assertLess( results[1]["fileSize"], results[0]["fileSize"] )
+		self.assertEqual( results[2]["fileSize"], os.path.getsize( os.path.join( ".", "test", "FileIndexedIO2.fio" ) ) )
+
+		# The file should contain the result of copying with the last candidate.
+
+		self.assertEqual(
+			IECore.IndexedIOAlgo.parallelReadAll( IECore.FileIndexedIO( os.path.join( ".", "test", "FileIndexedIO2.fio" ), [], IECore.IndexedIO.OpenMode.Read ) ),
+			IECore.IndexedIOAlgo.parallelReadAll( src )
+		)
+
 if __name__ == "__main__" :
 	unittest.main()
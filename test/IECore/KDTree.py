@@ -32,6 +32,7 @@
 #
 ##########################################################################
 
+import os
 import random
 import unittest
 import imath
@@ -129,6 +130,32 @@ class TestKDTree:
 				else :
 					self.assertFalse( i in s )
 
+	def doBatchQueries( self, numPoints ) :
+
+		self.makeTree( numPoints )
+
+		nearest = self.tree.batchNearestNeighbour( self.points )
+		self.assertEqual( len( nearest ), numPoints )
+		for i in range( 0, numPoints ) :
+			self.assertEqual( nearest[i], self.tree.nearestNeighbour( self.points[i] ) )
+
+		for r in self.radii :
+			neighbours, offsets = self.tree.batchNearestNeighbours( self.points, r )
+			self.assertEqual( len( offsets ), numPoints + 1 )
+			self.assertEqual( offsets[-1], len( neighbours ) )
+			for i in range( 0, numPoints ) :
+				self.assertEqual(
+					sorted( neighbours[offsets[i]:offsets[i+1]] ),
+					sorted( self.tree.nearestNeighbours( self.points[i], r ) )
+				)
+
+		for n in self.numNeighbours :
+			neighbours = self.tree.batchNearestNNeighbours( self.points, n )
+			self.assertEqual( len( neighbours ), numPoints * n )
+			for i in range( 0, numPoints ) :
+				expected = list( self.tree.nearestNNeighbours( self.points[i], n ) )
+				expected += [ -1 ] * ( n - len( expected ) )
+				self.assertEqual( list( neighbours[i*n:(i+1)*n] ), expected )
 
 class TestKDTreeV2f(unittest.TestCase, TestKDTree):
 
@@ -178,6 +205,11 @@ class TestKDTreeV2f(unittest.TestCase, TestKDTree):
 		for t in self.treeSizes:
 			self.doEnclosedPoints(t)
 
+	def testBatchQueries( self ) :
+
+		for t in self.treeSizes :
+			self.doBatchQueries( t )
+
 class TestKDTreeV2d(unittest.TestCase, TestKDTree):
 
 	def makeTree(self, numPoints):
@@ -226,6 +258,11 @@ class TestKDTreeV2d(unittest.TestCase, TestKDTree):
 		for t in self.treeSizes:
 			self.doEnclosedPoints(t)
 
+	def testBatchQueries( self ) :
+
+		for t in self.treeSizes :
+			self.doBatchQueries( t )
+
 class TestKDTreeV3f(unittest.TestCase, TestKDTree):
 
 	def makeTree(self, numPoints):
@@ -274,6 +311,11 @@ class TestKDTreeV3f(unittest.TestCase, TestKDTree):
 		for t in self.treeSizes:
 			self.doEnclosedPoints(t)
 
+	def testBatchQueries( self ) :
+
+		for t in self.treeSizes :
+			self.doBatchQueries( t )
+
 class TestKDTreeV3d(unittest.TestCase, TestKDTree):
 
 	def makeTree(self, numPoints):
@@ -322,6 +364,38 @@ class TestKDTreeV3d(unittest.TestCase, TestKDTree):
 		for t in self.treeSizes:
 			self.doEnclosedPoints(t)
 
+	def testBatchQueries( self ) :
+
+		for t in self.treeSizes :
+			self.doBatchQueries( t )
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testBuildPerformance( self ) :
+
+		random.seed( 0 )
+		points = IECore.V3fVectorData( [ imath.V3f( random.random(), random.random(), random.random() ) for i in range( 0, 1000000 ) ] )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		IECore.V3fTree( points )
+		print( "Build : {:.3f}s".format( t.stop() ) )
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testBatchQueryPerformance( self ) :
+
+		random.seed( 0 )
+		points = IECore.V3fVectorData( [ imath.V3f( random.random(), random.random(), random.random() ) for i in range( 0, 1000000 ) ] )
+		queries = IECore.V3fVectorData( [ imath.V3f( random.random(), random.random(), random.random() ) for i in range( 0, 100000 ) ] )
+		tree = IECore.V3fTree( points )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		single = [ tree.nearestNNeighbours( q, 8 ) for q in queries ]
+		print( "Single : {:.3f}s".format( t.stop() ) )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		batch = tree.batchNearestNNeighbours( queries, 8 )
+		print( "Batch : {:.3f}s".format( t.stop() ) )
+
+		self.assertEqual( list( batch[:8] ), list( single[0] ) )
 
 if __name__ == "__main__":
 	unittest.main()
@@ -224,5 +224,131 @@ class TestMessageHandler( unittest.TestCase ) :
 
 		self.assertEqual( w(), None )
 
+	def testMaximumLevel( self ) :
+
+		self.assertEqual( IECore.NullMessageHandler().maximumLevel(), IECore.Msg.Level.Invalid )
+
+		h = IECore.LevelFilteredMessageHandler( IECore.NullMessageHandler(), IECore.Msg.Level.Warning )
+		self.assertEqual( h.maximumLevel(), IECore.Msg.Level.Warning )
+
+		c = IECore.CompoundMessageHandler()
+		self.assertEqual( c.maximumLevel(), IECore.Msg.Level.Error )
+		c.addHandler( h )
+		self.assertEqual( c.maximumLevel(), IECore.Msg.Level.Warning )
+		c.addHandler( IECore.LevelFilteredMessageHandler( IECore.NullMessageHandler(), IECore.Msg.Level.Info ) )
+		self.assertEqual( c.maximumLevel(), IECore.Msg.Level.Info )
+
+	def testEnabled( self ) :
+
+		with IECore.LevelFilteredMessageHandler( IECore.CapturingMessageHandler(), IECore.Msg.Level.Warning ) :
+
+			self.assertTrue( IECore.MessageHandler.enabled( IECore.Msg.Level.Error ) )
+			self.assertTrue( IECore.MessageHandler.enabled( IECore.Msg.Level.Warning ) )
+			self.assertFalse( IECore.MessageHandler.enabled( IECore.Msg.Level.Info ) )
+			self.assertFalse( IECore.MessageHandler.enabled( IECore.Msg.Level.Debug ) )
+
+		with IECore.CapturingMessageHandler() :
+
+			self.assertTrue( IECore.MessageHandler.enabled( IECore.Msg.Level.Debug ) )
+
+	def testSuppressedMessagesNotHandled( self ) :
+
+		m = IECore.CapturingMessageHandler()
+		with IECore.LevelFilteredMessageHandler( m, IECore.Msg.Level.Warning ) :
+			IECore.msg( IECore.Msg.Level.Debug, "test", "ignored" )
+			IECore.msg( IECore.Msg.Level.Error, "test", "kept" )
+
+		self.assertEqual( len( m.messages ), 1 )
+		self.assertEqual( m.messages[0].message, "kept" )
+
+	def testAsyncMessageHandler( self ) :
+
+		m = IECore.CapturingMessageHandler()
+		h = IECore.AsyncMessageHandler( m, capacity = 10 )
+		self.assertEqual( h.maximumLevel(), IECore.Msg.Level.Invalid )
+
+		with h :
+			for i in range( 0, 100 ) :
+				IECore.msg( IECore.Msg.Level.Info, "test", str( i ) )
+
+		h.flush()
+
+		# Messages output while the queue is full are forwarded
+		# immediately, so may overtake queued messages.
+		self.assertEqual( len( m.messages ), 100 )
+		for message in m.messages :
+			self.assertEqual( message.level, IECore.Msg.Level.Info )
+			self.assertEqual( message.context, "test" )
+		self.assertEqual( sorted( int( x.message ) for x in m.messages ), list( range( 0, 100 ) ) )
+
+	def testAsyncMessageHandlerWithPythonHandler( self ) :
+
+		# The wrapped handler needs the GIL to drain the queue, so this
+		# would deadlock if we held the GIL while waiting for the destructor
+		# to finish.
+
+		class SlowHandler( IECore.MessageHandler ) :
+
+			def __init__( self ) :
+
+				IECore.MessageHandler.__init__( self )
+				self.messages = []
+
+			def handle( self, level, context, message ) :
+
+				time.sleep( 0.001 )
+				self.messages.append( message )
+
+		m = SlowHandler()
+		h = IECore.AsyncMessageHandler( m, capacity = 2 )
+
+		with h :
+			for i in range( 0, 50 ) :
+				IECore.msg( IECore.Msg.Level.Info, "test", str( i ) )
+			for i in range( 50, 75 ) :
+				IECore.MessageHandler.output( IECore.Msg.Level.Info, "test", str( i ) )
+
+		for i in range( 75, 100 ) :
+			h.handle( IECore.Msg.Level.Info, "test", str( i ) )
+
+		del h
+		self.assertEqual( sorted( int( x ) for x in m.messages ), list( range( 0, 100 ) ) )
+
+	def testAsyncMessageHandlerFullQueueWithGILHeld( self ) :
+
+		# Calling `handle()` on a LevelFilteredMessageHandler outputs to the
+		# AsyncMessageHandler from C++ without releasing the GIL. If that
+		# waited for space in the queue, it would deadlock, because the
+		# Python handler needs the GIL to drain the queue.
+
+		class BlockingHandler( IECore.MessageHandler ) :
+
+			def __init__( self ) :
+
+				IECore.MessageHandler.__init__( self )
+				self.messages = []
+
+			def handle( self, level, context, message ) :
+
+				time.sleep( 0.01 )
+				self.messages.append( message )
+
+		m = BlockingHandler()
+		h = IECore.AsyncMessageHandler( m, capacity = 1 )
+		f = IECore.LevelFilteredMessageHandler( h, IECore.Msg.Level.Debug )
+
+		for i in range( 0, 20 ) :
+			f.handle( IECore.Msg.Level.Info, "test", str( i ) )
+
+		h.flush()
+		self.assertEqual( sorted( int( x ) for x in m.messages ), list( range( 0, 20 ) ) )
+
+	def testAsyncMessageHandlerMaximumLevel( self ) :
+
+		h = IECore.AsyncMessageHandler(
+			IECore.LevelFilteredMessageHandler( IECore.NullMessageHandler(), IECore.Msg.Level.Warning )
+		)
+		self.assertEqual( h.maximumLevel(), IECore.Msg.Level.Warning )
+
 if __name__ == "__main__":
     unittest.main()
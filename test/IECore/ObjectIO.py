@@ -262,6 +262,38 @@ class TestObjectIO( unittest.TestCase ) :
 		self.assertTrue( dd['c']['d'].isSame( dd['links']['v3'] ) )
 		self.assertTrue( dd['c/d'].isSame( dd['links']['v3'] ) )
 
+	def testParallelLoad( self ) :
+
+		shared = IECore.IntVectorData( range( 0, 1000 ) )
+
+		o = IECore.CompoundObject()
+		for i in range( 0, 100 ) :
+			m = IECore.CompoundData()
+			m["value"] = IECore.FloatVectorData( [ i ] * 1000 )
+			m["shared"] = shared
+			o["member{}".format( i )] = m
+		o["vector"] = IECore.ObjectVector( [ shared, IECore.StringData( "a" ), shared ] )
+
+		fio = IECore.FileIndexedIO( os.path.join( "test", "o.fio" ), [], IECore.IndexedIO.OpenMode.Write )
+		o.save( fio, "test" )
+		del fio
+
+		fio = IECore.FileIndexedIO( os.path.join( "test", "o.fio" ), [], IECore.IndexedIO.OpenMode.Read )
+		oo = IECore.Object.load( fio, "test", parallel = True )
+		self.assertEqual( oo, o )
+
+		# Shared instances must remain shared, no matter which
+		# thread loaded them first.
+		s = oo["vector"][0]
+		self.assertTrue( oo["vector"][2].isSame( s ) )
+		for i in range( 0, 100 ) :
+			self.assertTrue( oo["member{}".format( i )]["shared"].isSame( s ) )
+
+		canceller = IECore.Canceller()
+		canceller.cancel()
+		with self.assertRaises( IECore.Cancelled ) :
+			IECore.Object.load( fio, "test", canceller, parallel = True )
+
 	def tearDown( self ) :
 
 		for f in [ os.path.join( "test", "o.fio" ), os.path.join( "test", "FileIndexedIOSlashes.fio" ) ] :
@@ -128,3 +128,89 @@ class StandardRadialLensModelTest(unittest.TestCase):
 		self.assertEqual( l2.typeName(), "StandardRadialLensModel" )
 		self.assertEqual( l2["distortion"].getNumericValue(), 0.2 )
 
+	def __lens( self, distortion = 0.2 ) :
+
+		lens = IECore.LensModel.create( "StandardRadialLensModel" )
+		lens["distortion"] = distortion
+		lens["curvatureX"] = 0.2
+		lens["curvatureY"] = 0.5
+		lens["quarticDistortion"] = .1
+		lens["lensCenterOffsetXCm"] = .25
+		lens["lensCenterOffsetYCm"] = -.1
+		lens.validate()
+		return lens
+
+	def testSTMap( self ) :
+
+		lens = self.__lens()
+		resolution = imath.V2i( 64, 48 )
+
+		for mode in ( IECore.LensModel.Distort, IECore.LensModel.Undistort ) :
+
+			stMap = lens.stMap( mode, resolution )
+			self.assertEqual( stMap.mode(), mode )
+			self.assertEqual( stMap.resolution(), resolution )
+
+			evaluate = lens.distort if mode == IECore.LensModel.Distort else lens.undistort
+			for y in range( 0, resolution.y + 1, 7 ) :
+				for x in range( 0, resolution.x + 1, 5 ) :
+					uv = imath.V2d( x, y ) / imath.V2d( resolution )
+					self.assertTrue( stMap.sample( x, y ).equalWithAbsError( evaluate( uv ), 1e-6 ) )
+					self.assertTrue( stMap.lookup( uv ).equalWithAbsError( evaluate( uv ), 1e-6 ) )
+
+			# Interpolated lookups should be within the reported error.
+
+			maxError = lens.stMapError( stMap )
+			self.assertGreater( maxError, 0 )
+			for uv in ( imath.V2d( 0.33, 0.71 ), imath.V2d( 0.5, 0.5 ), imath.V2d( 0.91, 0.07 ) ) :
+				error = ( stMap.lookup( uv ) - evaluate( uv ) ) * imath.V2d( resolution )
+				self.assertLessEqual( error.length(), maxError * 1.1 )
+
+			# The error should reduce as the resolution increases.
+
+			self.assertLess( lens.stMapError( lens.stMap( mode, resolution * 4 ) ), maxError )
+
+	def testSTMapCache( self ) :
+
+		lens1 = self.__lens()
+		lens2 = self.__lens()
+		lens3 = self.__lens( distortion = 0.1 )
+
+		resolution = imath.V2i( 32, 32 )
+		stMap1 = lens1.stMap( IECore.LensModel.Undistort, resolution )
+		self.assertTrue( lens2.stMap( IECore.LensModel.Undistort, resolution ).isSame( stMap1 ) )
+		self.assertFalse( lens3.stMap( IECore.LensModel.Undistort, resolution ).isSame( stMap1 ) )
+		self.assertFalse( lens1.stMap( IECore.LensModel.Distort, resolution ).isSame( stMap1 ) )
+		self.assertFalse( lens1.stMap( IECore.LensModel.Undistort, imath.V2i( 32, 16 ) ).isSame( stMap1 ) )
+
+		limit = IECore.LensModel.getSTMapCacheMemoryLimit()
+		try :
+			IECore.LensModel.setSTMapCacheMemoryLimit( 0 )
+			self.assertFalse( lens1.stMap( IECore.LensModel.Undistort, resolution ).isSame( stMap1 ) )
+		finally :
+			IECore.LensModel.setSTMapCacheMemoryLimit( limit )
+
+	def testSTMapValidates( self ) :
+
+		lens = self.__lens()
+		resolution = imath.V2i( 32, 32 )
+		stMap1 = lens.stMap( IECore.LensModel.Undistort, resolution )
+
+		# Change the parameters without calling `validate()`. The
+		# map must still reflect the new values.
+		lens["distortion"] = 0.1
+		stMap2 = lens.stMap( IECore.LensModel.Undistort, resolution )
+		self.assertFalse( stMap2.isSame( stMap1 ) )
+		self.assertTrue( stMap2.isSame( self.__lens( distortion = 0.1 ).stMap( IECore.LensModel.Undistort, resolution ) ) )
+
+		uv = imath.V2d( 0.25, 0.75 )
+		self.assertTrue( stMap2.sample( 8, 24 ).equalWithAbsError( lens.undistort( uv ), 1e-6 ) )
+
+	def testSTMapErrors( self ) :
+
+		lens = self.__lens()
+		self.assertRaises( Exception, lens.stMap, 2, imath.V2i( 10 ) )
+		self.assertRaises( Exception, lens.stMap, IECore.LensModel.Distort, imath.V2i( 0, 10 ) )
+
+if __name__ == "__main__":
+	unittest.main()
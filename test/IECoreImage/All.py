@@ -48,6 +48,7 @@ from ClampOpTest import ClampOpTest
 from ColorAlgoTest import ColorAlgoTest
 from DisplayDriverServerTest import DisplayDriverServerTest
 from EnvMapSamplerTest import EnvMapSamplerTest
+from HdrMergeOpTest import HdrMergeOpTest
 from FontTest import FontTest
 from ImageCropOpTest import ImageCropOpTest
 from ImageDiffOpTest import ImageDiffOpTest
@@ -0,0 +1,163 @@
+##########################################################################
+#
+#  Copyright (c) 2026, Image Engine Design Inc. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions are
+#  met:
+#
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#
+#     * Neither the name of Image Engine Design nor the names of any
+#       other contributors to this software may be used to endorse or
+#       promote products derived from this software without specific prior
+#       written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+#  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+##########################################################################
+
+
+import os
+import random
+import struct
+import unittest
+import imath
+import IECore
+import IECoreImage
+
+class HdrMergeOpTest( unittest.TestCase ) :
+
+	@staticmethod
+	def __float32( x ) :
+
+		return struct.unpack( "f", struct.pack( "f", x ) )[0]
+
+	def __smoothstep( self, v0, v1, v ) :
+
+		f = self.__float32
+		x = f( f( v - v0 ) / f( v1 - v0 ) )
+		if x > 0 :
+			if x < 1 :
+				return f( f( f( 3 - f( 2 * x ) ) * x ) * x )
+			return 1.0
+		return 0.0
+
+	## A serial implementation of the merge, accumulating one image at a time and
+	# rounding to single precision after every operation, as the original code did.
+	def __referenceMerge( self, images, exposureStep, exposureAdjustment, windowing ) :
+
+		f = self.__float32
+		pixelCount = len( images[0]["R"] )
+		outR = [ 0.0 ] * pixelCount
+		outG = [ 0.0 ] * pixelCount
+		outB = [ 0.0 ] * pixelCount
+		outA = [ 0.0 ] * pixelCount
+
+		exposure = exposureStep * ( len( images ) - 1 ) / 2.0
+		for imageIndex, image in enumerate( images ) :
+			intensityMultiplier = f( 2.0 ** exposure )
+			inR, inG, inB = image["R"], image["G"], image["B"]
+			for i in range( 0, pixelCount ) :
+				intensity = f( f( f( inR[i] + inG[i] ) + inB[i] ) / 3.0 )
+				weight = self.__smoothstep( windowing.min()[0], windowing.min()[1], intensity )
+				if imageIndex :
+					weight = f( weight * f( 1 - self.__smoothstep( windowing.max()[0], windowing.max()[1], intensity ) ) )
+				m = f( weight * intensityMultiplier )
+				outR[i] = f( outR[i] + f( inR[i] * m ) )
+				outG[i] = f( outG[i] + f( inG[i] * m ) )
+				outB[i] = f( outB[i] + f( inB[i] * m ) )
+				outA[i] = f( outA[i] + weight )
+			exposure -= exposureStep
+
+		adjustment = f( 2.0 ** -exposureAdjustment )
+		for i in range( 0, pixelCount ) :
+			w = f( adjustment * outA[i] )
+			if w > 0 :
+				outR[i] = f( outR[i] / w )
+				outG[i] = f( outG[i] / w )
+				outB[i] = f( outB[i] / w )
+
+		return { "R" : outR, "G" : outG, "B" : outB, "A" : outA }
+
+	def __assertChannelsEqual( self, data, expected ) :
+
+		self.assertEqual( data.size(), len( expected ) )
+		for a, b in zip( data, expected ) :
+			self.assertAlmostEqual( a, b, delta = 1e-5 * max( 1.0, abs( b ) ) )
+
+	def testMatchesReference( self ) :
+
+		# Large enough to be split across many tasks, with an offset
+		# data window.
+		window = imath.Box2i( imath.V2i( -5, 10 ), imath.V2i( 194, 109 ) )
+		pixelCount = 200 * 100
+
+		r = random.Random( 1 )
+		images = []
+		for exposure in [ 0.25, 0.5, 1.0 ] :
+			image = IECoreImage.ImagePrimitive( window, window )
+			for c in [ "R", "G", "B" ] :
+				image[c] = IECore.FloatVectorData( [ min( r.random() * exposure, 1.0 ) for i in range( 0, pixelCount ) ] )
+			images.append( image )
+
+		windowing = imath.Box2f( imath.V2f( 0.0, 0.05 ), imath.V2f( 0.9, 1.0 ) )
+		result = IECoreImage.HdrMergeOp()(
+			inputImages = IECore.ObjectVector( images ),
+			exposureStep = 1.0,
+			exposureAdjustment = 1.0,
+			windowing = windowing,
+		)
+
+		self.assertEqual( result.dataWindow, window )
+		self.assertEqual( result.displayWindow, window )
+		self.assertEqual( sorted( result.keys() ), [ "A", "B", "G", "R" ] )
+
+		expected = self.__referenceMerge( [ { c : list( i[c] ) for c in "RGB" } for i in images ], 1, 1, windowing )
+		for c in [ "R", "G", "B", "A" ] :
+			self.__assertChannelsEqual( result[c], expected[c] )
+
+	def testMismatchedResolutions( self ) :
+
+		images = []
+		for size in [ 10, 20 ] :
+			window = imath.Box2i( imath.V2i( 0 ), imath.V2i( size - 1 ) )
+			image = IECoreImage.ImagePrimitive( window, window )
+			for c in [ "R", "G", "B" ] :
+				image[c] = IECore.FloatVectorData( [ 0.5 ] * ( size * size ) )
+			images.append( image )
+
+		self.assertRaisesRegex( RuntimeError, "Images are not of the same resolution", IECoreImage.HdrMergeOp(), inputImages = IECore.ObjectVector( images ) )
+
+	@unittest.skipUnless( os.environ.get( "CORTEX_PERFORMANCE_TEST", False ), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testPerformance( self ) :
+
+		window = imath.Box2i( imath.V2i( 0 ), imath.V2i( 8191, 4095 ) )
+		images = []
+		for value in [ 0.1, 0.4, 0.8 ] :
+			image = IECoreImage.ImagePrimitive( window, window )
+			for c in [ "R", "G", "B" ] :
+				image[c] = IECore.FloatVectorData( [ value ] * ( 8192 * 4096 ) )
+			images.append( image )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		IECoreImage.HdrMergeOp()( inputImages = IECore.ObjectVector( images ) )
+		print( "\nHdrMergeOp : {:.3f}s".format( t.stop() ) )
+
+if __name__ == "__main__":
+	unittest.main()
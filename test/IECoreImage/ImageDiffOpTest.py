@@ -32,6 +32,8 @@
 #
 ##########################################################################
 
+import math
+import random
 import unittest
 import sys
 import os
@@ -172,6 +174,57 @@ class ImageDiffOpTest(unittest.TestCase):
 
 		self.assertFalse( res.value )
 
+	def testMatchesReference( self ) :
+
+		# Large enough to be split across many tiles, with data
+		# windows which differ from the display window.
+		displayWindow = imath.Box2i( imath.V2i( -10, 20 ), imath.V2i( 389, 219 ) )
+		dataWindowA = imath.Box2i( imath.V2i( -10, 20 ), imath.V2i( 389, 219 ) )
+		dataWindowB = imath.Box2i( imath.V2i( 0, 30 ), imath.V2i( 299, 199 ) )
+
+		r = random.Random( 1 )
+		imageA = IECoreImage.ImagePrimitive( dataWindowA, displayWindow )
+		imageB = IECoreImage.ImagePrimitive( dataWindowB, displayWindow )
+		for c in [ "R", "G" ] :
+			imageA[c] = IECore.FloatVectorData( [ r.random() for i in range( 0, imageA.channelSize() ) ] )
+			imageB[c] = IECore.FloatVectorData( [ r.random() for i in range( 0, imageB.channelSize() ) ] )
+
+		# Serially compute the RMS error of each channel, with
+		# pixels outside a data window treated as zero.
+		def value( data, window, x, y ) :
+			if x < window.min().x or x > window.max().x or y < window.min().y or y > window.max().y :
+				return 0.0
+			return data[(y-window.min().y)*(window.size().x+1)+(x-window.min().x)]
+
+		maxRMS = 0
+		for c in [ "R", "G" ] :
+			a = list( imageA[c] )
+			b = list( imageB[c] )
+			sumSquaredError = 0.0
+			for y in range( displayWindow.min().y, displayWindow.max().y + 1 ) :
+				for x in range( displayWindow.min().x, displayWindow.max().x + 1 ) :
+					sumSquaredError += ( value( a, dataWindowA, x, y ) - value( b, dataWindowB, x, y ) ) ** 2
+			pixelCount = ( displayWindow.size().x + 1 ) * ( displayWindow.size().y + 1 )
+			maxRMS = max( maxRMS, math.sqrt( sumSquaredError / pixelCount ) )
+
+		op = IECoreImage.ImageDiffOp()
+		self.assertTrue( op( imageA = imageA, imageB = imageB, maxError = maxRMS * 0.9999 ).value )
+		self.assertFalse( op( imageA = imageA, imageB = imageB, maxError = maxRMS * 1.0001 ).value )
+
+	@unittest.skipUnless( os.environ.get( "CORTEX_PERFORMANCE_TEST", False ), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testPerformance( self ) :
+
+		window = imath.Box2i( imath.V2i( 0 ), imath.V2i( 8191, 4095 ) )
+		imageA = IECoreImage.ImagePrimitive( window, window )
+		imageB = IECoreImage.ImagePrimitive( window, window )
+		for c in [ "R", "G", "B", "A" ] :
+			imageA[c] = IECore.FloatVectorData( [ 0.5 ] * ( 8192 * 4096 ) )
+			imageB[c] = IECore.FloatVectorData( [ 0.25 ] * ( 8192 * 4096 ) )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		IECoreImage.ImageDiffOp()( imageA = imageA, imageB = imageB, maxError = 1.0 )
+		print( "\nImageDiffOp : {:.3f}s".format( t.stop() ) )
+
 
 if __name__ == "__main__":
 	unittest.main()
@@ -39,6 +39,7 @@ import gc
 import glob
 import sys
 import time
+import threading
 import imath
 import IECore
 import IECoreImage
@@ -138,6 +139,101 @@ class ImageDisplayDriverTest(unittest.TestCase):
 		i = dd.image()
 		self.assertEqual( i["Y"], y )
 
+	def testConcurrentBuckets( self ) :
+
+		dataWindow = imath.Box2i( imath.V2i( 3, 5 ), imath.V2i( 130, 100 ) )
+		bucketSize = 16
+
+		for channelNames in ( [ "Y" ], [ "R", "G", "B" ], [ "R", "G", "B", "A" ], [ "R", "G", "B", "A", "Z" ] ) :
+
+			dd = IECoreImage.ImageDisplayDriver( dataWindow, dataWindow, channelNames, IECore.CompoundData() )
+
+			buckets = []
+			for y in range( dataWindow.min().y, dataWindow.max().y + 1, bucketSize ) :
+				for x in range( dataWindow.min().x, dataWindow.max().x + 1, bucketSize ) :
+					box = imath.Box2i(
+						imath.V2i( x, y ),
+						imath.V2i( min( x + bucketSize - 1, dataWindow.max().x ), min( y + bucketSize - 1, dataWindow.max().y ) )
+					)
+					data = IECore.FloatVectorData()
+					for by in range( box.min().y, box.max().y + 1 ) :
+						for bx in range( box.min().x, box.max().x + 1 ) :
+							for c in range( 0, len( channelNames ) ) :
+								data.append( bx + by * 1000 + c * 0.25 )
+					buckets.append( ( box, data ) )
+
+			def sendBuckets( i ) :
+				for box, data in buckets[i::4] :
+					dd.imageData( box, data )
+
+			threads = [ threading.Thread( target = sendBuckets, args = ( i, ) ) for i in range( 0, 4 ) ]
+			for t in threads :
+				t.start()
+			for t in threads :
+				t.join()
+
+			dd.imageClose()
+
+			image = dd.image()
+			self.assertEqual( image.keys(), sorted( channelNames ) )
+			for c, name in enumerate( channelNames ) :
+				i = 0
+				channel = image[name]
+				for y in range( dataWindow.min().y, dataWindow.max().y + 1 ) :
+					for x in range( dataWindow.min().x, dataWindow.max().x + 1 ) :
+						self.assertEqual( channel[i], x + y * 1000 + c * 0.25 )
+						i += 1
+
+	def testImageIsUnaffectedByLaterData( self ) :
+
+		window = imath.Box2i( imath.V2i( 0 ), imath.V2i( 15 ) )
+		dd = IECoreImage.ImageDisplayDriver( window, window, [ "Y" ], IECore.CompoundData() )
+
+		dd.imageData( window, IECore.FloatVectorData( [ 1 ] * 16 * 16 ) )
+		i1 = dd.image()
+		self.assertEqual( i1["Y"], IECore.FloatVectorData( [ 1 ] * 16 * 16 ) )
+		self.assertEqual( dd.image(), i1 )
+
+		dd.imageData( imath.Box2i( imath.V2i( 0 ), imath.V2i( 15, 7 ) ), IECore.FloatVectorData( [ 0.5 ] * 16 * 8 ) )
+		dd.imageClose()
+
+		self.assertEqual( i1["Y"], IECore.FloatVectorData( [ 1 ] * 16 * 16 ) )
+		self.assertEqual( dd.image()["Y"], IECore.FloatVectorData( [ 0.5 ] * 16 * 8 + [ 1 ] * 16 * 8 ) )
+
+	def testStoredImageIsUnaffectedByLaterData( self ) :
+
+		window = imath.Box2i( imath.V2i( 0 ), imath.V2i( 15 ) )
+		dd = IECoreImage.ImageDisplayDriver( window, window, [ "Y" ], IECore.CompoundData( { "handle" : "unaffectedHandle" } ) )
+
+		dd.imageData( window, IECore.FloatVectorData( [ 1 ] * 16 * 16 ) )
+		i1 = IECoreImage.ImageDisplayDriver.storedImage( "unaffectedHandle" )
+		self.assertEqual( i1["Y"], IECore.FloatVectorData( [ 1 ] * 16 * 16 ) )
+
+		dd.imageData( imath.Box2i( imath.V2i( 0 ), imath.V2i( 15, 7 ) ), IECore.FloatVectorData( [ 0.5 ] * 16 * 8 ) )
+		self.assertEqual( i1["Y"], IECore.FloatVectorData( [ 1 ] * 16 * 16 ) )
+
+		dd.imageClose()
+		del dd
+
+		i2 = IECoreImage.ImageDisplayDriver.removeStoredImage( "unaffectedHandle" )
+		self.assertEqual( i1["Y"], IECore.FloatVectorData( [ 1 ] * 16 * 16 ) )
+		self.assertEqual( i2["Y"], IECore.FloatVectorData( [ 0.5 ] * 16 * 8 + [ 1 ] * 16 * 8 ) )
+		self.assertEqual( IECoreImage.ImageDisplayDriver.storedImage( "unaffectedHandle" ), None )
+
+	def testRepeatedChannelNames( self ) :
+
+		window = imath.Box2i( imath.V2i( 0 ), imath.V2i( 15 ) )
+		dd = IECoreImage.ImageDisplayDriver( window, window, [ "R", "G", "R" ], IECore.CompoundData() )
+
+		# As before, the last occurrence of a channel takes precedence.
+		dd.imageData( window, IECore.FloatVectorData( [ 1, 2, 3 ] * 16 * 16 ) )
+		dd.imageClose()
+
+		image = dd.image()
+		self.assertEqual( image.keys(), [ "G", "R" ] )
+		self.assertEqual( image["R"], IECore.FloatVectorData( [ 3 ] * 16 * 16 ) )
+		self.assertEqual( image["G"], IECore.FloatVectorData( [ 2 ] * 16 * 16 ) )
+
 class ClientServerDisplayDriverTest(unittest.TestCase):
 
 	def setUp( self ):
@@ -262,6 +358,184 @@ class ClientServerDisplayDriverTest(unittest.TestCase):
 		i = IECoreImage.ImageDisplayDriver.removeStoredImage( "myHandle" )
 		self.assertEqual( i["Y"], y )
 
+	# Returns the transferred image, and the driver used to send it.
+	def __transfer( self, image, parameters, bucketSize = 32, passes = 1 ) :
+
+		channelNames = sorted( image.keys() )
+		dd = IECoreImage.ClientDisplayDriver( image.displayWindow, image.dataWindow, channelNames, parameters )
+
+		dataWindow = image.dataWindow
+		width = dataWindow.size().x + 1
+		buckets = []
+		for y in range( dataWindow.min().y, dataWindow.max().y + 1, bucketSize ) :
+			for x in range( dataWindow.min().x, dataWindow.max().x + 1, bucketSize ) :
+				box = imath.Box2i(
+					imath.V2i( x, y ),
+					imath.V2i( min( x + bucketSize - 1, dataWindow.max().x ), min( y + bucketSize - 1, dataWindow.max().y ) )
+				)
+				data = IECore.FloatVectorData()
+				for by in range( box.min().y, box.max().y + 1 ) :
+					for bx in range( box.min().x, box.max().x + 1 ) :
+						i = ( by - dataWindow.min().y ) * width + bx - dataWindow.min().x
+						for c in channelNames :
+							data.append( image[c][i] )
+				buckets.append( ( box, data ) )
+
+		for p in range( 0, passes ) :
+			for box, data in buckets :
+				dd.imageData( box, data )
+
+		dd.imageClose()
+
+		return IECoreImage.ImageDisplayDriver.removeStoredImage( parameters["handle"].value ), dd
+
+	def testCompressedTransfer( self ) :
+
+		img = IECore.Reader.create( os.path.join( "test", "IECoreImage", "data", "tiff", "bluegreen_noise.400x300.tif" ) )()
+		img.blindData().clear()
+
+		for compression in ( "none", "lossless", "half" ) :
+
+			newImg, dd = self.__transfer(
+				img,
+				IECore.CompoundData( {
+					"displayHost" : "localhost",
+					"displayPort" : "1559",
+					"remoteDisplayType" : "ImageDisplayDriver",
+					"handle" : "myHandle",
+					"displayCompression" : compression,
+				} )
+			)
+
+			if compression == "half" :
+				self.assertEqual( newImg.keys(), img.keys() )
+				for c in img.keys() :
+					for a, b in zip( img[c], newImg[c] ) :
+						self.assertAlmostEqual( a, b, delta = abs( a ) / 1024.0 + 1e-6 )
+			else :
+				self.assertEqual( newImg, img )
+
+	def testSharedMemoryTransfer( self ) :
+
+		img = IECore.Reader.create( os.path.join( "test", "IECoreImage", "data", "tiff", "bluegreen_noise.400x300.tif" ) )()
+		img.blindData().clear()
+
+		for compression in ( "none", "lossless" ) :
+			for bucketSize, passes in [
+				( 32, 1 ),
+				# Repeated passes wrap around the ring buffer,
+				# which is sized to hold a single pass.
+				( 37, 4 ),
+				# A single bucket filling the whole ring buffer.
+				( 1024, 2 ),
+			] :
+
+				newImg, dd = self.__transfer(
+					img,
+					IECore.CompoundData( {
+						"displayHost" : "localhost",
+						"displayPort" : "1559",
+						"remoteDisplayType" : "ImageDisplayDriver",
+						"handle" : "myHandle",
+						"displayCompression" : compression,
+						"displaySharedMemory" : True,
+					} ),
+					bucketSize = bucketSize,
+					passes = passes
+				)
+
+				self.assertEqual( newImg, img )
+				self.assertTrue( dd.sharedMemory() )
+				size = img.dataWindow.size() + imath.V2i( 1 )
+				numBuckets = ( ( size.x + bucketSize - 1 ) // bucketSize ) * ( ( size.y + bucketSize - 1 ) // bucketSize )
+				self.assertEqual( dd.numSharedMemoryBuckets(), numBuckets * passes )
+
+	def testSharedMemoryFallback( self ) :
+
+		img = IECore.Reader.create( os.path.join( "test", "IECoreImage", "data", "tiff", "bluegreen_noise.400x300.tif" ) )()
+		img.blindData().clear()
+
+		for compression in ( "none", "lossless" ) :
+			for parameters in [
+				# Shared memory not requested.
+				{},
+				{ "displaySharedMemory" : False },
+			] :
+
+				parameters.update( {
+					"displayHost" : "localhost",
+					"displayPort" : "1559",
+					"remoteDisplayType" : "ImageDisplayDriver",
+					"handle" : "myHandle",
+					"displayCompression" : compression,
+				} )
+
+				newImg, dd = self.__transfer( img, IECore.CompoundData( parameters ) )
+
+				self.assertEqual( newImg, img )
+				self.assertFalse( dd.sharedMemory() )
+				self.assertEqual( dd.numSharedMemoryBuckets(), 0 )
+
+	def testInvalidCompression( self ) :
+
+		window = imath.Box2i( imath.V2i( 0 ), imath.V2i( 15 ) )
+		with self.assertRaisesRegex( Exception, "Unknown displayCompression" ) :
+			IECoreImage.ClientDisplayDriver(
+				window, window, [ "Y" ],
+				IECore.CompoundData( {
+					"displayHost" : "localhost",
+					"displayPort" : "1559",
+					"remoteDisplayType" : "ImageDisplayDriver",
+					"displayCompression" : "lzma",
+				} )
+			)
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testTransferPerformance( self ) :
+
+		dataWindow = imath.Box2i( imath.V2i( 0 ), imath.V2i( 1919, 1079 ) )
+		channelNames = [ "R", "G", "B", "A", "Z", "N.x", "N.y", "N.z" ]
+		bucketSize = 64
+
+		buckets = []
+		for y in range( 0, dataWindow.max().y + 1, bucketSize ) :
+			for x in range( 0, dataWindow.max().x + 1, bucketSize ) :
+				box = imath.Box2i(
+					imath.V2i( x, y ),
+					imath.V2i( min( x + bucketSize - 1, dataWindow.max().x ), min( y + bucketSize - 1, dataWindow.max().y ) )
+				)
+				numPixels = ( box.size().x + 1 ) * ( box.size().y + 1 )
+				data = IECore.FloatVectorData( [ ( ( x + y + i ) % 255 ) / 255.0 for i in range( 0, numPixels * len( channelNames ) ) ] )
+				buckets.append( ( box, data ) )
+
+		for compression, sharedMemory in [
+			( "none", False ),
+			( "lossless", False ),
+			( "half", False ),
+			( "none", True ),
+		] :
+
+			t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+
+			dd = IECoreImage.ClientDisplayDriver(
+				dataWindow, dataWindow, channelNames,
+				IECore.CompoundData( {
+					"displayHost" : "localhost",
+					"displayPort" : "1559",
+					"remoteDisplayType" : "ImageDisplayDriver",
+					"handle" : "myHandle",
+					"displayCompression" : compression,
+					"displaySharedMemory" : sharedMemory,
+				} )
+			)
+
+			for box, data in buckets :
+				dd.imageData( box, data )
+			dd.imageClose()
+
+			print( "\n{}{} : {:.3f}s".format( compression, " (shared memory)" if sharedMemory else "", t.stop() ) )
+			IECoreImage.ImageDisplayDriver.removeStoredImage( "myHandle" )
+
 	def tearDown( self ):
 
 		self.server = None
@@ -742,6 +742,43 @@ class ImageWriterTest( unittest.TestCase ) :
 		w.write()
 		self.assertEqual( IECore.Reader.create( os.path.join( "test", "IECoreImage", "data", "exr", "output.exr" ) ).readHeader()["compression"].value, "zips" )
 
+	def testEXRTileSizeParameter( self ) :
+
+		# Deliberately not a multiple of the tile size, with
+		# the data window offset from the origin.
+		dataWindow = imath.Box2i( imath.V2i( 5, 10 ), imath.V2i( 304, 209 ) )
+		displayWindow = imath.Box2i( imath.V2i( 0 ), imath.V2i( 319, 239 ) )
+		imgOrig = self.__makeFloatImage( dataWindow, displayWindow, withAlpha = True )
+
+		w = IECore.Writer.create( imgOrig, os.path.join( "test", "IECoreImage", "data", "exr", "output.exr" ) )
+		w['formatSettings']['openexr']['dataType'].setValue( 'float' )
+
+		for tileSize in w['formatSettings']['openexr']['tileSize'].getPresets().values() :
+
+			w['formatSettings']['openexr']['tileSize'].setValue( tileSize )
+			w.write()
+
+			imgNew = IECore.Reader.create( os.path.join( "test", "IECoreImage", "data", "exr", "output.exr" ) ).read()
+			self.assertEqual( imgNew.dataWindow, dataWindow )
+			self.assertEqual( imgNew.displayWindow, displayWindow )
+			for c in [ "R", "G", "B", "A" ] :
+				self.assertEqual( imgNew[c], imgOrig[c] )
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testWritePerformance( self ) :
+
+		dataWindow = imath.Box2i( imath.V2i( 0 ), imath.V2i( 8191, 4095 ) )
+		img = IECoreImage.ImagePrimitive( dataWindow, dataWindow )
+		for c in [ "R", "G", "B", "A", "Z", "N.x", "N.y", "N.z" ] :
+			img[c] = IECore.FloatVectorData( [ 0.5 ] * ( 8192 * 4096 ) )
+
+		w = IECore.Writer.create( img, os.path.join( "test", "IECoreImage", "data", "exr", "output.exr" ) )
+		for tileSize in ( 0, 64 ) :
+			w['formatSettings']['openexr']['tileSize'].setTypedValue( tileSize )
+			t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+			w.write()
+			print( "\nTile size {} : {:.3f}s".format( tileSize, t.stop() ) )
+
 	def testJPGQualityParameter( self ) :
 
 		w = imath.Box2i(
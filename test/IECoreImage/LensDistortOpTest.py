@@ -35,6 +35,7 @@
 import sys
 import unittest
 import os
+import imath
 import IECore
 import IECoreImage
 
@@ -69,3 +70,121 @@ class LensDistortOpTest(unittest.TestCase):
 
 		self.assertEqual( img.displayWindow, img2.displayWindow )
 
+	def __lensModel( self ) :
+
+		o = IECore.CompoundObject()
+		o["lensModel"] = IECore.StringData( "StandardRadialLensModel" )
+		o["distortion"] = IECore.DoubleData( 0.2 )
+		o["anamorphicSqueeze"] = IECore.DoubleData( 1. )
+		o["curvatureX"] = IECore.DoubleData( 0.2 )
+		o["curvatureY"] = IECore.DoubleData( 0.5 )
+		o["quarticDistortion"] = IECore.DoubleData( .1 )
+
+		return o
+
+	def testWarpField( self ) :
+
+		img = IECore.Reader.create( os.path.join( "test", "IECoreImage", "data", "exr", "uvMapWithDataWindow.100x100.exr" ) ).read()
+
+		op = IECoreImage.LensDistortOp()
+		self.assertEqual( op.lastWarpField(), None )
+
+		out = op( input = img, mode = IECore.LensModel.Undistort, lensModel = self.__lensModel() )
+
+		warpField = op.lastWarpField()
+		self.assertIsInstance( warpField, IECore.V2fVectorData )
+		dataWindow = out.dataWindow
+		self.assertEqual( len( warpField ), ( dataWindow.size().x + 1 ) * ( dataWindow.size().y + 1 ) )
+
+		# Reusing the warp field must give an identical result.
+
+		out2 = IECoreImage.LensDistortOp()( input = img, mode = IECore.LensModel.Undistort, lensModel = self.__lensModel(), warpField = warpField )
+		self.assertEqual( out2, out )
+
+		# A field of the wrong size is an error.
+
+		warpField = warpField.copy()
+		warpField.append( imath.V2f( 0 ) )
+		self.assertRaises(
+			RuntimeError, IECoreImage.LensDistortOp(),
+			input = img, mode = IECore.LensModel.Undistort, lensModel = self.__lensModel(), warpField = warpField
+		)
+
+	def testCacheSTMap( self ) :
+
+		img = IECore.Reader.create( os.path.join( "test", "IECoreImage", "data", "exr", "uvMapWithDataWindow.100x100.exr" ) ).read()
+
+		op = IECoreImage.LensDistortOp()
+		self.assertEqual( op["cacheSTMap"].getTypedValue(), False )
+
+		out = op( input = img, mode = IECore.LensModel.Undistort, lensModel = self.__lensModel() )
+		warpField = op.lastWarpField()
+
+		cachedOut = op( input = img, mode = IECore.LensModel.Undistort, lensModel = self.__lensModel(), cacheSTMap = True )
+		cachedWarpField = op.lastWarpField()
+
+		# The ST-map stores samples as float offsets, so the results match
+		# to within float precision rather than exactly.
+		self.assertEqual( cachedOut.dataWindow, out.dataWindow )
+		self.assertEqual( len( cachedWarpField ), len( warpField ) )
+		for p1, p2 in zip( warpField, cachedWarpField ) :
+			self.assertTrue( p1.equalWithAbsError( p2, 1e-3 ) )
+
+	def testFilterAndBoundModes( self ) :
+
+		img = IECore.Reader.create( os.path.join( "test", "IECoreImage", "data", "exr", "uvMapWithDataWindow.100x100.exr" ) ).read()
+
+		noFilter = int( getattr( IECoreImage.WarpOp.FilterType, "None" ) )
+		for filterType in ( noFilter, int( IECoreImage.WarpOp.FilterType.Bilinear ) ) :
+			for boundMode in ( int( IECoreImage.WarpOp.BoundMode.Clamp ), int( IECoreImage.WarpOp.BoundMode.SetToBlack ) ) :
+
+				op = IECoreImage.LensDistortOp()
+				out = op(
+					input = img, mode = IECore.LensModel.Undistort, lensModel = self.__lensModel(),
+					filter = filterType, boundMode = boundMode
+				)
+				self.assertTrue( out.channelsValid() )
+				self.assertEqual( set( out.keys() ), set( img.keys() ) )
+
+				if filterType != noFilter :
+					continue
+
+				# Unfiltered resampling must match sampling the input at
+				# each position in the warp field.
+				warpField = op.lastWarpField()
+				inWindow = img.dataWindow
+				inWidth = inWindow.size().x + 1
+				inHeight = inWindow.size().y + 1
+				for i in range( 0, len( warpField ), 97 ) :
+					p = warpField[i]
+					x = int( p.x ) - inWindow.min().x
+					y = int( p.y ) - inWindow.min().y
+					if x < 0 or x >= inWidth or y < 0 or y >= inHeight :
+						if boundMode == int( IECoreImage.WarpOp.BoundMode.SetToBlack ) :
+							self.assertEqual( out["R"][i], 0 )
+						else :
+							x = min( max( x, 0 ), inWidth - 1 )
+							y = min( max( y, 0 ), inHeight - 1 )
+							self.assertEqual( out["R"][i], img["R"][y*inWidth+x] )
+					else :
+						self.assertEqual( out["R"][i], img["R"][y*inWidth+x] )
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testPerformance( self ) :
+
+		img = IECoreImage.ImagePrimitive.createRGBFloat( imath.Color3f( 0.5 ), imath.Box2i( imath.V2i( 0 ), imath.V2i( 4095, 2159 ) ), imath.Box2i( imath.V2i( 0 ), imath.V2i( 4095, 2159 ) ) )
+		img["A"] = img["R"].copy()
+		img["Z"] = img["R"].copy()
+		img["ZBack"] = img["R"].copy()
+
+		op = IECoreImage.LensDistortOp()
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		op( input = img, mode = IECore.LensModel.Undistort, lensModel = self.__lensModel() )
+		print( "Computing warp field : {:.3f}s".format( t.stop() ) )
+
+		warpField = op.lastWarpField()
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		op( input = img, mode = IECore.LensModel.Undistort, lensModel = self.__lensModel(), warpField = warpField )
+		print( "Reusing warp field : {:.3f}s".format( t.stop() ) )
+
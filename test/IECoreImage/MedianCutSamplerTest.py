@@ -72,6 +72,39 @@ class MedianCutSamplerTest( unittest.TestCase ) :
 
 		self.assertEqual( areaSum, luminanceImage.channelSize() )
 
+	def testChannelName( self ) :
+
+		image = IECore.Reader.create( os.path.join( "test", "IECoreImage", "data", "exr", "carPark.exr" ) ).read()
+		for n in ["R", "G", "B"] :
+			p = image[n]
+			p.data = IECore.DataCastOp()( object=image[n], targetType=IECore.FloatVectorData.staticTypeId() )
+			image[n] = p
+
+		luminanceImage = IECoreImage.LuminanceOp()( input=image )
+		s = IECoreImage.MedianCutSampler()( image=luminanceImage, subdivisionDepth=6 )
+
+		# Sampling a channel other than "Y" should give identical results.
+		renamedImage = luminanceImage.copy()
+		renamedImage["L"] = renamedImage["Y"]
+		del renamedImage["Y"]
+		s2 = IECoreImage.MedianCutSampler()( image=renamedImage, channelName="L", subdivisionDepth=6 )
+
+		self.assertEqual( s2, s )
+		self.assertEqual( len( s["areas"] ), 64 )
+
+	@unittest.skipUnless( os.environ.get( "CORTEX_PERFORMANCE_TEST", False ), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testPerformance( self ) :
+
+		b = imath.Box2i( imath.V2i( 0 ), imath.V2i( 8191, 4095 ) )
+		image = IECoreImage.ImagePrimitive( b, b )
+		image["Y"] = IECore.FloatVectorData( [ float( i % 8192 ) / 8192 for i in range( 0, 8192 * 4096 ) ] )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		s = IECoreImage.MedianCutSampler()( image=image, subdivisionDepth=10, projection=IECoreImage.MedianCutSampler.Projection.LatLong )
+		print( "\nMedianCutSampler : {:.3f}s".format( t.stop() ) )
+
+		self.assertEqual( len( s["areas"] ), 1024 )
+
 if __name__ == "__main__":
 	unittest.main()
 
@@ -32,6 +32,7 @@
 #
 ##########################################################################
 
+import os
 import unittest
 import math
 import imath
@@ -54,5 +55,43 @@ class SummedAreaOpTest( unittest.TestCase ) :
 		self.assertEqual( yy[2], 4 )
 		self.assertEqual( yy[3], 10 )
 
+	def testMatchesReference( self ) :
+
+		# Large enough to be split across many tasks, with
+		# an offset data window.
+		b = imath.Box2i( imath.V2i( -10, 20 ), imath.V2i( 612, 421 ) )
+		width = b.size().x + 1
+		height = b.size().y + 1
+
+		values = [ float( ( i * 7 ) % 13 ) for i in range( 0, width * height ) ]
+
+		i = IECoreImage.ImagePrimitive( b, b )
+		i["Y"] = IECore.FloatVectorData( values )
+		i["I"] = IECore.IntVectorData( [ int( v ) for v in values ] )
+
+		ii = IECoreImage.SummedAreaOp()( input=i, channels=IECore.StringVectorData( [ "Y", "I" ] ) )
+
+		expected = []
+		for y in range( 0, height ) :
+			rowSum = 0
+			for x in range( 0, width ) :
+				rowSum += values[y*width+x]
+				expected.append( rowSum + ( expected[(y-1)*width+x] if y else 0 ) )
+
+		self.assertEqual( ii["Y"], IECore.FloatVectorData( expected ) )
+		self.assertEqual( ii["I"], IECore.IntVectorData( [ int( v ) for v in expected ] ) )
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testPerformance( self ) :
+
+		b = imath.Box2i( imath.V2i( 0 ), imath.V2i( 8191, 4095 ) )
+		i = IECoreImage.ImagePrimitive( b, b )
+		for c in [ "R", "G", "B", "A" ] :
+			i[c] = IECore.FloatVectorData( [ 0.5 ] * ( 8192 * 4096 ) )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		IECoreImage.SummedAreaOp()( input=i, copyInput=False, channels=IECore.StringVectorData( [ "R", "G", "B", "A" ] ) )
+		print( "\nSummedAreaOp : {:.3f}s".format( t.stop() ) )
+
 if __name__ == "__main__":
     unittest.main()
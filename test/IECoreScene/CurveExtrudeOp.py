@@ -60,6 +60,29 @@ class CurveExtrudeOpTest( unittest.TestCase ) :
 
 			self.assertTrue( child.arePrimitiveVariablesValid() )
 
+	def testChildOrder( self ) :
+
+		numCurves = 100
+		p = IECore.V3fVectorData()
+		for c in range( 0, numCurves ) :
+			for i in range( 0, 4 + c % 3 ) :
+				p.append( imath.V3f( i, 0, c * 10 ) )
+
+		curves = IECoreScene.CurvesPrimitive(
+			IECore.IntVectorData( [ 4 + c % 3 for c in range( 0, numCurves ) ] ),
+			IECore.CubicBasisf.catmullRom(), False, p
+		)
+		curves["id"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Uniform, IECore.IntVectorData( range( 0, numCurves ) ) )
+		curves["constantwidth"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Constant, IECore.FloatData( 0.5 ) )
+
+		patchGroup = IECoreScene.CurveExtrudeOp()( curves = curves, resolution = imath.V2i( 6, 10 ) )
+		self.assertEqual( len( patchGroup.children() ), numCurves )
+
+		for c, child in enumerate( patchGroup.children() ) :
+			self.assertTrue( child.arePrimitiveVariablesValid() )
+			self.assertEqual( child["id"].data, IECore.IntData( c ) )
+			self.assertAlmostEqual( child.bound().center().z, c * 10, 4 )
+
 if __name__ == "__main__":
     unittest.main()
 
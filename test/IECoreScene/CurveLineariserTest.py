@@ -33,6 +33,7 @@
 ##########################################################################
 
 import unittest
+import math
 import imath
 import os
 import tempfile
@@ -333,6 +334,126 @@ class CurveLineariserTest( unittest.TestCase ) :
 
 		self.runTest( c )
 
+	def testMatchesSerialReference( self ) :
+
+		# Reference implementation, evaluating each output vertex
+		# one at a time at the parameters documented for `linearise()`.
+
+		def linearise( curves, verticesPerSegment ) :
+
+			e = IECoreScene.CurvesPrimitiveEvaluator( curves )
+			r = e.createResult()
+
+			verticesPerCurve = []
+			values = { k : [] for k in curves.keys() }
+			for curveIndex in range( 0, curves.numCurves() ) :
+
+				numVertices = max( int( math.floor( verticesPerSegment * curves.numSegments( curveIndex ) ) ), 3 if curves.periodic() else 2 )
+				verticesPerCurve.append( numVertices )
+				vStep = 1.0 / ( numVertices if curves.periodic() else numVertices - 1 )
+
+				for i in range( 0, numVertices ) :
+					self.assertTrue( e.pointAtV( curveIndex, min( vStep * i, 1.0 ), r ) )
+					for k in curves.keys() :
+						if curves[k].interpolation in ( IECoreScene.PrimitiveVariable.Interpolation.Vertex, IECoreScene.PrimitiveVariable.Interpolation.Varying ) :
+							values[k].append( r.primVar( curves[k] ) )
+
+			return verticesPerCurve, values
+
+		for basis, periodic, verticesPerCurve in [
+			( IECore.CubicBasisf.bezier(), False, [ 7, 4, 10 ] ),
+			( IECore.CubicBasisf.bezier(), True, [ 6, 3, 9 ] ),
+			( IECore.CubicBasisf.bSpline(), False, [ 6, 4, 9 ] ),
+			( IECore.CubicBasisf.bSpline(), True, [ 6, 4, 9 ] ),
+			( IECore.CubicBasisf.catmullRom(), False, [ 6, 4, 9 ] ),
+			( IECore.CubicBasisf.catmullRom(), True, [ 6, 4, 9 ] ),
+		] :
+
+			numVertices = sum( verticesPerCurve )
+			c = IECoreScene.CurvesPrimitive(
+				IECore.IntVectorData( verticesPerCurve ),
+				basis,
+				periodic,
+				IECore.V3fVectorData( [ imath.V3f( i, i % 2, ( i * 7 ) % 3 ) for i in range( 0, numVertices ) ] )
+			)
+
+			numVarying = c.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Varying )
+			c["a"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Vertex, IECore.FloatVectorData( [ ( i * 5 ) % 7 for i in range( 0, numVertices ) ] ) )
+			c["b"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Varying, IECore.Color3fVectorData( [ imath.Color3f( i, i % 3, 1 ) for i in range( 0, numVarying ) ] ) )
+			c["c"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Uniform, IECore.IntVectorData( [ 1, 2, 3 ] ) )
+			self.assertTrue( c.arePrimitiveVariablesValid() )
+
+			for verticesPerSegment in ( 1, 7 ) :
+
+				c2 = IECoreScene.CurvesAlgo.linearise( c, verticesPerSegment )
+				self.assertTrue( c2.arePrimitiveVariablesValid() )
+				self.assertEqual( c2, IECoreScene.CurveLineariser()( input = c, verticesPerSegment = verticesPerSegment ) )
+
+				expectedVerticesPerCurve, expectedValues = linearise( c, verticesPerSegment )
+				self.assertEqual( list( c2.verticesPerCurve() ), expectedVerticesPerCurve )
+				self.assertEqual( c2.basis(), IECore.CubicBasisf.linear() )
+				self.assertEqual( c2.periodic(), periodic )
+				self.assertEqual( c2["c"], c["c"] )
+
+				for k in ( "P", "a", "b" ) :
+					self.assertEqual( len( c2[k].data ), len( expectedValues[k] ) )
+					for value, expectedValue in zip( c2[k].data, expectedValues[k] ) :
+						if isinstance( value, float ) :
+							self.assertAlmostEqual( value, expectedValue, places = 4 )
+						else :
+							self.assertTrue( value.equalWithAbsError( expectedValue, 1e-4 ) )
+
+	def testIndexedPrimitiveVariable( self ) :
+
+		c = IECoreScene.CurvesPrimitive(
+			IECore.IntVectorData( [ 4 ] ),
+			IECore.CubicBasisf.bSpline(),
+			False,
+			IECore.V3fVectorData( [ imath.V3f( i, 0, 0 ) for i in range( 0, 4 ) ] )
+		)
+		c["a"] = IECoreScene.PrimitiveVariable(
+			IECoreScene.PrimitiveVariable.Interpolation.Vertex,
+			IECore.FloatVectorData( [ 1, 2 ] ), IECore.IntVectorData( [ 0, 0, 1, 1 ] )
+		)
+
+		c2 = IECoreScene.CurvesAlgo.linearise( c, 10 )
+		self.assertTrue( c2.arePrimitiveVariablesValid() )
+		self.assertEqual( c2["a"].indices, None )
+
+		c["a"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Vertex, c["a"].expandedData() )
+		self.assertEqual( c2["a"], IECoreScene.CurvesAlgo.linearise( c, 10 )["a"] )
+
+	def testCancellation( self ) :
+
+		c = IECoreScene.CurvesPrimitive(
+			IECore.IntVectorData( [ 4 ] * 1000 ),
+			IECore.CubicBasisf.bSpline(),
+			False,
+			IECore.V3fVectorData( [ imath.V3f( i ) for i in range( 0, 4000 ) ] )
+		)
+
+		canceller = IECore.Canceller()
+		canceller.cancel()
+		self.assertRaises( IECore.Cancelled, IECoreScene.CurvesAlgo.linearise, c, 10, canceller )
+
+	@unittest.skipUnless( os.environ.get( "CORTEX_PERFORMANCE_TEST", False ), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testPerformance( self ) :
+
+		numCurves = 2000000
+		c = IECoreScene.CurvesPrimitive(
+			IECore.IntVectorData( [ 6 ] * numCurves ),
+			IECore.CubicBasisf.catmullRom(),
+			False,
+			IECore.V3fVectorData( [ imath.V3f( i ) for i in range( 0, numCurves * 6 ) ] )
+		)
+		c["width"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Varying, IECore.FloatVectorData( [ 1 ] * c.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Varying ) ) )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		c2 = IECoreScene.CurveLineariser()( input = c, verticesPerSegment = 10 )
+		print( "CurveLineariser : {} curves in {:.3f}s".format( numCurves, t.stop() ) )
+
+		self.assertEqual( c2.numCurves(), numCurves )
+
 if __name__ == "__main__":
 	unittest.main()
 
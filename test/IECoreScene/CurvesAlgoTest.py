@@ -36,6 +36,7 @@ import IECoreScene
 
 import IECore
 
+import os
 import imath
 import unittest
 
@@ -1709,6 +1710,26 @@ class CurvesAlgoDeleteCurvesTest ( unittest.TestCase ):
 		curves = self.curvesBad()
 		self.assertRaises( RuntimeError, IECoreScene.CurvesAlgo.deleteCurves, curves, deletePrimVar )
 
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testDeleteCurvesPerformance( self ) :
+
+		numCurves = 2500000
+		curves = IECoreScene.CurvesPrimitive(
+			IECore.IntVectorData( [ 4 ] * numCurves ),
+			IECore.CubicBasisf.catmullRom(),
+			False,
+			IECore.V3fVectorData( [ imath.V3f( i ) for i in range( numCurves * 4 ) ] )
+		)
+		curves["width"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Varying, IECore.FloatVectorData( range( curves.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Varying ) ) ) )
+		curves["curveIndex"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Uniform, IECore.IntVectorData( range( numCurves ) ) )
+		deleteFlag = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Uniform, IECore.IntVectorData( [ i % 3 for i in range( numCurves ) ] ) )
+
+		timer = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		result = IECoreScene.CurvesAlgo.deleteCurves( curves, deleteFlag )
+		print( "deleteCurves : {} vertices in {:.3f}s".format( curves.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Vertex ), timer.totalElapsed() ) )
+
+		self.assertTrue( result.arePrimitiveVariablesValid() )
+
 
 class CurvesAlgoUpdateEndpointMultiplicityTest( unittest.TestCase ):
 
@@ -1245,6 +1245,206 @@ class CurvesPrimitiveEvaluatorTest( unittest.TestCase ) :
 
 		self.assertTrue( isinstance( e, IECoreScene.CurvesPrimitiveEvaluator ) )
 
+	def __randomCurves( self, basis, periodic = False, numCurves = 10, seed = 0 ) :
+
+		rand = imath.Rand32( seed )
+
+		p = IECore.V3fVectorData()
+		vertsPerCurve = IECore.IntVectorData()
+		for c in range( 0, numCurves ) :
+			numSegments = int( rand.nextf( 1, 10 ) )
+			if basis == IECore.CubicBasisf.linear() :
+				numVerts = numSegments + ( 2 if periodic else 1 )
+			else :
+				numVerts = ( 3 + numSegments ) if periodic else ( 4 + basis.step * ( numSegments - 1 ) )
+			vertsPerCurve.append( numVerts )
+			for i in range( 0, numVerts ) :
+				p.append( imath.V3f( rand.nextf(), rand.nextf(), rand.nextf() ) + imath.V3f( c * 2 ) )
+
+		return IECoreScene.CurvesPrimitive( vertsPerCurve, basis, periodic, p )
+
+	def testPointsAtV( self ) :
+
+		for basis in ( IECore.CubicBasisf.linear(), IECore.CubicBasisf.bezier(), IECore.CubicBasisf.bSpline(), IECore.CubicBasisf.catmullRom() ) :
+			for periodic in ( False, True ) :
+
+				if periodic and basis == IECore.CubicBasisf.bezier() :
+					continue
+
+				curves = self.__randomCurves( basis, periodic )
+				e = IECoreScene.CurvesPrimitiveEvaluator( curves )
+				r = e.createResult()
+
+				curveIndices = IECore.IntVectorData()
+				v = IECore.FloatVectorData()
+				for c in range( 0, curves.numCurves() ) :
+					for i in range( 0, 20 ) :
+						curveIndices.append( c )
+						v.append( i / 19.0 )
+
+				positions, tangents = e.pointsAtV( curveIndices, v )
+				self.assertEqual( len( positions ), len( v ) )
+				self.assertEqual( len( tangents ), len( v ) )
+				self.assertEqual( positions.getInterpretation(), IECore.GeometricData.Interpretation.Point )
+
+				for i in range( 0, len( v ) ) :
+					self.assertTrue( e.pointAtV( curveIndices[i], v[i], r ) )
+					self.assertEqual( positions[i], r.point() )
+					self.assertEqual( tangents[i], r.vTangent() )
+
+	def testPrimVarAtV( self ) :
+
+		curves = self.__randomCurves( IECore.CubicBasisf.catmullRom() )
+		curves["vertexFloat"] = IECoreScene.PrimitiveVariable(
+			IECoreScene.PrimitiveVariable.Interpolation.Vertex,
+			IECore.FloatVectorData( [ float( i ) for i in range( 0, curves.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Vertex ) ) ] )
+		)
+		curves["uniformColor"] = IECoreScene.PrimitiveVariable(
+			IECoreScene.PrimitiveVariable.Interpolation.Uniform,
+			IECore.Color3fVectorData( [ imath.Color3f( i ) for i in range( 0, curves.numCurves() ) ] )
+		)
+		curves["indexedUniformInt"] = IECoreScene.PrimitiveVariable(
+			IECoreScene.PrimitiveVariable.Interpolation.Uniform,
+			IECore.IntVectorData( [ 10, 20 ] ),
+			IECore.IntVectorData( [ i % 2 for i in range( 0, curves.numCurves() ) ] )
+		)
+		curves["constantV2f"] = IECoreScene.PrimitiveVariable(
+			IECoreScene.PrimitiveVariable.Interpolation.Constant,
+			IECore.V2fData( imath.V2f( 1, 2 ) )
+		)
+
+		e = IECoreScene.CurvesPrimitiveEvaluator( curves )
+		r = e.createResult()
+
+		curveIndices = IECore.IntVectorData( [ c for c in range( 0, curves.numCurves() ) for i in range( 0, 5 ) ] )
+		v = IECore.FloatVectorData( [ i / 4.0 for c in range( 0, curves.numCurves() ) for i in range( 0, 5 ) ] )
+
+		floats = e.primVarAtV( curves["vertexFloat"], curveIndices, v )
+		self.assertTrue( isinstance( floats, IECore.FloatVectorData ) )
+		colors = e.primVarAtV( curves["uniformColor"], curveIndices, v )
+		self.assertTrue( isinstance( colors, IECore.Color3fVectorData ) )
+		ints = e.primVarAtV( curves["indexedUniformInt"], curveIndices, v )
+		self.assertTrue( isinstance( ints, IECore.IntVectorData ) )
+		v2fs = e.primVarAtV( curves["constantV2f"], curveIndices, v )
+		self.assertTrue( isinstance( v2fs, IECore.V2fVectorData ) )
+
+		for i in range( 0, len( v ) ) :
+			e.pointAtV( curveIndices[i], v[i], r )
+			self.assertEqual( floats[i], r.floatPrimVar( curves["vertexFloat"] ) )
+			self.assertEqual( colors[i], r.colorPrimVar( curves["uniformColor"] ) )
+			self.assertEqual( ints[i], 10 if curveIndices[i] % 2 == 0 else 20 )
+			self.assertEqual( v2fs[i], imath.V2f( 1, 2 ) )
+
+		curves["string"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Constant, IECore.StringData( "a" ) )
+		self.assertRaises( Exception, e.primVarAtV, curves["string"], curveIndices, v )
+
+	def testBatchQueryErrors( self ) :
+
+		curves = self.__randomCurves( IECore.CubicBasisf.linear(), numCurves = 2 )
+		e = IECoreScene.CurvesPrimitiveEvaluator( curves )
+
+		self.assertRaisesRegex( Exception, "does not match", e.pointsAtV, IECore.IntVectorData( [ 0, 1 ] ), IECore.FloatVectorData( [ 0 ] ) )
+		self.assertRaisesRegex( Exception, "Curve index 2 out of range", e.pointsAtV, IECore.IntVectorData( [ 0, 2 ] ), IECore.FloatVectorData( [ 0, 0 ] ) )
+		self.assertRaisesRegex( Exception, "out of range", e.pointsAtV, IECore.IntVectorData( [ 0, 1 ] ), IECore.FloatVectorData( [ 0, 1.5 ] ) )
+		self.assertRaisesRegex( Exception, "Curve index -1 out of range", e.vAtLengths, IECore.IntVectorData( [ -1 ] ), IECore.FloatVectorData( [ 0 ] ) )
+
+	def testClosestPoints( self ) :
+
+		for basis in ( IECore.CubicBasisf.linear(), IECore.CubicBasisf.bSpline() ) :
+
+			curves = self.__randomCurves( basis )
+			e = IECoreScene.CurvesPrimitiveEvaluator( curves )
+			r = e.createResult()
+
+			rand = imath.Rand32()
+			points = IECore.V3fVectorData( [ imath.V3f( rand.nextf( -1, 20 ), rand.nextf( -1, 20 ), rand.nextf( -1, 20 ) ) for i in range( 0, 1000 ) ] )
+
+			curveIndices, v = e.closestPoints( points )
+			self.assertEqual( len( curveIndices ), len( points ) )
+			self.assertEqual( len( v ), len( points ) )
+
+			for i in range( 0, len( points ) ) :
+				self.assertTrue( e.closestPoint( points[i], r ) )
+				self.assertEqual( curveIndices[i], r.curveIndex() )
+				self.assertEqual( v[i], r.uv()[1] )
+
+	def testVAtLength( self ) :
+
+		# Linear curves are measured exactly.
+
+		c = IECoreScene.CurvesPrimitive(
+			IECore.IntVectorData( [ 3 ] ), IECore.CubicBasisf.linear(), False,
+			IECore.V3fVectorData( [ imath.V3f( 0 ), imath.V3f( 1, 0, 0 ), imath.V3f( 1, 3, 0 ) ] )
+		)
+		e = IECoreScene.CurvesPrimitiveEvaluator( c )
+
+		self.assertEqual( e.vAtLength( 0, -1 ), 0 )
+		self.assertEqual( e.vAtLength( 0, 0 ), 0 )
+		self.assertAlmostEqual( e.vAtLength( 0, 0.5 ), 0.25, 6 )
+		self.assertAlmostEqual( e.vAtLength( 0, 1 ), 0.5, 6 )
+		self.assertAlmostEqual( e.vAtLength( 0, 2.5 ), 0.75, 6 )
+		self.assertEqual( e.vAtLength( 0, 4 ), 1 )
+		self.assertEqual( e.vAtLength( 0, 10 ), 1 )
+		self.assertRaises( Exception, e.vAtLength, 1, 0 )
+
+		# Cubic curves agree with `curveLength()`.
+
+		curves = self.__randomCurves( IECore.CubicBasisf.catmullRom() )
+		e = IECoreScene.CurvesPrimitiveEvaluator( curves )
+		for c in range( 0, curves.numCurves() ) :
+			length = e.curveLength( c )
+			self.assertAlmostEqual( e.vAtLength( c, length ), 1, 4 )
+			for f in ( 0.1, 0.25, 0.5, 0.9 ) :
+				v = e.vAtLength( c, length * f )
+				self.assertAlmostEqual( e.curveLength( c, 0, v ) / length, f, 2 )
+
+		curveIndices = IECore.IntVectorData( [ 0, 1, 2 ] )
+		lengths = IECore.FloatVectorData( [ 0.1, 0.2, 0.3 ] )
+		v = e.vAtLengths( curveIndices, lengths )
+		for i in range( 0, 3 ) :
+			self.assertEqual( v[i], e.vAtLength( curveIndices[i], lengths[i] ) )
+
+	def testUniformLengthSamples( self ) :
+
+		c = IECoreScene.CurvesPrimitive(
+			IECore.IntVectorData( [ 3, 2 ] ), IECore.CubicBasisf.linear(), False,
+			IECore.V3fVectorData( [ imath.V3f( 0 ), imath.V3f( 1, 0, 0 ), imath.V3f( 1, 3, 0 ), imath.V3f( 0 ), imath.V3f( 0, 0, 2 ) ] )
+		)
+		e = IECoreScene.CurvesPrimitiveEvaluator( c )
+
+		curveIndices, v = e.uniformLengthSamples( 5 )
+		self.assertEqual( curveIndices, IECore.IntVectorData( [ 0 ] * 5 + [ 1 ] * 5 ) )
+
+		positions, tangents = e.pointsAtV( curveIndices, v )
+		expected = [
+			imath.V3f( 0 ), imath.V3f( 1, 0, 0 ), imath.V3f( 1, 1, 0 ), imath.V3f( 1, 2, 0 ), imath.V3f( 1, 3, 0 ),
+			imath.V3f( 0 ), imath.V3f( 0, 0, 0.5 ), imath.V3f( 0, 0, 1 ), imath.V3f( 0, 0, 1.5 ), imath.V3f( 0, 0, 2 ),
+		]
+		for i in range( 0, len( expected ) ) :
+			self.assertTrue( positions[i].equalWithAbsError( expected[i], 0.00001 ) )
+
+		curveIndices, v = e.uniformLengthSamples( 0 )
+		self.assertEqual( len( curveIndices ), 0 )
+		self.assertEqual( len( v ), 0 )
+
+	@unittest.skipUnless( os.environ.get( "CORTEX_PERFORMANCE_TEST", False ), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testBatchPerformance( self ) :
+
+		curves = self.__randomCurves( IECore.CubicBasisf.catmullRom(), numCurves = 100000 )
+		e = IECoreScene.CurvesPrimitiveEvaluator( curves )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		curveIndices, v = e.uniformLengthSamples( 20 )
+		print( "uniformLengthSamples : {:.3f}s".format( t.stop() ) )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		positions, tangents = e.pointsAtV( curveIndices, v )
+		print( "pointsAtV ({} points) : {:.3f}s".format( len( v ), t.stop() ) )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		e.closestPoints( positions )
+		print( "closestPoints including tree build : {:.3f}s".format( t.stop() ) )
+
 	def testParallelResultCreation( self ) :
 
 		IECoreScene.testCurvesPrimitiveEvaluatorParallelResultCreation()
@@ -36,6 +36,7 @@ import IECore
 
 import IECoreScene
 
+import os
 import unittest
 import imath
 
@@ -390,5 +391,18 @@ class MeshAlgoDeleteFacesTest( unittest.TestCase ) :
 
 		self.assertRaises( RuntimeError, IECoreScene.MeshAlgo.deleteFaces, planeMesh, primvarDelete  )
 
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testDeleteFacesPerformance( self ) :
+
+		mesh = IECoreScene.MeshPrimitive.createPlane( imath.Box2f( imath.V2f( 0 ), imath.V2f( 1 ) ), imath.V2i( 3163 ) )
+		mesh["faceIndex"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Uniform, IECore.IntVectorData( range( mesh.numFaces() ) ) )
+		deleteFlag = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Uniform, IECore.IntVectorData( [ i % 3 for i in range( mesh.numFaces() ) ] ) )
+
+		timer = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		result = IECoreScene.MeshAlgo.deleteFaces( mesh, deleteFlag )
+		print( "deleteFaces : {} faces in {:.3f}s".format( mesh.numFaces(), timer.totalElapsed() ) )
+
+		self.assertTrue( result.arePrimitiveVariablesValid() )
+
 if __name__ == "__main__":
 	unittest.main()
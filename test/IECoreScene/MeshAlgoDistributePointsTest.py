@@ -34,6 +34,7 @@
 
 import os
 import re
+import struct
 import sys
 import unittest
 import imath
@@ -177,6 +178,193 @@ class MeshAlgoDistributePointsTest( unittest.TestCase ) :
 
 		self.assertEqual( p, p2 )
 
+	@staticmethod
+	def __float32( x ) :
+
+		return struct.unpack( "f", struct.pack( "f", x ) )[0]
+
+	## A serial reimplementation of the original `distributePoints()`, which
+	# emitted points via a MeshPrimitiveEvaluator one triangle at a time. Used
+	# as an independent reference for the optimised implementation.
+	def __referencePoints( self, mesh, density, offset = imath.V2f( 0 ) ) :
+
+		mesh = IECoreScene.MeshAlgo.triangulate( mesh )
+		faceArea = IECoreScene.MeshAlgo.calculateFaceArea( mesh ).data
+		textureArea = IECoreScene.MeshAlgo.calculateFaceTextureArea( mesh ).data
+		if "density" not in mesh :
+			mesh["density"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Constant, IECore.FloatData( 1 ) )
+
+		uvs = mesh["uv"].expandedData()
+		if mesh["uv"].interpolation == IECoreScene.PrimitiveVariable.Interpolation.Vertex :
+			uvs = IECore.V2fVectorData( [ uvs[i] for i in mesh.vertexIds ] )
+
+		evaluator = IECoreScene.MeshPrimitiveEvaluator( mesh )
+		result = evaluator.createResult()
+		positions = IECore.V3fVectorData()
+
+		for i in range( 0, mesh.numFaces() ) :
+
+			# Match the single precision arithmetic of the C++ implementation.
+			textureDensity = self.__float32( self.__float32( density * faceArea[i] ) / textureArea[i] )
+			uv0, uv1, uv2 = [ uvs[i*3+j] + offset for j in range( 0, 3 ) ]
+
+			def densitySampler( pos ) :
+				bary = IECore.triangleContainsPoint( uv0, uv1, uv2, pos )
+				if bary is False :
+					return 0
+				evaluator.barycentricPosition( i, bary, result )
+				return result.floatPrimVar( mesh["density"] )
+
+			def pointEmitter( pos ) :
+				evaluator.barycentricPosition( i, IECore.triangleContainsPoint( uv0, uv1, uv2, pos ), result )
+				positions.append( result.point() )
+
+			uvBounds = imath.Box2f()
+			for uv in ( uv0, uv1, uv2 ) :
+				uvBounds.extendBy( uv )
+
+			IECore.PointDistribution.defaultInstance()( uvBounds, textureDensity, densitySampler, pointEmitter )
+
+		return positions
+
+	def __assertMatchesReference( self, points, reference ) :
+
+		self.assertEqual( points.numPoints, reference.size() )
+		for p, r in zip( points["P"].data, reference ) :
+			self.assertTrue( p.equalWithAbsError( r, 1e-6 ) )
+
+	def testPointDistributor( self ) :
+
+		m = IECore.Reader.create( os.path.join( "test", "IECore", "data", "cobFiles", "pCubeShape1.cob" ) ).read()
+		m = IECoreScene.MeshAlgo.triangulate( m )
+		numFaces = m.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Uniform )
+		# The reference thresholds via a density sampler, which never emits
+		# points where the density is zero, so keep the mask positive.
+		m["density"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Uniform, IECore.FloatVectorData( [ float(x+1)/numFaces for x in range( 0, numFaces ) ] ) )
+
+		distributor = IECoreScene.MeshAlgo.PointDistributor( m )
+		for density, offset in [ ( 0, imath.V2f( 0 ) ), ( 100, imath.V2f( 0 ) ), ( 1000, imath.V2f( 0.5, 0.25 ) ) ] :
+			reference = self.__referencePoints( m, density, offset )
+			self.__assertMatchesReference( distributor.distribute( density = density, offset = offset ), reference )
+			self.__assertMatchesReference( IECoreScene.MeshAlgo.distributePoints( mesh = m, density = density, offset = offset ), reference )
+
+		# Vertex UVs, and enough points to be divided between several threads.
+		plane = IECoreScene.MeshPrimitive.createPlane( imath.Box2f( imath.V2f( -1 ), imath.V2f( 1 ) ), imath.V2i( 20 ) )
+		plane["uv"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Vertex, plane["uv"].data )
+		self.__assertMatchesReference(
+			IECoreScene.MeshAlgo.PointDistributor( plane ).distribute( density = 5000 ),
+			self.__referencePoints( plane, 5000 )
+		)
+
+	def testPointDistributorChunks( self ) :
+
+		m = IECore.Reader.create( os.path.join( "test", "IECore", "data", "cobFiles", "pCubeShape1.cob" ) ).read()
+		distributor = IECoreScene.MeshAlgo.PointDistributor( m )
+		expected = distributor.distribute( density = 20000 )["P"].data
+
+		for chunkSize in [ 1000, 4096, expected.size(), expected.size() + 1 ] :
+
+			chunks = []
+			distributor.distributeChunks( chunks.append, chunkSize, density = 20000 )
+
+			for chunk in chunks[:-1] :
+				self.assertEqual( chunk.size(), chunkSize )
+			self.assertGreater( chunks[-1].size(), 0 )
+			self.assertLessEqual( chunks[-1].size(), chunkSize )
+
+			points = IECore.V3fVectorData()
+			for chunk in chunks :
+				points.extend( chunk )
+			self.assertEqual( points, expected )
+
+		chunks = []
+		distributor.distributeChunks( chunks.append, 100, density = 0 )
+		self.assertEqual( chunks, [] )
+
+	def testPointDistributorMaxPointsPerFace( self ) :
+
+		m = IECoreScene.MeshPrimitive.createPlane( imath.Box2f( imath.V2f( -1 ), imath.V2f( 1 ) ), imath.V2i( 4 ) )
+		distributor = IECoreScene.MeshAlgo.PointDistributor( m )
+
+		self.assertEqual( distributor.distribute( density = 1000, maxPointsPerFace = 1000000 ), distributor.distribute( density = 1000 ) )
+
+		# Each triangle has an area of 0.125, so the limit overrides the requested density.
+		p = distributor.distribute( density = 10000, maxPointsPerFace = 100 )
+		self.pointTest( m, p, 100 / 0.125 )
+		self.assertEqual( distributor.distribute( density = 1000, maxPointsPerFace = 0 ).numPoints, 0 )
+
+	def testPointDistributorPositions( self ) :
+
+		m = IECore.Reader.create( os.path.join( "test", "IECore", "data", "cobFiles", "pCubeShape1.cob" ) ).read()
+		distributor = IECoreScene.MeshAlgo.PointDistributor( m )
+		p = distributor.distribute( density = 500 )
+
+		positions = m["P"].data.copy()
+		positions += imath.V3f( 0, 5, 0 )
+		p2 = distributor.distribute( density = 500, positions = positions )
+		self.assertEqual( p.numPoints, p2.numPoints )
+
+		for i in range( 0, p.numPoints ) :
+			self.assertTrue( p2["P"].data[i].equalWithRelError( p["P"].data[i] + imath.V3f( 0, 5, 0 ), 1e-6 ) )
+
+		chunks = []
+		distributor.distributeChunks( chunks.append, 100, density = 500, positions = positions )
+		points = IECore.V3fVectorData()
+		for chunk in chunks :
+			points.extend( chunk )
+		self.assertEqual( points, p2["P"].data )
+
+	def testPointDistributorErrors( self ) :
+
+		m = IECore.Reader.create( os.path.join( "test", "IECore", "data", "cobFiles", "pCubeShape1.cob" ) ).read()
+		distributor = IECoreScene.MeshAlgo.PointDistributor( m )
+
+		with self.assertRaisesRegex( RuntimeError, "density of the distribution cannot be negative" ) :
+			distributor.distribute( density = -1 )
+
+		with self.assertRaisesRegex( RuntimeError, "maximum number of points per face cannot be negative" ) :
+			distributor.distribute( maxPointsPerFace = -1 )
+
+		with self.assertRaisesRegex( RuntimeError, "Expected {} positions but got 2".format( m["P"].data.size() ) ) :
+			distributor.distribute( positions = IECore.V3fVectorData( [ imath.V3f( 0 ) ] * 2 ) )
+
+		with self.assertRaisesRegex( RuntimeError, "chunk size must be greater than zero" ) :
+			distributor.distributeChunks( lambda points : None, 0 )
+
+		def chunkFunction( points ) :
+			raise ValueError( "Chunk error" )
+
+		with self.assertRaisesRegex( Exception, "Chunk error" ) :
+			distributor.distributeChunks( chunkFunction, 10 )
+
+		del m["uv"]
+		with self.assertRaisesRegex( RuntimeError, re.escape( 'MeshAlgo::distributePoints : MeshPrimitive has no uv primitive variable named "uv" of type FaceVarying or Vertex.' ) ) :
+			IECoreScene.MeshAlgo.PointDistributor( m )
+
+	@unittest.skipUnless( os.environ.get( "CORTEX_PERFORMANCE_TEST", False ), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testPointDistributorPerformance( self ) :
+
+		IECore.PointDistribution.defaultInstance()
+		m = IECoreScene.MeshPrimitive.createPlane( imath.Box2f( imath.V2f( -1 ), imath.V2f( 1 ) ), imath.V2i( 1000 ) )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		distributor = IECoreScene.MeshAlgo.PointDistributor( m )
+		print( "\nPreparation : {:.3f}s".format( t.stop() ) )
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		p = distributor.distribute( density = 5000000 )
+		print( "Distribute {} points : {:.3f}s".format( p.numPoints, t.stop() ) )
+
+		numPoints = [ 0 ]
+		def chunkFunction( points ) :
+			numPoints[0] += points.size()
+
+		t = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		distributor.distributeChunks( chunkFunction, 1000000, density = 5000000 )
+		print( "Distribute {} points in chunks : {:.3f}s".format( numPoints[0], t.stop() ) )
+
+		self.assertEqual( numPoints[0], p.numPoints )
+
 	@unittest.skipIf( ( IECore.TestUtil.inMacCI() or IECore.TestUtil.inWindowsCI() ), "Mac and Windows CI are too slow for reliable timing" )
 	def testCancel( self ) :
 		# Initializing the points distribution is slow and not cancellable
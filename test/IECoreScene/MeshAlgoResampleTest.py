@@ -36,6 +36,7 @@ import IECore
 import IECoreScene
 
 import imath
+import os
 import unittest
 
 class MeshAlgoResampleTest( unittest.TestCase ) :
@@ -423,5 +424,65 @@ class MeshAlgoResampleTest( unittest.TestCase ) :
 				for v in pv.data :
 					self.assertEqual( v, imath.V2f( 0 ) )
 
+	def testPrimitiveVariableResampler( self ) :
+
+		resampler = IECoreScene.MeshAlgo.PrimitiveVariableResampler( self.mesh )
+
+		interpolations = [
+			IECoreScene.PrimitiveVariable.Interpolation.Constant,
+			IECoreScene.PrimitiveVariable.Interpolation.Uniform,
+			IECoreScene.PrimitiveVariable.Interpolation.Vertex,
+			IECoreScene.PrimitiveVariable.Interpolation.Varying,
+			IECoreScene.PrimitiveVariable.Interpolation.FaceVarying,
+		]
+
+		for name in self.mesh.keys() :
+			if name in ( "j", "k" ) :
+				continue
+			for interpolation in interpolations :
+
+				expected = IECoreScene.PrimitiveVariable( self.mesh[name] )
+				IECoreScene.MeshAlgo.resamplePrimitiveVariable( self.mesh, expected, interpolation )
+
+				p = IECoreScene.PrimitiveVariable( self.mesh[name] )
+				resampler.resample( p, interpolation )
+				self.assertEqual( p, expected )
+
+	def testPrimitiveVariableResamplerList( self ) :
+
+		resampler = IECoreScene.MeshAlgo.PrimitiveVariableResampler( self.mesh )
+
+		for interpolation in ( IECoreScene.PrimitiveVariable.Interpolation.Uniform, IECoreScene.PrimitiveVariable.Interpolation.Vertex, IECoreScene.PrimitiveVariable.Interpolation.FaceVarying ) :
+
+			names = [ "b", "c", "e", "f", "g", "i", "vertex_Point_V3f", "uniform_Normal_V3f", "faceVarying_Color_V2f" ]
+			primitiveVariables = [ IECoreScene.PrimitiveVariable( self.mesh[n] ) for n in names ]
+			resampler.resample( primitiveVariables, interpolation )
+
+			for name, p in zip( names, primitiveVariables ) :
+				expected = IECoreScene.PrimitiveVariable( self.mesh[name] )
+				IECoreScene.MeshAlgo.resamplePrimitiveVariable( self.mesh, expected, interpolation )
+				self.assertEqual( p, expected )
+
+	def testUnreferencedVertices( self ) :
+
+		m = IECoreScene.MeshPrimitive( IECore.IntVectorData( [ 3 ] ), IECore.IntVectorData( [ 0, 1, 2 ] ), "linear", IECore.V3fVectorData( [ imath.V3f( 0 ) ] * 4 ) )
+		p = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Uniform, IECore.FloatVectorData( [ 2 ] ) )
+		IECoreScene.MeshAlgo.resamplePrimitiveVariable( m, p, IECoreScene.PrimitiveVariable.Interpolation.Vertex )
+		self.assertEqual( p.data, IECore.FloatVectorData( [ 2, 2, 2, 0 ] ) )
+
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testResamplePerformance( self ) :
+
+		m = IECoreScene.MeshPrimitive.createPlane( imath.Box2f( imath.V2f( -1 ), imath.V2f( 1 ) ), imath.V2i( 1000 ) )
+		data = IECore.V3fVectorData( [ imath.V3f( i ) for i in range( m.variableSize( IECoreScene.PrimitiveVariable.Interpolation.FaceVarying ) ) ] )
+		primitiveVariables = [
+			IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.FaceVarying, data )
+			for i in range( 8 )
+		]
+
+		timer = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		IECoreScene.MeshAlgo.PrimitiveVariableResampler( m ).resample( primitiveVariables, IECoreScene.PrimitiveVariable.Interpolation.Vertex )
+		print( "resample : {} variables in {:.3f}s".format( len( primitiveVariables ), timer.totalElapsed() ) )
+
 if __name__ == "__main__":
 	unittest.main()
@@ -59,6 +59,12 @@ class MeshAlgoSplitTest( unittest.TestCase ) :
 			key = splitter.value( i ).value
 			self.assertEqual( key, m[primVarName].data[0] )
 			result.append( ( key, m ) )
+			self.assertEqual( splitter.numFaces( i ), m.numFaces() )
+
+		# The batch methods should give identical results to processing each segment individually
+		self.assertEqual( splitter.bounds(), [ splitter.bound( i ) for i in range( splitter.numMeshes() ) ] )
+		self.assertEqual( splitter.meshes( list( range( splitter.numMeshes() ) ) ), [ r[1] for r in result ] )
+		self.assertEqual( splitter.meshes( list( reversed( range( splitter.numMeshes() ) ) ) ), [ r[1] for r in reversed( result ) ] )
 
 		# While we want to encourage the MeshSplitter API now, I suppose we should still check that
 		# that the segment call works
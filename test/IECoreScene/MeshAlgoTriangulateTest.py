@@ -285,5 +285,107 @@ class MeshAlgoTriangulateTest( unittest.TestCase ) :
 		self.assertLess( time.time() - startTime, 0.2 )
 		self.assertTrue( cancelled[0] )
 
+	def __assertTriangulatedIndexed( self, mesh, indexed ) :
+
+		triangulated = IECoreScene.MeshAlgo.triangulate( mesh )
+		self.assertTrue( indexed.arePrimitiveVariablesValid() )
+		self.assertEqual( indexed.verticesPerFace, triangulated.verticesPerFace )
+
+		vertexIds = triangulated.vertexIds
+		indexedIds = indexed.vertexIds
+		self.assertEqual( len( indexedIds ), len( vertexIds ) )
+
+		for name, primVar in triangulated.items() :
+
+			self.assertIn( name, indexed )
+			indexedPrimVar = indexed[name]
+			if primVar.interpolation == IECoreScene.PrimitiveVariable.Interpolation.Constant :
+				self.assertEqual( indexedPrimVar, primVar )
+				continue
+
+			self.assertEqual( indexedPrimVar.interpolation, IECoreScene.PrimitiveVariable.Interpolation.Vertex )
+			expected = primVar.expandedData()
+			actual = indexedPrimVar.expandedData()
+			for i in range( 0, len( vertexIds ) ) :
+				if primVar.interpolation == IECoreScene.PrimitiveVariable.Interpolation.Uniform :
+					e = expected[i//3]
+				elif primVar.interpolation == IECoreScene.PrimitiveVariable.Interpolation.FaceVarying :
+					e = expected[i]
+				else :
+					e = expected[vertexIds[i]]
+				self.assertEqual( actual[indexedIds[i]], e )
+
+	def testTriangulateIndexedWeldsContinuousValues( self ) :
+
+		mesh = IECoreScene.MeshPrimitive.createPlane( imath.Box2f( imath.V2f( -1 ), imath.V2f( 1 ) ), imath.V2i( 10 ) )
+		mesh["c"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Constant, IECore.IntData( 10 ) )
+		self.assertEqual( mesh["uv"].interpolation, IECoreScene.PrimitiveVariable.Interpolation.FaceVarying )
+
+		indexed = IECoreScene.MeshAlgo.triangulateIndexed( mesh )
+		self.__assertTriangulatedIndexed( mesh, indexed )
+
+		# The UVs are continuous, so we shouldn't need any vertices
+		# beyond those in the original mesh.
+		self.assertEqual( indexed.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Vertex ), mesh.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Vertex ) )
+		self.assertEqual( indexed.numFaces(), mesh.numFaces() * 2 )
+
+	def testTriangulateIndexedSplitsDiscontinuousValues( self ) :
+
+		mesh = IECoreScene.MeshPrimitive.createBox( imath.Box3f( imath.V3f( -1 ), imath.V3f( 1 ) ) )
+		mesh["N"] = IECoreScene.MeshAlgo.calculateNormals( mesh, IECoreScene.PrimitiveVariable.Interpolation.Uniform )
+		mesh["id"] = IECoreScene.PrimitiveVariable(
+			IECoreScene.PrimitiveVariable.Interpolation.FaceVarying,
+			IECore.IntVectorData( [ 0, 1 ] ),
+			IECore.IntVectorData( [ i % 2 for i in range( 0, 24 ) ] )
+		)
+
+		indexed = IECoreScene.MeshAlgo.triangulateIndexed( mesh )
+		self.__assertTriangulatedIndexed( mesh, indexed )
+
+		# Faceted normals require a separate vertex for each
+		# corner of each face.
+		self.assertEqual( indexed.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Vertex ), 24 )
+
+	def testTriangulateIndexedRemovesUnusedVertices( self ) :
+
+		mesh = IECoreScene.MeshPrimitive(
+			IECore.IntVectorData( [ 3 ] ), IECore.IntVectorData( [ 0, 2, 3 ] ), "linear",
+			IECore.V3fVectorData( [ imath.V3f( i ) for i in range( 0, 4 ) ] )
+		)
+
+		indexed = IECoreScene.MeshAlgo.triangulateIndexed( mesh )
+		self.__assertTriangulatedIndexed( mesh, indexed )
+		self.assertEqual( indexed["P"].data, IECore.V3fVectorData( [ imath.V3f( 0 ), imath.V3f( 2 ), imath.V3f( 3 ) ] ) )
+		self.assertEqual( indexed.vertexIds, IECore.IntVectorData( [ 0, 1, 2 ] ) )
+
+	def testInterleaveVertexData( self ) :
+
+		mesh = IECoreScene.MeshPrimitive.createPlane( imath.Box2f( imath.V2f( -1 ), imath.V2f( 1 ) ), imath.V2i( 4 ) )
+		mesh["N"] = IECoreScene.MeshAlgo.calculateNormals( mesh )
+		mesh = IECoreScene.MeshAlgo.triangulateIndexed( mesh )
+
+		interleaved = IECoreScene.MeshAlgo.interleaveVertexData( mesh, [ "P", "uv", "N" ] )
+		self.assertEqual( interleaved.stride, 8 )
+		self.assertEqual( interleaved.attributes, [ ( "P", 0, 3 ), ( "uv", 3, 2 ), ( "N", 5, 3 ) ] )
+
+		numVertices = mesh.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Vertex )
+		self.assertEqual( len( interleaved.data ), numVertices * 8 )
+
+		p = mesh["P"].expandedData()
+		uv = mesh["uv"].expandedData()
+		n = mesh["N"].expandedData()
+		for i in range( 0, numVertices ) :
+			d = interleaved.data[i*8:(i+1)*8]
+			self.assertEqual( imath.V3f( d[0], d[1], d[2] ), p[i] )
+			self.assertEqual( imath.V2f( d[3], d[4] ), uv[i] )
+			self.assertEqual( imath.V3f( d[5], d[6], d[7] ), n[i] )
+
+		# All float-based primitive variables are included by default.
+		interleaved = IECoreScene.MeshAlgo.interleaveVertexData( mesh )
+		self.assertEqual( sorted( a[0] for a in interleaved.attributes ), [ "N", "P", "uv" ] )
+
+		with self.assertRaisesRegex( Exception, "does not exist" ) :
+			IECoreScene.MeshAlgo.interleaveVertexData( mesh, [ "notAPrimVar" ] )
+
 if __name__ == "__main__":
 	unittest.main()
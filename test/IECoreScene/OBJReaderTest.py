@@ -35,6 +35,9 @@
 import unittest
 import sys
 import os
+import shutil
+import tempfile
+import imath
 import IECore
 import IECoreScene
 
@@ -97,6 +100,141 @@ class TestOBJReader( unittest.TestCase ) :
 
 		self.assertTrue( mesh.isInstanceOf( IECoreScene.MeshPrimitive.staticTypeId() ) )
 		self.assertTrue( mesh.arePrimitiveVariablesValid() )
+		self.assertEqual( mesh.verticesPerFace, IECore.IntVectorData( [ 3, 3, 3 ] ) )
+		self.assertEqual( mesh.vertexIds, IECore.IntVectorData( range( 0, 9 ) ) )
+		self.assertEqual( len( mesh["P"].data ), 9 )
+
+	def testReadGroups( self ) :
+
+		r = IECoreScene.OBJReader( os.path.join( "test", "IECore", "data", "obj", "groups.obj" ) )
+
+		groups = []
+		r.readGroups( lambda name, mesh : groups.append( ( name, mesh ) ) )
+
+		self.assertEqual( [ g[0] for g in groups ], [ "triangle mesh", "1", "default" ] )
+		for name, mesh in groups :
+			self.assertTrue( mesh.arePrimitiveVariablesValid() )
+			self.assertEqual( mesh.verticesPerFace, IECore.IntVectorData( [ 3 ] ) )
+			self.assertEqual( mesh.vertexIds, IECore.IntVectorData( [ 0, 1, 2 ] ) )
+
+		self.assertEqual(
+			groups[2][1]["P"].data,
+			IECore.V3fVectorData( [ imath.V3f( 0, 0, 0 ), imath.V3f( 1, 1, 0 ), imath.V3f( 0, 1, 0 ) ], IECore.GeometricData.Interpretation.Point )
+		)
+
+	def testMultipleChunks( self ) :
+
+		# Write a file large enough to be parsed in several chunks,
+		# using relative indices so that faces reference vertices
+		# from preceding chunks.
+
+		fileName = os.path.join( self.tempDir, "large.obj" )
+		numFaces = 100000
+		with open( fileName, "w" ) as f :
+			f.write( "v 0 0 0\nv 1 0 0\nvt 0 0\nvn 0 1 0\n" )
+			for i in range( 0, numFaces ) :
+				f.write( "v {0}.5 1.25e-1 -{0}\nvt 0.5 {0}\n".format( i ) )
+				f.write( "f -3/-1/1 -2/-1/1 -1/-1/1\n" )
+
+		mesh = IECoreScene.OBJReader( fileName ).read()
+		self.assertTrue( mesh.arePrimitiveVariablesValid() )
+		self.assertEqual( mesh.numFaces(), numFaces )
+		self.assertEqual( len( mesh["P"].data ), numFaces + 2 )
+		self.assertEqual( mesh["P"].data[-1], imath.V3f( numFaces - 0.5, 0.125, -( numFaces - 1 ) ) )
+		self.assertEqual( mesh.vertexIds[-3:], IECore.IntVectorData( [ numFaces - 1, numFaces, numFaces + 1 ] ) )
+		self.assertEqual( mesh["t"].data[-1], numFaces - 1 )
+		self.assertEqual( mesh["N"].data[-1], imath.V3f( 0, 1, 0 ) )
+
+		groups = []
+		IECoreScene.OBJReader( fileName ).readGroups( lambda name, mesh : groups.append( ( name, mesh ) ) )
+		self.assertEqual( len( groups ), 1 )
+		self.assertEqual( groups[0][0], "default" )
+		self.assertEqual( groups[0][1], mesh )
+
+	def testInvalidIndices( self ) :
+
+		fileName = os.path.join( self.tempDir, "invalid.obj" )
+		with open( fileName, "w" ) as f :
+			f.write( "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n" )
+
+		self.assertRaises( RuntimeError, IECoreScene.OBJReader( fileName ).read )
+
+	def testTrailingComments( self ) :
+
+		fileName = os.path.join( self.tempDir, "comments.obj" )
+		with open( fileName, "w" ) as f :
+			f.write( "# a comment\n" )
+			f.write( "v 0 0 0 # a comment\nv 1 0 0\nv 1 1 0\n" )
+			f.write( "vt 0 1 #comment\n" )
+			f.write( "g group # comment\n" )
+			f.write( "f 1/1 2/1 3/1 # comment\n" )
+			f.write( "f 3 2 1#comment\n" )
+			# Tokens which can't be parsed are ignored, along with the
+			# rest of the line.
+			f.write( "f 1 2 3 junk 4\n" )
+			f.write( "v 0 0 1 1 junk\n" )
+
+		mesh = IECoreScene.OBJReader( fileName ).read()
+		self.assertTrue( mesh.arePrimitiveVariablesValid() )
+		self.assertEqual( mesh.verticesPerFace, IECore.IntVectorData( [ 3, 3, 3 ] ) )
+		self.assertEqual( mesh.vertexIds, IECore.IntVectorData( [ 0, 1, 2, 2, 1, 0, 0, 1, 2 ] ) )
+		self.assertEqual( len( mesh["P"].data ), 4 )
+		self.assertEqual( mesh["t"].data[:3], IECore.FloatVectorData( [ 1, 1, 1 ] ) )
+
+		groups = []
+		IECoreScene.OBJReader( fileName ).readGroups( lambda name, mesh : groups.append( ( name, mesh ) ) )
+		self.assertEqual( [ g[0] for g in groups ], [ "group" ] )
+		self.assertEqual( groups[0][1].verticesPerFace, mesh.verticesPerFace )
+		self.assertEqual( groups[0][1].vertexIds, mesh.vertexIds )
+
+	def testForwardReferences( self ) :
+
+		# Faces may refer to vertices defined later in the file,
+		# and both `read()` and `readGroups()` accept them.
+
+		fileName = os.path.join( self.tempDir, "forward.obj" )
+		with open( fileName, "w" ) as f :
+			f.write( "g a\nf 1 2 3\ng b\nf 3 4 1\n" )
+			f.write( "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n" )
+
+		mesh = IECoreScene.OBJReader( fileName ).read()
+		self.assertTrue( mesh.arePrimitiveVariablesValid() )
+		self.assertEqual( mesh.vertexIds, IECore.IntVectorData( [ 0, 1, 2, 2, 3, 0 ] ) )
+
+		groups = []
+		IECoreScene.OBJReader( fileName ).readGroups( lambda name, mesh : groups.append( ( name, mesh ) ) )
+		self.assertEqual( [ g[0] for g in groups ], [ "a", "b" ] )
+		self.assertEqual( groups[0][1]["P"].data, IECore.V3fVectorData( [ imath.V3f( 0, 0, 0 ), imath.V3f( 1, 0, 0 ), imath.V3f( 1, 1, 0 ) ], IECore.GeometricData.Interpretation.Point ) )
+		self.assertEqual( groups[1][1]["P"].data, IECore.V3fVectorData( [ imath.V3f( 1, 1, 0 ), imath.V3f( 0, 1, 0 ), imath.V3f( 0, 0, 0 ) ], IECore.GeometricData.Interpretation.Point ) )
+
+		# References to vertices which are never defined are
+		# rejected by both.
+
+		with open( fileName, "w" ) as f :
+			f.write( "g a\nf 1 2 5\n" )
+			f.write( "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n" )
+
+		with self.assertRaisesRegex( RuntimeError, "Index 5 out of range" ) :
+			IECoreScene.OBJReader( fileName ).read()
+
+		with self.assertRaisesRegex( RuntimeError, "Index 5 out of range" ) :
+			IECoreScene.OBJReader( fileName ).readGroups( lambda name, mesh : None )
+
+	def testInvalidStatements( self ) :
+
+		fileName = os.path.join( self.tempDir, "invalid.obj" )
+		for statement in [ "v 0 0", "f 1 2", "f 1 0 2", "f 1 2/1 3" ] :
+			with open( fileName, "w" ) as f :
+				f.write( "v 0 0 0\nv 1 0 0\nv 1 1 0\nvt 0 0\n{}\n".format( statement ) )
+			self.assertRaises( RuntimeError, IECoreScene.OBJReader( fileName ).read )
+
+	def setUp( self ) :
+
+		self.tempDir = tempfile.mkdtemp()
+
+	def tearDown( self ) :
+
+		shutil.rmtree( self.tempDir )
 
 if __name__ == "__main__":
 
@@ -36,6 +36,7 @@ import IECoreScene
 
 import IECore
 
+import os
 import imath
 import unittest
 
@@ -491,6 +492,21 @@ class DeletePointsTest( unittest.TestCase ) :
 
 		self.assertRaises( RuntimeError, IECoreScene.PointsAlgo.deletePoints, points, delete )
 
+	@unittest.skipUnless( os.environ.get("CORTEX_PERFORMANCE_TEST", False), "'CORTEX_PERFORMANCE_TEST' env var not set" )
+	def testDeletePointsPerformance( self ) :
+
+		numPoints = 10000000
+		points = IECoreScene.PointsPrimitive( IECore.V3fVectorData( [ imath.V3f( i ) for i in range( numPoints ) ] ) )
+		points["id"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Vertex, IECore.IntVectorData( range( numPoints ) ) )
+		points["width"] = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Vertex, IECore.FloatVectorData( [ 0.5, 1.0 ] ), IECore.IntVectorData( [ i % 2 for i in range( numPoints ) ] ) )
+		deleteFlag = IECoreScene.PrimitiveVariable( IECoreScene.PrimitiveVariable.Interpolation.Vertex, IECore.IntVectorData( [ i % 3 for i in range( numPoints ) ] ) )
+
+		timer = IECore.Timer( True, IECore.Timer.Mode.WallClock )
+		result = IECoreScene.PointsAlgo.deletePoints( points, deleteFlag )
+		print( "deletePoints : {} points in {:.3f}s".format( numPoints, timer.totalElapsed() ) )
+
+		self.assertTrue( result.arePrimitiveVariablesValid() )
+
 
 class MergePointsTest( unittest.TestCase ) :
 
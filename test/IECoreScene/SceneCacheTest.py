@@ -1146,6 +1146,117 @@ class SceneCacheTest( unittest.TestCase ) :
 		self.assertEqual( m[0][0], 1.0 )
 		self.assertAlmostEqual( m[1][1], 0.74005603790283203 )
 
+	def testObjectDeltaEncoding( self ) :
+
+		def deformedPlane( time ) :
+
+			plane = IECoreScene.MeshPrimitive.createPlane( imath.Box2f( imath.V2f( -1 ), imath.V2f( 1 ) ), imath.V2i( 20 ) )
+			plane["P"] = IECoreScene.PrimitiveVariable(
+				plane["P"].interpolation,
+				IECore.V3fVectorData( [ p + imath.V3f( 0, 0, math.sin( p.x + time ) ) for p in plane["P"].data ], IECore.GeometricData.Interpretation.Point )
+			)
+			plane["width"] = IECoreScene.PrimitiveVariable(
+				IECoreScene.PrimitiveVariable.Interpolation.Vertex,
+				IECore.FloatVectorData( [ 1.0 + time * i for i in range( 0, plane.variableSize( IECoreScene.PrimitiveVariable.Interpolation.Vertex ) ) ] )
+			)
+			plane["constant"] = IECoreScene.PrimitiveVariable(
+				IECoreScene.PrimitiveVariable.Interpolation.Constant, IECore.FloatData( 1 )
+			)
+			return plane
+
+		times = [ i / 24.0 for i in range( 0, 20 ) ]
+
+		io = IECore.MemoryIndexedIO( IECore.CharVectorData(), IECore.IndexedIO.OpenMode.Write )
+		scc = IECoreScene.SceneCache( io )
+		self.assertEqual( scc.getObjectDeltaKeyframeInterval(), 0 )
+		scc.setObjectDeltaKeyframeInterval( 8 )
+		self.assertEqual( scc.getObjectDeltaKeyframeInterval(), 8 )
+
+		c = scc.createChild( "c" )
+		self.assertEqual( c.getObjectDeltaKeyframeInterval(), 8 )
+		for time in times :
+			c.writeObject( deformedPlane( time ), time )
+
+		del c, scc
+
+		io = IECore.MemoryIndexedIO( io.buffer(), IECore.IndexedIO.OpenMode.Read )
+		self.assertEqual(
+			sorted( int( str( i ) ) for i in io.directory( [ "root", "children", "c", "object", "encoded" ] ).entryIds() ),
+			[ i for i in range( 0, 20 ) if i % 8 ]
+		)
+
+		scc = IECoreScene.SceneCache( io )
+		c = scc.child( "c" )
+
+		# Read in reverse, so we don't rely on previous samples being cached.
+		for time in reversed( times ) :
+			self.assertEqual( c.readObject( time ), deformedPlane( time ) )
+
+		self.assertEqual( c.readObjectPrimitiveVariables( [ "P", "width" ], times[11] )["P"], deformedPlane( times[11] )["P"] )
+		self.assertEqual(
+			c.readObjectPrimitiveVariables( [ "P", "width" ], ( times[11] + times[12] ) / 2 )["width"].data,
+			IECore.linearObjectInterpolation( deformedPlane( times[11] )["width"].data, deformedPlane( times[12] )["width"].data, 0.5 )
+		)
+
+		with self.assertRaises( RuntimeError ) :
+			c.setObjectDeltaKeyframeInterval( 8 )
+
+	def testObjectQuantization( self ) :
+
+		mesh = IECoreScene.MeshPrimitive.createSphere( 10, divisions = imath.V2i( 30, 40 ) )
+		mesh["N"] = IECoreScene.PrimitiveVariable(
+			IECoreScene.PrimitiveVariable.Interpolation.Vertex,
+			IECore.V3fVectorData( [ p.normalized() for p in mesh["P"].data ], IECore.GeometricData.Interpretation.Normal )
+		)
+		mesh["velocity"] = IECoreScene.PrimitiveVariable(
+			IECoreScene.PrimitiveVariable.Interpolation.Vertex,
+			IECore.V3fVectorData( [ imath.V3f( p.y, -p.x, 0 ) for p in mesh["P"].data ], IECore.GeometricData.Interpretation.Vector )
+		)
+		mesh["Cs"] = IECoreScene.PrimitiveVariable(
+			IECoreScene.PrimitiveVariable.Interpolation.Vertex,
+			IECore.Color3fVectorData( [ imath.Color3f( p.x, p.y, p.z ) for p in mesh["P"].data ] )
+		)
+
+		tolerance = 0.001
+
+		io = IECore.MemoryIndexedIO( IECore.CharVectorData(), IECore.IndexedIO.OpenMode.Write )
+		scc = IECoreScene.SceneCache( io )
+		self.assertEqual( scc.getObjectQuantizationTolerance(), 0 )
+		scc.setObjectQuantizationTolerance( tolerance )
+		self.assertEqual( scc.getObjectQuantizationTolerance(), tolerance )
+
+		c = scc.createChild( "c" )
+		c.writeObject( mesh, 0 )
+		del c, scc
+
+		io = IECore.MemoryIndexedIO( io.buffer(), IECore.IndexedIO.OpenMode.Read )
+		scc = IECoreScene.SceneCache( io )
+		c = scc.child( "c" )
+		result = c.readObject( 0 )
+
+		self.assertEqual( result.keys(), mesh.keys() )
+		self.assertTrue( result.isPrimitiveVariableValid( result["P"] ) )
+		self.assertEqual( result.verticesPerFace, mesh.verticesPerFace )
+		self.assertEqual( result.vertexIds, mesh.vertexIds )
+
+		for name in [ "P", "N", "velocity", "uv" ] :
+			self.assertEqual( result[name].interpolation, mesh[name].interpolation )
+			self.assertEqual( result[name].indices, mesh[name].indices )
+			self.assertEqual( result[name].data.typeId(), mesh[name].data.typeId() )
+			self.assertEqual( result[name].data.getInterpretation(), mesh[name].data.getInterpretation() )
+			self.assertEqual( len( result[name].data ), len( mesh[name].data ) )
+			self.assertNotEqual( result[name].data, mesh[name].data )
+			for a, b in zip( result[name].data, mesh[name].data ) :
+				self.assertTrue( a.equalWithAbsError( b, tolerance * 1.01 ) )
+
+		# Colours aren't quantized
+		self.assertEqual( result["Cs"], mesh["Cs"] )
+
+		bound = c.readBound( 0 )
+		for i in range( 0, 3 ) :
+			self.assertLessEqual( bound.min()[i], result.bound().min()[i] )
+			self.assertGreaterEqual( bound.max()[i], result.bound().max()[i] )
+
 	def testObjectVectorShaderCompatibility( self ) :
 
 		# Write a file using ObjectVectors to represent shaders.